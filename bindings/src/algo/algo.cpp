@@ -26,6 +26,22 @@ void pyxmolpp::v1::define_algo_functions(pybind11::module& m) {
         return algo::calc_rmsd_impl(reference, variable);
       },
       py::arg("ref"), py::arg("var"));
+  m.def(
+      "calc_alignment",
+      [](xmol::CoordEigenMatrixf& reference, xmol::CoordEigenMatrixf& variable) {
+        return algo::calc_alignment_impl(reference, variable);
+      },
+      py::arg("ref").noconvert(), py::arg("var").noconvert(), "Single precision alignment of float32 arrays");
+  m.def(
+      "calc_rmsd",
+      [](xmol::CoordEigenMatrixf& reference, xmol::CoordEigenMatrixf& variable) {
+        if (reference.rows() != variable.rows()) {
+          throw geom::GeomError("rmsd: reference.size (=" + std::to_string(reference.rows()) +
+                                ") != variable.size (=" + std::to_string(variable.rows()) + ")");
+        }
+        return algo::calc_rmsd_impl(reference, variable);
+      },
+      py::arg("ref").noconvert(), py::arg("var").noconvert(), "Single precision RMSD of float32 arrays");
   m.def(
       "calc_inertia_tensor", [](xmol::CoordEigenMatrix& coords) { return algo::calc_inertia_tensor_impl(coords); },
       py::arg("coords"));
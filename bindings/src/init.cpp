@@ -11,7 +11,10 @@
 #include "geom/UnitCell.h"
 #include "geom/XYZ.h"
 #include "io/AmberNetCDF.h"
+#include "io/DcdFile.h"
+#include "io/GromacsTrrFile.h"
 #include "io/GromacsXtcFile.h"
+#include "io/MmCifFile.h"
 #include "io/PdbFile.h"
 #include "io/TrjtoolDatFile.h"
 #include "pipe/pipe.h"
@@ -19,6 +22,7 @@
 #include "proxy/references.h"
 #include "proxy/selections.h"
 #include "proxy/spans.h"
+#include "trajectory/InMemoryTrajectory.h"
 #include "trajectory/trajectory.h"
 
 namespace py = pybind11;
@@ -60,12 +64,19 @@ void pyxmolpp::v1::init(pybind11::module& v1) {
 
   auto pyTrajectory = py::class_<trajectory::Trajectory>(v1, "Trajectory", "Trajectory of frames");
   auto pyTrajectoryInputFile = py::class_<trajectory::TrajectoryInputFile, PyTrajectoryInputFile>(v1, "TrajectoryInputFile", "Trajectory input file ABC");
+  auto pyInMemoryTrajectory = py::class_<trajectory::InMemoryTrajectory, trajectory::TrajectoryInputFile>(v1, "InMemoryTrajectory", "Frames coordinates stored in memory");
 
   auto pyPdbInputFile = py::class_<io::PdbInputFile, trajectory::TrajectoryInputFile>(v1, "PdbFile", "PDB file");
+  auto pyPdbTrajectoryFile = py::class_<io::PdbTrajectoryFile, trajectory::TrajectoryInputFile>(v1, "PdbTrajectoryFile", "Multi-model PDB file read one model at a time");
+  auto pyMmCifFile = py::class_<io::MmCifFile, trajectory::TrajectoryInputFile>(v1, "MmCifFile", "mmCIF (PDBx) file read one model at a time");
   auto pyTrjtoolDatFile = py::class_<io::TrjtoolDatFile, trajectory::TrajectoryInputFile>(v1, "TrjtoolDatFile", "Trajtool trajectory file");
   auto pyAmberNetCDF = py::class_<io::AmberNetCDF, trajectory::TrajectoryInputFile>(v1, "AmberNetCDF", "Amber trajectory file");
+  auto pyAmberNetCDFWriter = py::class_<io::AmberNetCDFWriter>(v1, "AmberNetCDFWriter", "Writes frames in AMBER `.nc` binary format");
+  auto pyDcdFile = py::class_<io::DcdFile, trajectory::TrajectoryInputFile>(v1, "DcdFile", "CHARMM/NAMD `.dcd` trajectory file");
   auto pyGromacsXtc = py::class_<io::GromacsXtcFile, trajectory::TrajectoryInputFile>(v1, "GromacsXtcFile", "Gromacs binary `.xtc` input file");
   auto pyXtcWriter = py::class_<io::xdr::XtcWriter>(v1, "XtcWriter", "Writes frames in `.xtc` binary format");
+  auto pyGromacsTrr = py::class_<io::GromacsTrrFile, trajectory::TrajectoryInputFile>(v1, "GromacsTrrFile", "Gromacs binary `.trr` input file");
+  auto pyTrrWriter = py::class_<io::xdr::TrrWriter>(v1, "TrrWriter", "Writes frames in `.trr` binary format");
 
   py::implicitly_convertible<AtomSmartSpan,AtomSmartSelection>();
   py::implicitly_convertible<ResidueSmartSpan,ResidueSmartSelection>();
@@ -101,16 +112,23 @@ void pyxmolpp::v1::init(pybind11::module& v1) {
 
   populate(pyTrajectory);
   populate(pyTrajectoryInputFile);
+  populate(pyInMemoryTrajectory);
 
   // underscore in `_pipe` help disambiguate from pure python pyxmolpp2.pipe
   auto pipe = v1.def_submodule("_pipe");
   populate_pipe(pipe);
 
   populate(pyPdbInputFile);
+  populate(pyPdbTrajectoryFile);
+  populate(pyMmCifFile);
   populate(pyTrjtoolDatFile);
   populate(pyAmberNetCDF);
+  populate(pyAmberNetCDFWriter);
+  populate(pyDcdFile);
   populate(pyGromacsXtc);
   populate(pyXtcWriter);
+  populate(pyGromacsTrr);
+  populate(pyTrrWriter);
 
   define_algo_functions(v1);
   init_TorsionAngle(v1);
@@ -123,5 +141,8 @@ void pyxmolpp::v1::init(pybind11::module& v1) {
   py::register_exception<xmol::geom::GeomError>(v1, "GeomError");
   py::register_exception<xmol::io::XtcReadError>(v1, "XtcReadError");
   py::register_exception<xmol::io::XtcWriteError>(v1, "XtcWriteError");
+  py::register_exception<xmol::io::TrrReadError>(v1, "TrrReadError");
+  py::register_exception<xmol::io::TrrWriteError>(v1, "TrrWriteError");
+  py::register_exception<xmol::io::cif::CifException>(v1, "CifReadError");
   py::register_exception<xmol::utils::DeadObserverAccessError>(v1, "DeadObserverAccessError");
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "AmberNetCDF.h"
 #include "xmol/Frame.h"
 
+#include <pybind11/numpy.h>
+
 namespace py = pybind11;
 using namespace xmol::io;
 using namespace xmol::proxy::smart;
@@ -8,6 +10,9 @@ using namespace xmol::proxy::smart;
 void pyxmolpp::v1::populate(py::class_<AmberNetCDF, xmol::trajectory::TrajectoryInputFile>& pyAmberNetCDF) {
 
   pyAmberNetCDF.def(py::init<std::string>(), py::arg("filename"), "Amber binary trajectory ``.nc`` file")
+      .def(py::init<std::string, size_t>(), py::arg("filename"), py::arg("block_frames"),
+           "Read up to `block_frames` frames per request, 0 chooses block size automatically, 1 disables blocks")
+      .def("block_frames", &AmberNetCDF::block_frames, "Maximal number of frames fetched by single read")
       .def("n_frames", &AmberNetCDF::n_frames, "Number of frames")
       .def("n_atoms", &AmberNetCDF::n_atoms, "Number of atoms per frame")
       .def("read_frame", &AmberNetCDF::read_frame, py::arg("index"), py::arg("frame"),
@@ -15,3 +20,23 @@ void pyxmolpp::v1::populate(py::class_<AmberNetCDF, xmol::trajectory::Trajectory
       .def("advance", &AmberNetCDF::advance, py::arg("shift"), "Shift internal pointer by `shift`");
   ;
 }
+
+void pyxmolpp::v1::populate(py::class_<AmberNetCDFWriter>& pyAmberNetCDFWriter) {
+
+  pyAmberNetCDFWriter
+      .def(py::init<std::string, size_t>(), py::arg("filename"), py::arg("buffer_frames") = 16,
+           "Create (or overwrite) `filename`, up to `buffer_frames` frames are stored to disk at once")
+      .def("write", py::overload_cast<xmol::Frame&>(&AmberNetCDFWriter::write), py::arg("frame"),
+           "Write frame coordinates, cell and time")
+      .def(
+          "write",
+          [](AmberNetCDFWriter& self, xmol::Frame& frame,
+             const py::array_t<float, py::array::c_style | py::array::forcecast>& velocities) {
+            self.write(frame, xmol::future::Span<const float>(velocities.data(), velocities.size()));
+          },
+          py::arg("frame"), py::arg("velocities"),
+          "Write frame coordinates, cell, time and [n_atoms, 3] velocities (angstrom/picosecond)")
+      .def("flush", &AmberNetCDFWriter::flush, "Store buffered frames to disk")
+      .def("close", &AmberNetCDFWriter::close, "Flush buffered frames and close file")
+      .def("n_frames", &AmberNetCDFWriter::n_frames, "Number of written frames");
+}
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "xmol/io/AmberNetCDF.h"
+#include "xmol/io/AmberNetCDFWriter.h"
 #include <pybind11/pybind11.h>
 
 namespace pyxmolpp::v1 {
 
 void populate(pybind11::class_<xmol::io::AmberNetCDF, xmol::trajectory::TrajectoryInputFile>& pyAmberNetCDF);
+void populate(pybind11::class_<xmol::io::AmberNetCDFWriter>& pyAmberNetCDFWriter);
 
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+#include "DcdFile.h"
+#include "xmol/Frame.h"
+
+namespace py = pybind11;
+using namespace xmol::io;
+
+void pyxmolpp::v1::populate(py::class_<DcdFile, xmol::trajectory::TrajectoryInputFile>& pyDcdFile) {
+
+  pyDcdFile.def(py::init<std::string>(), py::arg("filename"))
+      .def("n_frames", &DcdFile::n_frames, "Number of frames")
+      .def("n_atoms", &DcdFile::n_atoms, "Number of atoms per frame")
+      .def("read_frame", &DcdFile::read_frame, py::arg("index"), py::arg("frame"),
+           "Assign `index` frame coordinates, cell, etc")
+      .def("advance", &DcdFile::advance, py::arg("shift"), "Shift internal pointer by `shift`")
+      .def("has_cell", &DcdFile::has_cell, "True if frames contain unit cell")
+      .def("n_fixed_atoms", &DcdFile::n_fixed_atoms, "Number of atoms stored in first frame only");
+}
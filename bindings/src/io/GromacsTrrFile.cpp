@@ -0,0 +1,55 @@
+#include "GromacsTrrFile.h"
+#include "xmol/Frame.h"
+
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+using namespace xmol::io;
+
+namespace {
+
+using Vectors = std::optional<py::array_t<double, py::array::c_style | py::array::forcecast>>;
+
+xmol::future::Span<const double> as_span(const Vectors& values) {
+  if (!values) {
+    return {};
+  }
+  return {values->data(), static_cast<size_t>(values->size())};
+}
+
+} // namespace
+
+void pyxmolpp::v1::populate(py::class_<GromacsTrrFile, xmol::trajectory::TrajectoryInputFile>& pyGromacsTrr) {
+
+  pyGromacsTrr.def(py::init<std::string>(), py::arg("filename"))
+      .def(py::init<std::string, std::string>(), py::arg("filename"), py::arg("index_filename"),
+           "Use frame offsets from `index_filename`, (re)create index file if it's missing or outdated")
+      .def("n_frames", &GromacsTrrFile::n_frames, "Number of frames")
+      .def("n_atoms", &GromacsTrrFile::n_atoms, "Number of atoms per frame")
+      .def("read_frame", &GromacsTrrFile::read_frame, py::arg("index"), py::arg("frame"),
+           "Assign `index` frame coordinates, cell, etc")
+      .def("advance", &GromacsTrrFile::advance, py::arg("shift"), "Shift internal pointer by `shift`")
+      .def("is_double_precision", &GromacsTrrFile::is_double_precision,
+           "True if first frame is stored in double precision")
+      .def("has_velocities", &GromacsTrrFile::has_velocities, "True if first frame contains velocities")
+      .def("has_forces", &GromacsTrrFile::has_forces, "True if first frame contains forces");
+}
+
+void pyxmolpp::v1::populate(pybind11::class_<xmol::io::xdr::TrrWriter>& pyTrrWriter) {
+
+  pyTrrWriter
+      .def(py::init<std::string, bool>(), py::arg("filename"), py::arg("double_precision") = false)
+      .def(
+          "write",
+          [](xdr::TrrWriter& self, xmol::Frame& frame, const Vectors& velocities, const Vectors& forces) {
+            if (!velocities && !forces) {
+              self.write(frame);
+              return;
+            }
+            self.write(frame, as_span(velocities), as_span(forces));
+          },
+          py::arg("frame"), py::arg("velocities") = py::none(), py::arg("forces") = py::none(),
+          "Write frame with optional [n_atoms, 3] `velocities` (Å/ps) and `forces` (kJ/mol/Å), "
+          "by default vectors stored in frame are written");
+}
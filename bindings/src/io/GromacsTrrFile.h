@@ -0,0 +1,12 @@
+#pragma once
+
+#include "xmol/io/GromacsTrrFile.h"
+#include "xmol/io/xdr/TrrWriter.h"
+#include <pybind11/pybind11.h>
+
+namespace pyxmolpp::v1 {
+
+void populate(pybind11::class_<xmol::io::GromacsTrrFile, xmol::trajectory::TrajectoryInputFile>& pyGromacsTrr);
+void populate(pybind11::class_<xmol::io::xdr::TrrWriter>& pyTrrWriter);
+
+}
@@ -1,24 +1,48 @@
 #include "GromacsXtcFile.h"
 #include "xmol/Frame.h"
 
+#include <pybind11/numpy.h>
+
 namespace py = pybind11;
 using namespace xmol::io;
 using namespace xmol::proxy::smart;
 
 void pyxmolpp::v1::populate(py::class_<GromacsXtcFile, xmol::trajectory::TrajectoryInputFile>& pyGromacsXtc) {
 
-  pyGromacsXtc.def(py::init<std::string, size_t>(), py::arg("filename"), py::arg("n_frames"))
+  pyGromacsXtc.def(py::init<std::string>(), py::arg("filename"))
+      .def(py::init<std::string, std::string>(), py::arg("filename"), py::arg("index_filename"),
+           "Use frame offsets from `index_filename`, (re)create index file if it's missing or outdated")
+      .def(py::init<std::string, size_t>(), py::arg("filename"), py::arg("n_frames"),
+           "Use first `n_frames` frames only")
       .def("n_frames", &GromacsXtcFile::n_frames, "Number of frames")
       .def("n_atoms", &GromacsXtcFile::n_atoms, "Number of atoms per frame")
       .def("read_frame", &GromacsXtcFile::read_frame, py::arg("index"), py::arg("frame"),
            "Assign `index` frame coordinates, cell, etc")
-      .def("advance", &GromacsXtcFile::advance, py::arg("shift"), "Shift internal pointer by `shift`");
+      .def("advance", &GromacsXtcFile::advance, py::arg("shift"), "Shift internal pointer by `shift`")
+      .def(
+          "read_frames",
+          [](const GromacsXtcFile& self, size_t begin, size_t end, size_t stride, size_t n_threads) {
+            size_t n_selected = (begin < end && stride > 0) ? (end - begin + stride - 1) / stride : 0;
+            py::array_t<float> result(std::vector<size_t>{n_selected, self.n_atoms(), 3});
+            float* out = result.mutable_data();
+            {
+              py::gil_scoped_release release;
+              self.read_frames(begin, end, stride, out, n_threads);
+            }
+            return result;
+          },
+          py::arg("begin"), py::arg("end"), py::arg("stride") = 1, py::arg("n_threads") = 0,
+          "Decode coordinates of frames ``begin:end:stride`` in parallel into [n_frames, n_atoms, 3] float32 array "
+          "(in angstroms), zero `n_threads` stands for number of CPU cores. Doesn't affect sequential reads");
   ;
 }
 
 void pyxmolpp::v1::populate(pybind11::class_<xmol::io::xdr::XtcWriter>& pyXtcWriter) {
 
   pyXtcWriter
-      .def(py::init<std::string, float>(), py::arg("filename"), py::arg("precision"))
-      .def("write", &xdr::XtcWriter::write, "Write frame");
+      .def(py::init<std::string, float, size_t>(), py::arg("filename"), py::arg("precision"), py::arg("n_threads") = 1,
+           "With `n_threads` > 1 frames are compressed in background threads and appended to file in order, "
+           "zero `n_threads` stands for number of CPU cores")
+      .def("write", &xdr::XtcWriter::write, "Write frame")
+      .def("flush", &xdr::XtcWriter::flush, "Wait for queued frames and write them to file");
 }
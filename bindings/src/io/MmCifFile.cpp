@@ -0,0 +1,18 @@
+#include "MmCifFile.h"
+#include "xmol/Frame.h"
+
+namespace py = pybind11;
+using namespace xmol::io;
+
+void pyxmolpp::v1::populate(py::class_<MmCifFile, xmol::trajectory::TrajectoryInputFile>& pyMmCifFile) {
+  pyMmCifFile
+      .def(py::init<std::string>(), py::arg("filename"),
+           "Index models of file, frames are read one at a time when trajectory is traversed")
+      .def("frame", &MmCifFile::frame, py::arg("index"), "Read `index` frame with topology")
+      .def("frames", &MmCifFile::frames, "Read all frames with topology")
+      .def("n_frames", &MmCifFile::n_frames, "Number of frames")
+      .def("n_atoms", &MmCifFile::n_atoms, "Number of atoms per frame")
+      .def("read_frame", &MmCifFile::read_frame, py::arg("index"), py::arg("frame"),
+           "Assign `index` frame coordinates and cell")
+      .def("advance", &MmCifFile::advance, py::arg("shift"), "Shift internal pointer by `shift`");
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "xmol/io/MmCifFile.h"
+#include "xmol/io/cif/exceptions.h"
+#include <pybind11/pybind11.h>
+
+namespace pyxmolpp::v1 {
+
+void populate(pybind11::class_<xmol::io::MmCifFile, xmol::trajectory::TrajectoryInputFile>& pyMmCifFile);
+
+}
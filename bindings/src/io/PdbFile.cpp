@@ -15,8 +15,12 @@ void pyxmolpp::v1::populate(py::class_<PdbInputFile, xmol::trajectory::Trajector
       .export_values();
 
   pyPdbInputFile
-      .def(py::init<std::string, PdbInputFile::Dialect>(), py::arg("filename"),
-           py::arg("dialect") = PdbInputFile::Dialect::AMBER_99, "Constructor")
+      .def(py::init([](std::string filename, PdbInputFile::Dialect dialect, size_t n_threads) {
+             return std::make_unique<PdbInputFile>(std::move(filename), dialect, true, n_threads);
+           }),
+           py::arg("filename"), py::arg("dialect") = PdbInputFile::Dialect::AMBER_99, py::arg("n_threads") = 1,
+           "Constructor, models of multi-model file are read with `n_threads` threads, "
+           "zero `n_threads` stands for number of CPU cores")
       .def("frames", &PdbInputFile::frames, "Get copy of frames")
       .def("n_frames", &PdbInputFile::n_frames, "Number of frames")
       .def("n_atoms", &PdbInputFile::n_atoms, "Number of atoms in first frame")
@@ -24,3 +28,16 @@ void pyxmolpp::v1::populate(py::class_<PdbInputFile, xmol::trajectory::Trajector
            "Assign `index` frame coordinates, cell, etc")
       .def("advance", &PdbInputFile::advance, "No-op");
 }
+
+void pyxmolpp::v1::populate(py::class_<PdbTrajectoryFile, xmol::trajectory::TrajectoryInputFile>& pyPdbTrajectoryFile) {
+  pyPdbTrajectoryFile
+      .def(py::init<std::string, PdbInputFile::Dialect>(), py::arg("filename"),
+           py::arg("dialect") = PdbInputFile::Dialect::AMBER_99,
+           "Index models of file, frames are read one at a time when trajectory is traversed")
+      .def("frame", &PdbTrajectoryFile::frame, py::arg("index"), "Read `index` frame with topology")
+      .def("n_frames", &PdbTrajectoryFile::n_frames, "Number of frames")
+      .def("n_atoms", &PdbTrajectoryFile::n_atoms, "Number of atoms per frame")
+      .def("read_frame", &PdbTrajectoryFile::read_frame, py::arg("index"), py::arg("frame"),
+           "Assign `index` frame coordinates and cell")
+      .def("advance", &PdbTrajectoryFile::advance, py::arg("shift"), "Shift internal pointer by `shift`");
+}
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "xmol/io/PdbInputFile.h"
+#include "xmol/io/PdbTrajectoryFile.h"
 #include <pybind11/pybind11.h>
 
 namespace pyxmolpp::v1 {
 
 void populate(pybind11::class_<xmol::io::PdbInputFile, xmol::trajectory::TrajectoryInputFile>& pyPdbInputFile);
+void populate(
+    pybind11::class_<xmol::io::PdbTrajectoryFile, xmol::trajectory::TrajectoryInputFile>& pyPdbTrajectoryFile);
 
 }
\ No newline at end of file
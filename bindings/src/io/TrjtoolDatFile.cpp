@@ -1,6 +1,8 @@
 #include "TrjtoolDatFile.h"
 #include "xmol/Frame.h"
 
+#include <pybind11/numpy.h>
+
 namespace py = pybind11;
 using namespace xmol::io;
 using namespace xmol::proxy::smart;
@@ -12,6 +14,23 @@ void pyxmolpp::v1::populate(py::class_<TrjtoolDatFile, xmol::trajectory::Traject
       .def("n_atoms", &TrjtoolDatFile::n_atoms, "Number of atoms per frame")
       .def("read_frame", &TrjtoolDatFile::read_frame, py::arg("index"), py::arg("frame"),
            "Assign `index` frame coordinates, cell, etc")
-      .def("advance", &TrjtoolDatFile::advance, py::arg("shift"), "Shift internal pointer by `shift`");
+      .def("advance", &TrjtoolDatFile::advance, py::arg("shift"), "Shift internal pointer by `shift`")
+      .def(
+          "raw_frame",
+          [](TrjtoolDatFile& self, size_t index) {
+            const char* data = self.raw_frame(index);
+            using MappingPtr = std::shared_ptr<const xmol::utils::MappedFile>;
+            py::capsule base(new MappingPtr(self.mapping()), [](void* p) { delete static_cast<MappingPtr*>(p); });
+            auto dtype = py::dtype::of<float>();
+            if (self.is_byte_swapped()) {
+              dtype = py::dtype::from_args(dtype.attr("newbyteorder")());
+            }
+            py::array result(dtype, std::vector<size_t>{self.n_atoms(), 3},
+                             std::vector<size_t>{3 * sizeof(float), sizeof(float)}, data, base);
+            result.attr("flags").attr("writeable") = false;
+            return result;
+          },
+          py::arg("index"),
+          "Read-only [n_atoms, 3] float32 view of `index` frame coordinates in file memory map, no copy is made");
   ;
 }
@@ -6,6 +6,7 @@
 
 #include <sstream>
 
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/stl.h>
 
@@ -14,6 +15,21 @@ using namespace xmol;
 using namespace xmol::proxy;
 using namespace xmol::proxy::smart;
 
+namespace {
+
+/// Writable [n_atoms, 3] view of frame vectors, None if frame doesn't store them
+template <typename Span> py::object as_values(py::object frame, bool present, Span (Frame::*get)()) {
+  if (!present) {
+    return py::none();
+  }
+  auto eigen_map = (frame.cast<Frame&>().*get)()._eigen();
+  size_t shape[] = {(size_t)eigen_map.rows(), (size_t)eigen_map.cols()};
+  size_t strides[] = {(size_t)eigen_map.rowStride() * sizeof(double), (size_t)eigen_map.colStride() * sizeof(double)};
+  return py::array(shape, strides, eigen_map.data(), frame);
+}
+
+} // namespace
+
 void pyxmolpp::v1::populate(pybind11::class_<Frame>& pyFrame) {
   using SRef = Frame;
   pyFrame.def(py::init<>())
@@ -25,6 +41,22 @@ void pyxmolpp::v1::populate(pybind11::class_<Frame>& pyFrame) {
       .def_readwrite("cell", &SRef::cell)
       .def_readwrite("index", &SRef::index, "Zero-based index in trajectory")
       .def_readwrite("time", &SRef::time, "Time point in trajectory, a.u.")
+      .def_property_readonly("has_velocities", &SRef::has_velocities)
+      .def_property_readonly("has_forces", &SRef::has_forces)
+      .def_property_readonly(
+          "velocities",
+          [](py::object self) {
+            return as_values(self, self.cast<SRef&>().has_velocities(), &SRef::velocities);
+          },
+          "Atom velocities as [n_atoms, 3] array in Å/ps, None unless enabled by `add_velocities()`")
+      .def_property_readonly(
+          "forces",
+          [](py::object self) { return as_values(self, self.cast<SRef&>().has_forces(), &SRef::forces); },
+          "Atom forces as [n_atoms, 3] array in kJ/mol/Å, None unless enabled by `add_forces()`")
+      .def("add_velocities", &SRef::add_velocities, "Store zero-initialized atom velocities")
+      .def("add_forces", &SRef::add_forces, "Store zero-initialized atom forces")
+      .def("remove_velocities", &SRef::remove_velocities, "Drop stored velocities")
+      .def("remove_forces", &SRef::remove_forces, "Drop stored forces")
       .def("add_molecule", [](SRef& ref) { return ref.add_molecule().smart(); })
       .def("to_pdb", to_pdb_file<SRef>, py::arg("path_or_buf"))
       .def("to_pdb", to_pdb_stream<SRef>, py::arg("path_or_buf"))
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "xmol/io/pdb/PdbBufferWriter.h"
 #include "xmol/io/pdb/PdbWriter.h"
 #include <fstream>
 
@@ -9,13 +10,23 @@
 
 namespace pyxmolpp::v1 {
 
+template <typename Element> void write_pdb(std::ostream& out, Element& element) {
+  xmol::io::pdb::PdbWriter writer(out);
+  writer.write(element, xmol::io::pdb::StandardPdbRecords::instance());
+}
+
+inline void write_pdb(std::ostream& out, xmol::Frame& frame) { xmol::io::pdb::PdbBufferWriter(out).write(frame); }
+
+inline void write_pdb(std::ostream& out, xmol::trajectory::Trajectory::Slice& slice) {
+  xmol::io::pdb::PdbBufferWriter(out).write(slice);
+}
+
 template <typename Element> void to_pdb_file(Element& element, std::string& path) {
   std::ofstream out(path);
   if (out.fail()) {
     throw std::runtime_error("Can't open file `" + path + "` for writing"); // toto: replace with IOError
   }
-  xmol::io::pdb::PdbWriter writer(out);
-  writer.write(element, xmol::io::pdb::StandardPdbRecords::instance());
+  write_pdb(out, element);
 }
 
 template <typename Element> void to_pdb_stream(Element& element, pybind11::object& fileHandle) {
@@ -27,8 +38,7 @@ template <typename Element> void to_pdb_stream(Element& element, pybind11::objec
   }
   pybind11::detail::pythonbuf buf(fileHandle);
   std::ostream stream(&buf);
-  xmol::io::pdb::PdbWriter writer(stream);
-  writer.write(element, xmol::io::pdb::StandardPdbRecords::instance());
+  write_pdb(stream, element);
 }
 
 } // namespace pyxmolpp::v1
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include "InMemoryTrajectory.h"
+#include "xmol/Frame.h"
+
+namespace py = pybind11;
+using namespace xmol::trajectory;
+
+void pyxmolpp::v1::populate(py::class_<InMemoryTrajectory, TrajectoryInputFile>& pyInMemoryTrajectory) {
+
+  pyInMemoryTrajectory
+      .def(py::init<size_t, double, size_t>(), py::arg("n_atoms"), py::arg("precision") = 0.0,
+           py::arg("block_size") = 32,
+           "Empty store of `n_atoms` frames. Coordinates are kept as float32 for zero `precision`, "
+           "otherwise they are rounded to multiples of `precision` (Å) and delta-encoded "
+           "in blocks of `block_size` frames")
+      .def("n_frames", &InMemoryTrajectory::n_frames, "Number of frames")
+      .def("n_atoms", &InMemoryTrajectory::n_atoms, "Number of atoms per frame")
+      .def("read_frame", &InMemoryTrajectory::read_frame, py::arg("index"), py::arg("frame"),
+           "Assign `index` frame coordinates, cell, etc")
+      .def("advance", &InMemoryTrajectory::advance, py::arg("shift"), "Shift internal pointer by `shift`")
+      .def("append", &InMemoryTrajectory::append, py::arg("frame"), "Store coordinates, cell and time of `frame`")
+      .def_property_readonly("precision", &InMemoryTrajectory::precision,
+                             "Quantization step in angstroms, zero for float32 storage")
+      .def_property_readonly("block_size", &InMemoryTrajectory::block_size, "Number of frames per block")
+      .def_property_readonly("size_in_bytes", &InMemoryTrajectory::size_in_bytes,
+                             "Memory occupied by stored coordinates in bytes");
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "xmol/trajectory/InMemoryTrajectory.h"
+#include <pybind11/pybind11.h>
+
+namespace pyxmolpp::v1 {
+
+void populate(pybind11::class_<xmol::trajectory::InMemoryTrajectory, xmol::trajectory::TrajectoryInputFile>&
+                  pyInMemoryTrajectory);
+
+}
@@ -1,6 +1,11 @@
 #include "trajectory.h"
 #include "iterator-helpers.h"
+#include "proxy/to_pdb_shortcuts.h"
 #include "xmol/proxy/smart/CoordSmartSpan.h"
+#include "xmol/proxy/smart/selections.h"
+
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 using namespace xmol::trajectory;
@@ -20,13 +25,103 @@ public:
   [[nodiscard]] size_t n_atoms() const final { return ptr->n_atoms(); }
 
   void read_frame(size_t index, Frame& frame) final { ptr->read_frame(index, frame); }
+  void read_coords(size_t index, const future::Span<float>& coords) final { ptr->read_coords(index, coords); }
+  void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) final {
+    ptr->read_frame_atoms(index, atoms, frame);
+  }
+  [[nodiscard]] std::optional<double> frame_time(size_t index) const final { return ptr->frame_time(index); }
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final { return ptr->clone(); }
   void advance(size_t shift) final { ptr->advance(shift); }
+  void seek(size_t current, size_t index) final { ptr->seek(current, index); }
 };
+
+/// Python iterator over prefetched slice, waits for frames and stops background reader with GIL released
+class PrefetchIterator {
+public:
+  explicit PrefetchIterator(std::unique_ptr<Trajectory::Iterator> it) : m_it(std::move(it)) {}
+  PrefetchIterator(PrefetchIterator&&) = default;
+  ~PrefetchIterator() {
+    if (m_it) {
+      py::gil_scoped_release release;
+      m_it.reset();
+    }
+  }
+
+  Frame& next() {
+    if (!m_first_or_done) {
+      ++*m_it;
+    } else {
+      m_first_or_done = false;
+    }
+    if (*m_it == Trajectory::Sentinel{}) {
+      m_first_or_done = true;
+      throw py::stop_iteration();
+    }
+    return **m_it;
+  }
+
+private:
+  std::unique_ptr<Trajectory::Iterator> m_it;
+  bool m_first_or_done = true;
+};
+
+std::vector<AtomIndex> atom_indices(proxy::smart::AtomSmartSelection& atoms) {
+  std::vector<AtomIndex> indices;
+  indices.reserve(atoms.size());
+  for (auto& atom : atoms) {
+    indices.push_back(atom.index());
+  }
+  return indices;
+}
+
+/// Coordinates of all slice frames as [n_frames, n_atoms, 3] array of `dtype` (float32 or float64)
+py::array slice_coords(Trajectory::Slice& slice, const py::object& dtype_like) {
+  const auto dtype = py::dtype::from_args(dtype_like);
+  const size_t n_frames = slice.n_frames();
+  const size_t n_atoms = slice.n_atoms();
+  std::vector<size_t> shape{n_frames, n_atoms, 3};
+  if (dtype.kind() == 'f' && dtype.itemsize() == sizeof(float)) {
+    py::array_t<float> result(shape);
+    float* out = result.mutable_data();
+    {
+      py::gil_scoped_release release;
+      slice.read_coords(future::Span<float>(out, n_frames * n_atoms * 3));
+    }
+    return std::move(result);
+  }
+  if (dtype.kind() == 'f' && dtype.itemsize() == sizeof(double)) {
+    py::array_t<double> result(shape);
+    double* out = result.mutable_data();
+    {
+      py::gil_scoped_release release;
+      slice.read_coords(future::Span<double>(out, n_frames * n_atoms * 3));
+    }
+    return std::move(result);
+  }
+  throw py::type_error("dtype must be float32 or float64");
+}
+
+py::object make_slice_iterator(Trajectory::Slice& slice) {
+  if (slice.prefetch_depth() == 0) {
+    return common::make_iterator(slice.begin(), slice.end());
+  }
+  std::unique_ptr<Trajectory::Iterator> it;
+  {
+    py::gil_scoped_release release; // background reader may need GIL to call python input files
+    it = std::make_unique<Trajectory::Iterator>(slice.begin());
+  }
+  return py::cast(PrefetchIterator(std::move(it)));
+}
 } // namespace
 
 void pyxmolpp::v1::populate(pybind11::class_<Trajectory>& pyTrajectory) {
   auto&& pyTrajectoryIterator = py::class_<Trajectory::Iterator>(pyTrajectory, "Iterator");
   auto&& pyTrajectorySlice = py::class_<Trajectory::Slice>(pyTrajectory, "Slice");
+  auto&& pyPrefetchIterator = py::class_<PrefetchIterator>(pyTrajectory, "PrefetchIterator");
+
+  pyPrefetchIterator.def("__iter__", [](PrefetchIterator& self) -> PrefetchIterator& { return self; })
+      .def("__next__", &PrefetchIterator::next, py::call_guard<py::gil_scoped_release>(),
+           py::return_value_policy::reference_internal);
 
   pyTrajectory.def(py::init<Frame>())
       .def(
@@ -68,11 +163,61 @@ void pyxmolpp::v1::populate(pybind11::class_<Trajectory>& pyTrajectory) {
            })
       .def(
           "__iter__", [](Trajectory& self) { return common::make_iterator(self.begin(), self.end()); },
-          py::keep_alive<0, 1>());
+          py::keep_alive<0, 1>())
+      .def("read_into", &Trajectory::read_into, py::arg("index"), py::arg("frame"),
+           "Read coordinates, cell and time of `index` frame into existing `frame`, topology is not copied")
+      .def("index_at_time", &Trajectory::index_at_time, py::arg("t"),
+           "Index of frame nearest to time `t`, frames of overlapping input files are superseded by later files")
+      .def("frame_at_time", &Trajectory::frame_at_time, py::arg("t"), "Frame nearest to time `t`")
+      .def("slice_by_time", &Trajectory::slice_by_time, py::arg("t0"), py::arg("t1"), py::arg("dt") = py::none(),
+           py::keep_alive<0, 1>(), "Slice of frames with time in [t0, t1), optionally thinned to `dt` time step")
+      .def("prefetch", &Trajectory::prefetch, py::arg("depth"), py::keep_alive<0, 1>(),
+           "Trajectory slice which reads up to `depth` frames ahead in background thread")
+      .def("select_atoms", &Trajectory::select_atoms, py::arg("indices"), py::keep_alive<0, 1>(),
+           "Trajectory slice which yields frames of atoms with given `indices` only")
+      .def(
+          "select_atoms",
+          [](Trajectory& self, proxy::smart::AtomSmartSelection& atoms) {
+            return self.select_atoms(atom_indices(atoms));
+          },
+          py::arg("atoms"), py::keep_alive<0, 1>(), "Trajectory slice which yields frames of given `atoms` only");
 
-  pyTrajectorySlice.def(
-      "__iter__", [](Trajectory::Slice& self) { return common::make_iterator(self.begin(), self.end()); },
-      py::keep_alive<0, 1>())
+  pyTrajectorySlice.def("__iter__", &make_slice_iterator, py::keep_alive<0, 1>())
+      .def("prefetch", &Trajectory::Slice::prefetch, py::arg("depth"), py::keep_alive<0, 1>(),
+           "Same slice which reads up to `depth` frames ahead in background thread")
+      .def("select_atoms", &Trajectory::Slice::select_atoms, py::arg("indices"), py::keep_alive<0, 1>(),
+           "Same slice which yields frames of atoms with given `indices` only")
+      .def(
+          "select_atoms",
+          [](Trajectory::Slice& self, proxy::smart::AtomSmartSelection& atoms) {
+            return self.select_atoms(atom_indices(atoms));
+          },
+          py::arg("atoms"), py::keep_alive<0, 1>(), "Same slice which yields frames of given `atoms` only")
+      .def(
+          "coords",
+          [](Trajectory::Slice& self, std::vector<AtomIndex> indices, const py::object& dtype) {
+            auto slice = self.select_atoms(std::move(indices));
+            return slice_coords(slice, dtype);
+          },
+          py::arg("indices"), py::arg("dtype") = "float32",
+          "Coordinates of atoms with given `indices` of all frames as [n_frames, n_atoms, 3] array, "
+          "indices are sorted and deduplicated")
+      .def(
+          "coords",
+          [](Trajectory::Slice& self, proxy::smart::AtomSmartSelection& atoms, const py::object& dtype) {
+            auto slice = self.select_atoms(atom_indices(atoms));
+            return slice_coords(slice, dtype);
+          },
+          py::arg("atoms"), py::arg("dtype") = "float32",
+          "Coordinates of given `atoms` (in index order) of all frames as [n_frames, n_atoms, 3] array")
+      .def(
+          "coords", [](Trajectory::Slice& self, const py::object& dtype) { return slice_coords(self, dtype); },
+          py::arg("dtype") = "float32",
+          "Coordinates of all frames as [n_frames, n_atoms, 3] array, frames are not constructed")
+      .def("to_pdb", pyxmolpp::v1::to_pdb_file<Trajectory::Slice>, py::arg("path_or_buf"),
+           "Write frames as models of multi-model `.pdb` file")
+      .def("to_pdb", pyxmolpp::v1::to_pdb_stream<Trajectory::Slice>, py::arg("path_or_buf"),
+           "Write frames as models of multi-model PDB")
       .def("__len__", &Trajectory::Slice::size)
       .def_property_readonly("n_atoms", &Trajectory::Slice::n_atoms, "Number of atoms in frame")
       .def_property_readonly("n_frames", &Trajectory::Slice::n_frames, "Number of frames")
@@ -95,10 +240,13 @@ void pyxmolpp::v1::populate(py::class_<TrajectoryInputFile, PyTrajectoryInputFil
       .def("n_atoms", &TrajectoryInputFile::n_atoms, "Number of atoms per frame")
       .def("read_frame", &TrajectoryInputFile::read_frame, py::arg("index"), py::arg("frame"),
            "Assign `index` frame coordinates, cell, etc")
+      .def("frame_time", &TrajectoryInputFile::frame_time, py::arg("index"),
+           "Time of `index` frame without reading it, None if unknown")
       .def("advance", &TrajectoryInputFile::advance, "Shift internal data pointer", py::arg("shift"));
 }
 
 void pyxmolpp::v1::PyTrajectoryInputFile::read_frame(size_t index, Frame& frame) {
+  py::gil_scoped_acquire gil; // may be called with GIL released (prefetch, bulk reads)
   py::object pyFrame = py::cast(frame, py::return_value_policy::reference);
   PYBIND11_OVERLOAD_PURE(void,                /* Return type */
                          TrajectoryInputFile, /* Parent class */
@@ -107,7 +255,17 @@ void pyxmolpp::v1::PyTrajectoryInputFile::read_frame(size_t index, Frame& frame)
   );
 }
 
+std::optional<double> pyxmolpp::v1::PyTrajectoryInputFile::frame_time(size_t index) const {
+  py::gil_scoped_acquire gil;
+  PYBIND11_OVERLOAD(std::optional<double>, /* Return type */
+                    TrajectoryInputFile,   /* Parent class */
+                    frame_time,            /* Name of function in C++ (must match Python name) */
+                    index                  /* Argument */
+  );
+}
+
 size_t pyxmolpp::v1::PyTrajectoryInputFile::n_frames() const {
+  py::gil_scoped_acquire gil;
   PYBIND11_OVERLOAD_PURE(size_t,              /* Return type */
                          TrajectoryInputFile, /* Parent class */
                          n_frames             /* Name of function in C++ (must match Python name) */
@@ -115,6 +273,7 @@ size_t pyxmolpp::v1::PyTrajectoryInputFile::n_frames() const {
 }
 
 size_t pyxmolpp::v1::PyTrajectoryInputFile::n_atoms() const {
+  py::gil_scoped_acquire gil;
   PYBIND11_OVERLOAD_PURE(size_t,              /* Return type */
                          TrajectoryInputFile, /* Parent class */
                          n_atoms              /* Name of function in C++ (must match Python name) */
@@ -122,6 +281,7 @@ size_t pyxmolpp::v1::PyTrajectoryInputFile::n_atoms() const {
 }
 
 void pyxmolpp::v1::PyTrajectoryInputFile::advance(size_t shift) {
+  py::gil_scoped_acquire gil;
   PYBIND11_OVERLOAD_PURE(void,                /* Return type */
                          TrajectoryInputFile, /* Parent class */
                          advance,             /* Name of function in C++ (must match Python name) */
@@ -10,6 +10,7 @@ public:
   [[nodiscard]] size_t n_frames() const override;
   [[nodiscard]] size_t n_atoms() const override;
   void read_frame(size_t index, xmol::Frame& frame) override;
+  [[nodiscard]] std::optional<double> frame_time(size_t index) const override;
   void advance(size_t shift) override;
 };
 
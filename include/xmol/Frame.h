@@ -61,6 +61,34 @@ public:
   /// Coordinates of the frame
   [[nodiscard]] proxy::CoordSpan coords();
 
+  /// True if frame stores atom velocities
+  [[nodiscard]] bool has_velocities() const { return m_has_velocities; }
+
+  /// True if frame stores forces acting on atoms
+  [[nodiscard]] bool has_forces() const { return m_has_forces; }
+
+  /// Velocities of the frame atoms, empty if frame has no velocities
+  [[nodiscard]] proxy::VelocitySpan velocities();
+
+  /// Forces acting on the frame atoms, empty if frame has no forces
+  [[nodiscard]] proxy::ForceSpan forces();
+
+  /// @brief Start to store zero-initialized atom velocities, no-op if velocities are present
+  ///
+  /// Trajectory input files fill velocities of frames which have them
+  void add_velocities();
+
+  /// @brief Start to store zero-initialized forces, no-op if forces are present
+  ///
+  /// Trajectory input files fill forces of frames which have them
+  void add_forces();
+
+  /// Drop velocities
+  void remove_velocities();
+
+  /// Drop forces
+  void remove_forces();
+
   /// Current number of smart atom references
   template <typename Smart>[[nodiscard]] size_t n_references() const {
     static_assert(std::is_base_of_v<utils::Observable<Smart>, Frame>);
@@ -145,6 +173,8 @@ private:
   friend proxy::AtomSpan;
   friend proxy::ResidueSpan;
   friend proxy::MoleculeSpan;
+  friend proxy::VelocitySpan;
+  friend proxy::ForceSpan;
 
   friend proxy::CoordSelection;
   friend proxy::AtomSelection;
@@ -169,6 +199,10 @@ private:
   std::vector<BaseResidue> m_residues{};
   std::vector<BaseMolecule> m_molecules{};
   std::vector<XYZ> m_coordinates;
+  std::vector<XYZ> m_velocities; /// per-atom velocities, empty unless m_has_velocities
+  std::vector<XYZ> m_forces;     /// per-atom forces, empty unless m_has_forces
+  bool m_has_velocities = false;
+  bool m_has_forces = false;
 
   void notify_frame_moved(Frame& other);
   void notify_frame_delete() const;
@@ -18,7 +18,7 @@ geom::affine::Rotation3d calc_alignment_precentered_impl(const MatrixA& X, const
     throw geom::GeomError("alignment: reference.size (=" + std::to_string(X.rows()) + ") < 3");
   }
 
-  Eigen::Matrix3d C = X.transpose() * Y;
+  Eigen::Matrix3d C = (X.transpose() * Y).template cast<double>();
 
   Eigen::JacobiSVD<Eigen::Matrix3d> svd(C, Eigen::ComputeFullU | Eigen::ComputeFullV);
 
@@ -37,15 +37,18 @@ geom::affine::Rotation3d calc_alignment_precentered_impl(const MatrixA& X, const
 
 /// Calculate alignment of coordinate matrices
 ///
+/// Single precision matrices are processed in float, only 3x3 correlation matrix is decomposed in double
+///
 /// @tparam MatrixA reference coordinates, Eigen [N*3] matrix or equivalent expression
 /// @tparam MatrixB coordinates to align, Eigen [N*3] matrix or equivalent expression
 template <typename MatrixA, typename MatrixB>
 geom::affine::Transformation3d calc_alignment_impl(const MatrixA& X, const MatrixB& Y) {
-  CoordEigenVector xc = X.colwise().mean();
-  CoordEigenVector yc = Y.colwise().mean();
+  Eigen::Matrix<typename MatrixA::Scalar, 1, 3> xc = X.colwise().mean();
+  Eigen::Matrix<typename MatrixB::Scalar, 1, 3> yc = Y.colwise().mean();
 
   auto R = calc_alignment_precentered_impl(X.rowwise() - xc, Y.rowwise() - yc);
-  auto T = geom::affine::Translation3d(XYZ(xc) - R.transform(XYZ(yc)));
+  auto T = geom::affine::Translation3d(XYZ(xc.template cast<double>()) -
+                                       R.transform(XYZ(yc.template cast<double>())));
 
   return geom::affine::Transformation3d(R, T);
 }
@@ -15,11 +15,18 @@ namespace xmol::algo {
 [[nodiscard]] geom::affine::Transformation3d calc_alignment(proxy::AtomSelection& reference, proxy::AtomSpan& variable);
 [[nodiscard]] geom::affine::Transformation3d calc_alignment(proxy::AtomSelection& reference, proxy::AtomSelection& variable);
 
+/// Alignment of single precision [N, 3] coordinate arrays, e.g. read by @ref trajectory::TrajectoryInputFile::read_coords()
+[[nodiscard]] geom::affine::Transformation3d calc_alignment(const future::Span<float>& reference,
+                                                            const future::Span<float>& variable);
+
 [[nodiscard]] double calc_rmsd(proxy::CoordSpan& reference, proxy::CoordSpan& variable);
 [[nodiscard]] double calc_rmsd(proxy::CoordSpan& reference, proxy::CoordSelection& variable);
 [[nodiscard]] double calc_rmsd(proxy::CoordSelection& reference, proxy::CoordSpan& variable);
 [[nodiscard]] double calc_rmsd(proxy::CoordSelection& reference, proxy::CoordSelection& variable);
 
+/// RMSD of single precision [N, 3] coordinate arrays
+[[nodiscard]] double calc_rmsd(const future::Span<float>& reference, const future::Span<float>& variable);
+
 [[nodiscard]] double calc_weighted_rmsd(proxy::AtomSpan& reference, proxy::AtomSpan& variable);
 [[nodiscard]] double calc_weighted_rmsd(proxy::AtomSpan& reference, proxy::AtomSelection& variable);
 [[nodiscard]] double calc_weighted_rmsd(proxy::AtomSelection& reference, proxy::AtomSpan& variable);
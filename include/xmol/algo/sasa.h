@@ -10,4 +10,10 @@ namespace xmol::algo {
 void calc_sasa(const future::Span<geom::XYZ>& coords, future::Span<double> coord_radii, double solvent_radii,
                future::Span<double> result, int n_samples = 20, const future::Span<int>& sasa_points_indices = {});
 
+/// SASA of single precision [N, 3] coordinate array, e.g. read by @ref trajectory::TrajectoryInputFile::read_coords()
+///
+/// Coordinates are widened once, areas are computed in double precision
+void calc_sasa(const future::Span<float>& coords, future::Span<double> coord_radii, double solvent_radii,
+               future::Span<double> result, int n_samples = 20, const future::Span<int>& sasa_points_indices = {});
+
 }
\ No newline at end of file
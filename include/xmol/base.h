@@ -21,8 +21,8 @@ struct ChainNameTag {};
 
 using AtomId = int32_t;
 using AtomName = xmol::utils::ShortAsciiString<4, false, detail::AtomNameTag>;
-using ResidueName = xmol::utils::ShortAsciiString<3, false, detail::ResidueNameTag>;
-using MoleculeName = xmol::utils::ShortAsciiString<1, false, detail::ChainNameTag>;
+using ResidueName = xmol::utils::ShortAsciiString<5, false, detail::ResidueNameTag>; // PDBx comp ids are up to 5 characters
+using MoleculeName = xmol::utils::ShortAsciiString<4, false, detail::ChainNameTag>;
 
 /// Storage of atomic data except coords
 struct BaseAtom {
@@ -33,6 +33,10 @@ class AtomSpan;
 class ResidueSpan;
 class MoleculeSpan;
 
+class AtomVectorSpan;
+class VelocitySpan;
+class ForceSpan;
+
 /// Reference counting (smart) proxies
 namespace smart {
 
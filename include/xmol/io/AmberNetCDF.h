@@ -6,6 +6,12 @@ namespace xmol::io {
 /**
  * AMBER NetCDF Trajectory
  *
+ * Frames are read in blocks: coordinates, cell and time of several frames are fetched with a single
+ * (strided) request per variable and served from memory afterwards. Blocks are read once two consecutive
+ * shifts of advance() are equal, their stride follows the shift, so `Trajectory::slice` steps are read
+ * without intermediate frames. Otherwise (e.g. random access by seek()) single frames are read.
+ *
+ * Velocities are read only into frames which store them (see Frame::add_velocities()).
  *
  * Format description: https://ambermd.org/netcdf/nctraj.xhtml
  * */
@@ -16,15 +22,32 @@ public:
   AmberNetCDF(AmberNetCDF&&) = default;
   AmberNetCDF& operator=(AmberNetCDF&&) = default;
   explicit AmberNetCDF(std::string filename);
+
+  /// Read up to @p block_frames frames at once, zero means automatic (bounded by buffer size), 1 disables blocks
+  AmberNetCDF(std::string filename, size_t block_frames);
   ~AmberNetCDF();
 
   size_t n_frames() const final;
   size_t n_atoms() const final;
   void read_frame(size_t index, Frame& frame) final;
+  void read_coords(size_t index, const future::Span<float>& coords) final;
+  void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) final;
+  [[nodiscard]] std::optional<double> frame_time(size_t index) const final;
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final;
   void advance(size_t shift) final;
+  void seek(size_t current, size_t index) final;
 
   bool has_cell() const { return m_has_cell; }
 
+  /// True if file contains velocities
+  bool has_velocities() const { return m_has_velocities; }
+
+  /// Maximal number of frames fetched by single read
+  size_t block_frames() const { return m_block_frames; }
+
+  /// Number of blocks fetched from file so far, each block holds from one to block_frames() frames
+  size_t n_block_reads() const { return m_n_block_reads; }
+
 private:
   std::string m_filename;
 
@@ -33,6 +56,11 @@ private:
   mutable bool m_has_cell;
   mutable int m_cell_lengths_id;
   mutable int m_cell_angles_id;
+  mutable bool m_has_time;
+  mutable int m_time_id;
+  mutable bool m_has_velocities;
+  mutable int m_velocities_id;
+  float m_velocities_scale = 1; /// `scale_factor` of velocities, converts them to angstrom/picosecond
   mutable bool m_is_open = false;
 
   size_t m_current_frame = 0;
@@ -40,10 +68,32 @@ private:
   size_t m_n_atoms = 0;
 
   std::vector<float> m_buffer;
+  std::vector<float> m_times; /// times of all frames, empty if file has no `time` variable
+
+  /// Frames `begin + i * stride` for `i` in `[0, size)`
+  struct Block {
+    size_t begin = 0;
+    size_t stride = 1;
+    size_t size = 0;
+    std::vector<float> coords;
+    std::vector<float> cell_lengths;
+    std::vector<float> cell_angles;
+    std::vector<float> time;
+    std::vector<float> velocities; /// empty unless requested by read
+  };
+  size_t m_block_frames = 0;
+  size_t m_stride = 0;           /// last shift between consequent reads, zero if unknown
+  size_t m_confirmed_stride = 0; /// shift repeated by two last advances, zero if there is no regular stride
+  size_t m_n_block_reads = 0;
+  bool m_read_since_advance = false;
+  Block m_block;
 
   void open();
   void close();
   void read_header();
+  void read_cell_and_time(Frame& frame);
+  size_t block_position(size_t frame_index, bool with_velocities);
+  void read_atom_runs(int var_id, const std::vector<AtomIndex>& atoms, float* dst);
   void print_info();
   std::string read_global_string_attr(const char* name);
 };
@@ -0,0 +1,79 @@
+#pragma once
+#include "xmol/fwd.h"
+#include "xmol/future/span.h"
+
+#include <string>
+#include <vector>
+
+namespace xmol::io {
+
+/**
+ * Writes frames to AMBER NetCDF Trajectory
+ *
+ * Output follows AMBER conventions (coordinates and cell in angstroms, cell angles in degrees,
+ * time in picoseconds, velocities in angstrom/picosecond), frame dimension is unlimited,
+ * per-frame variables are chunked by frame (netCDF-4 format).
+ * Frames are buffered and stored by one `nc_put_vara_*` call per variable for several frames.
+ *
+ * Format description: https://ambermd.org/netcdf/nctraj.xhtml
+ * */
+class AmberNetCDFWriter {
+public:
+  AmberNetCDFWriter(const AmberNetCDFWriter&) = delete;
+  AmberNetCDFWriter& operator=(const AmberNetCDFWriter&) = delete;
+
+  /// Create (or overwrite) @p filename, @p buffer_frames frames are kept in memory between writes to disk
+  explicit AmberNetCDFWriter(std::string filename, size_t buffer_frames = 16);
+
+  /// Flushes buffered frames and closes the file
+  ~AmberNetCDFWriter();
+
+  /** Write coordinates, cell and time of @p frame, velocities are written if frame has them
+   *
+   * Cell variables are defined only if first frame has a cell (unit cubic cell stands for absent cell),
+   * all frames must agree with first frame on presence of velocities and cell
+   * */
+  void write(Frame& frame);
+
+  /// Write coordinates, cell and time of @p frame along with flat @p velocities (angstrom/picosecond)
+  void write(Frame& frame, const future::Span<const float>& velocities);
+
+  /// Store buffered frames to file
+  void flush();
+
+  /// Flush buffered frames and close file, subsequent writes throw
+  void close();
+
+  /// Number of written frames (including buffered ones)
+  [[nodiscard]] size_t n_frames() const { return m_n_stored + m_n_buffered; }
+
+private:
+  std::string m_filename;
+  size_t m_buffer_frames;
+  size_t m_n_atoms = 0;
+  size_t m_n_stored = 0;
+  size_t m_n_buffered = 0;
+  bool m_is_open = false;
+  bool m_is_defined = false;
+  bool m_has_velocities = false;
+  bool m_has_cell = false;
+
+  int m_ncid = -1;
+  int m_time_id = -1;
+  int m_coords_id = -1;
+  int m_velocities_id = -1;
+  int m_cell_lengths_id = -1;
+  int m_cell_angles_id = -1;
+
+  std::vector<float> m_time;
+  std::vector<float> m_coords;
+  std::vector<float> m_velocities;
+  std::vector<double> m_cell_lengths;
+  std::vector<double> m_cell_angles;
+  std::vector<float> m_frame_velocities; /// single precision copy of frame velocities
+
+  void define(size_t n_atoms, bool has_velocities, bool has_cell);
+  void append(Frame& frame, const float* velocities);
+};
+
+} // namespace xmol::io
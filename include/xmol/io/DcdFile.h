@@ -0,0 +1,69 @@
+#pragma once
+#include "xmol/trajectory/TrajectoryFile.h"
+#include "xmol/utils/MappedFile.h"
+#include <memory>
+
+namespace xmol::io {
+
+/** CHARMM/NAMD/X-PLOR DCD trajectory
+ *
+ * File is memory-mapped, frames have fixed size after first one, so any frame is accessed in O(1).
+ * Both byte orders and 32/64-bit Fortran record markers are supported.
+ * Unit cell (CHARMM format) and fixed atoms (stored in first frame only) are read, 4th dimension is ignored.
+ *
+ * Format description: https://www.ks.uiuc.edu/Research/vmd/plugins/molfile/dcdplugin.html
+ */
+class DcdFile : public trajectory::TrajectoryInputFile {
+public:
+  explicit DcdFile(std::string filename);
+  [[nodiscard]] size_t n_frames() const final;
+  [[nodiscard]] size_t n_atoms() const final;
+  void read_frame(size_t index, Frame& frame) final;
+  void read_coords(size_t index, const future::Span<float>& coords) final;
+  void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) final;
+  [[nodiscard]] std::optional<double> frame_time(size_t index) const final;
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final;
+  void advance(size_t shift) final;
+  void seek(size_t current, size_t index) final;
+
+  /// True if frames contain unit cell
+  [[nodiscard]] bool has_cell() const { return m_has_cell; }
+
+  /// Number of atoms which are stored in first frame only
+  [[nodiscard]] size_t n_fixed_atoms() const { return m_n_atoms - m_free_atoms.size(); }
+
+  /// True if file byte order differs from native one
+  [[nodiscard]] bool is_byte_swapped() const { return m_swap_bytes; }
+
+private:
+  DcdFile() = default;
+
+  std::string m_filename;
+  std::shared_ptr<const utils::MappedFile> m_mapping;
+  bool m_swap_bytes = false;
+  size_t m_marker_size = 4;
+  bool m_has_cell = false;
+  bool m_has_4d = false;
+  size_t m_n_atoms = 0;
+  size_t m_n_frames = 0;
+  size_t m_current_frame = 0;
+
+  size_t m_first_frame_offset = 0;
+  size_t m_first_frame_size = 0;
+  size_t m_frame_size = 0;
+
+  int32_t m_first_step = 0;
+  int32_t m_steps_per_frame = 0;
+  double m_timestep = 0; // in ps
+
+  std::vector<int32_t> m_free_atoms;                        /// indices of non-fixed atoms, all atoms if none fixed
+  std::vector<int32_t> m_free_position;                     /// position of atom in m_free_atoms, -1 for fixed
+  std::shared_ptr<const std::vector<float>> m_first_coords; /// first frame coords [n_atoms, 3], if atoms are fixed
+
+  void read_header();
+  const utils::MappedFile& mapping();
+  [[nodiscard]] const char* frame_data(size_t index);
+  template <typename T> void load_coords(size_t index, const std::vector<AtomIndex>* atoms, T* dst);
+  void read_cell_and_time(size_t index, Frame& frame);
+};
+} // namespace xmol::io
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "xmol/Frame.h"
+#include "xmol/io/xdr/FrameOffsetIndex.h"
+#include "xmol/io/xdr/TrrReader.h"
+#include "xmol/trajectory/TrajectoryFile.h"
+
+#include <array>
+#include <vector>
+
+namespace xmol::io {
+
+class TrrReadError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/** Gromacs `.trr` input file
+ *
+ * Coordinates are stored uncompressed in single or double precision, frames may carry velocities and forces.
+ * Frame offsets are collected on construction by a single pass over frame headers,
+ * which makes @ref advance() a plain seek.
+ *
+ * Velocities (in Å/ps) and forces (in kJ/mol/Å) are read only into frames which store them
+ * (see Frame::add_velocities() and Frame::add_forces()), otherwise they are skipped.
+ * Frames without coordinates (written by Gromacs when `nstvout` or `nstfout` differs from `nstxout`)
+ * are not part of trajectory, their velocities and forces are not read
+ * */
+class GromacsTrrFile : public trajectory::TrajectoryInputFile {
+public:
+  /// Open file and scan it for frame offsets
+  explicit GromacsTrrFile(std::string filename);
+
+  /** Open file and use frame offsets stored in @p index_filename
+   *
+   * If index file is missing or outdated the trajectory is scanned and index is (re)written
+   * */
+  GromacsTrrFile(std::string filename, std::string index_filename);
+
+  [[nodiscard]] size_t n_frames() const final;
+  [[nodiscard]] size_t n_atoms() const final;
+  void read_frame(size_t index, Frame& frame) final;
+  void read_coords(size_t index, const future::Span<float>& coords) final;
+  void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) final;
+  [[nodiscard]] std::optional<double> frame_time(size_t index) const final;
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final;
+  void advance(size_t shift) final;
+  void seek(size_t current, size_t index) final;
+
+  /// True if first frame is stored in double precision
+  [[nodiscard]] bool is_double_precision() const { return m_first_header.is_double; }
+
+  /// True if first frame contains velocities
+  [[nodiscard]] bool has_velocities() const { return m_first_header.has_velocities(); }
+
+  /// True if first frame contains forces
+  [[nodiscard]] bool has_forces() const { return m_first_header.has_forces(); }
+
+private:
+  GromacsTrrFile() = default;
+
+  std::string m_filename;
+  std::unique_ptr<xdr::TrrReader> m_reader;
+  std::vector<double> m_buffer;
+  std::vector<double> m_velocities;
+  std::vector<double> m_forces;
+  xdr::FrameOffsetIndex m_offsets;
+  xdr::TrrHeader m_first_header;
+  size_t m_ahead_of_current_frame = 0;
+  size_t m_current_frame = 0;
+
+  void scan_offsets();
+  void read_first_header();
+  xdr::TrrHeader read_frame_data(size_t index, std::array<double, 9>& box, bool with_velocities, bool with_forces);
+  void assign_frame(const xdr::TrrHeader& header, const std::array<double, 9>& box,
+                    const std::vector<AtomIndex>* atoms, Frame& frame);
+};
+
+} // namespace xmol::io
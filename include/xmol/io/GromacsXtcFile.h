@@ -1,9 +1,11 @@
 #pragma once
 
 #include "xmol/Frame.h"
+#include "xmol/io/xdr/FrameOffsetIndex.h"
 #include "xmol/io/xdr/XtcReader.h"
 #include "xmol/trajectory/TrajectoryFile.h"
 
+#include <array>
 #include <vector>
 
 namespace xmol::io {
@@ -13,24 +15,60 @@ public:
   using std::runtime_error::runtime_error;
 };
 
-/// Gromacs `.xtc` input file
+/** Gromacs `.xtc` input file
+ *
+ * Frame offsets are collected on construction by a single pass over frame headers,
+ * which makes @ref advance() a plain seek.
+ * */
 class GromacsXtcFile : public trajectory::TrajectoryInputFile {
 public:
-  explicit GromacsXtcFile(std::string filename, size_t n_frames);
+  /// Open file and scan it for frame offsets
+  explicit GromacsXtcFile(std::string filename);
+
+  /** Open file and use frame offsets stored in @p index_filename
+   *
+   * If index file is missing or outdated the trajectory is scanned and index is (re)written
+   * */
+  GromacsXtcFile(std::string filename, std::string index_filename);
+
+  /// Open file and use first @p n_frames frames only
+  GromacsXtcFile(std::string filename, size_t n_frames);
 
   [[nodiscard]] size_t n_frames() const final;
   [[nodiscard]] size_t n_atoms() const final;
   void read_frame(size_t index, Frame& frame) final;
+  void read_coords(size_t index, const future::Span<float>& coords) final;
+  void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) final;
+  [[nodiscard]] std::optional<double> frame_time(size_t index) const final;
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final;
   void advance(size_t shift) final;
+  void seek(size_t current, size_t index) final;
+
+  /** Decode every @p stride 'th frame of [@p begin, @p end) range in parallel
+   *
+   * Coordinates are written to @p out as contiguous [n_selected_frames, n_atoms, 3] array in angstroms.
+   * Frames are split across @p n_threads workers, each worker reads via own file handle and decompression
+   * buffers, so sequential read position of this file is not affected.
+   *
+   * Zero @p n_threads stands for std::thread::hardware_concurrency()
+   * */
+  void read_frames(size_t begin, size_t end, size_t stride, float* out, size_t n_threads = 0) const;
 
 private:
+  GromacsXtcFile() = default;
+
   std::string m_filename;
   std::unique_ptr<xdr::XtcReader> m_reader;
   std::vector<float> m_buffer;
-  int m_ahead_of_current_frame = 0;
+  xdr::FrameOffsetIndex m_offsets;
+  size_t m_ahead_of_current_frame = 0;
   size_t m_current_frame = 0;
-  size_t m_n_frames = 0;
   size_t m_n_atoms = 0;
+
+  void scan_offsets();
+  xdr::XtcHeader read_frame_data(size_t index, std::array<float, 9>& box, const future::Span<float>& coords,
+                                 size_t max_atoms = SIZE_MAX);
+  void read_n_atoms();
 };
 
-} // namespace xmol::io
\ No newline at end of file
+} // namespace xmol::io
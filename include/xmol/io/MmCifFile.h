@@ -0,0 +1,47 @@
+#pragma once
+#include "xmol/io/cif/CifBufferReader.h"
+#include "xmol/trajectory/TrajectoryFile.h"
+#include "xmol/utils/MappedFile.h"
+#include <memory>
+
+namespace xmol::io {
+
+/** mmCIF (PDBx) file read as trajectory, one model at a time
+ *
+ * Unlike PDB format, mmCIF has no limits on number of atoms and residues, so it's the format of large entries.
+ * File is memory-mapped and indexed on construction (see cif::CifBufferReader), models are read directly into
+ * caller's Frame. Topology of models is not checked, only number of atoms.
+ * */
+class MmCifFile : public trajectory::TrajectoryInputFile {
+public:
+  explicit MmCifFile(std::string filename);
+  MmCifFile(MmCifFile&& other) = default;
+  [[nodiscard]] size_t n_frames() const final;
+  [[nodiscard]] size_t n_atoms() const final;
+  void read_frame(size_t index, Frame& frame) final;
+  void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) final;
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final;
+  void advance(size_t shift) final;
+  void seek(size_t current, size_t index) final;
+
+  /// Read @p index frame with topology, doesn't depend on current position
+  [[nodiscard]] Frame frame(size_t index) const;
+
+  /// Read all frames with topology
+  [[nodiscard]] std::vector<Frame> frames() const;
+
+private:
+  MmCifFile(const MmCifFile& other);
+
+  std::string m_filename;
+  std::shared_ptr<const cif::CifBufferReader> m_reader;
+  std::shared_ptr<const utils::MappedFile> m_mapping;
+  size_t m_n_atoms = 0;
+  size_t m_current_frame = 0;
+  std::vector<XYZ> m_coords; /// coordinates of last read frame
+
+  const utils::MappedFile& mapping();
+  void load_coords(size_t index);
+};
+
+} // namespace xmol::io
@@ -1,6 +1,8 @@
 #pragma once
 #include "xmol/Frame.h"
+#include "xmol/io/pdb/PdbRecord_fwd.h"
 #include "xmol/trajectory/TrajectoryFile.h"
+#include <memory>
 #include <vector>
 
 namespace xmol::io {
@@ -19,22 +21,38 @@ public:
     AMBER_99     /// compatibility with AMBER tools
   };
 
-  explicit PdbInputFile(std::string filename, Dialect dialect = Dialect::STANDARD_V3, bool read_now=true);
+  /** @param n_threads number of threads to read models of multi-model file with,
+   *  zero stands for std::thread::hardware_concurrency()
+   * */
+  explicit PdbInputFile(std::string filename, Dialect dialect = Dialect::STANDARD_V3, bool read_now = true,
+                        size_t n_threads = 1);
+  PdbInputFile(PdbInputFile&& other) = default;
   PdbInputFile& read();
-  [[nodiscard]] const std::vector<Frame>& frames() const { return m_frames; }
+
+  /// Records of @p dialect
+  [[nodiscard]] static pdb::AlteredPdbRecords records(Dialect dialect);
+
+  /// Read frames, empty when file is closed (advanced past the last frame)
+  [[nodiscard]] const std::vector<Frame>& frames() const;
 
   [[nodiscard]] size_t n_frames() const final;
   [[nodiscard]] size_t n_atoms() const final;
   void read_frame(size_t index, Frame& frame) final;
+  /// Copy shares already read frames with this file
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final;
   void advance(size_t shift) final;
+  void seek(size_t current, size_t index) final;
 
 private:
+  PdbInputFile(const PdbInputFile& other);
+
   std::string m_filename;
-  std::vector<Frame> m_frames;
+  std::shared_ptr<const std::vector<Frame>> m_frames; /// read frames, shared with copies, `nullptr` if file is closed
   size_t m_current_frame=0;
   size_t m_n_frames=0;
   size_t m_n_atoms=0;
   Dialect m_dialect;
+  size_t m_n_threads;
 };
 
 } // namespace xmol::io
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include "xmol/io/PdbInputFile.h"
+#include "xmol/io/pdb/PdbBufferReader.h"
+#include "xmol/utils/MappedFile.h"
+#include <memory>
+
+namespace xmol::io {
+
+/** Multi-model PDB file read as trajectory, one model at a time
+ *
+ * File is memory-mapped and indexed by MODEL records on construction, frames are the same as of PdbInputFile.
+ * Frames are read directly into caller's Frame, so memory usage doesn't grow with number of models.
+ * Topology of frames is not checked, only number of atoms.
+ * */
+class PdbTrajectoryFile : public trajectory::TrajectoryInputFile {
+public:
+  explicit PdbTrajectoryFile(std::string filename, PdbInputFile::Dialect dialect = PdbInputFile::Dialect::STANDARD_V3);
+  PdbTrajectoryFile(PdbTrajectoryFile&& other) = default;
+  [[nodiscard]] size_t n_frames() const final;
+  [[nodiscard]] size_t n_atoms() const final;
+  void read_frame(size_t index, Frame& frame) final;
+  void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) final;
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final;
+  void advance(size_t shift) final;
+  void seek(size_t current, size_t index) final;
+
+  /// Read @p index frame with topology, doesn't depend on current position
+  [[nodiscard]] Frame frame(size_t index) const;
+
+private:
+  using Index = std::vector<pdb::PdbBufferReader::FrameLocation>;
+
+  PdbTrajectoryFile(const PdbTrajectoryFile& other);
+
+  std::string m_filename;
+  pdb::PdbBufferReader m_reader;
+  std::shared_ptr<const Index> m_index;
+  std::shared_ptr<const utils::MappedFile> m_mapping;
+  size_t m_n_atoms = 0;
+  size_t m_current_frame = 0;
+  std::vector<XYZ> m_coords; /// coordinates of last read frame
+
+  const utils::MappedFile& mapping();
+  void load_coords(size_t index);
+};
+
+} // namespace xmol::io
@@ -1,10 +1,13 @@
 #pragma once
 #include "xmol/trajectory/TrajectoryFile.h"
-#include <fstream>
+#include "xmol/utils/MappedFile.h"
+#include <memory>
 
 namespace xmol::io {
 
 /// 3d MD coordinates in "trjtool .dat" format
+///
+/// File is memory-mapped, both little- and big-endian files are supported
 class TrjtoolDatFile : public trajectory::TrajectoryInputFile {
   struct Header {
     int32_t nitems;
@@ -12,27 +15,42 @@ class TrjtoolDatFile : public trajectory::TrajectoryInputFile {
     int32_t dtype;
   };
 
-  union HeaderUnion {
-    Header header;
-    char bytes[sizeof(Header)];
-  };
-
 public:
   explicit TrjtoolDatFile(std::string filename);
   [[nodiscard]] size_t n_frames() const final;
   [[nodiscard]] size_t n_atoms() const final;
   void read_frame(size_t index, Frame& frame) final;
+  void read_coords(size_t index, const future::Span<float>& coords) final;
+  void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) final;
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final;
   void advance(size_t shift) final;
+  void seek(size_t current, size_t index) final;
+
+  /** Raw float32 coordinates of frame @p index as stored in file, [n_atoms, 3] in angstroms, no copy is made
+   *
+   * Values have file byte order (see @ref is_byte_swapped()), pointer is not necessarily aligned to `float`.
+   * Data stays valid as long as @ref mapping() is alive
+   */
+  [[nodiscard]] const char* raw_frame(size_t index);
+
+  /// Shared mapping of file, maps file if it's not mapped yet
+  [[nodiscard]] std::shared_ptr<const utils::MappedFile> mapping();
+
+  /// True if file byte order differs from native one
+  [[nodiscard]] bool is_byte_swapped() const { return m_swap_bytes; }
 
 private:
+  TrjtoolDatFile() = default;
+
   std::string m_filename;
-  std::unique_ptr<std::istream> m_stream;
+  std::shared_ptr<const utils::MappedFile> m_mapping;
   Header m_header;
-  std::vector<float> m_buffer;
+  bool m_swap_bytes = false;
   size_t m_n_frames;
   size_t m_current_frame = 0;
-  std::streampos m_offset;
+  size_t m_offset;
 
   void read_header();
+  [[nodiscard]] size_t frame_size_bytes() const;
 };
-} // namespace xmol::trajectory
\ No newline at end of file
+} // namespace xmol::trajectory
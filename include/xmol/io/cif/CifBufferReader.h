@@ -0,0 +1,66 @@
+#pragma once
+#include "xmol/Frame.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xmol::io::cif {
+
+/** Reader of atoms (`_atom_site` loop) of mmCIF (PDBx) text held in memory (e.g. mapped file)
+ *
+ * Text is indexed on construction: `_atom_site` columns are mapped to atom fields once
+ * and models (`pdbx_PDB_model_num`) are located, so any model can be read without reading preceding ones.
+ * Tokens are parsed in place, frames are built with exact reservation of atoms, residues and molecules.
+ *
+ * Author names and numbers (`auth_*`) are used where present, `label_*` ones otherwise.
+ * New molecule starts when chain (`auth_asym_id` or `label_asym_id`) changes,
+ * new residue starts when residue id (sequence number and insertion code) changes, as in PdbReader.
+ * Cell is set from `_cell` lengths and angles, unit cubic cell is used if they are absent.
+ *
+ * Only first data block is read, methods must be called with the same text as constructor
+ * (it may reside at another address, e.g. in a new mapping of the same file)
+ * */
+class CifBufferReader {
+public:
+  CifBufferReader(const char* begin, const char* end);
+
+  /// Number of models
+  [[nodiscard]] size_t n_frames() const { return m_models.size(); }
+
+  /// Number of atoms of @p index model
+  [[nodiscard]] size_t n_atoms(size_t index) const { return m_models.at(index).n_atoms; }
+
+  /// Cell of all models
+  [[nodiscard]] const xmol::geom::UnitCell& cell() const { return m_cell; }
+
+  /// Read all models of text `[begin, end)`
+  [[nodiscard]] std::vector<xmol::Frame> read_frames(const char* begin, const char* end) const;
+
+  /// Read @p index model of text `[begin, end)`
+  [[nodiscard]] xmol::Frame read_frame(const char* begin, const char* end, size_t index) const;
+
+  /// Read only atom coordinates of @p index model of text `[begin, end)`
+  void read_coords(const char* begin, const char* end, size_t index, std::vector<xmol::XYZ>& coords) const;
+
+private:
+  /// Atom field stored in `_atom_site` column
+  enum class Field { NONE, ID, NAME, RESIDUE_NAME, CHAIN, ENTITY_CHAIN, RESIDUE_SERIAL, INSERTION_CODE, X, Y, Z };
+
+  /// Location of model in text
+  struct Model {
+    size_t offset;  /// offset of first `_atom_site` row of model
+    size_t n_atoms; /// number of rows of model
+  };
+
+  class Tokenizer;
+
+  /// Map `_atom_site` columns @p tags to fields, returns column of model number (std::string_view::npos if absent)
+  size_t map_columns(const std::vector<std::string_view>& tags, const Tokenizer& tokens);
+
+  std::vector<Field> m_columns;     /// fields of `_atom_site` columns
+  std::vector<std::string> m_names; /// names of `_atom_site` columns, for error messages
+  std::vector<Model> m_models;
+  xmol::geom::UnitCell m_cell;
+};
+
+} // namespace xmol::io::cif
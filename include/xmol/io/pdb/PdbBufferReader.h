@@ -0,0 +1,68 @@
+#pragma once
+#include "xmol/Frame.h"
+#include <vector>
+
+namespace xmol::io::pdb {
+
+class basic_PdbRecords;
+
+/** Fast reader of PDB text held in memory (e.g. mapped file)
+ *
+ * Column ranges of ATOM/HETATM/CRYST1 fields are resolved once from the records table,
+ * lines are parsed in place and frames are built with exact reservation of atoms, residues and molecules.
+ * Frames are split into molecules and residues the same way as by PdbReader,
+ * records which are not used for frame construction are skipped without table lookup.
+ *
+ * Models which have the same ATOM/HETATM/TER records as preceding one (except coordinates) are read
+ * as copies of it with new coordinates. Multi-model text can be split at MODEL records and read in parallel.
+ * */
+class PdbBufferReader {
+public:
+  explicit PdbBufferReader(const basic_PdbRecords& db);
+
+  /** Read all frames of PDB text `[begin, end)`
+   *
+   * @param n_threads number of threads to read models with, zero stands for std::thread::hardware_concurrency()
+   * */
+  [[nodiscard]] std::vector<xmol::Frame> read_frames(const char* begin, const char* end, size_t n_threads = 1) const;
+
+  /// Location of frame in PDB text
+  struct FrameLocation {
+    size_t offset;             /// offset of first record of frame (MODEL or ATOM/HETATM)
+    xmol::geom::UnitCell cell; /// cell of last preceding CRYST1 record
+  };
+
+  /// Locate frames of PDB text `[begin, end)` without reading them, frames are the same as of read_frames()
+  [[nodiscard]] std::vector<FrameLocation> index_frames(const char* begin, const char* end) const;
+
+  /// Read frame at @p location of PDB text `[begin, end)`
+  [[nodiscard]] xmol::Frame read_frame(const char* begin, const char* end, const FrameLocation& location) const;
+
+  /// Read only atom coordinates of frame at @p location of PDB text `[begin, end)`
+  void read_coords(const char* begin, const char* end, const FrameLocation& location,
+                   std::vector<xmol::XYZ>& coords) const;
+
+private:
+  /// Zero-based column range of field
+  struct Field {
+    int first;
+    int size;
+  };
+
+  /// Fields of ATOM or HETATM record
+  struct AtomFields {
+    Field serial, name, resName, chainID, resSeq, iCode, x, y, z;
+  };
+
+  struct CellFields {
+    Field a, b, c, alpha, beta, gamma;
+  };
+
+  class Parser;
+
+  AtomFields m_atom;
+  AtomFields m_hetatm;
+  CellFields m_cryst1;
+};
+
+} // namespace xmol::io::pdb
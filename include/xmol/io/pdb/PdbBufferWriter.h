@@ -0,0 +1,81 @@
+#pragma once
+#include "xmol/trajectory/Trajectory.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace xmol::io::pdb {
+
+class basic_PdbRecords;
+
+/** Fast writer of PDB text, output is byte-identical to PdbWriter
+ *
+ * Column ranges of ATOM/CRYST1 fields are resolved once from the records table, fields are formatted
+ * without iostreams and locale into a buffer which is written to the stream when it exceeds buffer size.
+ * ATOM records are formatted once per topology, frames differ in coordinates (and cell) only.
+ * */
+class PdbBufferWriter {
+public:
+  /// Writer of standard PDB records to @p out
+  explicit PdbBufferWriter(std::ostream& out, size_t buffer_size = 1 << 20);
+
+  /// Writer of @p db records to @p out
+  PdbBufferWriter(std::ostream& out, const basic_PdbRecords& db, size_t buffer_size = 1 << 20);
+
+  PdbBufferWriter(const PdbBufferWriter&) = delete;
+  PdbBufferWriter& operator=(const PdbBufferWriter&) = delete;
+
+  /// Flushes buffered text
+  ~PdbBufferWriter();
+
+  /// Write @p frame, same as PdbWriter::write(Frame&)
+  void write(xmol::Frame& frame);
+
+  /** Write frames of @p slice as models of multi-model PDB
+   *
+   * Each frame is written as by write(Frame&) enclosed in MODEL/ENDMDL records,
+   * models are numbered from 1, CRYST1 record (if any) precedes MODEL one
+   * */
+  void write(xmol::trajectory::Trajectory::Slice slice);
+
+  /// Write buffered text to stream
+  void flush();
+
+private:
+  /// Zero-based column range of field
+  struct Field {
+    int first;
+    int size;
+  };
+
+  struct AtomFields {
+    Field serial, name, resName, chainID, resSeq, iCode, x, y, z;
+  };
+
+  struct CellFields {
+    Field a, b, c, alpha, beta, gamma;
+  };
+
+  /// Offset and length (without newline) of ATOM record in m_topology
+  struct AtomLine {
+    size_t offset;
+    size_t size;
+  };
+
+  void set_topology(xmol::Frame& frame);
+  void write_cell(xmol::Frame& frame);
+  void write_atoms(xmol::Frame& frame);
+  void write_model(xmol::Frame& frame, size_t serial);
+  void reserve(size_t n);
+
+  std::ostream* m_ostream;
+  AtomFields m_atom;
+  CellFields m_cryst1;
+  size_t m_buffer_size;
+  std::string m_buffer;
+  std::string m_topology;          /// ATOM and TER records of frame with blank coordinates
+  std::vector<AtomLine> m_atom_lines; /// ATOM records of m_topology
+};
+
+} // namespace xmol::io::pdb
@@ -13,4 +13,5 @@ using RecordName = utils::ShortAsciiString<6, false, detail::RecordTypeNameTag>;
 using FieldName = utils::ShortAsciiString<8, true, detail::RecordFieldNameTag>;
 
 class basic_PdbRecords;
+class AlteredPdbRecords;
 } // namespace xmol::io::pdb
\ No newline at end of file
@@ -18,6 +18,11 @@ public:
   using PdbException::PdbException;
 };
 
+class PdbWriteError : public PdbException {
+public:
+  using PdbException::PdbException;
+};
+
 class PdbFieldReadError : public PdbException {
 public:
   PdbFieldReadError(const std::string& what, int colon_l, int colon_r)
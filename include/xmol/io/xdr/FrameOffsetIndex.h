@@ -0,0 +1,56 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace xmol::io::xdr {
+
+/** Byte offsets and times of frames in a trajectory file
+ *
+ * Index may be persisted to a sidecar file. Persisted index is stamped with size and modification time
+ * of the trajectory file and considered outdated if any of them changes.
+ * */
+class FrameOffsetIndex {
+public:
+  /// Number of indexed frames
+  [[nodiscard]] size_t n_frames() const { return m_offsets.size(); }
+
+  /// Byte offset of @p i 'th frame
+  [[nodiscard]] std::int64_t operator[](size_t i) const { return m_offsets[i]; }
+
+  /// Time of @p i 'th frame
+  [[nodiscard]] double time(size_t i) const { return m_times[i]; }
+
+  /// Append offset and time of next frame
+  void push_back(std::int64_t offset, double time) {
+    m_offsets.push_back(offset);
+    m_times.push_back(time);
+  }
+
+  /// Keep first @p n_frames frames only
+  void truncate(size_t n_frames) {
+    m_offsets.resize(std::min(n_frames, m_offsets.size()));
+    m_times.resize(m_offsets.size());
+  }
+
+  /** Write index to @p index_filename
+   *
+   * Returns false if index can't be written (e.g. directory is read-only)
+   * */
+  bool save(const std::string& index_filename, const std::string& trajectory_filename) const;
+
+  /** Read index from @p index_filename
+   *
+   * Returns nullopt if index file is missing, corrupted or outdated
+   * */
+  static std::optional<FrameOffsetIndex> load(const std::string& index_filename,
+                                              const std::string& trajectory_filename);
+
+private:
+  std::vector<std::int64_t> m_offsets;
+  std::vector<double> m_times;
+};
+
+} // namespace xmol::io::xdr
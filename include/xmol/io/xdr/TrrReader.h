@@ -0,0 +1,92 @@
+#pragma once
+#include "FrameOffsetIndex.h"
+#include "XdrHandle.h"
+#include "xmol/future/span.h"
+#include <cstdint>
+#include <vector>
+
+namespace xmol::io::xdr {
+
+struct TrrHeader {
+  int n_atoms = 0;
+  int step = 0;
+  int n_energies = 0;
+  double time = 0;
+  double lambda = 0;
+
+  /// Sizes of frame blocks in bytes, zero if block is absent
+  int box_size = 0;
+  int vir_size = 0;
+  int pres_size = 0;
+  int x_size = 0;
+  int v_size = 0;
+  int f_size = 0;
+
+  /// True if real values are stored in double precision
+  bool is_double = false;
+
+  [[nodiscard]] int real_size() const { return is_double ? sizeof(double) : sizeof(float); }
+  [[nodiscard]] bool has_box() const { return box_size != 0; }
+  [[nodiscard]] bool has_coords() const { return x_size != 0; }
+  [[nodiscard]] bool has_velocities() const { return v_size != 0; }
+  [[nodiscard]] bool has_forces() const { return f_size != 0; }
+
+  /// Size of frame payload which follows header, in bytes
+  [[nodiscard]] std::int64_t data_size() const {
+    return std::int64_t(box_size) + vir_size + pres_size + x_size + v_size + f_size;
+  }
+};
+
+/** @file
+ *
+ *  `.trr` file layout is simply byte-wise concatenation of frames.
+ *
+ *  Frame layout is following:
+ *
+ *      int[1] “magic” (1993)
+ *      int[1] “version string length + 1”
+ *      string “version” (xdr string: int length, chars padded to 4 bytes)
+ *      int[13] “ir_size, e_size, box_size, vir_size, pres_size, top_size, sym_size,
+ *               x_size, v_size, f_size, natoms, step, nre”
+ *      real[2] “t, lambda”
+ *      real[9] “box” (if box_size != 0)
+ *      real[9] “virial” (if vir_size != 0)
+ *      real[9] “pressure” (if pres_size != 0)
+ *      real[natoms*3] “x” (if x_size != 0)
+ *      real[natoms*3] “v” (if v_size != 0)
+ *      real[natoms*3] “f” (if f_size != 0)
+ *
+ *  Real is either float or double, precision is deduced from block sizes.
+ * */
+class TrrReader {
+public:
+  explicit TrrReader(const std::string& filename) : m_xdr(filename, XdrHandle::Mode::READ) {}
+
+  auto read_header(TrrHeader& header) -> Status;
+
+  /** Read payload of frame described by @p header
+   *
+   * Blocks are stored to corresponding spans (values are converted to double if file is single precision).
+   * Empty span stands for skip of the block, blocks absent in frame leave spans untouched.
+   * Virial and pressure are always skipped.
+   * */
+  auto read_data(const TrrHeader& header, const future::Span<double>& box, const future::Span<double>& x,
+                 const future::Span<double>& v, const future::Span<double>& f) -> Status;
+  auto skip_data(const TrrHeader& header) -> Status;
+  auto advance(size_t n_frames) -> Status;      /// Skip n_frame frames
+  /// Collect offsets of remaining frames with coordinates into index, last frame cut by end of file is skipped,
+  /// corrupted frames are errors
+  auto scan(FrameOffsetIndex& index) -> Status;
+  [[nodiscard]] auto tell() const -> std::int64_t { return m_xdr.tell(); } /// Current byte offset
+  auto seek(std::int64_t offset) -> Status; /// Move to frame which starts at @p offset
+  [[nodiscard]] const char* last_error() const { return m_error_str; };
+
+private:
+  auto read_block(const TrrHeader& header, int block_size, size_t n_reals, const future::Span<double>& dst)
+      -> Status;
+  XdrHandle m_xdr;
+  const char* m_error_str = "";
+  std::vector<float> m_float_buffer;
+};
+
+} // namespace xmol::io::xdr
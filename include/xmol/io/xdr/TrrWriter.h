@@ -0,0 +1,50 @@
+#pragma once
+
+#include "TrrReader.h"
+#include "XdrHandle.h"
+#include "xmol/fwd.h"
+
+namespace xmol::io {
+
+class TrrWriteError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+namespace xdr {
+
+/** Writes frames in Gromacs `.trr` format
+ *
+ * Coordinates are stored without compression in single or double precision along with box,
+ * optional velocities and forces.
+ * */
+class TrrWriter {
+public:
+  explicit TrrWriter(const std::string& filename, bool double_precision = false)
+      : m_xdr(filename, XdrHandle::Mode::WRITE), m_double_precision(double_precision){};
+
+  /// Write frame coordinates, cell, time, index (as step) and velocities/forces if frame has them
+  void write(xmol::Frame& frame);
+
+  /** Write frame along with velocities and/or forces
+   *
+   * @p velocities (in Å/ps) and @p forces (in kJ/mol/Å) are flat [n_atoms, 3] arrays,
+   * empty span stands for absent block
+   * */
+  void write(xmol::Frame& frame, const future::Span<const double>& velocities,
+             const future::Span<const double>& forces);
+
+  [[nodiscard]] const char* last_error() const { return m_error_str; };
+
+private:
+  [[nodiscard]] auto write_header(const TrrHeader& header) -> Status;
+  [[nodiscard]] auto write_reals(const future::Span<const double>& values, double factor) -> Status;
+  XdrHandle m_xdr;
+  bool m_double_precision;
+  const char* m_error_str = "";
+  std::vector<double> m_double_buffer;
+  std::vector<float> m_float_buffer;
+};
+} // namespace xdr
+
+} // namespace xmol::io
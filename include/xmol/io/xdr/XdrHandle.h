@@ -2,9 +2,10 @@
 #include "xmol/future/span.h"
 #include <array>
 #include <cstdint>
+#include <cstdio>
 #include <iostream>
-#include <rpc/xdr.h>
 #include <string>
+#include <vector>
 
 namespace xmol::io::xdr {
 
@@ -17,6 +18,11 @@ inline Status& operator&=(Status& lhs, const Status& rhs) {
 }
 inline bool operator!(const Status& lhs) { return lhs == Status::ERROR; }
 
+/** Buffered XDR (RFC 4506) stream over a file
+ *
+ * Values are 4-byte (8-byte for double) big-endian words, opaque data is padded to 4 bytes.
+ * File is accessed in large chunks, arrays are converted by single byte-swap pass over the buffer.
+ * */
 class XdrHandle {
 public:
   enum class Mode : uint8_t {
@@ -25,11 +31,11 @@ public:
   };
 
   XdrHandle(const std::string& path, Mode mode);
+  XdrHandle(const XdrHandle&) = delete;
+  XdrHandle& operator=(const XdrHandle&) = delete;
 
-  ~XdrHandle() {
-    xdr_destroy(&m_xdr);
-    std::fclose(m_file);
-  }
+  /// Flushes pending output and closes the file
+  ~XdrHandle();
 
   [[nodiscard]] auto read_opaque(char* cp, unsigned int cnt) -> Status;
   [[nodiscard]] auto write_opaque(const char* cp, unsigned int cnt) -> Status;
@@ -40,16 +46,51 @@ public:
   [[nodiscard]] auto read(float& value) -> Status;
   [[nodiscard]] auto write(const float& value) -> Status;
 
+  [[nodiscard]] auto read(double& value) -> Status;
+  [[nodiscard]] auto write(const double& value) -> Status;
+
   [[nodiscard]] auto read(const future::Span<float>& value) -> Status;
   [[nodiscard]] auto write(const future::Span<const float>& value) -> Status;
 
+  [[nodiscard]] auto read(const future::Span<double>& value) -> Status;
+  [[nodiscard]] auto write(const future::Span<const double>& value) -> Status;
+
   [[nodiscard]] auto read(const future::Span<int>& value) -> Status;
   [[nodiscard]] auto write(const future::Span<const int>& value) -> Status;
 
+  /// Current byte offset from the beginning of file
+  [[nodiscard]] auto tell() const -> std::int64_t;
+
+  /// File size in bytes
+  [[nodiscard]] auto size() const -> std::int64_t;
+
+  /// Move to absolute byte @p offset
+  [[nodiscard]] auto seek(std::int64_t offset) -> Status;
+
+  /// Skip @p n_bytes bytes without reading them
+  [[nodiscard]] auto skip(std::int64_t n_bytes) -> Status;
+
+  /// Write buffered output to file
+  [[nodiscard]] auto flush() -> Status;
+
+  /// Whether last read failed because it ran past end of file
+  [[nodiscard]] bool past_end() const { return m_past_end; }
+
 private:
-  XDR m_xdr;
+  /// Copy next @p n_bytes bytes to @p dst
+  auto read_bytes(void* dst, size_t n_bytes) -> Status;
+  auto write_bytes(const void* src, size_t n_bytes) -> Status;
+  template <typename T> auto read_words(T* dst, size_t n) -> Status;
+  template <typename T> auto write_words(const T* src, size_t n) -> Status;
+
   std::FILE* m_file;
   const Mode m_mode;
+  std::vector<char> m_buffer;
+  std::int64_t m_buffer_offset = 0; /// file offset of buffer begin
+  size_t m_pos = 0;                 /// read/write position within buffer
+  size_t m_end = 0;                 /// end of valid data in buffer (read mode)
+  bool m_past_end = false;          /// last read ran past end of file
+  size_t m_refill_size;             /// size of next buffer refill, reduced after seek (read mode)
 };
 
-} // namespace xmol::io::xdr
\ No newline at end of file
+} // namespace xmol::io::xdr
@@ -1,6 +1,8 @@
 #pragma once
+#include "FrameOffsetIndex.h"
 #include "XdrHandle.h"
 #include "xmol/future/span.h"
+#include <cstdint>
 #include <iostream>
 
 namespace xmol::io::xdr {
@@ -36,15 +38,22 @@ public:
 
   auto read_header(XtcHeader& header) -> Status;
   auto read_box(const future::Span<float>& box) -> Status;
-  auto read_coords(const future::Span<float>& flat_coords) -> Status;
+  /// Read compressed coordinates, decoding stops once first @p max_atoms atoms are restored
+  /// (values of the rest are unspecified), compressed payload is consumed entirely anyway
+  auto read_coords(const future::Span<float>& flat_coords, size_t max_atoms = SIZE_MAX) -> Status;
   auto advance(size_t n_frames) -> Status; /// Skip n_frame frames
+  /// Collect offsets of remaining frames into index, last frame cut by end of file is skipped,
+  /// corrupted frames (bad magic or size) are errors
+  auto scan(FrameOffsetIndex& index) -> Status;
+  [[nodiscard]] auto tell() const -> std::int64_t { return m_xdr.tell(); } /// Current byte offset
+  auto seek(std::int64_t offset) -> Status; /// Move to frame which starts at @p offset
   [[nodiscard]] const char* last_error() const { return m_error_str; };
 
 private:
+  auto skip_coords(int n_atoms) -> Status;
   XdrHandle m_xdr;
   const char* m_error_str = "";
-  std::vector<int> m_ip;
-  std::vector<int> m_buf;
+  std::vector<char> m_buf; /// compressed coordinates
 };
 
 } // namespace xmol::io::xdr
\ No newline at end of file
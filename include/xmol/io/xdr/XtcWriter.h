@@ -5,6 +5,7 @@
 #include "xmol/fwd.h"
 
 #include <iostream>
+#include <memory>
 
 namespace xmol::io {
 
@@ -16,21 +17,41 @@ public:
 namespace xdr {
 class XtcWriter {
 public:
-  explicit XtcWriter(const std::string& filename, float precision)
-      : m_xdr(filename, XdrHandle::Mode::WRITE), m_precision(precision){};
+  /** @param precision coordinates precision, in 1/nm
+   *  @param n_threads number of compression threads, zero stands for std::thread::hardware_concurrency().
+   *
+   *  With single thread frames are compressed and written on calling thread,
+   *  otherwise they are queued, compressed in background and appended to file in order
+   * */
+  explicit XtcWriter(const std::string& filename, float precision, size_t n_threads = 1);
+  XtcWriter(const XtcWriter&) = delete;
+  XtcWriter& operator=(const XtcWriter&) = delete;
+
+  /// Writes queued frames, errors are ignored (use flush() to catch them)
+  ~XtcWriter();
+
   void write(xmol::Frame& frame);
+
+  /// Wait for queued frames and write them to file
+  void flush();
+
   [[nodiscard]] const char* last_error() const { return m_error_str; };
 
 private:
+  struct Record;
+  class Compressor;
+
+  std::unique_ptr<Record> acquire_record();
+  /// Write compressed record and put it to pool of free records, throws on error
+  void write_record(std::unique_ptr<Record> record);
   [[nodiscard]] auto write_header(const XtcHeader& header) -> Status;
   [[nodiscard]] auto write_box(const future::Span<const float>& box) -> Status;
-  [[nodiscard]] auto write_coords(const future::Span<const float>& flat_coords, float precision) -> Status;
+  [[nodiscard]] auto write_coords(const Record& record) -> Status;
   XdrHandle m_xdr;
   float m_precision;
   const char* m_error_str = "";
-  std::vector<int> m_ip;
-  std::vector<int> m_buf;
-  std::vector<float> m_flat_coords;
+  std::vector<std::unique_ptr<Record>> m_free_records;
+  std::unique_ptr<Compressor> m_compressor; /// background compression threads, null in single-threaded mode
 };
 } // namespace xdr
 
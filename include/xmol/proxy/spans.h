@@ -49,6 +49,74 @@ private:
   friend smart::MoleculeSmartSpan;
 };
 
+/** Per-atom vectors (velocities or forces) of contiguous range of frame atoms
+ *
+ * Unlike CoordSpan the span refers to frame storage by atom indices,
+ * so it stays usable when storage is reallocated (e.g. by atom insertion)
+ */
+class AtomVectorSpan {
+public:
+  [[nodiscard]] size_t size() const { return m_size; }
+  [[nodiscard]] bool empty() const { return m_size == 0; }
+
+  /// Vector of @p i 'th atom of the span
+  [[nodiscard]] XYZ& operator[](size_t i) {
+    assert(i < size());
+    return data()[i];
+  }
+
+  /// Zero-copy [size, 3] view of vectors
+  Eigen::Map<CoordEigenMatrix> _eigen() {
+    return Eigen::Map<CoordEigenMatrix>(empty() ? nullptr : data()->_eigen().data(), size(), 3);
+  }
+
+  XYZ mean() { return XYZ(_eigen().colwise().mean()); }
+
+  /// Parent frame
+  [[nodiscard]] Frame& frame() {
+    assert(m_frame);
+    return *m_frame;
+  }
+
+protected:
+  AtomVectorSpan() = default;
+  AtomVectorSpan(Frame& frame, std::vector<XYZ>& storage, size_t begin, size_t size)
+      : m_frame(&frame), m_storage(&storage), m_begin(begin), m_size(size){};
+
+private:
+  /// Throws if parent frame doesn't store vectors of the span anymore
+  XYZ* data();
+
+  Frame* m_frame = nullptr;
+  std::vector<XYZ>* m_storage = nullptr;
+  size_t m_begin = 0;
+  size_t m_size = 0;
+};
+
+/// Velocities of contiguous range of frame atoms
+class VelocitySpan : public AtomVectorSpan {
+public:
+  VelocitySpan() = default;
+
+private:
+  VelocitySpan(Frame& frame, std::vector<XYZ>& storage, size_t begin, size_t size)
+      : AtomVectorSpan(frame, storage, begin, size){};
+  friend Frame;
+  friend AtomSpan;
+};
+
+/// Forces of contiguous range of frame atoms
+class ForceSpan : public AtomVectorSpan {
+public:
+  ForceSpan() = default;
+
+private:
+  ForceSpan(Frame& frame, std::vector<XYZ>& storage, size_t begin, size_t size)
+      : AtomVectorSpan(frame, storage, begin, size){};
+  friend Frame;
+  friend AtomSpan;
+};
+
 class AtomSpan : public ProxySpan<AtomRef, BaseAtom> {
 public:
   using ProxySpan::ProxySpan;
@@ -57,6 +125,11 @@ public:
   ResidueSpan residues();
   MoleculeSpan molecules();
 
+  /// Velocities of atoms, empty if frame has no velocities
+  VelocitySpan velocities();
+
+  /// Forces acting on atoms, empty if frame has no forces
+  ForceSpan forces();
 
   [[nodiscard]] bool contains(const AtomRef& ref) const;
 
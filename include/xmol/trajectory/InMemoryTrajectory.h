@@ -0,0 +1,67 @@
+#pragma once
+#include "xmol/trajectory/TrajectoryFile.h"
+#include "xmol/geom/UnitCell.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace xmol::trajectory {
+
+/** Trajectory frames kept in memory
+ *
+ * Only coordinates, cell and time of frames are stored. Coordinates are stored either as float32 values
+ * or, for positive `precision`, rounded to multiples of `precision` and packed in blocks of `block_size` frames.
+ * Within a block every frame is stored as difference to the previous one, each axis is bit-packed
+ * with the smallest width which fits its range. Random access decodes frames from the beginning of the block,
+ * sequential reads decode one frame each.
+ *
+ * Stored frames are shared by clone()'s, append() to a shared store makes a private copy first.
+ * */
+class InMemoryTrajectory : public TrajectoryInputFile {
+public:
+  /** @param precision quantization step in angstroms, zero stands for float32 storage
+   *  @param block_size number of frames in delta-encoded block, ignored for float32 storage
+   * */
+  explicit InMemoryTrajectory(size_t n_atoms, double precision = 0, size_t block_size = 32);
+
+  [[nodiscard]] size_t n_frames() const final;
+  [[nodiscard]] size_t n_atoms() const final { return m_n_atoms; }
+  void read_frame(size_t index, Frame& frame) final;
+  void read_coords(size_t index, const future::Span<float>& coords) final;
+  void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) final;
+  [[nodiscard]] std::optional<double> frame_time(size_t index) const final;
+  [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final;
+  void advance(size_t shift) final;
+  void seek(size_t current, size_t index) final;
+
+  /// Append coordinates, cell and time of @p frame
+  void append(Frame& frame);
+
+  /// Quantization step in angstroms, zero for float32 storage
+  [[nodiscard]] double precision() const { return m_precision; }
+
+  /// Number of frames per block
+  [[nodiscard]] size_t block_size() const { return m_block_size; }
+
+  /// Memory occupied by stored coordinates in bytes
+  [[nodiscard]] size_t size_in_bytes() const;
+
+private:
+  struct Storage;
+
+  /// Decode quantized coordinates of @p index frame into m_ints
+  void decode(size_t index);
+  template <typename T> void load_coords(size_t index, const std::vector<AtomIndex>* atoms, T* dst);
+
+  size_t m_n_atoms;
+  double m_precision;
+  size_t m_block_size;
+  std::shared_ptr<Storage> m_storage;
+  size_t m_current_frame = 0;
+
+  std::vector<int32_t> m_ints;  /// quantized coordinates of last decoded frame
+  size_t m_decoded = SIZE_MAX; /// index of last decoded frame
+};
+
+} // namespace xmol::trajectory
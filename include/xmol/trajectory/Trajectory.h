@@ -1,6 +1,13 @@
 #pragma once
 #include "../Frame.h"
 #include "TrajectoryFile.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
 
 /// MD trajectory classes and utilites
 namespace xmol::trajectory {
@@ -21,11 +28,18 @@ class Trajectory {
     size_t pos_in_file; // position in input file
   };
 
+  using Files = std::vector<std::unique_ptr<TrajectoryInputFile>>;
+
 public:
 
   struct Sentinel {};
 
-  /// Iterator[Trajectory::Frame] (don't confuse with Frame)
+  /** Iterator[Trajectory::Frame] (don't confuse with Frame)
+   *
+   * First active iterator reads trajectory input files directly, iterators created while it's alive
+   * read independent copies of input files (see TrajectoryInputFile::clone()), which allows nested loops
+   * and concurrent iteration from several threads.
+   * */
   class Iterator {
   public:
     Iterator() = delete;
@@ -33,18 +47,15 @@ public:
     Iterator& operator=(const Iterator&) = delete;
     Iterator(Iterator&& other) noexcept;
     Iterator& operator=(Iterator&& other) noexcept;
-    ~Iterator() {
-      if (m_traj) {
-        m_traj->m_iterator_counter--;
-        if (m_pos.global_pos < m_end) { /// handle break
-          m_traj->advance(m_pos, m_end, m_end - m_pos.global_pos);
-        }
-      }
-    }
+    ~Iterator();
     Frame& operator*() { return m_frame; }
     Frame* operator->() { return &m_frame; }
     Iterator& operator++() {
-      m_traj->advance(m_pos, m_end, m_step);
+      if (m_prefetcher) {
+        m_pos.global_pos += m_step; // files are advanced by prefetcher
+      } else {
+        Trajectory::advance(*m_files, m_pos, m_end, m_step);
+      }
       if (m_pos.global_pos < m_end) {
         update();
       }
@@ -55,37 +66,36 @@ public:
     bool operator==(const Sentinel&) const { return m_pos.global_pos >= m_end; }
 
   private:
+    class Prefetcher;
     friend Trajectory;
-    Iterator(Trajectory& t, Position begin, size_t end, size_t step)
-        : m_traj(&t), m_pos(begin), m_end(end), m_step(step), m_frame(t.m_frame) {
-      assert(step > 0);
-      m_traj->m_iterator_counter++;
-      if (m_traj->m_iterator_counter > 1) {
-        throw TrajectoryDoubleTraverseError(""); // add link to doc / example
-      }
-      if (m_pos.global_pos < m_end) {
-        m_traj->advance(m_pos, m_end, 0);
-        update();
-      }
-    }
-    void update() {
-      m_traj->read_frame(m_pos, m_frame);
-      m_frame.index = m_pos.global_pos;
-    }
+    Iterator(Trajectory& t, Position begin, size_t end, size_t step, size_t prefetch_depth = 0,
+             std::shared_ptr<const std::vector<AtomIndex>> atoms = {}, bool read_frames = true);
+    void update();
+    void read_coords(const future::Span<float>& coords, std::vector<float>& buffer);
+    void release();
     Trajectory* m_traj;
+    std::unique_ptr<Files> m_own_files; /// independent copies of trajectory files, if any
+    Files* m_files;                     /// files to read, either trajectory or own ones
     Position m_pos;
     size_t m_end;
     size_t m_step;
+    std::shared_ptr<const std::vector<AtomIndex>> m_atoms;
+    bool m_read_frames; /// frames are not updated if false, see Slice::read_coords()
     Frame m_frame;
+    std::unique_ptr<Prefetcher> m_prefetcher;
   };
 
   /// Reference to trajectory slice
   class Slice {
   public:
-    Iterator begin() { return Iterator(m_traj, m_begin, m_end, m_step); }
+    Iterator begin() { return Iterator(m_traj, m_begin, m_end, m_step, m_prefetch_depth, m_atoms); }
     Sentinel end() { return {}; }
 
-    Frame at(size_t i) { return m_traj.at(m_begin.global_pos + m_step * i); }
+    Frame at(size_t i) {
+      Slice single = m_traj.slice(m_begin.global_pos + m_step * i, m_begin.global_pos + m_step * i + 1, 1);
+      single.m_atoms = m_atoms;
+      return *single.begin();
+    }
 
     /// Total number of frames in slice
     size_t size() const {
@@ -99,8 +109,43 @@ public:
     [[nodiscard]] size_t n_frames() const { return size(); };
 
     /// Number of atoms in frame
-    [[nodiscard]] size_t n_atoms() const { return m_traj.n_atoms(); }
+    [[nodiscard]] size_t n_atoms() const { return m_atoms ? m_atoms->size() : m_traj.n_atoms(); }
+
+    /** Same slice, but frames are read by background thread up to @p depth frames ahead of iterator
+     *
+     * Input files are accessed by background thread only, frames are copied to iterated frame.
+     * Frames read ahead are read again if iterated frame gets velocities or forces (see Frame::add_velocities()).
+     * Zero @p depth disables prefetching
+     * */
+    [[nodiscard]] Slice prefetch(size_t depth) const {
+      Slice result(*this);
+      result.m_prefetch_depth = depth;
+      return result;
+    }
 
+    /// Number of frames read ahead of iterator
+    [[nodiscard]] size_t prefetch_depth() const { return m_prefetch_depth; }
+
+    /** Same slice, but frames contain only @p atoms of trajectory frame
+     *
+     * Topology of yielded frames is reduced to selected atoms (and their residues and molecules),
+     * input files read selected atoms only where format permits.
+     * Indices are sorted and deduplicated, out of range index throws std::out_of_range
+     * */
+    [[nodiscard]] Slice select_atoms(std::vector<AtomIndex> atoms) const;
+
+    /** Read coordinates of (selected) atoms of all frames in slice as flat [n_frames, n_atoms, 3] array
+     *
+     * Frames are not constructed, coordinates are read by TrajectoryInputFile::read_coords().
+     * @p coords size must be equal to `n_frames() * n_atoms() * 3`
+     * */
+    void read_coords(const future::Span<float>& coords);
+
+    /// Same as above, single precision coordinates of each frame are widened directly into @p coords
+    void read_coords(const future::Span<double>& coords);
+
+    /// Indices of selected atoms, `nullptr` if all atoms are read
+    [[nodiscard]] const std::vector<AtomIndex>* selected_atoms() const { return m_atoms.get(); }
 
   private:
     friend Trajectory;
@@ -110,6 +155,11 @@ public:
     Position m_begin;
     size_t m_end;
     size_t m_step;
+    size_t m_prefetch_depth = 0;
+    std::shared_ptr<const std::vector<AtomIndex>> m_atoms;
+
+    /// Checks size of @p coords and calls @p store(iterator, buffer, out) for each frame, @p out advances by frame
+    template <typename T, typename Store> void read_coords(const future::Span<T>& coords, Store&& store);
   };
 
   Trajectory() = delete;
@@ -118,10 +168,10 @@ public:
   explicit Trajectory(xmol::Frame frame) : m_frame(std::move(frame)){};
 
   /// Move constructor, invalidates iterators/slices
-  Trajectory(Trajectory&& other) = default;
+  Trajectory(Trajectory&& other);
 
   /// Move assignment, invalidates iterators/slices
-  Trajectory& operator=(Trajectory&& other) = default;
+  Trajectory& operator=(Trajectory&& other);
 
   Trajectory(const Trajectory& other) = delete;
   Trajectory& operator=(const Trajectory& other) = delete;
@@ -134,11 +184,73 @@ public:
   Iterator begin() { return Iterator(*this, Position{0, 0, 0}, n_frames(), 1); }
   Sentinel end() { return {}; }
 
-  Frame at(size_t i) { return *slice(i, i + 1, 1).begin(); }
+  /// Copy of trajectory frame with coordinates of @p i 'th frame, see read_into()
+  Frame at(size_t i) {
+    Frame result(m_frame);
+    read_into(i, result);
+    return result;
+  }
+
+  /** Read coordinates, cell and time of @p i 'th frame into @p frame, topology of @p frame is not touched
+   *
+   * @p frame must have n_atoms() atoms. Input files are read through own independent copies
+   * (see TrajectoryInputFile::clone()) positioned by TrajectoryInputFile::seek(). Copy of the last read
+   * file stays open between calls, so random access within a file doesn't reopen it or read intermediate
+   * frames, while copies of other files are closed.
+   * Files which can't be copied are read directly when no iterator is active.
+   *
+   * Throws std::out_of_range for bad @p i, std::runtime_error on n_atoms() mismatch
+   * */
+  void read_into(size_t i, Frame& frame);
 
   /// Slice of trajectory
   Slice slice(std::optional<size_t> begin = {}, std::optional<size_t> end = {}, size_t step = 1);
 
+  /** Index of frame nearest to time @p t
+   *
+   * Frames are located by binary search over TrajectoryInputFile::frame_time(), frames are not read.
+   * Input files may overlap in time (e.g. restarted runs): frames of a file with time not less than
+   * first time of some later file are superseded by the later file and never returned.
+   *
+   * Throws std::out_of_range if @p t is outside of trajectory time range
+   * and std::runtime_error if some input file doesn't provide frame times
+   * */
+  [[nodiscard]] size_t index_at_time(double t);
+
+  /// Frame nearest to time @p t, see index_at_time()
+  Frame frame_at_time(double t) { return at(index_at_time(t)); }
+
+  /** Slice of frames with time in `[t0, t1)`, see index_at_time()
+   *
+   * If @p dt is given, slice step is @p dt divided by mean time between frames in the window (at least 1).
+   * Slice is a contiguous range of frames, so window which includes superseded frames of overlapping files
+   * throws std::runtime_error, such window should be split at restart times.
+   * */
+  Slice slice_by_time(double t0, double t1, std::optional<double> dt = {});
+
+  /// Whole trajectory read by background thread, see Slice::prefetch()
+  Slice prefetch(size_t depth) { return slice().prefetch(depth); }
+
+  /// Whole trajectory reduced to @p atoms, see Slice::select_atoms()
+  Slice select_atoms(std::vector<AtomIndex> atoms) { return slice().select_atoms(std::move(atoms)); }
+
+  /** Apply @p map to every frame of @p slice in parallel and combine results with @p reduce
+   *
+   * Slice is split into (at most) @p n_threads contiguous chunks of frames, each chunk is traversed by own
+   * thread with own Frame and independent input files (see TrajectoryInputFile::clone()).
+   * Results are combined in frame order: `reduce(...reduce(reduce(init, map(f0)), map(f1))..., map(fN))`
+   * up to associativity of @p reduce, so the result doesn't depend on thread scheduling.
+   * If some input file can't be copied slice is processed in calling thread only.
+   *
+   * Zero @p n_threads means std::thread::hardware_concurrency().
+   * Exception thrown by @p map or @p reduce is rethrown after all threads finished (the earliest one in frame order).
+   *
+   * @param map callable `T(Frame&)`, invoked concurrently from several threads
+   * @param reduce callable `T(T, T)`, invoked concurrently from several threads
+   */
+  template <typename T, typename Map, typename Reduce>
+  T parallel_map_reduce(const Slice& slice, size_t n_threads, T init, Map&& map, Reduce&& reduce);
+
   /// Total number of frames in trajectory
   [[nodiscard]] size_t n_frames() const { return m_n_frames; };
 
@@ -148,14 +260,43 @@ public:
 private:
   xmol::Frame m_frame;
   size_t m_n_frames = 0;
-  std::vector<std::unique_ptr<TrajectoryInputFile>> m_files;
-  int m_iterator_counter = 0;
+  Files m_files;
+  std::atomic<int> m_iterator_counter{0};
+
+  /// Frames of input file which are not superseded by later input files
+  struct TimeSegment {
+    size_t file;  // number of input file
+    size_t begin; // global index of first frame of file
+    size_t size;  // number of leading frames of file with time less than first time of later files
+  };
+
+  /// First and last frame times of input file
+  struct FileTimes {
+    double first;
+    double last;
+  };
+  std::vector<FileTimes> m_file_times; /// cached times of input files, filled by time_segments()
+
+  Files m_random_access_files;                   /// copies of input files used by read_into(), `nullptr` if can't copy
+  std::vector<size_t> m_random_access_positions; /// read positions of m_random_access_files
+  static constexpr size_t no_open_file = static_cast<size_t>(-1);
+  size_t m_random_access_open_file = no_open_file; /// index of the only open file of m_random_access_files
 
-  void read_frame(Position pos, Frame& frame) {
-    m_files[pos.file]->read_frame(pos.pos_in_file, frame);
+  /// Non-empty time segments of input files, ordered by time
+  std::vector<TimeSegment> time_segments();
+
+  static void read_frame(Files& files, Position pos, Frame& frame, const std::vector<AtomIndex>* atoms) {
+    if (atoms) {
+      files[pos.file]->read_frame_atoms(pos.pos_in_file, *atoms, frame);
+    } else {
+      files[pos.file]->read_frame(pos.pos_in_file, frame);
+    }
   }
 
-  void advance(Position& position, size_t end, size_t step);
+  static void advance(Files& files, Position& position, size_t end, size_t step);
+
+  /// Independent copies of input files, throws TrajectoryDoubleTraverseError if some file can't be copied
+  Files clone_files() const;
 
   void extend_unique_ptr(std::unique_ptr<TrajectoryInputFile>&& input_file) {
     if (n_atoms() != input_file->n_atoms()) {
@@ -167,4 +308,82 @@ private:
   }
 };
 
-} // namespace xmol::trajectory
\ No newline at end of file
+template <typename T, typename Map, typename Reduce>
+T Trajectory::parallel_map_reduce(const Slice& slice, size_t n_threads, T init, Map&& map, Reduce&& reduce) {
+  if (&slice.m_traj != this) {
+    throw std::runtime_error("Trajectory::parallel_map_reduce(): slice belongs to other trajectory");
+  }
+  const size_t n_slice_frames = slice.size();
+  if (n_threads == 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  n_threads = std::max<size_t>(1, std::min(n_threads, n_slice_frames));
+
+  // Iterators are created upfront to fall back to single chunk if input files can't be copied
+  std::vector<Iterator> iterators;
+  std::vector<size_t> chunk_sizes;
+  for (size_t i = 0, done = 0; i < n_threads && done < n_slice_frames; ++i) {
+    size_t chunk_size = (n_slice_frames - done) / (n_threads - i);
+    Slice chunk = this->slice(slice.m_begin.global_pos + done * slice.m_step,
+                              slice.m_begin.global_pos + (done + chunk_size - 1) * slice.m_step + 1, slice.m_step);
+    chunk.m_atoms = slice.m_atoms;
+    chunk.m_prefetch_depth = slice.m_prefetch_depth;
+    try {
+      iterators.push_back(chunk.begin());
+    } catch (TrajectoryDoubleTraverseError&) {
+      if (iterators.empty()) {
+        throw;
+      }
+      iterators.clear();
+      chunk_sizes.clear();
+      iterators.push_back(Slice(slice).begin());
+      chunk_sizes.push_back(n_slice_frames);
+      break;
+    }
+    chunk_sizes.push_back(chunk_size);
+    done += chunk_size;
+  }
+
+  std::vector<std::optional<T>> results(iterators.size());
+  std::vector<std::exception_ptr> errors(iterators.size());
+  auto process_chunk = [&](size_t i) {
+    try {
+      auto& it = iterators[i];
+      for (size_t n = 0; n < chunk_sizes[i]; ++n, ++it) {
+        if (results[i]) {
+          results[i] = reduce(std::move(*results[i]), map(*it));
+        } else {
+          results[i] = map(*it);
+        }
+      }
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < iterators.size(); ++i) {
+    threads.emplace_back(process_chunk, i);
+  }
+  if (!iterators.empty()) {
+    process_chunk(0);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  iterators.clear();
+
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  for (auto& result : results) {
+    if (result) {
+      init = reduce(std::move(init), std::move(*result));
+    }
+  }
+  return init;
+}
+
+} // namespace xmol::trajectory
@@ -2,13 +2,21 @@
 #include "xmol/proxy/spans.h"
 #include "xmol/fwd.h"
 #include "xmol/geom/fwd.h"
+#include <memory>
+#include <optional>
 
 namespace xmol::trajectory {
 
 /// Forward read-only re-enterable trajectory coordinate file
 class TrajectoryInputFile {
 public:
-  virtual ~TrajectoryInputFile() = default;
+  TrajectoryInputFile() = default;
+  /// Copy has own scratch frame
+  TrajectoryInputFile(const TrajectoryInputFile& other);
+  TrajectoryInputFile(TrajectoryInputFile&& other) noexcept;
+  TrajectoryInputFile& operator=(const TrajectoryInputFile& other);
+  TrajectoryInputFile& operator=(TrajectoryInputFile&& other) noexcept;
+  virtual ~TrajectoryInputFile();
   /// Number of frames
   [[nodiscard]] virtual size_t n_frames() const = 0;
 
@@ -22,6 +30,44 @@ public:
    * */
   virtual void read_frame(size_t index, Frame& frame) = 0;
 
+  /** Read @p index 'th frame coordinates as single precision [n_atoms, 3] array in angstroms
+   *
+   * Cell and time are not read. Same precondition as for @ref read_frame() applies.
+   *
+   * Default implementation reads frame into scratch Frame of the file and narrows it,
+   * files which store float32 coordinates should override it to read values without double round trip
+   * */
+  virtual void read_coords(size_t index, const future::Span<float>& coords);
+
+  /** Read subset of @p index 'th frame atoms
+   *
+   * @p atoms are sorted unique atom indices, @p frame has exactly `atoms.size()` atoms in the same order.
+   * Same precondition as for @ref read_frame() applies.
+   *
+   * Default implementation reads whole frame into scratch Frame of the file and copies selected atoms
+   * (and their velocities and forces if @p frame has them),
+   * files should override it to skip unselected atoms
+   * */
+  virtual void read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame);
+
+  /** Time of @p index 'th frame without reading the frame, or `std::nullopt` if it's unknown
+   *
+   * May be called at any read position (and concurrently with reads), doesn't change the position.
+   * Used by Trajectory to locate frames by time with binary search.
+   *
+   * Default implementation returns `std::nullopt`
+   * */
+  [[nodiscard]] virtual std::optional<double> frame_time(size_t index) const;
+
+  /** Independent copy of file with own read position, or `nullptr` if file can't be copied
+   *
+   * Copy is closed as if it was advanced past the last frame. Copies may be read concurrently
+   * with the original from other threads, therefore implementation must not touch mutable state of the original.
+   *
+   * Default implementation returns `nullptr`
+   * */
+  [[nodiscard]] virtual std::unique_ptr<TrajectoryInputFile> clone() const;
+
   /** Advance internal data pointer by @p shift frames and be prepared to read coordinates
    *
    * When internal data pointer shifted beyond @ref n_frames() file handles must be closed
@@ -30,6 +76,21 @@ public:
    * */
   virtual void advance(size_t shift) = 0;
 
+  /** Move internal data pointer from @p current frame to @p index frame, @p index may precede @p current
+   *
+   * Used for random access reads (see Trajectory::read_into()), file must be open at @p current frame.
+   *
+   * Default implementation closes the file by advancing it past the last frame and advances it again
+   * from the beginning if @p index precedes @p current,
+   * files with random access should override it to seek directly
+   * */
+  virtual void seek(size_t current, size_t index);
+
+private:
+  std::unique_ptr<Frame> m_scratch_frame; /// n_atoms() frame reused by default read_coords() and read_frame_atoms()
+
+  /// Scratch frame with velocities and forces as requested
+  Frame& scratch_frame(bool with_velocities, bool with_forces);
 };
 
 } // namespace xmol::trajectory
\ No newline at end of file
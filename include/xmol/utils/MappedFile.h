@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace xmol::utils {
+
+/// Read-only memory mapping of whole file
+///
+/// Pages are shared with OS page cache, so concurrent readers of same file don't duplicate it in memory
+class MappedFile {
+public:
+  explicit MappedFile(const std::string& filename);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+  ~MappedFile();
+
+  [[nodiscard]] const char* data() const { return m_data; }
+  [[nodiscard]] size_t size() const { return m_size; }
+
+private:
+  const char* m_data = nullptr;
+  size_t m_size = 0;
+};
+
+} // namespace xmol::utils
@@ -7,26 +7,33 @@ from ._core import *
 
 __all__ = [
     "AmberNetCDF",
+    "AmberNetCDFWriter",
     "AngleValue",
     "Atom",
     "AtomPredicate",
     "AtomSelection",
     "AtomSpan",
+    "CifReadError",
     "CoordSelection",
     "CoordSelectionSizeMismatchError",
     "CoordSpan",
+    "DcdFile",
     "DeadFrameAccessError",
     "DeadObserverAccessError",
     "Degrees",
     "Frame",
     "GeomError",
+    "GromacsTrrFile",
     "GromacsXtcFile",
+    "InMemoryTrajectory",
+    "MmCifFile",
     "Molecule",
     "MoleculePredicate",
     "MoleculeSelection",
     "MoleculeSpan",
     "MultipleFramesSelectionError",
     "PdbFile",
+    "PdbTrajectoryFile",
     "Radians",
     "Residue",
     "ResidueId",
@@ -43,6 +50,9 @@ __all__ = [
     "Transformation",
     "Translation",
     "TrjtoolDatFile",
+    "TrrReadError",
+    "TrrWriteError",
+    "TrrWriter",
     "UniformScale",
     "UnitCell",
     "XYZ",
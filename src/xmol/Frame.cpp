@@ -3,6 +3,8 @@
 #include "xmol/proxy/smart/selections.h"
 #include "xmol/proxy/smart/spans.h"
 
+#include <utility>
+
 using namespace xmol;
 using namespace xmol::proxy::smart;
 
@@ -84,6 +86,13 @@ BaseAtom& Frame::add_atom(BaseResidue& residue) {
   auto new_inserted_it = m_atoms.insert(m_atoms.begin() + (old_insert_pos - old_begin), BaseAtom{{}, {}, &residue});
 
   auto new_inserted_crd_it = m_coordinates.insert(m_coordinates.begin() + (old_insert_pos - old_begin), XYZ{});
+  // velocities and forces are addressed by atom index, no references to update
+  if (m_has_velocities) {
+    m_velocities.insert(m_velocities.begin() + (old_insert_pos - old_begin), XYZ{});
+  }
+  if (m_has_forces) {
+    m_forces.insert(m_forces.begin() + (old_insert_pos - old_begin), XYZ{});
+  }
 
   auto new_begin = m_atoms.data();
   auto new_begin_crd = m_coordinates.data();
@@ -155,6 +164,10 @@ Frame& Frame::operator=(Frame&& other) {
     m_residues = std::move(other.m_residues);
     m_molecules = std::move(other.m_molecules);
     m_coordinates = std::move(other.m_coordinates);
+    m_velocities = std::move(other.m_velocities);
+    m_forces = std::move(other.m_forces);
+    m_has_velocities = std::exchange(other.m_has_velocities, false);
+    m_has_forces = std::exchange(other.m_has_forces, false);
     for (auto& mol : m_molecules) {
       mol.frame = this;
     }
@@ -174,6 +187,10 @@ Frame& Frame::operator=(const Frame& other) {
     m_residues = other.m_residues;
     m_molecules = other.m_molecules;
     m_coordinates = other.m_coordinates;
+    m_velocities = other.m_velocities;
+    m_forces = other.m_forces;
+    m_has_velocities = other.m_has_velocities;
+    m_has_forces = other.m_has_forces;
     for (auto& mol : m_molecules) {
       mol.frame = this;
       mol.residues.rebase(other.m_residues.data(), m_residues.data());
@@ -192,7 +209,8 @@ Frame& Frame::operator=(const Frame& other) {
 
 Frame::Frame(const Frame& other)
     : cell(other.cell), index(other.index), time(other.time), m_atoms(other.m_atoms), m_residues(other.m_residues), m_molecules(other.m_molecules),
-      m_coordinates(other.m_coordinates) {
+      m_coordinates(other.m_coordinates), m_velocities(other.m_velocities), m_forces(other.m_forces),
+      m_has_velocities(other.m_has_velocities), m_has_forces(other.m_has_forces) {
   for (auto& mol : m_molecules) {
     mol.frame = this;
     mol.residues.rebase(other.m_residues.data(), m_residues.data());
@@ -220,7 +238,10 @@ Frame::Frame(Frame&& other)
       utils::Observable<CoordSmartSpan>(std::move(other)),
       utils::Observable<CoordSmartSelection>(std::move(other)),
       cell(std::move(other.cell)), index(other.index), time(other.time), m_atoms(std::move(other.m_atoms)), m_residues(std::move(other.m_residues)),
-      m_molecules(std::move(other.m_molecules)), m_coordinates(std::move(other.m_coordinates)) {
+      m_molecules(std::move(other.m_molecules)), m_coordinates(std::move(other.m_coordinates)),
+      m_velocities(std::move(other.m_velocities)), m_forces(std::move(other.m_forces)),
+      m_has_velocities(std::exchange(other.m_has_velocities, false)),
+      m_has_forces(std::exchange(other.m_has_forces, false)) {
   notify_frame_moved(other);
   for (auto& mol : m_molecules) {
     mol.frame = this;
@@ -297,6 +318,12 @@ void Frame::reserve_atoms(size_t n) {
     m_coordinates.reserve(n);
     notify_coordinates_move(old_begin, old_end, m_coordinates.data());
   }
+  if (m_has_velocities) {
+    m_velocities.reserve(n);
+  }
+  if (m_has_forces) {
+    m_forces.reserve(n);
+  }
 }
 
 void Frame::reserve_residues(size_t n) {
@@ -317,6 +344,44 @@ proxy::ResidueSpan Frame::residues() { return proxy::ResidueSpan(m_residues.data
 proxy::MoleculeSpan Frame::molecules() { return proxy::MoleculeSpan(m_molecules.data(), m_molecules.size()); }
 proxy::CoordSpan Frame::coords() { return proxy::CoordSpan(*this, m_coordinates.data(), m_coordinates.size()); }
 
+proxy::VelocitySpan Frame::velocities() {
+  if (!m_has_velocities) {
+    return {};
+  }
+  return proxy::VelocitySpan(*this, m_velocities, 0, m_velocities.size());
+}
+
+proxy::ForceSpan Frame::forces() {
+  if (!m_has_forces) {
+    return {};
+  }
+  return proxy::ForceSpan(*this, m_forces, 0, m_forces.size());
+}
+
+void Frame::add_velocities() {
+  if (!m_has_velocities) {
+    m_velocities.assign(n_atoms(), XYZ{});
+    m_has_velocities = true;
+  }
+}
+
+void Frame::add_forces() {
+  if (!m_has_forces) {
+    m_forces.assign(n_atoms(), XYZ{});
+    m_has_forces = true;
+  }
+}
+
+void Frame::remove_velocities() {
+  m_velocities = {};
+  m_has_velocities = false;
+}
+
+void Frame::remove_forces() {
+  m_forces = {};
+  m_has_forces = false;
+}
+
 void Frame::notify_atoms_move(BaseAtom* old_begin, BaseAtom* old_end, BaseAtom* new_begin) const {
   if (old_begin != new_begin) {
     utils::Observable<AtomSmartRef>::notify(&AtomSmartRef::on_base_atoms_move, old_begin, old_end, new_begin);
@@ -64,6 +64,15 @@ template <typename Atoms> Eigen::Matrix3d calc_intertia_tensor_atoms_impl(Atoms&
   return calc_inertia_tensor(coords, mass_span);
 }
 
+using ConstCoordEigenMatrixMapf = Eigen::Map<const xmol::CoordEigenMatrixf>;
+
+ConstCoordEigenMatrixMapf as_matrix(const xmol::future::Span<float>& coords) {
+  if (coords.size() % 3 != 0) {
+    throw xmol::geom::GeomError("coordinates size (=" + std::to_string(coords.size()) + ") is not a multiple of 3");
+  }
+  return ConstCoordEigenMatrixMapf(coords.data(), coords.size() / 3, 3);
+}
+
 } // namespace
 
 Transformation3d xmol::algo::calc_alignment(proxy::CoordSpan& reference, proxy::CoordSpan& variable) {
@@ -92,6 +101,11 @@ Transformation3d xmol::algo::calc_alignment(xmol::proxy::AtomSelection& referenc
   return calc_alignment_atoms_impl(reference, variable);
 }
 
+Transformation3d xmol::algo::calc_alignment(const future::Span<float>& reference,
+                                            const future::Span<float>& variable) {
+  return calc_alignment_impl(as_matrix(reference), as_matrix(variable));
+}
+
 double xmol::algo::calc_rmsd(proxy::CoordSpan& reference, proxy::CoordSpan& variable) {
   return calc_rmsd_impl(reference._eigen(), variable._eigen());
 }
@@ -105,6 +119,16 @@ double xmol::algo::calc_rmsd(proxy::CoordSelection& reference, proxy::CoordSelec
   return calc_rmsd_impl(reference._eigen(), variable._eigen());
 }
 
+double xmol::algo::calc_rmsd(const future::Span<float>& reference, const future::Span<float>& variable) {
+  auto X = as_matrix(reference);
+  auto Y = as_matrix(variable);
+  if (X.rows() != Y.rows()) {
+    throw geom::GeomError("rmsd: reference.size (=" + std::to_string(X.rows()) + ") != variable.size (=" +
+                          std::to_string(Y.rows()) + ")");
+  }
+  return calc_rmsd_impl(X, Y);
+}
+
 double xmol::algo::calc_weighted_rmsd(proxy::AtomSpan& reference, proxy::AtomSpan& variable) {
   return calc_weighted_rmsd_atoms_impl(reference, variable);
 }
@@ -112,3 +112,15 @@ void xmol::algo::calc_sasa(const future::Span<geom::XYZ>& coords, future::Span<d
     result[i1] = atom_area;
   }
 }
+
+void xmol::algo::calc_sasa(const future::Span<float>& coords, future::Span<double> coord_radii, double solvent_radii,
+                           future::Span<double> result, int n_samples, const future::Span<int>& sasa_points_indices) {
+  if (coords.size() % 3 != 0) {
+    throw GeomError("xmol::algo::calc_sasa: coords.size() is not a multiple of 3");
+  }
+  std::vector<XYZ> wide(coords.size() / 3);
+  for (size_t i = 0; i < wide.size(); ++i) {
+    wide[i] = XYZ(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+  }
+  calc_sasa(future::Span(wide), coord_radii, solvent_radii, result, n_samples, sasa_points_indices);
+}
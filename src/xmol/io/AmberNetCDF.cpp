@@ -1,23 +1,35 @@
 #include "xmol/io/AmberNetCDF.h"
+#include "netcdf_utils.h"
 #include "xmol/Frame.h"
 #include "xmol/geom/AngleValue.h"
+#include <algorithm>
 #include <iostream>
 #include <netcdf.h>
 #include <utility>
 
 using namespace xmol::io;
 
+using xmol::io::netcdf::check_netcdf_call;
+using xmol::io::netcdf::netcdf_mutex;
+
 namespace {
-inline void check_netcdf_call(int retval, int expected, const char* const nc_funciton_name) {
-  if (retval != expected) {
-    throw std::runtime_error(std::string(nc_funciton_name) + " failed (" + std::to_string(retval) + ")");
-  }
-}
+/// Upper bound of automatically chosen block size
+constexpr size_t MaxAutoBlockFrames = 64;
+/// Upper bound of coordinates buffer for automatically chosen block size
+constexpr size_t MaxAutoBlockBytes = 32 * 1024 * 1024;
 } // namespace
 
-AmberNetCDF::AmberNetCDF(std::string filename) : m_filename(std::move(filename)) {
+AmberNetCDF::AmberNetCDF(std::string filename) : AmberNetCDF(std::move(filename), 0) {}
+
+AmberNetCDF::AmberNetCDF(std::string filename, size_t block_frames)
+    : m_filename(std::move(filename)), m_block_frames(block_frames) {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
   read_header();
   close();
+  if (m_block_frames == 0) {
+    size_t frame_bytes = std::max<size_t>(m_n_atoms, 1) * 3 * sizeof(float);
+    m_block_frames = std::clamp<size_t>(MaxAutoBlockBytes / frame_bytes, 1, MaxAutoBlockFrames);
+  }
 }
 
 void AmberNetCDF::open() {
@@ -29,6 +41,7 @@ void AmberNetCDF::open() {
 }
 
 AmberNetCDF::~AmberNetCDF() {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
   if (m_is_open) {
     close();
   }
@@ -66,21 +79,119 @@ std::string AmberNetCDF::read_global_string_attr(const char* name) {
 
 size_t xmol::io::AmberNetCDF::n_frames() const { return m_n_frames; }
 size_t xmol::io::AmberNetCDF::n_atoms() const { return m_n_atoms; }
-void xmol::io::AmberNetCDF::read_frame(size_t index, Frame& frame) {
-  auto coordinates = frame.coords();
+void xmol::io::AmberNetCDF::read_frame(size_t /*index*/, Frame& frame) {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
+  const bool with_velocities = m_has_velocities && frame.has_velocities();
+  const size_t pos = block_position(m_current_frame, with_velocities);
+  CoordEigenMatrixMapf buffer_map(m_block.coords.data() + pos * n_atoms() * 3, n_atoms(), 3);
+  frame.coords()._eigen() = buffer_map.cast<double>();
+  if (with_velocities) {
+    CoordEigenMatrixMapf velocities_map(m_block.velocities.data() + pos * n_atoms() * 3, n_atoms(), 3);
+    frame.velocities()._eigen() = velocities_map.cast<double>() * m_velocities_scale;
+  }
+
+  if (m_has_cell) {
+    const float* lengths = m_block.cell_lengths.data() + pos * 3;
+    const float* angles = m_block.cell_angles.data() + pos * 3;
+    frame.cell = geom::UnitCell(lengths[0], lengths[1], lengths[2], geom::Degrees(angles[0]), geom::Degrees(angles[1]),
+                                geom::Degrees(angles[2]));
+  }
+  if (m_has_time) {
+    frame.time = m_block.time[pos];
+  }
+}
+
+size_t xmol::io::AmberNetCDF::block_position(size_t frame_index, bool with_velocities) {
+  assert(frame_index < n_frames());
+  m_read_since_advance = true;
+  if (m_block.size > 0 && frame_index >= m_block.begin && (frame_index - m_block.begin) % m_block.stride == 0 &&
+      (frame_index - m_block.begin) / m_block.stride < m_block.size &&
+      (!with_velocities || !m_block.velocities.empty())) {
+    return (frame_index - m_block.begin) / m_block.stride;
+  }
   this->open();
+  // block is read only for regular stride, irregular (random) access reads single frames
+  const size_t stride = m_confirmed_stride > 0 ? m_confirmed_stride : 1;
+  const size_t size =
+      m_confirmed_stride > 0 ? std::min(m_block_frames, (n_frames() - frame_index + stride - 1) / stride) : 1;
+  m_block.size = 0; // invalidate block in case of read failure
+  m_block.coords.resize(size * n_atoms() * 3);
   {
-    m_buffer.resize(n_atoms() * 3);
+    size_t start[] = {frame_index, 0, 0};
+    size_t count[] = {size, n_atoms(), 3};
+    ptrdiff_t strides[] = {static_cast<ptrdiff_t>(stride), 1, 1};
+    check_netcdf_call(nc_get_vars_float(m_ncid, m_coords_id, start, count, strides, m_block.coords.data()), NC_NOERR,
+                      "nc_get_vars_float");
+    m_block.velocities.clear();
+    if (with_velocities) {
+      m_block.velocities.resize(size * n_atoms() * 3);
+      check_netcdf_call(
+          nc_get_vars_float(m_ncid, m_velocities_id, start, count, strides, m_block.velocities.data()), NC_NOERR,
+          "nc_get_vars_float");
+    }
+  }
+  if (m_has_cell) {
+    m_block.cell_lengths.resize(size * 3);
+    m_block.cell_angles.resize(size * 3);
+    size_t start[] = {frame_index, 0};
+    size_t count[] = {size, 3};
+    ptrdiff_t strides[] = {static_cast<ptrdiff_t>(stride), 1};
+    check_netcdf_call(
+        nc_get_vars_float(m_ncid, m_cell_lengths_id, start, count, strides, m_block.cell_lengths.data()), NC_NOERR,
+        "nc_get_vars_float");
+    check_netcdf_call(nc_get_vars_float(m_ncid, m_cell_angles_id, start, count, strides, m_block.cell_angles.data()),
+                      NC_NOERR, "nc_get_vars_float");
+  }
+  if (m_has_time) {
+    m_block.time.resize(size);
+    size_t start[] = {frame_index};
+    size_t count[] = {size};
+    ptrdiff_t strides[] = {static_cast<ptrdiff_t>(stride)};
+    check_netcdf_call(nc_get_vars_float(m_ncid, m_time_id, start, count, strides, m_block.time.data()), NC_NOERR,
+                      "nc_get_vars_float");
+  }
+  m_block.begin = frame_index;
+  m_block.stride = stride;
+  m_block.size = size;
+  ++m_n_block_reads;
+  return 0;
+}
+
+void xmol::io::AmberNetCDF::read_frame_atoms(size_t /*index*/, const std::vector<AtomIndex>& atoms, Frame& frame) {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
+  assert(frame.coords().size() == atoms.size());
+  this->open();
+  m_read_since_advance = true;
+  m_buffer.resize(atoms.size() * 3);
+
+  read_atom_runs(m_coords_id, atoms, m_buffer.data());
+  CoordEigenMatrixMapf buffer_map(m_buffer.data(), atoms.size(), 3);
+  frame.coords()._eigen() = buffer_map.cast<double>();
 
-    size_t start[] = {static_cast<size_t>(m_current_frame), 0, 0};
-    size_t count[] = {1, static_cast<size_t>(n_atoms()), 3};
+  if (m_has_velocities && frame.has_velocities()) {
+    read_atom_runs(m_velocities_id, atoms, m_buffer.data());
+    frame.velocities()._eigen() = buffer_map.cast<double>() * m_velocities_scale;
+  }
+
+  read_cell_and_time(frame);
+}
 
-    check_netcdf_call(nc_get_vara_float(m_ncid, m_coords_id, start, count, m_buffer.data()), NC_NOERR,
+void xmol::io::AmberNetCDF::read_atom_runs(int var_id, const std::vector<AtomIndex>& atoms, float* dst) {
+  // read contiguous runs of selected atoms with single hyperslab request each
+  for (size_t run_begin = 0; run_begin < atoms.size();) {
+    size_t run_end = run_begin + 1;
+    while (run_end < atoms.size() && atoms[run_end] == atoms[run_end - 1] + 1) {
+      ++run_end;
+    }
+    size_t start[] = {static_cast<size_t>(m_current_frame), static_cast<size_t>(atoms[run_begin]), 0};
+    size_t count[] = {1, run_end - run_begin, 3};
+    check_netcdf_call(nc_get_vara_float(m_ncid, var_id, start, count, dst + run_begin * 3), NC_NOERR,
                       "nc_get_vara_float");
-    CoordEigenMatrixMapf buffer_map(m_buffer.data(), n_atoms(), 3);
-    coordinates._eigen() = buffer_map.cast<double>();
+    run_begin = run_end;
   }
+}
 
+void xmol::io::AmberNetCDF::read_cell_and_time(Frame& frame) {
   if (m_has_cell) {
     float lengths[3];
     float angles[3];
@@ -94,14 +205,36 @@ void xmol::io::AmberNetCDF::read_frame(size_t index, Frame& frame) {
     frame.cell = geom::UnitCell(lengths[0], lengths[1], lengths[2], geom::Degrees(angles[0]), geom::Degrees(angles[1]),
                                 geom::Degrees(angles[2]));
   }
+  if (m_has_time) {
+    float time;
+    size_t start[] = {static_cast<size_t>(m_current_frame)};
+    size_t count[] = {1};
+    check_netcdf_call(nc_get_vara_float(m_ncid, m_time_id, start, count, &time), NC_NOERR, "nc_get_vara_float");
+    frame.time = time;
+  }
+}
+
+void xmol::io::AmberNetCDF::read_coords(size_t /*index*/, const future::Span<float>& coords) {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
+  assert(coords.size() == n_atoms() * 3);
+  const size_t pos = block_position(m_current_frame, false);
+  std::copy_n(m_block.coords.data() + pos * n_atoms() * 3, n_atoms() * 3, coords.data());
 }
 
 void xmol::io::AmberNetCDF::advance(size_t shift) {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
   m_current_frame += shift;
+  if (m_read_since_advance && shift > 0) {
+    m_confirmed_stride = shift == m_stride ? shift : 0;
+    m_stride = shift;
+  }
+  m_read_since_advance = false;
 
   if (m_current_frame >= n_frames()) {
     close();
     m_current_frame = 0;
+    m_stride = 0;
+    m_confirmed_stride = 0;
     return;
   }
 
@@ -109,6 +242,30 @@ void xmol::io::AmberNetCDF::advance(size_t shift) {
     open();
   }
 }
+
+void xmol::io::AmberNetCDF::seek(size_t /*current*/, size_t index) {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
+  assert(index < n_frames());
+  // random access has no stride, next read fetches single frame unless it's already in block
+  m_current_frame = index;
+  m_stride = 0;
+  m_confirmed_stride = 0;
+  m_read_since_advance = false;
+  if (!m_is_open) {
+    open();
+  }
+}
+std::optional<double> AmberNetCDF::frame_time(size_t index) const {
+  if (!m_has_time) {
+    return std::nullopt;
+  }
+  return m_times[index];
+}
+
+std::unique_ptr<xmol::trajectory::TrajectoryInputFile> AmberNetCDF::clone() const {
+  return std::make_unique<AmberNetCDF>(m_filename, m_block_frames);
+}
+
 void AmberNetCDF::read_header() {
   this->open();
 
@@ -131,4 +288,19 @@ void AmberNetCDF::read_header() {
   auto cell_angles_status = nc_inq_varid(m_ncid, "cell_angles", &m_cell_angles_id);
 
   m_has_cell = cell_length_status == NC_NOERR && cell_angles_status == NC_NOERR;
+
+  m_has_time = nc_inq_varid(m_ncid, "time", &m_time_id) == NC_NOERR;
+  m_times.clear();
+  if (m_has_time && m_n_frames > 0) { // whole time table is small, it allows lookup of frames by time
+    m_times.resize(m_n_frames);
+    size_t start[] = {0};
+    size_t count[] = {m_n_frames};
+    check_netcdf_call(nc_get_vara_float(m_ncid, m_time_id, start, count, m_times.data()), NC_NOERR,
+                      "nc_get_vara_float");
+  }
+
+  m_has_velocities = nc_inq_varid(m_ncid, "velocities", &m_velocities_id) == NC_NOERR;
+  if (m_has_velocities && nc_get_att_float(m_ncid, m_velocities_id, "scale_factor", &m_velocities_scale) != NC_NOERR) {
+    m_velocities_scale = 1;
+  }
 }
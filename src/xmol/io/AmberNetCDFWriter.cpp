@@ -0,0 +1,222 @@
+#include "xmol/io/AmberNetCDFWriter.h"
+#include "netcdf_utils.h"
+#include "xmol/Frame.h"
+#include <cstring>
+#include <netcdf.h>
+#include <utility>
+
+using namespace xmol::io;
+
+using xmol::io::netcdf::check_netcdf_call;
+using xmol::io::netcdf::netcdf_mutex;
+
+namespace {
+void put_text_attr(int ncid, int varid, const char* name, const std::string& value) {
+  check_netcdf_call(nc_put_att_text(ncid, varid, name, value.size(), value.c_str()), NC_NOERR, "nc_put_att_text()");
+}
+} // namespace
+
+AmberNetCDFWriter::AmberNetCDFWriter(std::string filename, size_t buffer_frames)
+    : m_filename(std::move(filename)), m_buffer_frames(std::max<size_t>(buffer_frames, 1)) {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
+  check_netcdf_call(nc_create(m_filename.c_str(), NC_CLOBBER | NC_NETCDF4, &m_ncid), NC_NOERR, "nc_create()");
+  m_is_open = true;
+}
+
+AmberNetCDFWriter::~AmberNetCDFWriter() {
+  try {
+    close();
+  } catch (...) {
+    // destructor must not throw, call close() explicitly to handle errors
+  }
+}
+
+void AmberNetCDFWriter::write(Frame& frame) {
+  if (!frame.has_velocities()) {
+    append(frame, nullptr);
+    return;
+  }
+  auto velocities = frame.velocities()._eigen();
+  m_frame_velocities.resize(velocities.size());
+  CoordEigenMatrixMapf(m_frame_velocities.data(), velocities.rows(), 3) = velocities.cast<float>();
+  append(frame, m_frame_velocities.data());
+}
+
+void AmberNetCDFWriter::write(Frame& frame, const future::Span<const float>& velocities) {
+  if (velocities.size() != frame.n_atoms() * 3) {
+    throw std::runtime_error("AmberNetCDFWriter::write(): velocities size mismatch: " +
+                             std::to_string(velocities.size()) + " != " + std::to_string(frame.n_atoms() * 3));
+  }
+  append(frame, velocities.data());
+}
+
+void AmberNetCDFWriter::append(Frame& frame, const float* velocities) {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
+  if (!m_is_open) {
+    throw std::runtime_error("AmberNetCDFWriter::write(): `" + m_filename + "` is closed");
+  }
+  const bool has_cell = frame.cell.volume() != 1.0; // unit cubic cell stands for absent cell
+  if (!m_is_defined) {
+    define(frame.n_atoms(), velocities != nullptr, has_cell);
+  }
+  if (frame.n_atoms() != m_n_atoms) {
+    throw std::runtime_error("AmberNetCDFWriter::write(): n_atoms() mismatch: " + std::to_string(frame.n_atoms()) +
+                             " != " + std::to_string(m_n_atoms));
+  }
+  if ((velocities != nullptr) != m_has_velocities) {
+    throw std::runtime_error(std::string("AmberNetCDFWriter::write(): velocities are ") +
+                             (m_has_velocities ? "required" : "not expected") +
+                             ", all frames must be written either with or without velocities");
+  }
+  if (has_cell != m_has_cell) {
+    throw std::runtime_error(std::string("AmberNetCDFWriter::write(): cell is ") +
+                             (m_has_cell ? "required" : "not expected") +
+                             ", all frames must be written either with or without cell");
+  }
+
+  const size_t i = m_n_buffered;
+  m_time[i] = static_cast<float>(frame.time);
+  CoordEigenMatrixMapf coords_map(m_coords.data() + i * m_n_atoms * 3, m_n_atoms, 3);
+  coords_map = frame.coords()._eigen().cast<float>();
+  if (m_has_velocities) {
+    std::memcpy(m_velocities.data() + i * m_n_atoms * 3, velocities, m_n_atoms * 3 * sizeof(float));
+  }
+  if (m_has_cell) {
+    auto& cell = frame.cell;
+    double lengths[] = {cell.a(), cell.b(), cell.c()};
+    double angles[] = {cell.alpha().degrees(), cell.beta().degrees(), cell.gamma().degrees()};
+    std::copy(lengths, lengths + 3, m_cell_lengths.data() + i * 3);
+    std::copy(angles, angles + 3, m_cell_angles.data() + i * 3);
+  }
+
+  if (++m_n_buffered == m_buffer_frames) {
+    flush();
+  }
+}
+
+void AmberNetCDFWriter::flush() {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
+  if (m_n_buffered == 0) {
+    return;
+  }
+  {
+    size_t start[] = {m_n_stored};
+    size_t count[] = {m_n_buffered};
+    check_netcdf_call(nc_put_vara_float(m_ncid, m_time_id, start, count, m_time.data()), NC_NOERR,
+                      "nc_put_vara_float()");
+  }
+  {
+    size_t start[] = {m_n_stored, 0, 0};
+    size_t count[] = {m_n_buffered, m_n_atoms, 3};
+    check_netcdf_call(nc_put_vara_float(m_ncid, m_coords_id, start, count, m_coords.data()), NC_NOERR,
+                      "nc_put_vara_float()");
+    if (m_has_velocities) {
+      check_netcdf_call(nc_put_vara_float(m_ncid, m_velocities_id, start, count, m_velocities.data()), NC_NOERR,
+                        "nc_put_vara_float()");
+    }
+  }
+  if (m_has_cell) {
+    size_t start[] = {m_n_stored, 0};
+    size_t count[] = {m_n_buffered, 3};
+    check_netcdf_call(nc_put_vara_double(m_ncid, m_cell_lengths_id, start, count, m_cell_lengths.data()), NC_NOERR,
+                      "nc_put_vara_double()");
+    check_netcdf_call(nc_put_vara_double(m_ncid, m_cell_angles_id, start, count, m_cell_angles.data()), NC_NOERR,
+                      "nc_put_vara_double()");
+  }
+  m_n_stored += m_n_buffered;
+  m_n_buffered = 0;
+}
+
+void AmberNetCDFWriter::close() {
+  std::lock_guard<std::recursive_mutex> lock(netcdf_mutex());
+  if (!m_is_open) {
+    return;
+  }
+  m_is_open = false;
+  try {
+    flush();
+  } catch (...) {
+    nc_close(m_ncid);
+    throw;
+  }
+  check_netcdf_call(nc_close(m_ncid), NC_NOERR, "nc_close()");
+}
+
+void AmberNetCDFWriter::define(size_t n_atoms, bool has_velocities, bool has_cell) {
+  m_n_atoms = n_atoms;
+  m_has_velocities = has_velocities;
+  m_has_cell = has_cell;
+
+  put_text_attr(m_ncid, NC_GLOBAL, "Conventions", "AMBER");
+  put_text_attr(m_ncid, NC_GLOBAL, "ConventionVersion", "1.0");
+  put_text_attr(m_ncid, NC_GLOBAL, "program", "xmolpp2");
+  put_text_attr(m_ncid, NC_GLOBAL, "programVersion", "2");
+
+  int frame_dim, spatial_dim, atom_dim;
+  int cell_spatial_dim = -1, cell_angular_dim = -1, label_dim = -1;
+  check_netcdf_call(nc_def_dim(m_ncid, "frame", NC_UNLIMITED, &frame_dim), NC_NOERR, "nc_def_dim()");
+  check_netcdf_call(nc_def_dim(m_ncid, "spatial", 3, &spatial_dim), NC_NOERR, "nc_def_dim()");
+  check_netcdf_call(nc_def_dim(m_ncid, "atom", n_atoms, &atom_dim), NC_NOERR, "nc_def_dim()");
+
+  int spatial_id, cell_spatial_id = -1, cell_angular_id = -1;
+  check_netcdf_call(nc_def_var(m_ncid, "spatial", NC_CHAR, 1, &spatial_dim, &spatial_id), NC_NOERR, "nc_def_var()");
+  if (has_cell) {
+    check_netcdf_call(nc_def_dim(m_ncid, "cell_spatial", 3, &cell_spatial_dim), NC_NOERR, "nc_def_dim()");
+    check_netcdf_call(nc_def_dim(m_ncid, "cell_angular", 3, &cell_angular_dim), NC_NOERR, "nc_def_dim()");
+    check_netcdf_call(nc_def_dim(m_ncid, "label", 5, &label_dim), NC_NOERR, "nc_def_dim()");
+    check_netcdf_call(nc_def_var(m_ncid, "cell_spatial", NC_CHAR, 1, &cell_spatial_dim, &cell_spatial_id), NC_NOERR,
+                      "nc_def_var()");
+    int dims[] = {cell_angular_dim, label_dim};
+    check_netcdf_call(nc_def_var(m_ncid, "cell_angular", NC_CHAR, 2, dims, &cell_angular_id), NC_NOERR,
+                      "nc_def_var()");
+  }
+
+  check_netcdf_call(nc_def_var(m_ncid, "time", NC_FLOAT, 1, &frame_dim, &m_time_id), NC_NOERR, "nc_def_var()");
+  put_text_attr(m_ncid, m_time_id, "units", "picosecond");
+
+  // per-frame variables are chunked by frame to keep single frame reads cheap
+  {
+    int dims[] = {frame_dim, atom_dim, spatial_dim};
+    size_t chunks[] = {1, n_atoms, 3};
+    check_netcdf_call(nc_def_var(m_ncid, "coordinates", NC_FLOAT, 3, dims, &m_coords_id), NC_NOERR, "nc_def_var()");
+    check_netcdf_call(nc_def_var_chunking(m_ncid, m_coords_id, NC_CHUNKED, chunks), NC_NOERR,
+                      "nc_def_var_chunking()");
+    put_text_attr(m_ncid, m_coords_id, "units", "angstrom");
+    if (has_velocities) {
+      check_netcdf_call(nc_def_var(m_ncid, "velocities", NC_FLOAT, 3, dims, &m_velocities_id), NC_NOERR,
+                        "nc_def_var()");
+      check_netcdf_call(nc_def_var_chunking(m_ncid, m_velocities_id, NC_CHUNKED, chunks), NC_NOERR,
+                        "nc_def_var_chunking()");
+      put_text_attr(m_ncid, m_velocities_id, "units", "angstrom/picosecond");
+    }
+  }
+  if (has_cell) {
+    int lengths_dims[] = {frame_dim, cell_spatial_dim};
+    int angles_dims[] = {frame_dim, cell_angular_dim};
+    check_netcdf_call(nc_def_var(m_ncid, "cell_lengths", NC_DOUBLE, 2, lengths_dims, &m_cell_lengths_id), NC_NOERR,
+                      "nc_def_var()");
+    check_netcdf_call(nc_def_var(m_ncid, "cell_angles", NC_DOUBLE, 2, angles_dims, &m_cell_angles_id), NC_NOERR,
+                      "nc_def_var()");
+    put_text_attr(m_ncid, m_cell_lengths_id, "units", "angstrom");
+    put_text_attr(m_ncid, m_cell_angles_id, "units", "degree");
+  }
+
+  check_netcdf_call(nc_enddef(m_ncid), NC_NOERR, "nc_enddef()");
+
+  check_netcdf_call(nc_put_var_text(m_ncid, spatial_id, "xyz"), NC_NOERR, "nc_put_var_text()");
+  if (has_cell) {
+    check_netcdf_call(nc_put_var_text(m_ncid, cell_spatial_id, "abc"), NC_NOERR, "nc_put_var_text()");
+    check_netcdf_call(nc_put_var_text(m_ncid, cell_angular_id, "alphabeta gamma"), NC_NOERR, "nc_put_var_text()");
+  }
+
+  m_time.resize(m_buffer_frames);
+  m_coords.resize(m_buffer_frames * n_atoms * 3);
+  if (has_velocities) {
+    m_velocities.resize(m_buffer_frames * n_atoms * 3);
+  }
+  if (has_cell) {
+    m_cell_lengths.resize(m_buffer_frames * 3);
+    m_cell_angles.resize(m_buffer_frames * 3);
+  }
+  m_is_defined = true;
+}
@@ -0,0 +1,296 @@
+#include "xmol/io/DcdFile.h"
+#include "byte_order.h"
+#include "xmol/Frame.h"
+#include "xmol/geom/UnitCell.h"
+
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+using namespace xmol::io;
+
+using xmol::io::byte_order::load;
+using xmol::io::byte_order::load_floats;
+
+namespace {
+/// CHARMM AKMA time unit in picoseconds
+constexpr double AkmaTimeUnit = 0.04888821;
+/// Size of header record payload: "CORD" + 20 control integers
+constexpr size_t HeaderRecordSize = 84;
+/// Size of unit cell record payload: 6 doubles
+constexpr size_t CellRecordSize = 6 * sizeof(double);
+} // namespace
+
+DcdFile::DcdFile(std::string filename) : m_filename(std::move(filename)) {
+  read_header();
+  advance(n_frames());
+}
+size_t DcdFile::n_frames() const { return m_n_frames; }
+size_t DcdFile::n_atoms() const { return m_n_atoms; }
+
+void DcdFile::read_frame(size_t index, Frame& frame) {
+  auto coordinates = frame.coords();
+  assert(m_mapping);
+  assert(m_current_frame == index);
+  assert(coordinates.size() == n_atoms());
+
+  load_coords(index, nullptr, coordinates._eigen().data());
+  read_cell_and_time(index, frame);
+}
+void DcdFile::read_coords(size_t index, const future::Span<float>& coords) {
+  assert(m_mapping);
+  assert(m_current_frame == index);
+  assert(coords.size() == n_atoms() * 3);
+
+  load_coords(index, nullptr, coords.data());
+}
+void DcdFile::read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) {
+  auto coordinates = frame.coords();
+  assert(m_mapping);
+  assert(m_current_frame == index);
+  assert(coordinates.size() == atoms.size());
+
+  load_coords(index, &atoms, coordinates._eigen().data());
+  read_cell_and_time(index, frame);
+}
+
+template <typename T> void DcdFile::load_coords(size_t index, const std::vector<AtomIndex>* atoms, T* dst) {
+  const char* data = frame_data(index) + (m_has_cell ? CellRecordSize + 2 * m_marker_size : 0);
+  const bool all_atoms_stored = index == 0 || m_free_atoms.size() == m_n_atoms;
+  const size_t n_stored = all_atoms_stored ? m_n_atoms : m_free_atoms.size();
+  const size_t record_size = n_stored * sizeof(float) + 2 * m_marker_size;
+
+  // coordinates are stored as X, Y and Z records
+  for (size_t dim = 0; dim < 3; ++dim) {
+    const char* component = data + dim * record_size + m_marker_size;
+    if (!atoms && all_atoms_stored) {
+      load_floats(component, m_n_atoms, m_swap_bytes, dst + dim, 3);
+    } else if (!atoms) {
+      const auto& first_coords = *m_first_coords;
+      for (size_t i = 0; i < m_n_atoms; ++i) {
+        dst[i * 3 + dim] = first_coords[i * 3 + dim];
+      }
+      for (size_t i = 0; i < m_free_atoms.size(); ++i) {
+        dst[m_free_atoms[i] * 3 + dim] = load<float>(component + i * sizeof(float), m_swap_bytes);
+      }
+    } else {
+      for (size_t i = 0; i < atoms->size(); ++i) {
+        const AtomIndex atom = (*atoms)[i];
+        const int32_t pos = all_atoms_stored ? atom : m_free_position[atom];
+        dst[i * 3 + dim] =
+            pos < 0 ? (*m_first_coords)[atom * 3 + dim] : load<float>(component + pos * sizeof(float), m_swap_bytes);
+      }
+    }
+  }
+}
+
+void DcdFile::read_cell_and_time(size_t index, Frame& frame) {
+  frame.time = *frame_time(index);
+  if (!m_has_cell) {
+    return;
+  }
+  const char* data = frame_data(index) + m_marker_size;
+  double values[6];
+  for (size_t i = 0; i < 6; ++i) {
+    values[i] = load<double>(data + i * sizeof(double), m_swap_bytes);
+  }
+  // record layout: A, gamma, B, beta, alpha, C
+  double a = values[0], b = values[2], c = values[5];
+  double alpha = values[4], beta = values[3], gamma = values[1];
+  if (std::abs(alpha) <= 1 && std::abs(beta) <= 1 && std::abs(gamma) <= 1) {
+    // recent CHARMM and NAMD versions store cosines of angles
+    alpha = geom::radians_to_degrees(std::acos(alpha));
+    beta = geom::radians_to_degrees(std::acos(beta));
+    gamma = geom::radians_to_degrees(std::acos(gamma));
+  }
+  if (a > 0 && b > 0 && c > 0) {
+    frame.cell = geom::UnitCell(a, b, c, geom::Degrees(alpha), geom::Degrees(beta), geom::Degrees(gamma));
+  }
+}
+
+void DcdFile::seek(size_t current, size_t index) {
+  assert(current == m_current_frame);
+  if (index >= current) {
+    advance(index - current);
+    return;
+  }
+  m_current_frame = index; // frames are read from mapping which is alive at `current > 0`
+}
+
+std::optional<double> DcdFile::frame_time(size_t index) const {
+  return (m_first_step + static_cast<double>(index) * m_steps_per_frame) * m_timestep;
+}
+
+std::unique_ptr<xmol::trajectory::TrajectoryInputFile> DcdFile::clone() const {
+  std::unique_ptr<DcdFile> result(new DcdFile());
+  result->m_filename = m_filename;
+  result->m_swap_bytes = m_swap_bytes;
+  result->m_marker_size = m_marker_size;
+  result->m_has_cell = m_has_cell;
+  result->m_has_4d = m_has_4d;
+  result->m_n_atoms = m_n_atoms;
+  result->m_n_frames = m_n_frames;
+  result->m_first_frame_offset = m_first_frame_offset;
+  result->m_first_frame_size = m_first_frame_size;
+  result->m_frame_size = m_frame_size;
+  result->m_first_step = m_first_step;
+  result->m_steps_per_frame = m_steps_per_frame;
+  result->m_timestep = m_timestep;
+  result->m_free_atoms = m_free_atoms;
+  result->m_free_position = m_free_position;
+  result->m_first_coords = m_first_coords;
+  return result; // mapping is created by advance(), pages are shared by OS
+}
+
+const xmol::utils::MappedFile& DcdFile::mapping() {
+  if (!m_mapping) {
+    m_mapping = std::make_shared<const utils::MappedFile>(m_filename);
+  }
+  return *m_mapping;
+}
+
+const char* DcdFile::frame_data(size_t index) {
+  size_t offset = m_first_frame_offset;
+  if (index > 0) {
+    offset += m_first_frame_size + (index - 1) * m_frame_size;
+  }
+  return m_mapping->data() + offset;
+}
+
+void DcdFile::read_header() {
+  const auto& file = mapping();
+
+  auto check_size = [&](size_t end) {
+    if (end > file.size()) {
+      throw std::runtime_error("DcdFile::open(): unexpected EOF in `" + m_filename + "`");
+    }
+  };
+
+  check_size(2 * sizeof(uint64_t) - sizeof(uint32_t));
+  if (std::memcmp(file.data() + sizeof(uint32_t), "CORD", 4) == 0) {
+    m_marker_size = sizeof(uint32_t);
+  } else if (std::memcmp(file.data() + sizeof(uint64_t), "CORD", 4) == 0) {
+    m_marker_size = sizeof(uint64_t);
+  } else {
+    throw std::runtime_error("DcdFile::open(): `" + m_filename + "` is not a DCD file");
+  }
+
+  auto read_marker = [&](size_t pos) -> uint64_t {
+    check_size(pos + m_marker_size);
+    if (m_marker_size == sizeof(uint32_t)) {
+      return load<uint32_t>(file.data() + pos, m_swap_bytes);
+    }
+    return load<uint64_t>(file.data() + pos, m_swap_bytes);
+  };
+
+  if (read_marker(0) != HeaderRecordSize) {
+    m_swap_bytes = true;
+    if (read_marker(0) != HeaderRecordSize) {
+      throw std::runtime_error("DcdFile::open(): `" + m_filename + "` has bad header record size");
+    }
+  }
+
+  size_t pos = 0;
+  /// Skips Fortran record at `pos`, returns offset and size of its payload
+  auto read_record = [&]() -> std::pair<size_t, size_t> {
+    const size_t size = read_marker(pos);
+    const size_t begin = pos + m_marker_size;
+    check_size(begin + size);
+    if (read_marker(begin + size) != size) {
+      throw std::runtime_error("DcdFile::open(): corrupted record at offset " + std::to_string(pos) + " in `" +
+                               m_filename + "`");
+    }
+    pos = begin + size + m_marker_size;
+    return {begin, size};
+  };
+  auto read_int32 = [&](size_t offset) { return load<int32_t>(file.data() + offset, m_swap_bytes); };
+
+  const size_t header = read_record().first + 4; // skip "CORD"
+  int32_t control[20];
+  for (size_t i = 0; i < 20; ++i) {
+    control[i] = read_int32(header + i * sizeof(int32_t));
+  }
+  const bool is_charmm = control[19] != 0;
+  m_first_step = control[1];
+  m_steps_per_frame = control[2];
+  const int32_t n_fixed = control[8];
+  const double delta = is_charmm ? load<float>(file.data() + header + 9 * sizeof(int32_t), m_swap_bytes)
+                                 : load<double>(file.data() + header + 9 * sizeof(int32_t), m_swap_bytes);
+  m_timestep = delta * AkmaTimeUnit;
+  m_has_cell = is_charmm && control[10] != 0;
+  m_has_4d = is_charmm && control[11] != 0;
+
+  read_record(); // title
+
+  auto [n_atoms_offset, n_atoms_size] = read_record();
+  if (n_atoms_size != sizeof(int32_t)) {
+    throw std::runtime_error("DcdFile::open(): bad atom count record in `" + m_filename + "`");
+  }
+  const int32_t n_atoms = read_int32(n_atoms_offset);
+  if (n_atoms <= 0 || n_fixed < 0 || n_fixed >= n_atoms) {
+    throw std::runtime_error("DcdFile::open(): bad number of atoms (" + std::to_string(n_atoms) + ", " +
+                             std::to_string(n_fixed) + " fixed) in `" + m_filename + "`");
+  }
+  m_n_atoms = n_atoms;
+
+  m_free_atoms.resize(n_atoms - n_fixed);
+  if (n_fixed > 0) {
+    auto [free_offset, free_size] = read_record();
+    if (free_size != m_free_atoms.size() * sizeof(int32_t)) {
+      throw std::runtime_error("DcdFile::open(): bad free atoms record in `" + m_filename + "`");
+    }
+    for (size_t i = 0; i < m_free_atoms.size(); ++i) {
+      m_free_atoms[i] = read_int32(free_offset + i * sizeof(int32_t)) - 1; // indices are 1-based
+      if (m_free_atoms[i] < 0 || m_free_atoms[i] >= n_atoms) {
+        throw std::runtime_error("DcdFile::open(): free atom index is out of range in `" + m_filename + "`");
+      }
+    }
+  } else {
+    std::iota(m_free_atoms.begin(), m_free_atoms.end(), 0);
+  }
+  m_free_position.assign(m_n_atoms, -1);
+  for (size_t i = 0; i < m_free_atoms.size(); ++i) {
+    m_free_position[m_free_atoms[i]] = i;
+  }
+
+  const size_t cell_size = m_has_cell ? CellRecordSize + 2 * m_marker_size : 0;
+  const size_t n_components = m_has_4d ? 4 : 3;
+  m_first_frame_offset = pos;
+  m_first_frame_size = cell_size + n_components * (m_n_atoms * sizeof(float) + 2 * m_marker_size);
+  m_frame_size = cell_size + n_components * (m_free_atoms.size() * sizeof(float) + 2 * m_marker_size);
+
+  if (file.size() < m_first_frame_offset + m_first_frame_size) {
+    m_n_frames = 0;
+    return;
+  }
+  m_n_frames = 1 + (file.size() - m_first_frame_offset - m_first_frame_size) / m_frame_size;
+
+  // layout of first frame is checked, others are assumed to be the same
+  if (m_has_cell && read_record().second != CellRecordSize) {
+    throw std::runtime_error("DcdFile::open(): bad unit cell record in `" + m_filename + "`");
+  }
+  for (size_t i = 0; i < n_components; ++i) {
+    if (read_record().second != m_n_atoms * sizeof(float)) {
+      throw std::runtime_error("DcdFile::open(): bad coordinates record in `" + m_filename + "`");
+    }
+  }
+
+  if (n_fixed > 0) {
+    auto first_coords = std::make_shared<std::vector<float>>(m_n_atoms * 3);
+    load_coords(0, nullptr, first_coords->data());
+    m_first_coords = std::move(first_coords);
+  }
+}
+
+void DcdFile::advance(size_t shift) {
+  m_current_frame += shift;
+
+  if (m_current_frame >= n_frames()) {
+    m_mapping = {};
+    m_current_frame = 0;
+    return;
+  }
+
+  static_cast<void>(mapping());
+}
@@ -0,0 +1,182 @@
+#include "xmol/io/GromacsTrrFile.h"
+
+xmol::io::GromacsTrrFile::GromacsTrrFile(std::string filename) : m_filename(std::move(filename)) {
+  scan_offsets();
+  read_first_header();
+}
+
+xmol::io::GromacsTrrFile::GromacsTrrFile(std::string filename, std::string index_filename)
+    : m_filename(std::move(filename)) {
+  if (auto offsets = xdr::FrameOffsetIndex::load(index_filename, m_filename)) {
+    m_offsets = std::move(*offsets);
+  } else {
+    scan_offsets();
+    m_offsets.save(index_filename, m_filename); // failure to persist the index is not an error
+  }
+  read_first_header();
+}
+
+void xmol::io::GromacsTrrFile::scan_offsets() {
+  xdr::TrrReader reader(m_filename);
+  if (!reader.scan(m_offsets)) {
+    throw TrrReadError("Can't scan `" + m_filename + "` frame #" + std::to_string(m_offsets.n_frames()) + ": " +
+                       reader.last_error());
+  }
+}
+
+void xmol::io::GromacsTrrFile::read_first_header() {
+  if (m_offsets.n_frames() == 0) {
+    return;
+  }
+  xdr::TrrReader reader(m_filename);
+  if (!reader.seek(m_offsets[0]) || !reader.read_header(m_first_header)) {
+    throw TrrReadError("Can't read `" + m_filename + "` header: " + reader.last_error());
+  }
+}
+
+size_t xmol::io::GromacsTrrFile::n_frames() const { return m_offsets.n_frames(); }
+size_t xmol::io::GromacsTrrFile::n_atoms() const { return m_first_header.n_atoms; }
+
+void xmol::io::GromacsTrrFile::read_frame(size_t index, Frame& frame) {
+  assert(frame.coords().size() == n_atoms());
+
+  std::array<double, 9> box{};
+  auto header = read_frame_data(index, box, frame.has_velocities(), frame.has_forces());
+  assign_frame(header, box, nullptr, frame);
+}
+
+void xmol::io::GromacsTrrFile::read_coords(size_t index, const future::Span<float>& coords) {
+  assert(coords.size() == n_atoms() * 3);
+  std::array<double, 9> box{};
+  read_frame_data(index, box, false, false);
+  CoordEigenMatrixMapf(coords.data(), n_atoms(), 3) =
+      CoordEigenMatrixMap(m_buffer.data(), n_atoms(), 3).cast<float>();
+}
+
+void xmol::io::GromacsTrrFile::read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) {
+  assert(frame.coords().size() == atoms.size());
+
+  std::array<double, 9> box{};
+  auto header = read_frame_data(index, box, frame.has_velocities(), frame.has_forces());
+  assign_frame(header, box, &atoms, frame);
+}
+
+xmol::io::xdr::TrrHeader xmol::io::GromacsTrrFile::read_frame_data(size_t index, std::array<double, 9>& box,
+                                                                   bool with_velocities, bool with_forces) {
+  assert(m_reader);
+  assert(m_current_frame == index);
+
+  xdr::TrrHeader header{};
+  if (!m_reader->read_header(header)) {
+    throw TrrReadError("Can't read frame #" + std::to_string(index) + ": " + std::string(m_reader->last_error()));
+  }
+  if (static_cast<size_t>(header.n_atoms) != n_atoms() || !header.has_coords()) {
+    throw TrrReadError("Frame #" + std::to_string(index) + " of `" + m_filename + "` has " +
+                       std::to_string(header.n_atoms) + " atoms" + (header.has_coords() ? "" : " and no coordinates") +
+                       ", expected " + std::to_string(n_atoms()));
+  }
+
+  // empty buffers make reader skip corresponding blocks
+  m_velocities.resize(with_velocities && header.has_velocities() ? n_atoms() * 3 : 0);
+  m_forces.resize(with_forces && header.has_forces() ? n_atoms() * 3 : 0);
+  if (!m_reader->read_data(header, box, m_buffer, m_velocities, m_forces)) {
+    throw TrrReadError("Can't read frame #" + std::to_string(index) + ": " + std::string(m_reader->last_error()));
+  }
+  // next frame may be preceded by skipped frames without coordinates
+  const bool next_frame_follows = index + 1 < n_frames() && m_reader->tell() == m_offsets[index + 1];
+  m_ahead_of_current_frame = next_frame_follows ? 1 : 0;
+
+  // .trr values are in nanometers, convert to angstroms
+  for (auto& x : m_buffer) {
+    x *= 10;
+  }
+  for (auto& v : m_velocities) {
+    v *= 10; // nm/ps to Å/ps
+  }
+  for (auto& f : m_forces) {
+    f /= 10; // kJ/mol/nm to kJ/mol/Å
+  }
+  return header;
+}
+
+void xmol::io::GromacsTrrFile::assign_frame(const xdr::TrrHeader& header, const std::array<double, 9>& box,
+                                            const std::vector<AtomIndex>* atoms, Frame& frame) {
+  frame.time = header.time;
+  if (header.has_box()) {
+    frame.cell = xmol::geom::UnitCell(XYZ(box[0], box[1], box[2]) * 10,
+                                      XYZ(box[3], box[4], box[5]) * 10,
+                                      XYZ(box[6], box[7], box[8]) * 10); // convert nanometers to angstroms
+  }
+
+  auto assign = [&](const std::vector<double>& values, CoordEigenMatrixMap dst) {
+    CoordEigenMatrixMap values_map(const_cast<double*>(values.data()), n_atoms(), 3);
+    if (!atoms) {
+      dst = values_map;
+      return;
+    }
+    for (size_t i = 0; i < atoms->size(); ++i) {
+      dst.row(i) = values_map.row((*atoms)[i]);
+    }
+  };
+  assign(m_buffer, frame.coords()._eigen());
+  // frames without velocities/forces block get zero vectors
+  if (!m_velocities.empty()) {
+    assign(m_velocities, frame.velocities()._eigen());
+  } else if (frame.has_velocities()) {
+    frame.velocities()._eigen().setZero();
+  }
+  if (!m_forces.empty()) {
+    assign(m_forces, frame.forces()._eigen());
+  } else if (frame.has_forces()) {
+    frame.forces()._eigen().setZero();
+  }
+}
+
+void xmol::io::GromacsTrrFile::advance(size_t shift) {
+  m_current_frame += shift;
+
+  if (m_current_frame >= n_frames()) {
+    m_reader.reset();
+    m_buffer.clear();
+    m_current_frame = 0;
+    m_ahead_of_current_frame = 0;
+    return;
+  }
+
+  bool need_seek = shift != m_ahead_of_current_frame;
+  if (!m_reader) {
+    m_reader = std::make_unique<xdr::TrrReader>(m_filename);
+    m_buffer.resize(n_atoms() * 3);
+    need_seek = m_offsets[m_current_frame] != 0;
+  }
+
+  if (need_seek) {
+    if (!m_reader->seek(m_offsets[m_current_frame])) {
+      throw TrrReadError("Can't advance to frame #" + std::to_string(m_current_frame) + ": " + m_reader->last_error());
+    }
+  }
+  m_ahead_of_current_frame = 0;
+}
+
+void xmol::io::GromacsTrrFile::seek(size_t current, size_t index) {
+  assert(current == m_current_frame);
+  if (index >= current) {
+    advance(index - current);
+    return;
+  }
+  m_current_frame = index; // file is open at `current > 0`
+  if (!m_reader->seek(m_offsets[m_current_frame])) {
+    throw TrrReadError("Can't seek to frame #" + std::to_string(m_current_frame) + ": " + m_reader->last_error());
+  }
+  m_ahead_of_current_frame = 0;
+}
+
+std::optional<double> xmol::io::GromacsTrrFile::frame_time(size_t index) const { return m_offsets.time(index); }
+
+std::unique_ptr<xmol::trajectory::TrajectoryInputFile> xmol::io::GromacsTrrFile::clone() const {
+  std::unique_ptr<GromacsTrrFile> result(new GromacsTrrFile());
+  result->m_filename = m_filename;
+  result->m_offsets = m_offsets;
+  result->m_first_header = m_first_header;
+  return result;
+}
@@ -1,38 +1,65 @@
 #include "xmol/io/GromacsXtcFile.h"
 
-xmol::io::GromacsXtcFile::GromacsXtcFile(std::string filename, size_t n_frames)
-    : m_filename(std::move(filename)), m_n_frames(n_frames) {
+#include <exception>
+#include <thread>
+
+xmol::io::GromacsXtcFile::GromacsXtcFile(std::string filename) : m_filename(std::move(filename)) {
+  scan_offsets();
+  read_n_atoms();
+}
+
+xmol::io::GromacsXtcFile::GromacsXtcFile(std::string filename, std::string index_filename)
+    : m_filename(std::move(filename)) {
+  if (auto offsets = xdr::FrameOffsetIndex::load(index_filename, m_filename)) {
+    m_offsets = std::move(*offsets);
+  } else {
+    scan_offsets();
+    m_offsets.save(index_filename, m_filename); // failure to persist the index is not an error
+  }
+  read_n_atoms();
+}
+
+xmol::io::GromacsXtcFile::GromacsXtcFile(std::string filename, size_t n_frames) : m_filename(std::move(filename)) {
+  scan_offsets();
+  if (m_offsets.n_frames() < n_frames) {
+    throw XtcReadError("`" + m_filename + "` contains " + std::to_string(m_offsets.n_frames()) + " frames, but " +
+                       std::to_string(n_frames) + " requested");
+  }
+  m_offsets.truncate(n_frames);
+  read_n_atoms();
+}
+
+void xmol::io::GromacsXtcFile::scan_offsets() {
+  xdr::XtcReader reader(m_filename);
+  if (!reader.scan(m_offsets)) {
+    throw XtcReadError("Can't scan `" + m_filename + "` frame #" + std::to_string(m_offsets.n_frames()) + ": " +
+                       reader.last_error());
+  }
+}
+
+void xmol::io::GromacsXtcFile::read_n_atoms() {
+  if (m_offsets.n_frames() == 0) {
+    return;
+  }
   xdr::XtcReader reader(m_filename);
   xdr::XtcHeader header{};
-  reader.read_header(header);
+  if (!reader.read_header(header)) {
+    throw XtcReadError("Can't read `" + m_filename + "` header: " + reader.last_error());
+  }
   m_n_atoms = header.n_atoms;
 }
-size_t xmol::io::GromacsXtcFile::n_frames() const { return m_n_frames; }
+
+size_t xmol::io::GromacsXtcFile::n_frames() const { return m_offsets.n_frames(); }
 size_t xmol::io::GromacsXtcFile::n_atoms() const { return m_n_atoms; }
 
 void xmol::io::GromacsXtcFile::read_frame(size_t index, Frame& frame) {
   auto coordinates = frame.coords();
-  assert(m_reader);
-  assert(m_current_frame == index);
   assert(m_buffer.size() == n_atoms() * 3);
   assert(coordinates.size() == n_atoms());
 
-  xdr::XtcHeader header{};
   std::array<float, 9> box{};
+  auto header = read_frame_data(index, box, m_buffer);
 
-  auto status = xdr::Status::OK;
-  status &= m_reader->read_header(header);
-  if (!!status) {
-    assert(coordinates.size() == header.n_atoms);
-    status &= m_reader->read_box(box);
-    if (!!status) {
-      status &= m_reader->read_coords(m_buffer);
-    }
-  }
-
-  if (!status) {
-    throw XtcReadError("Can't read frame #" + std::to_string(index) + ": " + std::string(m_reader->last_error()));
-  }
   /* I don't set frame.index = header.step as it would be any way overwritten by trajectory
    * step from input file doesn't make a lot of sense to create a separate field in Frame
    */
@@ -43,8 +70,58 @@ void xmol::io::GromacsXtcFile::read_frame(size_t index, Frame& frame) {
 
   CoordEigenMatrixMapf buffer_map(m_buffer.data(), n_atoms(), 3);
   coordinates._eigen() = buffer_map.cast<double>() * 10; // .xtc values in nanometers, convert to angstroms
+}
+
+void xmol::io::GromacsXtcFile::read_coords(size_t index, const future::Span<float>& coords) {
+  assert(coords.size() == n_atoms() * 3);
+  std::array<float, 9> box{};
+  read_frame_data(index, box, coords);
+  CoordEigenMatrixMapf(coords.data(), n_atoms(), 3) *= 10; // .xtc values in nanometers, convert to angstroms
+}
+
+void xmol::io::GromacsXtcFile::read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) {
+  auto coordinates = frame.coords();
+  assert(m_buffer.size() == n_atoms() * 3);
+  assert(coordinates.size() == atoms.size());
+
+  std::array<float, 9> box{};
+  auto header = read_frame_data(index, box, m_buffer, atoms.empty() ? 0 : atoms.back() + 1);
+
+  frame.time = header.time;
+  frame.cell = xmol::geom::UnitCell(XYZ(box[0], box[1], box[2]) * 10,
+                                    XYZ(box[3], box[4], box[5]) * 10,
+                                    XYZ(box[6], box[7], box[8]) * 10); // convert nanometers to angstroms
 
+  CoordEigenMatrixMapf buffer_map(m_buffer.data(), n_atoms(), 3);
+  auto selected = coordinates._eigen();
+  for (size_t i = 0; i < atoms.size(); ++i) {
+    selected.row(i) = buffer_map.row(atoms[i]).cast<double>() * 10; // nanometers to angstroms
+  }
+}
+
+xmol::io::xdr::XtcHeader xmol::io::GromacsXtcFile::read_frame_data(size_t index, std::array<float, 9>& box,
+                                                                   const future::Span<float>& coords,
+                                                                   size_t max_atoms) {
+  assert(m_reader);
+  assert(m_current_frame == index);
+
+  xdr::XtcHeader header{};
+
+  auto status = xdr::Status::OK;
+  status &= m_reader->read_header(header);
+  if (!!status) {
+    assert(coords.size() == header.n_atoms * 3);
+    status &= m_reader->read_box(box);
+    if (!!status) {
+      status &= m_reader->read_coords(coords, max_atoms);
+    }
+  }
+
+  if (!status) {
+    throw XtcReadError("Can't read frame #" + std::to_string(index) + ": " + std::string(m_reader->last_error()));
+  }
   m_ahead_of_current_frame = 1;
+  return header;
 }
 
 void xmol::io::GromacsXtcFile::advance(size_t shift) {
@@ -63,9 +140,93 @@ void xmol::io::GromacsXtcFile::advance(size_t shift) {
     m_buffer.resize(n_atoms() * 3);
   }
 
-  if (shift >= m_ahead_of_current_frame) {
-    if (!m_reader->advance(shift - m_ahead_of_current_frame)) {
+  if (shift != m_ahead_of_current_frame) {
+    if (!m_reader->seek(m_offsets[m_current_frame])) {
       throw XtcReadError("Can't advance to frame" + std::to_string(m_current_frame) + ": " + m_reader->last_error());
     }
   }
+  m_ahead_of_current_frame = 0;
+}
+
+void xmol::io::GromacsXtcFile::seek(size_t current, size_t index) {
+  assert(current == m_current_frame);
+  if (index >= current) {
+    advance(index - current);
+    return;
+  }
+  m_current_frame = index; // file is open at `current > 0`
+  if (!m_reader->seek(m_offsets[m_current_frame])) {
+    throw XtcReadError("Can't seek to frame " + std::to_string(m_current_frame) + ": " + m_reader->last_error());
+  }
+  m_ahead_of_current_frame = 0;
+}
+
+std::optional<double> xmol::io::GromacsXtcFile::frame_time(size_t index) const { return m_offsets.time(index); }
+
+std::unique_ptr<xmol::trajectory::TrajectoryInputFile> xmol::io::GromacsXtcFile::clone() const {
+  std::unique_ptr<GromacsXtcFile> result(new GromacsXtcFile());
+  result->m_filename = m_filename;
+  result->m_offsets = m_offsets;
+  result->m_n_atoms = m_n_atoms;
+  return result;
+}
+
+void xmol::io::GromacsXtcFile::read_frames(size_t begin, size_t end, size_t stride, float* out,
+                                           size_t n_threads) const {
+  if (begin > end || end > n_frames() || stride == 0) {
+    throw std::out_of_range("GromacsXtcFile::read_frames(): bad range [" + std::to_string(begin) + ":" +
+                            std::to_string(end) + ":" + std::to_string(stride) + "] for " +
+                            std::to_string(n_frames()) + " frames");
+  }
+  const size_t n_selected = (end - begin + stride - 1) / stride;
+  if (n_threads == 0) {
+    n_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  n_threads = std::min(n_threads, n_selected);
+
+  auto decode_chunk = [&](size_t first, size_t last) {
+    xdr::XtcReader reader(m_filename);
+    xdr::XtcHeader header{};
+    std::array<float, 9> box{};
+    for (size_t k = first; k < last; ++k) {
+      const size_t index = begin + k * stride;
+      float* frame_out = out + k * n_atoms() * 3;
+      auto status = xdr::Status::OK;
+      if (k == first || stride != 1) {
+        status &= reader.seek(m_offsets[index]);
+      }
+      status &= reader.read_header(header);
+      if (!!status && static_cast<size_t>(header.n_atoms) != n_atoms()) {
+        throw XtcReadError("Frame #" + std::to_string(index) + " of `" + m_filename + "` has " +
+                           std::to_string(header.n_atoms) + " atoms, expected " + std::to_string(n_atoms()));
+      }
+      status &= reader.read_box(box);
+      status &= reader.read_coords(future::Span<float>(frame_out, n_atoms() * 3));
+      if (!status) {
+        throw XtcReadError("Can't read frame #" + std::to_string(index) + ": " + reader.last_error());
+      }
+      CoordEigenMatrixMapf(frame_out, n_atoms(), 3) *= 10; // .xtc values in nanometers, convert to angstroms
+    }
+  };
+
+  std::vector<std::exception_ptr> errors(n_threads);
+  std::vector<std::thread> workers;
+  workers.reserve(n_threads);
+  for (size_t w = 0; w < n_threads; ++w) {
+    workers.emplace_back([&, w] {
+      try {
+        decode_chunk(n_selected * w / n_threads, n_selected * (w + 1) / n_threads);
+      } catch (...) {
+        errors[w] = std::current_exception();
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
 }
@@ -0,0 +1,112 @@
+#include "xmol/io/MmCifFile.h"
+#include "xmol/io/cif/exceptions.h"
+#include "xmol/Frame.h"
+
+using namespace xmol::io;
+using namespace xmol::io::cif;
+
+namespace {
+std::shared_ptr<const xmol::utils::MappedFile> map_file(const std::string& filename) {
+  try {
+    return std::make_shared<const xmol::utils::MappedFile>(filename);
+  } catch (std::runtime_error&) {
+    throw CifException("Can't read `" + filename + "`");
+  }
+}
+} // namespace
+
+MmCifFile::MmCifFile(std::string filename) : m_filename(std::move(filename)) {
+  auto& file = mapping();
+  m_reader = std::make_shared<const CifBufferReader>(file.data(), file.data() + file.size());
+  if (n_frames() > 0) {
+    m_n_atoms = m_reader->n_atoms(0);
+  }
+  advance(n_frames());
+}
+
+MmCifFile::MmCifFile(const MmCifFile& other)
+    : m_filename(other.m_filename), m_reader(other.m_reader), m_n_atoms(other.m_n_atoms) {}
+
+size_t MmCifFile::n_frames() const { return m_reader->n_frames(); }
+size_t MmCifFile::n_atoms() const { return m_n_atoms; }
+
+const xmol::utils::MappedFile& MmCifFile::mapping() {
+  if (!m_mapping) {
+    m_mapping = map_file(m_filename);
+  }
+  return *m_mapping;
+}
+
+void MmCifFile::load_coords(size_t index) {
+  if (m_reader->n_atoms(index) != m_n_atoms) {
+    throw CifException("Wrong number of atoms in " + std::to_string(index) + " frame in `" + m_filename +
+                       "`. Expected " + std::to_string(m_n_atoms) + ", got " +
+                       std::to_string(m_reader->n_atoms(index)));
+  }
+  auto& file = mapping();
+  m_reader->read_coords(file.data(), file.data() + file.size(), index, m_coords);
+}
+
+void MmCifFile::read_frame(size_t index, Frame& frame) {
+  auto coordinates = frame.coords();
+  assert(m_mapping);
+  assert(m_current_frame == index);
+  assert(coordinates.size() == n_atoms());
+  load_coords(index);
+  for (size_t i = 0; i < m_coords.size(); ++i) {
+    coordinates[i].set(m_coords[i]);
+  }
+  frame.cell = m_reader->cell();
+}
+
+void MmCifFile::read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) {
+  auto coordinates = frame.coords();
+  assert(m_mapping);
+  assert(m_current_frame == index);
+  assert(coordinates.size() == atoms.size());
+  load_coords(index);
+  for (size_t i = 0; i < atoms.size(); ++i) {
+    coordinates[i].set(m_coords[atoms[i]]);
+  }
+  frame.cell = m_reader->cell();
+}
+
+xmol::Frame MmCifFile::frame(size_t index) const {
+  if (index >= n_frames()) {
+    throw std::out_of_range("MmCifFile::frame(): index " + std::to_string(index) + " is out of range [0, " +
+                            std::to_string(n_frames()) + ")");
+  }
+  auto file = m_mapping ? m_mapping : map_file(m_filename);
+  return m_reader->read_frame(file->data(), file->data() + file->size(), index);
+}
+
+std::vector<xmol::Frame> MmCifFile::frames() const {
+  auto file = m_mapping ? m_mapping : map_file(m_filename);
+  return m_reader->read_frames(file->data(), file->data() + file->size());
+}
+
+std::unique_ptr<xmol::trajectory::TrajectoryInputFile> MmCifFile::clone() const {
+  return std::unique_ptr<MmCifFile>(new MmCifFile(*this)); // mapping is created by advance()
+}
+
+void MmCifFile::seek(size_t current, size_t index) {
+  assert(current == m_current_frame);
+  if (index >= current) {
+    advance(index - current);
+    return;
+  }
+  m_current_frame = index; // frames are read from mapping which is alive at `current > 0`
+}
+
+void MmCifFile::advance(size_t shift) {
+  m_current_frame += shift;
+
+  if (m_current_frame >= n_frames()) {
+    m_mapping = {};
+    m_coords = {};
+    m_current_frame = 0;
+    return;
+  }
+
+  static_cast<void>(mapping());
+}
@@ -1,63 +1,96 @@
-#include "xmol/io/pdb/PdbReader.h"
+#include "xmol/io/pdb/PdbBufferReader.h"
 #include "xmol/io/pdb/PdbRecord.h"
 #include "xmol/io/PdbInputFile.h"
-#include <fstream>
+#include "xmol/utils/MappedFile.h"
+#include <memory>
 
 using namespace xmol::io;
 using namespace xmol::io::pdb;
 
-PdbInputFile::PdbInputFile(std::string filename, Dialect dialect, bool read_now)
-    : m_filename(std::move(filename)), m_dialect(dialect) {
+PdbInputFile::PdbInputFile(std::string filename, Dialect dialect, bool read_now, size_t n_threads)
+    : m_filename(std::move(filename)), m_dialect(dialect), m_n_threads(n_threads) {
   if (read_now) {
     read();
   }
 }
 
-PdbInputFile& PdbInputFile::read() {
+PdbInputFile::PdbInputFile(const PdbInputFile& other)
+    : m_filename(other.m_filename), m_frames(other.m_frames), m_n_frames(other.m_n_frames),
+      m_n_atoms(other.m_n_atoms), m_dialect(other.m_dialect), m_n_threads(other.m_n_threads) {}
+
+AlteredPdbRecords PdbInputFile::records(Dialect dialect) {
   AlteredPdbRecords alteredPdbRecords(StandardPdbRecords::instance());
-  switch (m_dialect) {
+  switch (dialect) {
   case (Dialect::AMBER_99):
     alteredPdbRecords.alter_record(pdb::RecordName("ATOM"), pdb::FieldName("serial"), {7, 12});
     break;
   case (Dialect::STANDARD_V3):
     break;
   }
+  return alteredPdbRecords;
+}
 
-  std::ifstream in(m_filename);
-  if (!in){
-    throw PdbReadError("Can't read `"+m_filename+"`");
+PdbInputFile& PdbInputFile::read() {
+  auto alteredPdbRecords = records(m_dialect);
+
+  std::unique_ptr<utils::MappedFile> file;
+  try {
+    file = std::make_unique<utils::MappedFile>(m_filename);
+  } catch (std::runtime_error&) {
+    throw PdbReadError("Can't read `" + m_filename + "`");
   }
-  m_frames = PdbReader(in).read_frames(alteredPdbRecords);
+  m_frames = std::make_shared<const std::vector<Frame>>(
+      PdbBufferReader(alteredPdbRecords).read_frames(file->data(), file->data() + file->size(), m_n_threads));
 
-  m_n_frames = m_frames.size();
-  if (!m_frames.empty()) {
-    m_n_atoms = m_frames[0].n_atoms();
+  m_n_frames = m_frames->size();
+  if (!m_frames->empty()) {
+    m_n_atoms = (*m_frames)[0].n_atoms();
   }
   return *this;
 }
 
+const std::vector<xmol::Frame>& PdbInputFile::frames() const {
+  static const std::vector<Frame> no_frames;
+  return m_frames ? *m_frames : no_frames;
+}
+
 size_t PdbInputFile::n_frames() const { return m_n_frames; }
 size_t PdbInputFile::n_atoms() const { return m_n_atoms; }
 void PdbInputFile::read_frame(size_t index, Frame& frame) {
   auto coordinates = frame.coords();
-  assert(!m_frames.empty());
+  assert(m_frames);
   assert(m_current_frame == index);
 
-  Frame& _frame = m_frames[index];
+  // coords() of shared frame is only read
+  Frame& _frame = const_cast<Frame&>((*m_frames)[index]);
   if (coordinates.size() != _frame.n_atoms()) {
     throw PdbReadError("Wrong of atoms in " + std::to_string(index) + " frame in `" + m_filename + "`. Expected " +
                        std::to_string(coordinates.size()));
   }
   coordinates._eigen() = _frame.coords()._eigen();
 }
+
+std::unique_ptr<xmol::trajectory::TrajectoryInputFile> PdbInputFile::clone() const {
+  return std::unique_ptr<PdbInputFile>(new PdbInputFile(*this));
+}
+
+void PdbInputFile::seek(size_t current, size_t index) {
+  assert(current == m_current_frame);
+  if (index >= current) {
+    advance(index - current);
+    return;
+  }
+  m_current_frame = index; // frames are alive at `current > 0`
+}
+
 void PdbInputFile::advance(size_t shift) {
   m_current_frame += shift;
   if (m_current_frame >= n_frames()) {
-    m_frames.clear();
+    m_frames = {};
     m_current_frame = 0;
     return;
   }
-  if (m_frames.empty()) {
+  if (!m_frames) {
     read();
   }
 }
\ No newline at end of file
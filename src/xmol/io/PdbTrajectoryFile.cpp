@@ -0,0 +1,107 @@
+#include "xmol/io/PdbTrajectoryFile.h"
+#include "xmol/io/pdb/PdbRecord.h"
+#include "xmol/Frame.h"
+
+using namespace xmol::io;
+
+namespace {
+std::shared_ptr<const xmol::utils::MappedFile> map_file(const std::string& filename) {
+  try {
+    return std::make_shared<const xmol::utils::MappedFile>(filename);
+  } catch (std::runtime_error&) {
+    throw PdbReadError("Can't read `" + filename + "`");
+  }
+}
+} // namespace
+
+PdbTrajectoryFile::PdbTrajectoryFile(std::string filename, PdbInputFile::Dialect dialect)
+    : m_filename(std::move(filename)), m_reader(PdbInputFile::records(dialect)) {
+  auto& file = mapping();
+  m_index = std::make_shared<const Index>(m_reader.index_frames(file.data(), file.data() + file.size()));
+  if (n_frames() > 0) {
+    load_coords(0);
+    m_n_atoms = m_coords.size();
+  }
+  advance(n_frames());
+}
+
+PdbTrajectoryFile::PdbTrajectoryFile(const PdbTrajectoryFile& other)
+    : m_filename(other.m_filename), m_reader(other.m_reader), m_index(other.m_index), m_n_atoms(other.m_n_atoms) {}
+
+size_t PdbTrajectoryFile::n_frames() const { return m_index->size(); }
+size_t PdbTrajectoryFile::n_atoms() const { return m_n_atoms; }
+
+const xmol::utils::MappedFile& PdbTrajectoryFile::mapping() {
+  if (!m_mapping) {
+    m_mapping = map_file(m_filename);
+  }
+  return *m_mapping;
+}
+
+void PdbTrajectoryFile::load_coords(size_t index) {
+  auto& file = mapping();
+  m_reader.read_coords(file.data(), file.data() + file.size(), (*m_index)[index], m_coords);
+  if (m_n_atoms != 0 && m_coords.size() != m_n_atoms) {
+    throw PdbReadError("Wrong number of atoms in " + std::to_string(index) + " frame in `" + m_filename +
+                       "`. Expected " + std::to_string(m_n_atoms) + ", got " + std::to_string(m_coords.size()));
+  }
+}
+
+void PdbTrajectoryFile::read_frame(size_t index, Frame& frame) {
+  auto coordinates = frame.coords();
+  assert(m_mapping);
+  assert(m_current_frame == index);
+  assert(coordinates.size() == n_atoms());
+  load_coords(index);
+  for (size_t i = 0; i < m_coords.size(); ++i) {
+    coordinates[i].set(m_coords[i]);
+  }
+  frame.cell = (*m_index)[index].cell;
+}
+
+void PdbTrajectoryFile::read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) {
+  auto coordinates = frame.coords();
+  assert(m_mapping);
+  assert(m_current_frame == index);
+  assert(coordinates.size() == atoms.size());
+  load_coords(index);
+  for (size_t i = 0; i < atoms.size(); ++i) {
+    coordinates[i].set(m_coords[atoms[i]]);
+  }
+  frame.cell = (*m_index)[index].cell;
+}
+
+xmol::Frame PdbTrajectoryFile::frame(size_t index) const {
+  if (index >= n_frames()) {
+    throw std::out_of_range("PdbTrajectoryFile::frame(): index " + std::to_string(index) + " is out of range [0, " +
+                            std::to_string(n_frames()) + ")");
+  }
+  auto file = m_mapping ? m_mapping : map_file(m_filename);
+  return m_reader.read_frame(file->data(), file->data() + file->size(), (*m_index)[index]);
+}
+
+std::unique_ptr<xmol::trajectory::TrajectoryInputFile> PdbTrajectoryFile::clone() const {
+  return std::unique_ptr<PdbTrajectoryFile>(new PdbTrajectoryFile(*this)); // mapping is created by advance()
+}
+
+void PdbTrajectoryFile::seek(size_t current, size_t index) {
+  assert(current == m_current_frame);
+  if (index >= current) {
+    advance(index - current);
+    return;
+  }
+  m_current_frame = index; // frames are read from mapping which is alive at `current > 0`
+}
+
+void PdbTrajectoryFile::advance(size_t shift) {
+  m_current_frame += shift;
+
+  if (m_current_frame >= n_frames()) {
+    m_mapping = {};
+    m_coords = {};
+    m_current_frame = 0;
+    return;
+  }
+
+  static_cast<void>(mapping());
+}
@@ -1,19 +1,15 @@
 #include "xmol/io/TrjtoolDatFile.h"
+#include "byte_order.h"
 #include "xmol/geom/UnitCell.h"
 #include "xmol/Frame.h"
 
+#include <cstring>
 #include <utility>
 
 using namespace xmol::io;
 
-namespace {
-
-template <typename T> union FromRawBytes {
-  T value;
-  char bytes[sizeof(T)];
-};
-
-} // namespace
+using xmol::io::byte_order::byteswap;
+using xmol::io::byte_order::load_floats;
 
 TrjtoolDatFile::TrjtoolDatFile(std::string filename) : m_filename(std::move(filename)) {
   read_header();
@@ -23,71 +19,121 @@ size_t TrjtoolDatFile::n_frames() const { return m_n_frames; }
 size_t TrjtoolDatFile::n_atoms() const { return m_header.nitems; }
 void TrjtoolDatFile::read_frame(size_t index, Frame& frame) {
   auto coordinates = frame.coords();
-  assert(m_stream);
+  assert(m_mapping);
   assert(m_current_frame == index);
-  assert(m_buffer.size() == n_atoms() * 3);
   assert(coordinates.size() == n_atoms());
 
-  /// todo: properly handle endianness
-  m_stream->read(reinterpret_cast<char*>(m_buffer.data()), sizeof(float) * n_atoms() * 3);
-  CoordEigenMatrixMapf buffer_map(m_buffer.data(), n_atoms(), 3);
-  coordinates._eigen() = buffer_map.cast<double>();
+  load_floats(m_mapping->data() + m_offset + frame_size_bytes() * index, n_atoms() * 3, m_swap_bytes,
+              coordinates._eigen().data());
 }
-void TrjtoolDatFile::read_header() {
-  m_stream = std::make_unique<std::ifstream>(m_filename, std::ios::binary);
-  auto& in = *m_stream;
-  in.seekg(0, std::ios::beg);
+void TrjtoolDatFile::read_coords(size_t index, const future::Span<float>& coords) {
+  assert(m_mapping);
+  assert(m_current_frame == index);
+  assert(coords.size() == n_atoms() * 3);
 
-  HeaderUnion hu{};
+  load_floats(m_mapping->data() + m_offset + frame_size_bytes() * index, n_atoms() * 3, m_swap_bytes, coords.data());
+}
+void TrjtoolDatFile::read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) {
+  auto coordinates = frame.coords();
+  assert(m_mapping);
+  assert(m_current_frame == index);
+  assert(coordinates.size() == atoms.size());
 
-  if (!in.read(hu.bytes, sizeof(hu.bytes))) { // todo: handle endianness
-    throw std::runtime_error("TrjtoolDatFile::open(): unexpected EOF");
+  const char* frame_data = m_mapping->data() + m_offset + frame_size_bytes() * index;
+  double* dst = coordinates._eigen().data();
+  for (size_t i = 0; i < atoms.size(); ++i) {
+    load_floats(frame_data + atoms[i] * 3 * sizeof(float), 3, m_swap_bytes, dst + i * 3);
   }
+}
+std::unique_ptr<xmol::trajectory::TrajectoryInputFile> TrjtoolDatFile::clone() const {
+  std::unique_ptr<TrjtoolDatFile> result(new TrjtoolDatFile());
+  result->m_filename = m_filename;
+  result->m_header = m_header;
+  result->m_swap_bytes = m_swap_bytes;
+  result->m_n_frames = m_n_frames;
+  result->m_offset = m_offset;
+  return result; // mapping is created by advance(), pages are shared by OS
+}
+const char* TrjtoolDatFile::raw_frame(size_t index) {
+  if (index >= n_frames()) {
+    throw std::out_of_range("TrjtoolDatFile::raw_frame(): index " + std::to_string(index) + " is out of range [0," +
+                            std::to_string(n_frames()) + ")");
+  }
+  return mapping()->data() + m_offset + frame_size_bytes() * index;
+}
+std::shared_ptr<const xmol::utils::MappedFile> TrjtoolDatFile::mapping() {
+  if (!m_mapping) {
+    m_mapping = std::make_shared<const utils::MappedFile>(m_filename);
+  }
+  return m_mapping;
+}
+size_t TrjtoolDatFile::frame_size_bytes() const { return sizeof(float) * m_header.nitems * m_header.ndim; }
+void TrjtoolDatFile::read_header() {
+  const auto& file = *mapping();
+  size_t pos = 0;
 
-  m_header = hu.header;
+  auto read_int32 = [&]() {
+    uint32_t bits;
+    if (pos + sizeof(bits) > file.size()) {
+      throw std::runtime_error("TrjtoolDatFile::open(): unexpected EOF");
+    }
+    std::memcpy(&bits, file.data() + pos, sizeof(bits));
+    pos += sizeof(bits);
+    return static_cast<int32_t>(m_swap_bytes ? byteswap(bits) : bits);
+  };
+
+  m_header.nitems = read_int32();
+  m_header.ndim = read_int32();
+  m_header.dtype = read_int32();
+
+  if (m_header.dtype != 5 && static_cast<int32_t>(byteswap(static_cast<uint32_t>(m_header.dtype))) == 5) {
+    m_swap_bytes = true;
+    m_header.nitems = byteswap(static_cast<uint32_t>(m_header.nitems));
+    m_header.ndim = byteswap(static_cast<uint32_t>(m_header.ndim));
+    m_header.dtype = byteswap(static_cast<uint32_t>(m_header.dtype));
+  }
   if (m_header.dtype != 5) {
     throw std::runtime_error("TrjtoolDatFile::open(): non-float data");
   }
+  if (m_header.ndim != 3 || m_header.nitems <= 0) {
+    throw std::runtime_error("TrjtoolDatFile::open(): expected non-empty 3d data");
+  }
   for (int i = 0; i < m_header.nitems; i++) {
-    FromRawBytes<int> info_len{};
-    if (!in.read(info_len.bytes, sizeof(info_len.bytes))) { // todo: handle endianness
-      throw std::runtime_error("TrjtoolDatFile::open(): unexpected EOF");
-    }
-    if (info_len.value <= 5) {
+    auto info_len = read_int32();
+    if (info_len <= 5) {
       throw std::runtime_error("TrjtoolDatFile::open(): can't read info (info_len<=5)");
     }
-    char buffer[info_len.value + 1];
-    if (!in.read(buffer, info_len.value)) {
+    if (pos + info_len > file.size()) {
       throw std::runtime_error("TrjtoolDatFile::open(): unexpected EOF");
     }
+    pos += info_len;
   }
 
-  m_offset = in.tellg();
-  in.seekg(0, std::ios_base::end);
-  auto endpos = in.tellg();
-
-  auto n_payload_bytes = endpos - m_offset;
+  m_offset = pos;
+  auto n_payload_bytes = file.size() - m_offset;
 
-  m_n_frames = n_payload_bytes / m_header.nitems / m_header.ndim / 4;
-  if (m_header.nitems * m_header.ndim * 4 * m_n_frames != n_payload_bytes) {
+  m_n_frames = n_payload_bytes / frame_size_bytes();
+  if (frame_size_bytes() * m_n_frames != n_payload_bytes) {
     throw std::runtime_error("File size does not match header info");
   }
 }
+void TrjtoolDatFile::seek(size_t current, size_t index) {
+  assert(current == m_current_frame);
+  if (index >= current) {
+    advance(index - current);
+    return;
+  }
+  m_current_frame = index; // frames are read from mapping which is alive at `current > 0`
+}
+
 void TrjtoolDatFile::advance(size_t shift) {
   m_current_frame += shift;
 
   if (m_current_frame >= n_frames()) {
-    m_stream = {};
-    m_buffer.clear();
+    m_mapping = {};
     m_current_frame = 0;
     return;
   }
 
-  if (!m_stream) {
-    m_stream = std::make_unique<std::ifstream>(m_filename, std::ios::binary);
-    m_buffer.resize(n_atoms() * 3);
-  }
-
-  const std::streamoff frame_begin = sizeof(float) * m_header.nitems * m_header.ndim * m_current_frame;
-  m_stream->seekg(m_offset + frame_begin, std::ios::beg);
+  static_cast<void>(mapping());
 }
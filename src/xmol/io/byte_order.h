@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace xmol::io::byte_order {
+
+inline uint32_t byteswap(uint32_t v) {
+  return (v >> 24) | ((v >> 8) & 0x0000FF00u) | ((v << 8) & 0x00FF0000u) | (v << 24);
+}
+
+inline uint64_t byteswap(uint64_t v) {
+  return (static_cast<uint64_t>(byteswap(static_cast<uint32_t>(v))) << 32) | byteswap(static_cast<uint32_t>(v >> 32));
+}
+
+/// Unaligned load of @p Stored value at @p src, bytes are reversed if @p swap_bytes
+template <typename Stored> Stored load(const char* src, bool swap_bytes) {
+  static_assert(sizeof(Stored) == 4 || sizeof(Stored) == 8);
+  using Bits = std::conditional_t<sizeof(Stored) == 4, uint32_t, uint64_t>;
+  Bits bits;
+  std::memcpy(&bits, src, sizeof(bits));
+  if (swap_bytes) {
+    bits = byteswap(bits);
+  }
+  Stored value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/// Convert @p n packed float32 values at @p src to @p T, every @p dst_stride 'th element of @p dst is written
+///
+/// Plain shift/mask loops are recognized by compilers and vectorized into byte shuffles
+template <typename T> void load_floats(const char* src, size_t n, bool swap_bytes, T* dst, size_t dst_stride = 1) {
+  if (swap_bytes) {
+    for (size_t i = 0; i < n; ++i) {
+      dst[i * dst_stride] = load<float>(src + i * sizeof(float), true);
+    }
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      dst[i * dst_stride] = load<float>(src + i * sizeof(float), false);
+    }
+  }
+}
+
+} // namespace xmol::io::byte_order
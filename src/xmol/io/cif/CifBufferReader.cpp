@@ -0,0 +1,503 @@
+#include "xmol/io/cif/CifBufferReader.h"
+#include "xmol/io/cif/exceptions.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+using namespace xmol::io::cif;
+using namespace xmol;
+
+namespace {
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+bool is_digit(char c) { return static_cast<unsigned>(c) - '0' < 10; }
+
+char to_lower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+/// Case-insensitive check that @p s starts with @p prefix, CIF tags and reserved words are case-insensitive
+bool starts_with(std::string_view s, std::string_view prefix) {
+  if (s.size() < prefix.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < prefix.size(); ++i) {
+    if (to_lower(s[i]) != to_lower(prefix[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Case-insensitive comparison of @p s with @p name
+bool equals(std::string_view s, std::string_view name) { return s.size() == name.size() && starts_with(s, name); }
+
+/// Whether unquoted @p token terminates values of loop: tag or reserved word
+bool is_keyword(std::string_view token) {
+  return token[0] == '_' || starts_with(token, "data_") || starts_with(token, "loop_") ||
+         starts_with(token, "save_") || starts_with(token, "global_") || starts_with(token, "stop_");
+}
+
+/** Parse CIF number, standard uncertainty in parentheses (e.g. `1.234(5)`) is ignored
+ *
+ * Numbers of up to 18 significant digits with small exponent are converted exactly as by std::strtod(),
+ * others are converted by std::strtod()
+ * */
+bool parse_real(std::string_view s, double& value) {
+  static const double powers_of_10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  if (!s.empty() && s.back() == ')') {
+    const auto uncertainty = s.find('(');
+    if (uncertainty == std::string_view::npos) {
+      return false;
+    }
+    s = s.substr(0, uncertainty);
+  }
+  size_t i = 0;
+  const bool negative = i < s.size() && s[i] == '-';
+  if (i < s.size() && (s[i] == '-' || s[i] == '+')) {
+    ++i;
+  }
+  uint64_t mantissa = 0;
+  int n_significant = 0;
+  int exponent = 0;
+  bool has_digits = false;
+  bool is_exact = true;
+  auto add_digit = [&](char c, int shift) {
+    has_digits = true;
+    if (n_significant == 18) {
+      is_exact = false;
+      return;
+    }
+    mantissa = mantissa * 10 + (c - '0');
+    n_significant += mantissa != 0;
+    exponent += shift;
+  };
+  for (; i < s.size() && is_digit(s[i]); ++i) {
+    add_digit(s[i], 0);
+  }
+  if (!is_exact) {
+    return false; // too long integer part isn't expected in coordinates
+  }
+  if (i < s.size() && s[i] == '.') {
+    for (++i; i < s.size() && is_digit(s[i]); ++i) {
+      add_digit(s[i], -1);
+    }
+  }
+  if (!has_digits) {
+    return false;
+  }
+  if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+    ++i;
+    const bool negative_exponent = i < s.size() && s[i] == '-';
+    if (i < s.size() && (s[i] == '-' || s[i] == '+')) {
+      ++i;
+    }
+    if (i == s.size()) {
+      return false;
+    }
+    int e = 0;
+    for (; i < s.size() && is_digit(s[i]) && e < 10000; ++i) {
+      e = e * 10 + (s[i] - '0');
+    }
+    exponent += negative_exponent ? -e : e;
+  }
+  if (i != s.size()) {
+    return false;
+  }
+  if (is_exact && mantissa <= (uint64_t(1) << 53) && -22 <= exponent && exponent <= 22) {
+    // both operands are exact, so result is correctly rounded
+    value = exponent < 0 ? mantissa / powers_of_10[-exponent] : mantissa * powers_of_10[exponent];
+    value = negative ? -value : value;
+  } else {
+    value = std::strtod(std::string(s).c_str(), nullptr); // sign is parsed by strtod
+  }
+  return true;
+}
+
+bool parse_int(std::string_view s, int& value) {
+  const bool negative = !s.empty() && s[0] == '-';
+  if (!s.empty() && (s[0] == '-' || s[0] == '+')) {
+    s.remove_prefix(1);
+  }
+  if (s.empty() || s.size() > 9) {
+    return false;
+  }
+  int result = 0;
+  for (char c : s) {
+    if (!is_digit(c)) {
+      return false;
+    }
+    result = result * 10 + (c - '0');
+  }
+  value = negative ? -result : result;
+  return true;
+}
+
+struct AtomRecord {
+  AtomName name;
+  AtomId id;
+  XYZ r;
+  ResidueName residue_name;   /// set for the first atom of residue
+  ResidueId residue_id;       /// set for the first atom of residue
+  MoleculeName molecule_name; /// set for the first atom of molecule
+  bool new_residue;
+  bool new_molecule;
+};
+
+} // namespace
+
+/// Tokenizer of CIF text (https://www.iucr.org/resources/cif/spec/version1.1/cifsyntax), comments are skipped
+class CifBufferReader::Tokenizer {
+public:
+  Tokenizer(const char* begin, const char* end, size_t offset = 0) : m_begin(begin), m_end(end), m_pos(begin + offset) {}
+
+  /// Read next token into @p token, returns false at end of text. Quotes and semicolons of text fields are stripped
+  bool next(std::string_view& token) {
+    skip_blanks();
+    if (m_pos == m_end) {
+      return false;
+    }
+    m_token = m_pos;
+    m_quoted = true;
+    const char c = *m_pos;
+    if (c == ';' && (m_pos == m_begin || m_pos[-1] == '\n' || m_pos[-1] == '\r')) {
+      // text field lasts up to the line which starts with semicolon
+      const char* p = m_pos + 1;
+      do {
+        p = static_cast<const char*>(std::memchr(p, '\n', m_end - p));
+        if (!p) {
+          error("Unterminated text field");
+        }
+        ++p;
+      } while (p == m_end || *p != ';');
+      token = std::string_view(m_pos + 1, p - 1 - (m_pos + 1));
+      m_pos = p + 1;
+    } else if (c == '\'' || c == '"') {
+      // quoted string is closed by the same quote followed by blank
+      const char* p = m_pos + 1;
+      while (p == m_end || *p != c || (p + 1 != m_end && !is_space(p[1]))) {
+        if (p == m_end || *p == '\n' || *p == '\r') {
+          error("Unterminated quoted string");
+        }
+        ++p;
+      }
+      token = std::string_view(m_pos + 1, p - (m_pos + 1));
+      m_pos = p + 1;
+    } else {
+      m_quoted = false;
+      const char* p = m_pos;
+      while (p != m_end && !is_space(*p)) {
+        ++p;
+      }
+      token = std::string_view(m_pos, p - m_pos);
+      m_pos = p;
+    }
+    return true;
+  }
+
+  /// Whether last token is quoted string or text field, i.e. it's a value even if it looks like tag or keyword
+  [[nodiscard]] bool quoted() const { return m_quoted; }
+
+  /// Whether last token is unknown (`?`) or inapplicable (`.`) value
+  [[nodiscard]] bool is_null(std::string_view token) const { return !m_quoted && (token == "?" || token == "."); }
+
+  /// Offset of last token from beginning of text
+  [[nodiscard]] size_t offset() const { return m_token - m_begin; }
+
+  /// Name from @p token of @p column, null value stands for empty name
+  template <typename Name> Name read_name(std::string_view token, const std::string& column) const {
+    if (is_null(token)) {
+      return Name{};
+    }
+    if (token.size() > static_cast<size_t>(Name::max_length)) {
+      error("Too long `" + column + "` value `" + std::string(token) + "`");
+    }
+    return Name(token.data(), static_cast<int>(token.size()));
+  }
+
+  /// Integer from @p token of @p column, null value stands for zero
+  int read_int(std::string_view token, const std::string& column) const {
+    int value = 0;
+    if (!is_null(token) && !parse_int(token, value)) {
+      error("Bad `" + column + "` value `" + std::string(token) + "`");
+    }
+    return value;
+  }
+
+  double read_double(std::string_view token, const std::string& column) const {
+    double value;
+    if (!parse_real(token, value)) {
+      error("Bad `" + column + "` value `" + std::string(token) + "`");
+    }
+    return value;
+  }
+
+  /// Throw CifException with @p what at line of last token
+  [[noreturn]] void error(const std::string& what) const {
+    throw CifException(what + " at line " + std::to_string(1 + std::count(m_begin, m_token, '\n')));
+  }
+
+private:
+  void skip_blanks() {
+    while (m_pos != m_end) {
+      if (is_space(*m_pos)) {
+        ++m_pos;
+      } else if (*m_pos == '#') {
+        auto eol = static_cast<const char*>(std::memchr(m_pos, '\n', m_end - m_pos));
+        m_pos = eol ? eol : m_end;
+      } else {
+        break;
+      }
+    }
+  }
+
+  const char* m_begin;
+  const char* m_end;
+  const char* m_pos;
+  const char* m_token = m_pos;
+  bool m_quoted = false;
+};
+
+CifBufferReader::CifBufferReader(const char* begin, const char* end)
+    : m_cell(geom::UnitCell::unit_cubic_cell()) {
+  Tokenizer tokens(begin, end);
+  std::string_view token;
+  bool has_token = tokens.next(token);
+  bool in_block = false;
+  std::optional<double> cell[6];
+  const std::string_view cell_tags[6] = {"_cell.length_a",    "_cell.length_b",   "_cell.length_c",
+                                         "_cell.angle_alpha", "_cell.angle_beta", "_cell.angle_gamma"};
+  auto is_value = [&] { return has_token && (tokens.quoted() || !is_keyword(token)); };
+
+  while (has_token) {
+    if (tokens.quoted() || !is_keyword(token)) {
+      has_token = tokens.next(token); // stray value
+    } else if (starts_with(token, "data_")) {
+      if (in_block) {
+        break;
+      }
+      in_block = true;
+      has_token = tokens.next(token);
+    } else if (equals(token, "loop_")) {
+      std::vector<std::string_view> tags;
+      while ((has_token = tokens.next(token)) && !tokens.quoted() && token[0] == '_') {
+        tags.push_back(token);
+      }
+      if (!tags.empty() && starts_with(tags[0], "_atom_site.") && m_columns.empty()) {
+        const size_t model_column = map_columns(tags, tokens);
+        size_t column = 0;
+        size_t row_offset = 0;
+        std::string_view row_model;
+        std::string_view model;
+        for (; is_value(); has_token = tokens.next(token)) {
+          if (column == 0) {
+            row_offset = tokens.offset();
+          }
+          if (column == model_column) {
+            row_model = token;
+          }
+          if (++column == m_columns.size()) {
+            column = 0;
+            if (m_models.empty() || row_model != model) {
+              m_models.push_back(Model{row_offset, 0});
+              model = row_model;
+            }
+            ++m_models.back().n_atoms;
+          }
+        }
+        if (column != 0) {
+          tokens.error("Number of `_atom_site` values is not multiple of number of columns");
+        }
+      } else {
+        while (is_value()) {
+          has_token = tokens.next(token);
+        }
+      }
+    } else if (token[0] == '_') {
+      const auto tag = token;
+      if (!tokens.next(token)) {
+        tokens.error("No value of `" + std::string(tag) + "`");
+      }
+      for (int i = 0; i < 6; ++i) {
+        double value;
+        if (equals(tag, cell_tags[i]) && !tokens.is_null(token) && parse_real(token, value)) {
+          cell[i] = value;
+        }
+      }
+      has_token = tokens.next(token);
+    } else {
+      has_token = tokens.next(token); // save_, global_, stop_
+    }
+  }
+  if (cell[0] && cell[1] && cell[2]) {
+    m_cell = geom::UnitCell(*cell[0], *cell[1], *cell[2], geom::Degrees(cell[3].value_or(90)),
+                            geom::Degrees(cell[4].value_or(90)), geom::Degrees(cell[5].value_or(90)));
+  }
+}
+
+size_t CifBufferReader::map_columns(const std::vector<std::string_view>& tags, const Tokenizer& tokens) {
+  const size_t none = tags.size();
+  auto column_of = [&](std::string_view name) {
+    for (size_t i = 0; i < tags.size(); ++i) {
+      if (equals(tags[i].substr(std::string_view("_atom_site.").size()), name)) {
+        return i;
+      }
+    }
+    return none;
+  };
+  auto set = [&](Field field, size_t column) {
+    if (column != none) {
+      m_columns[column] = field;
+    }
+  };
+  auto set_preferred = [&](Field field, std::string_view author_name, std::string_view label_name) {
+    const size_t author = column_of(author_name);
+    set(field, author != none ? author : column_of(label_name));
+    return author != none;
+  };
+
+  m_columns.assign(tags.size(), Field::NONE);
+  m_names.assign(tags.begin(), tags.end());
+  set(Field::ID, column_of("id"));
+  set_preferred(Field::NAME, "auth_atom_id", "label_atom_id");
+  set_preferred(Field::RESIDUE_NAME, "auth_comp_id", "label_comp_id");
+  if (set_preferred(Field::CHAIN, "auth_asym_id", "label_asym_id")) {
+    set(Field::ENTITY_CHAIN, column_of("label_asym_id"));
+  }
+  set_preferred(Field::RESIDUE_SERIAL, "auth_seq_id", "label_seq_id");
+  set(Field::INSERTION_CODE, column_of("pdbx_PDB_ins_code"));
+  for (auto [field, name] : {std::make_pair(Field::X, "Cartn_x"), std::make_pair(Field::Y, "Cartn_y"),
+                             std::make_pair(Field::Z, "Cartn_z")}) {
+    const size_t column = column_of(name);
+    if (column == none) {
+      tokens.error("No `_atom_site." + std::string(name) + "` column");
+    }
+    set(field, column);
+  }
+  const size_t model_column = column_of("pdbx_PDB_model_num");
+  return model_column == none ? std::string_view::npos : model_column;
+}
+
+std::vector<Frame> CifBufferReader::read_frames(const char* begin, const char* end) const {
+  std::vector<Frame> result;
+  result.reserve(n_frames());
+  for (size_t i = 0; i < n_frames(); ++i) {
+    result.push_back(read_frame(begin, end, i));
+  }
+  return result;
+}
+
+Frame CifBufferReader::read_frame(const char* begin, const char* end, size_t index) const {
+  const Model& model = m_models.at(index);
+  Tokenizer tokens(begin, end, model.offset);
+  std::vector<AtomRecord> atoms;
+  atoms.reserve(model.n_atoms);
+  size_t n_residues = 0;
+  size_t n_molecules = 0;
+  MoleculeName chain;
+  std::string_view entity_chain;
+  ResidueId residue_id;
+  std::string_view token;
+  for (size_t i = 0; i < model.n_atoms; ++i) {
+    AtomRecord atom{};
+    MoleculeName atom_chain;
+    std::string_view atom_entity_chain;
+    ResidueInsertionCode insertion_code;
+    int residue_serial = 0;
+    for (size_t c = 0; c < m_columns.size(); ++c) {
+      tokens.next(token);
+      switch (m_columns[c]) {
+      case Field::NONE:
+        break;
+      case Field::ID:
+        atom.id = tokens.read_int(token, m_names[c]);
+        break;
+      case Field::NAME:
+        atom.name = tokens.read_name<AtomName>(token, m_names[c]);
+        break;
+      case Field::RESIDUE_NAME:
+        atom.residue_name = tokens.read_name<ResidueName>(token, m_names[c]);
+        break;
+      case Field::CHAIN:
+        atom_chain = tokens.read_name<MoleculeName>(token, m_names[c]);
+        break;
+      case Field::ENTITY_CHAIN:
+        atom_entity_chain = token;
+        break;
+      case Field::RESIDUE_SERIAL:
+        residue_serial = tokens.read_int(token, m_names[c]);
+        break;
+      case Field::INSERTION_CODE:
+        insertion_code = tokens.read_name<ResidueInsertionCode>(token, m_names[c]);
+        break;
+      case Field::X:
+        atom.r.set_x(tokens.read_double(token, m_names[c]));
+        break;
+      case Field::Y:
+        atom.r.set_y(tokens.read_double(token, m_names[c]));
+        break;
+      case Field::Z:
+        atom.r.set_z(tokens.read_double(token, m_names[c]));
+        break;
+      }
+    }
+    atom.residue_id = ResidueId(residue_serial, insertion_code);
+    atom.new_molecule = atoms.empty() || atom_chain != chain || atom_entity_chain != entity_chain;
+    atom.new_residue = atom.new_molecule || atom.residue_id != residue_id;
+    atom.molecule_name = atom_chain;
+    n_molecules += atom.new_molecule;
+    n_residues += atom.new_residue;
+    chain = atom_chain;
+    entity_chain = atom_entity_chain;
+    residue_id = atom.residue_id;
+    atoms.push_back(atom);
+  }
+
+  Frame result;
+  result.reserve_molecules(n_molecules);
+  result.reserve_residues(n_residues);
+  result.reserve_atoms(atoms.size());
+  std::optional<proxy::MoleculeRef> molecule;
+  std::optional<proxy::ResidueRef> residue;
+  for (auto& atom : atoms) {
+    if (atom.new_molecule) {
+      molecule = result.add_molecule().name(atom.molecule_name);
+    }
+    if (atom.new_residue) {
+      residue = molecule->add_residue().name(atom.residue_name).id(atom.residue_id);
+    }
+    residue->add_atom().name(atom.name).id(atom.id).r(atom.r);
+  }
+  result.cell = m_cell;
+  return result;
+}
+
+void CifBufferReader::read_coords(const char* begin, const char* end, size_t index,
+                                  std::vector<XYZ>& coords) const {
+  const Model& model = m_models.at(index);
+  Tokenizer tokens(begin, end, model.offset);
+  coords.resize(model.n_atoms);
+  std::string_view token;
+  for (auto& r : coords) {
+    for (size_t c = 0; c < m_columns.size(); ++c) {
+      tokens.next(token);
+      switch (m_columns[c]) {
+      case Field::X:
+        r.set_x(tokens.read_double(token, m_names[c]));
+        break;
+      case Field::Y:
+        r.set_y(tokens.read_double(token, m_names[c]));
+        break;
+      case Field::Z:
+        r.set_z(tokens.read_double(token, m_names[c]));
+        break;
+      default:
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace xmol::io::netcdf {
+
+inline void check_netcdf_call(int retval, int expected, const char* const nc_funciton_name) {
+  if (retval != expected) {
+    throw std::runtime_error(std::string(nc_funciton_name) + " failed (" + std::to_string(retval) + ")");
+  }
+}
+
+/// netCDF-C library is not thread-safe, all calls to it are serialized
+inline std::recursive_mutex& netcdf_mutex() {
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+
+} // namespace xmol::io::netcdf
@@ -172,14 +172,14 @@ template <typename Iterator> Frame readFrame(Iterator& it) {
 }
 
 geom::UnitCell read_cell_from_cryst1_record(const PdbLine& line){
-  return geom::UnitCell(
+  return geom::UnitCell{
       line.getDouble(FieldName("a")),
       line.getDouble(FieldName("b")),
       line.getDouble(FieldName("c")),
       geom::Degrees(line.getDouble(FieldName("alpha"))),
       geom::Degrees(line.getDouble(FieldName("beta"))),
       geom::Degrees(line.getDouble(FieldName("gamma")))
-  );
+  };
 }
 
 } // namespace
@@ -0,0 +1,599 @@
+#include "xmol/io/pdb/PdbBufferReader.h"
+#include "xmol/io/pdb/PdbRecord.h"
+#include "xmol/io/pdb/exceptions.h"
+#include "xmol/utils/parsing.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <optional>
+#include <string_view>
+#include <thread>
+
+using namespace xmol::io::pdb;
+using namespace xmol;
+
+namespace {
+
+/// Kinds of records used for frame construction, ANISOU stands for SIGATM and SIGUIJ as well
+enum class Record { ATOM, HETATM, ANISOU, TER, MODEL, ENDMDL, CRYST1, OTHER };
+
+bool is_space(char c) { return std::isspace(static_cast<unsigned char>(c)); }
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && is_space(s.front())) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && is_space(s.back())) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+/// True if record name of @p line (first 6 columns without trailing spaces) is @p name
+template <size_t N> bool has_name(std::string_view line, const char (&name)[N]) {
+  constexpr size_t n = N - 1;
+  if (line.size() < n || std::memcmp(line.data(), name, n) != 0) {
+    return false;
+  }
+  for (size_t i = n; i < std::min<size_t>(line.size(), 6); ++i) {
+    if (!is_space(line[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Record record_of(std::string_view line) {
+  if (line.empty()) {
+    return Record::OTHER;
+  }
+  switch (line[0]) {
+  case 'A':
+    return has_name(line, "ATOM") ? Record::ATOM : has_name(line, "ANISOU") ? Record::ANISOU : Record::OTHER;
+  case 'H':
+    return has_name(line, "HETATM") ? Record::HETATM : Record::OTHER;
+  case 'S':
+    return has_name(line, "SIGATM") || has_name(line, "SIGUIJ") ? Record::ANISOU : Record::OTHER;
+  case 'T':
+    return has_name(line, "TER") ? Record::TER : Record::OTHER;
+  case 'M':
+    return has_name(line, "MODEL") ? Record::MODEL : Record::OTHER;
+  case 'E':
+    return has_name(line, "ENDMDL") ? Record::ENDMDL : Record::OTHER;
+  case 'C':
+    return has_name(line, "CRYST1") ? Record::CRYST1 : Record::OTHER;
+  default:
+    return Record::OTHER;
+  }
+}
+
+/// Unsigned integer of 1 to 9 digits
+bool parse_uint(const char* s, int n, int& value) {
+  if (n < 1 || n > 9) {
+    return false;
+  }
+  int result = 0;
+  for (int i = 0; i < n; ++i) {
+    const unsigned digit = static_cast<unsigned>(s[i]) - '0';
+    if (digit > 9) {
+      return false;
+    }
+    result = result * 10 + static_cast<int>(digit);
+  }
+  value = result;
+  return true;
+}
+
+/// Same as utils::parse_int<SpaceStrip::LEFT_AND_RIGHT>()
+bool parse_int(std::string_view s, int& value) {
+  while (!s.empty() && s.back() == ' ') {
+    s.remove_suffix(1);
+  }
+  while (!s.empty() && s.front() == ' ') {
+    s.remove_prefix(1);
+  }
+  const bool negative = !s.empty() && s.front() == '-';
+  if (negative) {
+    s.remove_prefix(1);
+  }
+  if (!parse_uint(s.data(), s.size(), value)) {
+    return false;
+  }
+  value = negative ? -value : value;
+  return true;
+}
+
+/// Same as utils::parse_fixed_precision_rt()
+bool parse_fixed(std::string_view s, double& value) {
+  const char* pos = s.data();
+  const auto dot = static_cast<const char*>(std::memchr(pos, '.', s.size()));
+  if (!dot) {
+    return false;
+  }
+  int whole = dot - pos;
+  int precision = static_cast<int>(s.size()) - 1 - whole;
+  if (precision == 0) {
+    return false;
+  }
+  while (pos[0] == ' ' && whole > 0) {
+    --whole;
+    ++pos;
+  }
+  while (pos[whole + precision] == ' ' && precision > 0) {
+    --precision;
+  }
+  int sign = 1;
+  if (pos[0] == '-') {
+    sign = -1;
+    ++pos;
+    --whole;
+  }
+  int whole_part = 0;
+  if (!parse_uint(pos, whole, whole_part)) {
+    return false;
+  }
+  if (precision == 0) {
+    value = sign * whole_part;
+    return true;
+  }
+  int fraction_part = 0;
+  if (!parse_uint(pos + whole + 1, precision, fraction_part)) {
+    return false;
+  }
+  value = sign * (whole_part + double(fraction_part) / utils::powers_of_10[precision]);
+  return true;
+}
+
+/// Name from field text, too long names throw as in PdbReader
+template <typename Name> Name make_name(std::string_view s) {
+  if (s.size() > static_cast<size_t>(Name::max_length)) {
+    return Name(std::string(s));
+  }
+  return Name(s.data(), static_cast<int>(s.size()));
+}
+
+struct AtomRecord {
+  AtomName name;
+  AtomId serial;
+  XYZ r;
+  ResidueName residue_name;   /// set for the first atom of residue
+  ResidueId residue_id;       /// set for the first atom of residue
+  MoleculeName molecule_name; /// set for the first atom of molecule
+  bool new_residue;
+  bool new_molecule;
+};
+
+} // namespace
+
+class PdbBufferReader::Parser {
+public:
+  /// Frames of part of PDB text
+  struct Chunk {
+    std::vector<Frame> frames;
+    size_t n_without_cell = 0;          /// number of leading frames which precede CRYST1 records of chunk
+    std::optional<geom::UnitCell> cell; /// last CRYST1 record of chunk
+  };
+
+  /// Parser of `[begin, end)` part of PDB text starting at `text`
+  Parser(const PdbBufferReader& reader, const char* text, const char* begin, const char* end)
+      : m_reader(reader), m_text(text), m_pos(begin), m_end(end) {}
+
+  Chunk read_chunk() {
+    return guarded([&] {
+      Chunk chunk;
+      while (m_pos < m_end) {
+        auto line = next_line();
+        const auto record = record_of(line);
+        if (record == Record::CRYST1) {
+          chunk.cell = read_cell(line);
+          skip(line);
+        } else if (record == Record::MODEL && read_model_coords(line, chunk)) {
+          // topology is shared with reference model
+        } else if (record == Record::MODEL || record == Record::ATOM || record == Record::HETATM) {
+          add(chunk, read_frame(line));
+          if (record == Record::MODEL) {
+            set_reference(line, chunk);
+          }
+        } else {
+          skip(line);
+        }
+      }
+      return chunk;
+    });
+  }
+
+  std::vector<FrameLocation> index_frames() {
+    return guarded([&] {
+      std::vector<FrameLocation> result;
+      auto cell = geom::UnitCell::unit_cubic_cell(); // create dummy cell
+      while (m_pos < m_end) {
+        auto line = next_line();
+        const auto record = record_of(line);
+        if (record == Record::CRYST1) {
+          cell = read_cell(line);
+          skip(line);
+        } else if (record == Record::MODEL || record == Record::ATOM || record == Record::HETATM) {
+          result.push_back(FrameLocation{static_cast<size_t>(line.data() - m_text), cell});
+          walk_frame(line, [](std::string_view, const AtomFields&, bool) {});
+        } else {
+          skip(line);
+        }
+      }
+      return result;
+    });
+  }
+
+  /// Read frame at current position
+  Frame read_frame_here() {
+    return guarded([&] { return read_frame(next_line()); });
+  }
+
+  /// Read coordinates of frame at current position
+  void read_coords_here(std::vector<XYZ>& coords) {
+    guarded([&] {
+      coords.clear();
+      walk_frame(next_line(), [&](std::string_view line, const AtomFields& f, bool) {
+        coords.push_back(XYZ{read_double(line, f.x), read_double(line, f.y), read_double(line, f.z)});
+      });
+    });
+  }
+
+private:
+  /// Line at current position, remembered for error messages
+  std::string_view next_line() {
+    const auto eol = static_cast<const char*>(std::memchr(m_pos, '\n', m_end - m_pos));
+    m_line = std::string_view(m_pos, (eol ? eol : m_end) - m_pos);
+    return m_line;
+  }
+
+  /// Move past @p line and its newline
+  void skip(std::string_view line) { m_pos = std::min(line.data() + line.size() + 1, m_end); }
+
+  static std::string_view text(std::string_view line, Field field) {
+    if (line.size() < static_cast<size_t>(field.first + field.size)) {
+      throw PdbFieldReadError("PDB line is too short", field.first, field.first + field.size - 1);
+    }
+    return line.substr(field.first, field.size);
+  }
+
+  static int read_int(std::string_view line, Field field) {
+    int value = 0;
+    if (line.size() < static_cast<size_t>(field.first + field.size) ||
+        !parse_int(line.substr(field.first, field.size), value)) {
+      throw PdbFieldReadError("PDB line: can't read int", field.first, field.first + field.size - 1);
+    }
+    return value;
+  }
+
+  static double read_double(std::string_view line, Field field) {
+    double value = 0;
+    if (line.size() < static_cast<size_t>(field.first + field.size) ||
+        !parse_fixed(line.substr(field.first, field.size), value)) {
+      throw PdbFieldReadError("PDB line: can't read double", field.first, field.first + field.size - 1);
+    }
+    return value;
+  }
+
+  geom::UnitCell read_cell(std::string_view line) const {
+    auto& f = m_reader.m_cryst1;
+    // braced initialization reads fields left to right, so the first bad field is reported
+    return geom::UnitCell{read_double(line, f.a), read_double(line, f.b), read_double(line, f.c),
+                          geom::Degrees(read_double(line, f.alpha)), geom::Degrees(read_double(line, f.beta)),
+                          geom::Degrees(read_double(line, f.gamma))};
+  }
+
+  /// Call @p f, field read errors are reported with text line
+  template <typename F> auto guarded(F&& f) -> decltype(f()) {
+    try {
+      return f();
+    } catch (PdbFieldReadError& e) {
+      const auto line_number = 1 + std::count(m_text, m_line.data(), '\n');
+      std::string filler(std::min(std::max(e.colon_l, 0), 80), '~');
+      std::string underline(std::min(e.colon_r - e.colon_l + 1, 80), '^');
+      throw PdbException(std::string(e.what()) + "\n" + "at line " + std::to_string(line_number) + ":" +
+                         std::to_string(e.colon_l) + "-" + std::to_string(e.colon_r) + "\n" + std::string(m_line) +
+                         "\n" + filler + underline);
+    }
+  }
+
+  /** Walk records of frame starting at @p first line (MODEL or ATOM/HETATM)
+   *
+   * `on_atom(line, fields, in_chain)` is called for every atom, `in_chain` is false for the first atom
+   * after TER record. Line which terminates frame is consumed.
+   * */
+  template <typename OnAtom> void walk_frame(std::string_view first, OnAtom&& on_atom) {
+    const bool has_model = record_of(first) == Record::MODEL;
+    if (has_model) {
+      skip(first);
+    }
+    bool in_chain = false;   // chain is not closed by TER
+    bool after_atom = false; // previous record is atom or its ANISOU/SIGATM/SIGUIJ
+    while (m_pos < m_end) {
+      auto line = next_line();
+      const auto record = record_of(line);
+      if (record == Record::ATOM || record == Record::HETATM) {
+        on_atom(line, fields_of(record), in_chain);
+        in_chain = true;
+        after_atom = true;
+      } else if (record == Record::ANISOU && after_atom) {
+        // atom details are skipped
+      } else if (record == Record::TER && in_chain) {
+        in_chain = false;
+        after_atom = false;
+      } else if (!has_model || record == Record::ENDMDL) {
+        skip(line); // frame terminator is consumed as in PdbReader
+        break;
+      } else {
+        after_atom = false; // other records within MODEL are skipped
+      }
+      skip(line);
+    }
+  }
+
+  /// Read frame starting at @p first line (MODEL or ATOM/HETATM), line which terminates frame is consumed
+  Frame read_frame(std::string_view first) {
+    m_atoms.clear();
+    size_t n_residues = 0;
+    size_t n_molecules = 0;
+    char chain = 0;
+    ResidueId residue_id;
+    walk_frame(first, [&](std::string_view line, const AtomFields& f, bool in_chain) {
+      const auto chain_id = text(line, f.chainID);
+      const ResidueId id{read_int(line, f.resSeq), make_name<ResidueInsertionCode>(trim(text(line, f.iCode)))};
+      const bool new_molecule = !in_chain || chain_id[0] != chain;
+      const bool new_residue = new_molecule || id != residue_id;
+      m_atoms.push_back(AtomRecord{
+          make_name<AtomName>(trim(text(line, f.name))),
+          read_int(line, f.serial),
+          XYZ{read_double(line, f.x), read_double(line, f.y), read_double(line, f.z)},
+          new_residue ? make_name<ResidueName>(trim(text(line, f.resName))) : ResidueName{},
+          id,
+          new_molecule ? make_name<MoleculeName>(chain_id) : MoleculeName{},
+          new_residue,
+          new_molecule,
+      });
+      n_molecules += new_molecule;
+      n_residues += new_residue;
+      chain = chain_id[0];
+      residue_id = id;
+    });
+
+    Frame result;
+    result.reserve_molecules(n_molecules);
+    result.reserve_residues(n_residues);
+    result.reserve_atoms(m_atoms.size());
+    std::optional<proxy::MoleculeRef> molecule;
+    std::optional<proxy::ResidueRef> residue;
+    for (auto& atom : m_atoms) {
+      if (atom.new_molecule) {
+        molecule = result.add_molecule().name(atom.molecule_name);
+      }
+      if (atom.new_residue) {
+        residue = molecule->add_residue().name(atom.residue_name).id(atom.residue_id);
+      }
+      residue->add_atom().name(atom.name).id(atom.serial).r(atom.r);
+    }
+    return result;
+  }
+
+  const AtomFields& fields_of(Record record) const {
+    return record == Record::ATOM ? m_reader.m_atom : m_reader.m_hetatm;
+  }
+
+  void add(Chunk& chunk, Frame&& frame) {
+    if (chunk.cell) {
+      frame.cell = *chunk.cell;
+    } else {
+      ++chunk.n_without_cell;
+    }
+    chunk.frames.push_back(std::move(frame));
+  }
+
+  /// Make last frame of @p chunk, read from MODEL record @p first, reference for following models
+  void set_reference(std::string_view first, Chunk& chunk) {
+    m_reference = chunk.frames.size() - 1;
+    // frames are copied on reallocation, reserve for following models of about the same size
+    const size_t model_size = m_pos - first.data();
+    chunk.frames.reserve(chunk.frames.size() + (m_end - m_pos) / model_size + 1);
+    m_reference_lines.clear();
+    const char* pos = first.data() + first.size();
+    while (pos < m_end) {
+      ++pos;
+      const auto eol = static_cast<const char*>(std::memchr(pos, '\n', m_end - pos));
+      const std::string_view line(pos, (eol ? eol : m_end) - pos);
+      const auto record = record_of(line);
+      if (record == Record::ATOM || record == Record::HETATM || record == Record::TER) {
+        m_reference_lines.push_back(line);
+      } else if (record == Record::ENDMDL) {
+        break;
+      }
+      pos = line.data() + line.size();
+    }
+  }
+
+  /// True if atom records @p line and @p reference_line of the same type describe the same atom
+  static bool same_atom(std::string_view line, std::string_view reference_line, const AtomFields& f) {
+    for (auto& field : {f.serial, f.name, f.resName, f.chainID, f.resSeq, f.iCode}) {
+      const size_t last = field.first + field.size;
+      if (line.size() < last || reference_line.size() < last ||
+          std::memcmp(line.data() + field.first, reference_line.data() + field.first, field.size) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** Read model starting at MODEL record @p first as copy of reference model with new coordinates
+   *
+   * Topology of model is the same as reference one if their ATOM/HETATM/TER records go in the same order
+   * and have identical fields except coordinates. Returns false and consumes nothing otherwise.
+   * */
+  bool read_model_coords(std::string_view first, Chunk& chunk) {
+    if (m_reference == SIZE_MAX) {
+      return false;
+    }
+    skip(first);
+    m_coords.clear();
+    size_t n_lines = 0;
+    bool same = true;
+    while (m_pos < m_end) {
+      auto line = next_line();
+      const auto record = record_of(line);
+      if (record == Record::ENDMDL) {
+        skip(line);
+        break;
+      }
+      if (record == Record::ATOM || record == Record::HETATM || record == Record::TER) {
+        same = n_lines < m_reference_lines.size() && record_of(m_reference_lines[n_lines]) == record &&
+               (record == Record::TER || same_atom(line, m_reference_lines[n_lines], fields_of(record)));
+        if (!same) {
+          break;
+        }
+        if (record != Record::TER) {
+          auto& f = fields_of(record);
+          m_coords.push_back(XYZ{read_double(line, f.x), read_double(line, f.y), read_double(line, f.z)});
+        }
+        ++n_lines;
+      }
+      skip(line);
+    }
+    if (!same || n_lines != m_reference_lines.size()) {
+      m_pos = first.data();
+      return false;
+    }
+    Frame frame(chunk.frames[m_reference]);
+    auto coords = frame.coords();
+    for (size_t i = 0; i < m_coords.size(); ++i) {
+      coords[i].set(m_coords[i]);
+    }
+    add(chunk, std::move(frame));
+    return true;
+  }
+
+  const PdbBufferReader& m_reader;
+  const char* m_text;
+  const char* m_pos;
+  const char* m_end;
+  std::string_view m_line;         /// current line
+  std::vector<AtomRecord> m_atoms; /// atoms of current frame
+
+  size_t m_reference = SIZE_MAX;                  /// index of last model read in full
+  std::vector<std::string_view> m_reference_lines; /// ATOM/HETATM/TER records of reference model
+  std::vector<XYZ> m_coords;                       /// coordinates of current model
+};
+
+namespace {
+
+/// Zero-based column range of @p name field of @p record
+template <typename Field, size_t N> Field field_of(const PdbRecordType& record, const char (&name)[N]) {
+  auto& colons = record.getFieldColons(FieldName(name));
+  return Field{colons[0] - 1, colons[1] - colons[0] + 1};
+}
+
+} // namespace
+
+PdbBufferReader::PdbBufferReader(const basic_PdbRecords& db) {
+  for (auto [record_name, fields] : {std::make_pair(RecordName("ATOM"), &m_atom),
+                                     std::make_pair(RecordName("HETATM"), &m_hetatm)}) {
+    auto& record = db.get_record(record_name);
+    *fields = AtomFields{
+        field_of<Field>(record, "serial"),  field_of<Field>(record, "name"),    field_of<Field>(record, "resName"),
+        field_of<Field>(record, "chainID"), field_of<Field>(record, "resSeq"),  field_of<Field>(record, "iCode"),
+        field_of<Field>(record, "x"),       field_of<Field>(record, "y"),       field_of<Field>(record, "z"),
+    };
+  }
+  auto& cryst1 = db.get_record(RecordName("CRYST1"));
+  m_cryst1 = CellFields{
+      field_of<Field>(cryst1, "a"),     field_of<Field>(cryst1, "b"),    field_of<Field>(cryst1, "c"),
+      field_of<Field>(cryst1, "alpha"), field_of<Field>(cryst1, "beta"), field_of<Field>(cryst1, "gamma"),
+  };
+}
+
+std::vector<Frame> PdbBufferReader::read_frames(const char* begin, const char* end, size_t n_threads) const {
+  if (n_threads == 0) {
+    n_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  // Text is split at MODEL records which follow ENDMDL ones, reading state doesn't depend on preceding text there
+  // except for the unit cell which is passed between chunks afterwards
+  std::vector<const char*> splits;
+  if (n_threads > 1) {
+    const std::string_view text(begin, end - begin);
+    for (size_t pos = text.find("\nMODEL"); pos != std::string_view::npos; pos = text.find("\nMODEL", pos + 1)) {
+      const size_t previous = pos == 0 ? std::string_view::npos : text.rfind('\n', pos - 1);
+      const size_t line_begin = previous == std::string_view::npos ? 0 : previous + 1;
+      if (has_name(text.substr(pos + 1), "MODEL") &&
+          has_name(text.substr(line_begin, pos - line_begin), "ENDMDL")) {
+        splits.push_back(begin + pos + 1);
+      }
+    }
+  }
+  const size_t n_chunks = std::min(n_threads, splits.size() + 1);
+  std::vector<const char*> bounds{begin};
+  for (size_t w = 1; w < n_chunks; ++w) {
+    bounds.push_back(splits[splits.size() * w / n_chunks]);
+  }
+  bounds.push_back(end);
+
+  std::vector<Parser::Chunk> chunks(n_chunks);
+  if (n_chunks == 1) {
+    chunks[0] = Parser(*this, begin, begin, end).read_chunk();
+  } else {
+    std::vector<std::exception_ptr> errors(n_chunks);
+    std::vector<std::thread> workers;
+    workers.reserve(n_chunks);
+    for (size_t w = 0; w < n_chunks; ++w) {
+      workers.emplace_back([&, w] {
+        try {
+          chunks[w] = Parser(*this, begin, bounds[w], bounds[w + 1]).read_chunk();
+        } catch (...) {
+          errors[w] = std::current_exception();
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    for (auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error); // the first error in text order
+      }
+    }
+  }
+
+  size_t n_frames = 0;
+  for (auto& chunk : chunks) {
+    n_frames += chunk.frames.size();
+  }
+  std::vector<Frame> frames;
+  frames.reserve(n_frames);
+  auto cell = geom::UnitCell::unit_cubic_cell(); // create dummy cell
+  for (auto& chunk : chunks) {
+    for (size_t i = 0; i < chunk.frames.size(); ++i) {
+      if (i < chunk.n_without_cell) {
+        chunk.frames[i].cell = cell;
+      }
+      frames.push_back(std::move(chunk.frames[i]));
+    }
+    if (chunk.cell) {
+      cell = *chunk.cell;
+    }
+  }
+  return frames;
+}
+
+std::vector<PdbBufferReader::FrameLocation> PdbBufferReader::index_frames(const char* begin, const char* end) const {
+  return Parser(*this, begin, begin, end).index_frames();
+}
+
+Frame PdbBufferReader::read_frame(const char* begin, const char* end, const FrameLocation& location) const {
+  auto frame = Parser(*this, begin, begin + location.offset, end).read_frame_here();
+  frame.cell = location.cell;
+  return frame;
+}
+
+void PdbBufferReader::read_coords(const char* begin, const char* end, const FrameLocation& location,
+                                  std::vector<XYZ>& coords) const {
+  Parser(*this, begin, begin + location.offset, end).read_coords_here(coords);
+}
@@ -0,0 +1,264 @@
+#include "xmol/io/pdb/PdbBufferWriter.h"
+#include "xmol/io/pdb/PdbRecord.h"
+#include "xmol/io/pdb/exceptions.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace xmol::io::pdb;
+using namespace xmol;
+
+namespace {
+
+const int pdb_line_width = 80;
+
+/// Size of buffers for formatted fields, longer fields are truncated as by std::snprintf()
+const size_t text_capacity = 32;
+
+/// Format @p value as by printf("%d"), returns length of text
+size_t format_int(char* out, long long value) {
+  char digits[24];
+  unsigned long long n = value < 0 ? 0ull - static_cast<unsigned long long>(value) : value;
+  size_t k = 0;
+  do {
+    digits[k++] = static_cast<char>('0' + n % 10);
+    n /= 10;
+  } while (n != 0);
+  size_t length = 0;
+  if (value < 0) {
+    out[length++] = '-';
+  }
+  while (k != 0) {
+    out[length++] = digits[--k];
+  }
+  return length;
+}
+
+/** Format @p value as by printf("%*.*f", width, precision) in "C" locale, returns length of complete text
+ *
+ * Value is rounded as by printf: exact decimal value of double is rounded half to even.
+ * Text longer than text_capacity - 1 is truncated (it's possible for huge values only)
+ * */
+size_t format_fixed(char* out, double value, int width, int precision) {
+  static const double scales[] = {1, 10, 100, 1000, 10000};
+  assert(0 < precision && precision < 5);
+  const double abs_value = std::abs(value);
+  const double scaled = abs_value * scales[precision];
+  if (!(scaled < 1e15)) { // inf, nan and values which don't fit integer arithmetic
+    return std::snprintf(out, text_capacity, "%*.*f", width, precision, value);
+  }
+  double rounded = std::nearbyint(scaled); // ties to even
+  if (std::abs(rounded - scaled) == 0.5) {
+    // Rounded product is a tie, exact product decides (its error is representable and computed exactly by fma)
+    const double error = std::fma(abs_value, scales[precision], -scaled);
+    if (error != 0) {
+      rounded = error > 0 ? std::ceil(scaled) : std::floor(scaled);
+    }
+  }
+  auto n = static_cast<unsigned long long>(rounded);
+  char text[text_capacity];
+  char* const end = text + text_capacity;
+  char* p = end;
+  for (int i = 0; i < precision; ++i) {
+    *--p = static_cast<char>('0' + n % 10);
+    n /= 10;
+  }
+  *--p = '.';
+  do {
+    *--p = static_cast<char>('0' + n % 10);
+    n /= 10;
+  } while (n != 0);
+  if (std::signbit(value)) {
+    *--p = '-';
+  }
+  const auto length = static_cast<size_t>(end - p);
+  const size_t padding = static_cast<size_t>(width) > length ? width - length : 0;
+  std::memset(out, ' ', padding);
+  std::memcpy(out + padding, p, length);
+  return padding + length;
+}
+
+template <typename Field, size_t N> Field field_of(const PdbRecordType& record, const char (&name)[N]) {
+  auto& colons = record.getFieldColons(FieldName(name));
+  assert(colons[0] <= colons[1]);
+  assert(colons[1] <= pdb_line_width);
+  return Field{colons[0] - 1, colons[1] - colons[0] + 1};
+}
+
+/** Place formatted @p text of @p length into @p line as PdbWriter does
+ *
+ * Text is right-aligned to the last column of field. Text longer than field is truncated to field size
+ * and replaces @p length characters, so the rest of line is shifted left.
+ * */
+template <typename Field> void put(std::string& line, const Field& field, const char* text, size_t length) {
+  assert(std::min<size_t>(length, field.size) < text_capacity);
+  line.replace(field.first + field.size - length, length, text, std::min<size_t>(length, field.size));
+}
+
+} // namespace
+
+PdbBufferWriter::PdbBufferWriter(std::ostream& out, size_t buffer_size)
+    : PdbBufferWriter(out, StandardPdbRecords::instance(), buffer_size) {}
+
+PdbBufferWriter::PdbBufferWriter(std::ostream& out, const basic_PdbRecords& db, size_t buffer_size)
+    : m_ostream(&out), m_buffer_size(buffer_size) {
+  auto& atom = db.get_record(RecordName("ATOM"));
+  m_atom = AtomFields{
+      field_of<Field>(atom, "serial"),  field_of<Field>(atom, "name"),   field_of<Field>(atom, "resName"),
+      field_of<Field>(atom, "chainID"), field_of<Field>(atom, "resSeq"), field_of<Field>(atom, "iCode"),
+      field_of<Field>(atom, "x"),       field_of<Field>(atom, "y"),      field_of<Field>(atom, "z"),
+  };
+  auto& cryst1 = db.get_record(RecordName("CRYST1"));
+  m_cryst1 = CellFields{
+      field_of<Field>(cryst1, "a"),     field_of<Field>(cryst1, "b"),    field_of<Field>(cryst1, "c"),
+      field_of<Field>(cryst1, "alpha"), field_of<Field>(cryst1, "beta"), field_of<Field>(cryst1, "gamma"),
+  };
+  m_buffer.reserve(m_buffer_size + 4 * pdb_line_width);
+}
+
+PdbBufferWriter::~PdbBufferWriter() { flush(); }
+
+void PdbBufferWriter::flush() {
+  m_ostream->write(m_buffer.data(), m_buffer.size());
+  m_buffer.clear();
+}
+
+void PdbBufferWriter::reserve(size_t n) {
+  if (m_buffer.size() + n > m_buffer_size) {
+    flush();
+  }
+}
+
+void PdbBufferWriter::write(Frame& frame) {
+  set_topology(frame);
+  write_cell(frame);
+  write_atoms(frame);
+}
+
+void PdbBufferWriter::write(trajectory::Trajectory::Slice slice) {
+  size_t serial = 1;
+  for (auto& frame : slice) {
+    if (serial == 1) {
+      set_topology(frame); // topology is the same for all frames of slice
+    }
+    write_model(frame, serial++);
+  }
+}
+
+void PdbBufferWriter::write_model(Frame& frame, size_t serial) {
+  write_cell(frame);
+  reserve(pdb_line_width);
+  char text[text_capacity];
+  const size_t length = format_int(text, static_cast<long long>(serial));
+  m_buffer += "MODEL ";
+  m_buffer.append(length < 8 ? 8 - length : 0, ' '); // serial at columns 11-14
+  m_buffer.append(text, length);
+  m_buffer += '\n';
+  write_atoms(frame);
+  reserve(pdb_line_width);
+  m_buffer += "ENDMDL\n";
+}
+
+void PdbBufferWriter::set_topology(Frame& frame) {
+  m_topology.clear();
+  m_atom_lines.clear();
+  m_topology.reserve(frame.n_atoms() * pdb_line_width + frame.n_molecules() * 4);
+  m_atom_lines.reserve(frame.n_atoms());
+
+  std::string line;
+  char text[text_capacity];
+  for (auto& molecule : frame.molecules()) {
+    const auto chain_id = molecule.name().str();
+    if (static_cast<int>(chain_id.size()) > m_atom.chainID.size) {
+      throw PdbWriteError("Molecule name `" + chain_id + "` is longer than PDB chainID field (" +
+                          std::to_string(m_atom.chainID.size) + " columns)");
+    }
+    for (auto& residue : molecule.residues()) {
+      const auto res_name = residue.name().str();
+      if (static_cast<int>(res_name.size()) > m_atom.resName.size) {
+        throw PdbWriteError("Residue name `" + res_name + "` is longer than PDB resName field (" +
+                            std::to_string(m_atom.resName.size) + " columns)");
+      }
+      const auto i_code = residue.id().iCode.str();
+      for (auto& atom : residue.atoms()) {
+        line.assign(pdb_line_width, ' ');
+        line.replace(0, 6, "ATOM");
+        put(line, m_atom.serial, text, format_int(text, atom.id()));
+        auto name = atom.name().str();
+        if (name.size() < 4) {
+          name.insert(name.begin(), ' ');
+        }
+        if (name.size() < 4) {
+          name.resize(4, ' ');
+        }
+        put(line, m_atom.name, name.data(), name.size());
+        put(line, m_atom.resName, res_name.data(), res_name.size());
+        put(line, m_atom.chainID, chain_id.data(), chain_id.size());
+        put(line, m_atom.resSeq, text, format_int(text, residue.id().serial));
+        put(line, m_atom.iCode, i_code.data(), i_code.size());
+        m_atom_lines.push_back(AtomLine{m_topology.size(), line.size()});
+        m_topology += line;
+        m_topology += '\n';
+      }
+    }
+    m_topology += "TER\n";
+  }
+}
+
+void PdbBufferWriter::write_cell(Frame& frame) {
+  if (frame.cell.volume() == 1.0) {
+    return;
+  }
+  std::string line(pdb_line_width, ' ');
+  line.replace(0, 6, "CRYST1");
+  char text[text_capacity];
+  put(line, m_cryst1.a, text, format_fixed(text, frame.cell.a(), 9, 3));
+  put(line, m_cryst1.b, text, format_fixed(text, frame.cell.b(), 9, 3));
+  put(line, m_cryst1.c, text, format_fixed(text, frame.cell.c(), 9, 3));
+  put(line, m_cryst1.alpha, text, format_fixed(text, frame.cell.alpha().degrees(), 7, 2));
+  put(line, m_cryst1.beta, text, format_fixed(text, frame.cell.beta().degrees(), 7, 2));
+  put(line, m_cryst1.gamma, text, format_fixed(text, frame.cell.gamma().degrees(), 7, 2));
+  reserve(line.size() + 1);
+  m_buffer += line;
+  m_buffer += '\n';
+}
+
+void PdbBufferWriter::write_atoms(Frame& frame) {
+  auto coords = frame.coords()._eigen();
+  assert(static_cast<size_t>(coords.rows()) == m_atom_lines.size());
+  const Field fields[3] = {m_atom.x, m_atom.y, m_atom.z};
+  char text[3][text_capacity];
+  size_t length[3];
+  size_t done = 0; // written part of m_topology
+  for (size_t i = 0; i < m_atom_lines.size(); ++i) {
+    const AtomLine& atom_line = m_atom_lines[i];
+    bool in_place = true;
+    for (int k = 0; k < 3; ++k) {
+      length[k] = format_fixed(text[k], coords(i, k), 8, 3);
+      in_place = in_place && length[k] <= static_cast<size_t>(fields[k].size) &&
+                 static_cast<size_t>(fields[k].first + fields[k].size) <= atom_line.size;
+    }
+    reserve(atom_line.offset + atom_line.size + 1 - done);
+    if (in_place) {
+      m_buffer.append(m_topology, done, atom_line.offset + atom_line.size + 1 - done);
+      char* record = &m_buffer[m_buffer.size() - atom_line.size - 1];
+      for (int k = 0; k < 3; ++k) {
+        std::memcpy(record + fields[k].first + fields[k].size - length[k], text[k], length[k]);
+      }
+    } else {
+      m_buffer.append(m_topology, done, atom_line.offset - done);
+      std::string record = m_topology.substr(atom_line.offset, atom_line.size);
+      for (int k = 0; k < 3; ++k) {
+        put(record, fields[k], text[k], length[k]);
+      }
+      m_buffer += record;
+      m_buffer += '\n';
+    }
+    done = atom_line.offset + atom_line.size + 1;
+  }
+  reserve(m_topology.size() - done);
+  m_buffer.append(m_topology, done, std::string::npos);
+}
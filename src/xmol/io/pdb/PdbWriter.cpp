@@ -1,6 +1,7 @@
 #include "xmol/io/pdb/PdbWriter.h"
 #include "xmol/Frame.h"
 #include "xmol/io/pdb/PdbRecord.h"
+#include "xmol/io/pdb/exceptions.h"
 #include "xmol/proxy/selections.h"
 
 using namespace xmol::io::pdb;
@@ -56,8 +57,22 @@ void PdbWriter::write(AtomRef& atom, const basic_PdbRecords& db) {
   write_field("%d", atom.id(), FieldName("serial"));
   write_field("%-4s", format_atom_name(atom.name()).c_str(), FieldName("name"));
 //  write_field("%s", , FieldName("altLoc"));
-  write_field("%-s", atom.residue().name().str().c_str(), FieldName("resName"));
-  write_field("%-s", atom.residue().molecule().name().str().c_str(), FieldName("chainID"));
+  const auto res_name = atom.residue().name().str();
+  const auto& res_name_colons = atom_record.getFieldColons(FieldName("resName"));
+  const int res_name_width = res_name_colons[1] - res_name_colons[0] + 1;
+  if (static_cast<int>(res_name.size()) > res_name_width) {
+    throw PdbWriteError("Residue name `" + res_name + "` is longer than PDB resName field (" +
+                        std::to_string(res_name_width) + " columns)");
+  }
+  write_field("%-s", res_name.c_str(), FieldName("resName"));
+  const auto chain_id = atom.residue().molecule().name().str();
+  const auto& chain_colons = atom_record.getFieldColons(FieldName("chainID"));
+  const int chain_width = chain_colons[1] - chain_colons[0] + 1;
+  if (static_cast<int>(chain_id.size()) > chain_width) {
+    throw PdbWriteError("Molecule name `" + chain_id + "` is longer than PDB chainID field (" +
+                        std::to_string(chain_width) + " columns)");
+  }
+  write_field("%-s", chain_id.c_str(), FieldName("chainID"));
   write_field("%-d", atom.residue().id().serial, FieldName("resSeq"));
   write_field("%s", atom.residue().id().iCode.str().c_str(), FieldName("iCode"));
   write_field("%8.3f", atom.r().x(), FieldName("x"));
@@ -0,0 +1,101 @@
+#include "xmol/io/xdr/FrameOffsetIndex.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace xmol::io::xdr;
+
+namespace {
+
+constexpr std::array<char, 8> Magic{'X', 'M', 'O', 'L', 'I', 'D', 'X', '3'};
+
+struct Stamp {
+  std::uint64_t file_size;
+  std::int64_t mtime;
+};
+
+std::optional<Stamp> stamp_of(const std::string& filename) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(filename, ec);
+  if (ec) {
+    return {};
+  }
+  auto mtime = std::filesystem::last_write_time(filename, ec);
+  if (ec) {
+    return {};
+  }
+  return Stamp{static_cast<std::uint64_t>(size), static_cast<std::int64_t>(mtime.time_since_epoch().count())};
+}
+
+template <typename T> bool read_raw(std::istream& in, T& value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+template <typename T> void write_raw(std::ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // namespace
+
+bool FrameOffsetIndex::save(const std::string& index_filename, const std::string& trajectory_filename) const {
+  auto stamp = stamp_of(trajectory_filename);
+  if (!stamp) {
+    return false;
+  }
+  std::ofstream out(index_filename, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+  out.write(Magic.data(), Magic.size());
+  write_raw(out, stamp->file_size);
+  write_raw(out, stamp->mtime);
+  write_raw(out, static_cast<std::uint64_t>(m_offsets.size()));
+  out.write(reinterpret_cast<const char*>(m_offsets.data()), sizeof(m_offsets[0]) * m_offsets.size());
+  out.write(reinterpret_cast<const char*>(m_times.data()), sizeof(m_times[0]) * m_times.size());
+  return static_cast<bool>(out);
+}
+
+std::optional<FrameOffsetIndex> FrameOffsetIndex::load(const std::string& index_filename,
+                                                       const std::string& trajectory_filename) {
+  auto stamp = stamp_of(trajectory_filename);
+  if (!stamp) {
+    return {};
+  }
+  std::ifstream in(index_filename, std::ios::binary);
+  if (!in) {
+    return {};
+  }
+  std::array<char, Magic.size()> magic{};
+  Stamp stored{};
+  std::uint64_t n_frames;
+  if (!in.read(magic.data(), magic.size()) || magic != Magic) {
+    return {};
+  }
+  if (!read_raw(in, stored.file_size) || !read_raw(in, stored.mtime) || !read_raw(in, n_frames)) {
+    return {};
+  }
+  if (stored.file_size != stamp->file_size || stored.mtime != stamp->mtime) {
+    return {};
+  }
+  if (n_frames > stamp->file_size / sizeof(std::int64_t)) { // division avoids overflow of corrupted n_frames
+    return {};
+  }
+  FrameOffsetIndex result;
+  result.m_offsets.resize(n_frames);
+  result.m_times.resize(n_frames);
+  if (!in.read(reinterpret_cast<char*>(result.m_offsets.data()), sizeof(std::int64_t) * n_frames) ||
+      !in.read(reinterpret_cast<char*>(result.m_times.data()), sizeof(double) * n_frames)) {
+    return {};
+  }
+  // offsets of stale or damaged index must not be used for seeking
+  const auto file_size = static_cast<std::int64_t>(stamp->file_size);
+  for (size_t i = 0; i < result.m_offsets.size(); ++i) {
+    const auto offset = result.m_offsets[i];
+    if (offset < 0 || offset >= file_size || (i > 0 && offset <= result.m_offsets[i - 1])) {
+      return {};
+    }
+  }
+  return result;
+}
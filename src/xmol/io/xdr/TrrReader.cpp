@@ -0,0 +1,199 @@
+#include "xmol/io/xdr/TrrReader.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+using namespace xmol::io::xdr;
+
+namespace {
+constexpr int Magic = 1993;
+} // namespace
+
+auto TrrReader::read_header(TrrHeader& header) -> Status {
+  auto status = Status::OK;
+  int magic = 0;
+  status &= m_xdr.read(magic);
+  if (!status) {
+    m_error_str = "Can't read frame header";
+    return Status::ERROR;
+  }
+  if (magic != Magic) {
+    m_error_str = "Can't read frame header: Bad magic";
+    return Status::ERROR;
+  }
+
+  int version_size_plus_one = 0;
+  int version_size = 0;
+  status &= m_xdr.read(version_size_plus_one);
+  status &= m_xdr.read(version_size);
+  if (!status || version_size < 0 || version_size + 1 != version_size_plus_one) {
+    m_error_str = "Can't read frame header: Bad version string";
+    return Status::ERROR;
+  }
+  status &= m_xdr.skip((version_size + 3) / 4 * 4); // xdr strings are padded to 4 bytes
+
+  std::array<int, 13> ints{};
+  status &= m_xdr.read(ints);
+  if (!status) {
+    m_error_str = "Can't read frame header";
+    return Status::ERROR;
+  }
+  const int ir_size = ints[0];
+  const int e_size = ints[1];
+  header.box_size = ints[2];
+  header.vir_size = ints[3];
+  header.pres_size = ints[4];
+  const int top_size = ints[5];
+  const int sym_size = ints[6];
+  header.x_size = ints[7];
+  header.v_size = ints[8];
+  header.f_size = ints[9];
+  header.n_atoms = ints[10];
+  header.step = ints[11];
+  header.n_energies = ints[12];
+
+  if (ir_size != 0 || e_size != 0 || top_size != 0 || sym_size != 0) {
+    m_error_str = "Can't read frame header: Unsupported frame contents";
+    return Status::ERROR;
+  }
+  if (header.n_atoms < 0) {
+    m_error_str = "Can't read frame header: Bad number of atoms";
+    return Status::ERROR;
+  }
+
+  int real_size = 0;
+  if (header.box_size != 0) {
+    real_size = header.box_size / 9;
+  } else if (header.n_atoms > 0 && header.x_size != 0) {
+    real_size = header.x_size / (header.n_atoms * 3);
+  } else if (header.n_atoms > 0 && header.v_size != 0) {
+    real_size = header.v_size / (header.n_atoms * 3);
+  } else if (header.n_atoms > 0 && header.f_size != 0) {
+    real_size = header.f_size / (header.n_atoms * 3);
+  }
+  if (real_size != sizeof(float) && real_size != sizeof(double)) {
+    m_error_str = "Can't read frame header: Can't determine precision";
+    return Status::ERROR;
+  }
+  header.is_double = real_size == sizeof(double);
+
+  auto valid_size = [&](int size, int n_reals) { return size == 0 || size == n_reals * real_size; };
+  const int n_vector_reals = header.n_atoms * 3;
+  if (!valid_size(header.box_size, 9) || !valid_size(header.vir_size, 9) || !valid_size(header.pres_size, 9) ||
+      !valid_size(header.x_size, n_vector_reals) || !valid_size(header.v_size, n_vector_reals) ||
+      !valid_size(header.f_size, n_vector_reals)) {
+    m_error_str = "Can't read frame header: Inconsistent block sizes";
+    return Status::ERROR;
+  }
+
+  if (header.is_double) {
+    status &= m_xdr.read(header.time);
+    status &= m_xdr.read(header.lambda);
+  } else {
+    float time, lambda;
+    status &= m_xdr.read(time);
+    status &= m_xdr.read(lambda);
+    header.time = time;
+    header.lambda = lambda;
+  }
+  if (!status) {
+    m_error_str = "Can't read frame header";
+  }
+  return Status(status);
+}
+
+auto TrrReader::read_block(const TrrHeader& header, int block_size, size_t n_reals,
+                           const future::Span<double>& dst) -> Status {
+  if (block_size == 0) {
+    return Status::OK;
+  }
+  if (dst.empty()) {
+    return m_xdr.skip(block_size);
+  }
+  assert(dst.size() == n_reals);
+  if (header.is_double) {
+    return m_xdr.read(dst);
+  }
+  m_float_buffer.resize(n_reals);
+  auto status = m_xdr.read(m_float_buffer);
+  std::copy(m_float_buffer.begin(), m_float_buffer.end(), dst.begin());
+  return status;
+}
+
+auto TrrReader::read_data(const TrrHeader& header, const future::Span<double>& box, const future::Span<double>& x,
+                          const future::Span<double>& v, const future::Span<double>& f) -> Status {
+  const size_t n_vector_reals = header.n_atoms * 3;
+  if (!read_block(header, header.box_size, 9, box)) {
+    m_error_str = "Can't read box vectors";
+    return Status::ERROR;
+  }
+  if (!m_xdr.skip(std::int64_t(header.vir_size) + header.pres_size)) {
+    m_error_str = "Can't skip virial and pressure";
+    return Status::ERROR;
+  }
+  if (!read_block(header, header.x_size, n_vector_reals, x)) {
+    m_error_str = "Can't read coordinates";
+    return Status::ERROR;
+  }
+  if (!read_block(header, header.v_size, n_vector_reals, v)) {
+    m_error_str = "Can't read velocities";
+    return Status::ERROR;
+  }
+  if (!read_block(header, header.f_size, n_vector_reals, f)) {
+    m_error_str = "Can't read forces";
+    return Status::ERROR;
+  }
+  return Status::OK;
+}
+
+auto TrrReader::skip_data(const TrrHeader& header) -> Status {
+  if (!m_xdr.skip(header.data_size())) {
+    m_error_str = "Can't skip frame data";
+    return Status::ERROR;
+  }
+  return Status::OK;
+}
+
+// Frame size is known from header, no need to read payload
+auto TrrReader::advance(size_t n_frames) -> Status {
+  TrrHeader header{};
+  for (size_t i = 0; i < n_frames; i++) {
+    if (!read_header(header) || !skip_data(header)) {
+      return Status::ERROR;
+    }
+  }
+  return Status::OK;
+}
+
+auto TrrReader::scan(FrameOffsetIndex& index) -> Status {
+  TrrHeader header{};
+  const auto file_size = m_xdr.size();
+  const auto first_offset = tell();
+  while (tell() < file_size) {
+    auto offset = tell();
+    if (!read_header(header) || !skip_data(header)) {
+      if (!m_xdr.past_end() || offset == first_offset) {
+        return Status::ERROR; // corrupted frame
+      }
+      break; // last frame is cut in header (e.g. file is being written), keep preceding frames
+    }
+    if (tell() > file_size) {
+      break; // last frame is incomplete
+    }
+    if (!header.has_coords()) {
+      continue; // velocities/forces written at steps without coordinates (nstvout/nstfout != nstxout)
+    }
+    index.push_back(offset, header.time);
+  }
+  m_error_str = "";
+  return Status::OK;
+}
+
+auto TrrReader::seek(std::int64_t offset) -> Status {
+  if (!m_xdr.seek(offset)) {
+    m_error_str = "Can't seek to frame offset";
+    return Status::ERROR;
+  }
+  return Status::OK;
+}
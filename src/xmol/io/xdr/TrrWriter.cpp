@@ -0,0 +1,116 @@
+#include "xmol/io/xdr/TrrWriter.h"
+#include "xmol/Frame.h"
+
+#include <cstring>
+
+namespace {
+constexpr int Magic = 1993;
+constexpr const char* Version = "GMX_trn_file";
+} // namespace
+
+void xmol::io::xdr::TrrWriter::write(Frame& frame) {
+  auto velocities = frame.velocities()._eigen();
+  auto forces = frame.forces()._eigen();
+  write(frame, future::Span<const double>(velocities.data(), velocities.size()),
+        future::Span<const double>(forces.data(), forces.size()));
+}
+
+void xmol::io::xdr::TrrWriter::write(Frame& frame, const future::Span<const double>& velocities,
+                                     const future::Span<const double>& forces) {
+  const size_t n_reals = 3 * frame.n_atoms();
+  if (!velocities.empty() && velocities.size() != n_reals) {
+    throw TrrWriteError("TrrWriter::write(): expected " + std::to_string(n_reals) + " velocity components, got " +
+                        std::to_string(velocities.size()));
+  }
+  if (!forces.empty() && forces.size() != n_reals) {
+    throw TrrWriteError("TrrWriter::write(): expected " + std::to_string(n_reals) + " force components, got " +
+                        std::to_string(forces.size()));
+  }
+
+  TrrHeader header{};
+  header.is_double = m_double_precision;
+  header.n_atoms = frame.n_atoms();
+  header.step = frame.index;
+  header.time = frame.time;
+  header.box_size = 9 * header.real_size();
+  header.x_size = n_reals * header.real_size();
+  header.v_size = velocities.empty() ? 0 : n_reals * header.real_size();
+  header.f_size = forces.empty() ? 0 : n_reals * header.real_size();
+  if (!write_header(header)) {
+    throw TrrWriteError(m_error_str);
+  }
+
+  const std::array<double, 9> box{
+      frame.cell[0].x(), frame.cell[0].y(), frame.cell[0].z(), //
+      frame.cell[1].x(), frame.cell[1].y(), frame.cell[1].z(), //
+      frame.cell[2].x(), frame.cell[2].y(), frame.cell[2].z(), //
+  };
+  if (!write_reals(future::Span<const double>(box.data(), box.size()), 0.1)) { // angstroms to nanometers
+    m_error_str = "Can't write box vectors";
+    throw TrrWriteError(m_error_str);
+  }
+
+  auto coords = frame.coords()._eigen();
+  if (!write_reals(future::Span<const double>(coords.data(), n_reals), 0.1)) { // angstroms to nanometers
+    m_error_str = "Can't write coordinates";
+    throw TrrWriteError(m_error_str);
+  }
+  if (!write_reals(velocities, 0.1)) { // Å/ps to nm/ps
+    m_error_str = "Can't write velocities";
+    throw TrrWriteError(m_error_str);
+  }
+  if (!write_reals(forces, 10.0)) { // kJ/mol/Å to kJ/mol/nm
+    m_error_str = "Can't write forces";
+    throw TrrWriteError(m_error_str);
+  }
+}
+
+auto xmol::io::xdr::TrrWriter::write_header(const TrrHeader& header) -> Status {
+  auto status = Status::OK;
+  const int version_size = std::strlen(Version);
+  status &= m_xdr.write(Magic);
+  status &= m_xdr.write(version_size + 1);
+  status &= m_xdr.write(version_size);
+  status &= m_xdr.write_opaque(Version, version_size); // xdr_opaque pads to 4 bytes
+
+  const std::array<int, 13> ints{0, // ir_size
+                                 0, // e_size
+                                 header.box_size,
+                                 header.vir_size,
+                                 header.pres_size,
+                                 0, // top_size
+                                 0, // sym_size
+                                 header.x_size,
+                                 header.v_size,
+                                 header.f_size,
+                                 header.n_atoms,
+                                 header.step,
+                                 header.n_energies};
+  status &= m_xdr.write(future::Span<const int>(ints.data(), ints.size()));
+  if (header.is_double) {
+    status &= m_xdr.write(header.time);
+    status &= m_xdr.write(header.lambda);
+  } else {
+    status &= m_xdr.write(static_cast<float>(header.time));
+    status &= m_xdr.write(static_cast<float>(header.lambda));
+  }
+  if (!status) {
+    m_error_str = "Can't write frame header";
+  }
+  return Status(status);
+}
+
+auto xmol::io::xdr::TrrWriter::write_reals(const future::Span<const double>& values, double factor) -> Status {
+  if (m_double_precision) {
+    m_double_buffer.resize(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+      m_double_buffer[i] = values[i] * factor;
+    }
+    return m_xdr.write(future::Span<const double>(m_double_buffer.data(), m_double_buffer.size()));
+  }
+  m_float_buffer.resize(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    m_float_buffer[i] = static_cast<float>(values[i] * factor);
+  }
+  return m_xdr.write(future::Span<const float>(m_float_buffer.data(), m_float_buffer.size()));
+}
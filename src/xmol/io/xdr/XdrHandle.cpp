@@ -1,81 +1,226 @@
 #include "xmol/io/xdr/XdrHandle.h"
+#include "../byte_order.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <type_traits>
 
 using namespace xmol::io::xdr;
 
-auto XdrHandle::read_opaque(char* cp, unsigned int cnt) -> Status { return Status(xdr_opaque(&m_xdr, cp, cnt)); }
-auto XdrHandle::write_opaque(const char* cp, unsigned int cnt) -> Status {
-  return Status(xdr_opaque(&m_xdr, const_cast<char*>(cp), cnt));
+namespace {
+
+/// Size of read/write buffer, reads of larger arrays bypass it
+constexpr size_t BufferSize = 1 << 20;
+
+/// Size of first buffer refill after seek, doubled by each following sequential refill up to BufferSize,
+/// so strided and header-only reads don't read whole buffer per frame
+constexpr size_t SeekRefillSize = 1 << 14;
+
+/// Convert @p n big-endian words of type @p T to host order (and vice versa) in place
+template <typename T> void swap_words(char* bytes, size_t n) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  static_assert(sizeof(T) == 4 || sizeof(T) == 8);
+  using W = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+  for (size_t i = 0; i < n; ++i) { // simple loop over fixed-size words is vectorized by compiler
+    W w;
+    std::memcpy(&w, bytes + i * sizeof(W), sizeof(W));
+    w = xmol::io::byte_order::byteswap(w);
+    std::memcpy(bytes + i * sizeof(W), &w, sizeof(W));
+  }
+#else
+  static_cast<void>(bytes);
+  static_cast<void>(n);
+#endif
 }
 
-XdrHandle::XdrHandle(const std::string& path, XdrHandle::Mode mode) : m_mode(mode) {
+} // namespace
+
+XdrHandle::XdrHandle(const std::string& path, XdrHandle::Mode mode)
+    : m_mode(mode), m_buffer(BufferSize), m_refill_size(BufferSize) {
   const char* mode_str = "rb";
-  xdr_op op = xdr_op::XDR_DECODE;
   switch (mode) {
   case Mode::READ:
     mode_str = "rb";
-    op = xdr_op::XDR_DECODE;
     break;
   case Mode::WRITE:
     mode_str = "wb";
-    op = xdr_op::XDR_ENCODE;
     break;
   }
   m_file = std::fopen(path.c_str(), mode_str);
   if (!m_file){
     throw std::runtime_error("Can't open `" + path + "` in `" + mode_str + "` mode");
   }
-  xdrstdio_create(&m_xdr, m_file, op);
+  std::setvbuf(m_file, nullptr, _IONBF, 0); // buffering is done by handle
 }
 
-auto XdrHandle::read(int& value) -> Status {
+XdrHandle::~XdrHandle() {
+  if (m_mode == Mode::WRITE) {
+    static_cast<void>(flush());
+  }
+  std::fclose(m_file);
+}
+
+auto XdrHandle::read_bytes(void* dst, size_t n_bytes) -> Status {
   assert(m_mode == Mode::READ);
-  return Status(xdr_int(&m_xdr, &value));
+  auto out = static_cast<char*>(dst);
+  const size_t available = m_end - m_pos;
+  m_past_end = false;
+  if (n_bytes <= available) {
+    std::memcpy(out, m_buffer.data() + m_pos, n_bytes);
+    m_pos += n_bytes;
+    return Status::OK;
+  }
+  std::memcpy(out, m_buffer.data() + m_pos, available);
+  out += available;
+  n_bytes -= available;
+  m_buffer_offset += m_end;
+  m_pos = m_end = 0;
+
+  if (n_bytes >= BufferSize) { // large arrays are read directly
+    const size_t n_read = std::fread(out, 1, n_bytes, m_file);
+    m_buffer_offset += n_read;
+    m_past_end = n_read < n_bytes;
+    return Status(n_read == n_bytes);
+  }
+  const size_t refill_size = std::max(m_refill_size, n_bytes);
+  m_refill_size = std::min(m_refill_size * 2, BufferSize);
+  m_end = std::fread(m_buffer.data(), 1, refill_size, m_file);
+  if (m_end < n_bytes) {
+    m_pos = m_end;
+    m_past_end = true;
+    return Status::ERROR;
+  }
+  std::memcpy(out, m_buffer.data(), n_bytes);
+  m_pos = n_bytes;
+  return Status::OK;
 }
 
-auto XdrHandle::write(const int& value) -> Status {
+auto XdrHandle::write_bytes(const void* src, size_t n_bytes) -> Status {
   assert(m_mode == Mode::WRITE);
-  return Status(xdr_int(&m_xdr, const_cast<int*>(&value)));
+  if (m_pos + n_bytes > BufferSize && !flush()) {
+    return Status::ERROR;
+  }
+  if (n_bytes >= BufferSize) {
+    const size_t n_written = std::fwrite(src, 1, n_bytes, m_file);
+    m_buffer_offset += n_written;
+    return Status(n_written == n_bytes);
+  }
+  std::memcpy(m_buffer.data() + m_pos, src, n_bytes);
+  m_pos += n_bytes;
+  return Status::OK;
 }
 
-auto XdrHandle::read(float& value) -> Status {
-  assert(m_mode == Mode::READ);
-  return Status(xdr_float(&m_xdr, &value));
+template <typename T> auto XdrHandle::read_words(T* dst, size_t n) -> Status {
+  if (!read_bytes(dst, n * sizeof(T))) {
+    return Status::ERROR;
+  }
+  swap_words<T>(reinterpret_cast<char*>(dst), n);
+  return Status::OK;
+}
+
+template <typename T> auto XdrHandle::write_words(const T* src, size_t n) -> Status {
+  assert(m_mode == Mode::WRITE);
+  while (n > 0) {
+    const size_t chunk = std::min(n, (BufferSize - m_pos) / sizeof(T));
+    if (chunk == 0) {
+      if (!flush()) {
+        return Status::ERROR;
+      }
+      continue;
+    }
+    char* out = m_buffer.data() + m_pos;
+    std::memcpy(out, src, chunk * sizeof(T));
+    swap_words<T>(out, chunk);
+    m_pos += chunk * sizeof(T);
+    src += chunk;
+    n -= chunk;
+  }
+  return Status::OK;
 }
 
-auto XdrHandle::write(const float& value) -> Status {
+auto XdrHandle::flush() -> Status {
   assert(m_mode == Mode::WRITE);
-  return Status(xdr_float(&m_xdr, const_cast<float*>(&value)));
+  const size_t n_written = std::fwrite(m_buffer.data(), 1, m_pos, m_file);
+  m_buffer_offset += n_written;
+  const bool ok = n_written == m_pos;
+  m_pos = 0;
+  return Status(ok);
+}
+
+auto XdrHandle::read_opaque(char* cp, unsigned int cnt) -> Status {
+  auto status = read_bytes(cp, cnt);
+  status &= skip((4 - cnt % 4) % 4); // opaque data is padded to 4 bytes
+  return status;
+}
+
+auto XdrHandle::write_opaque(const char* cp, unsigned int cnt) -> Status {
+  constexpr char zeros[4] = {};
+  auto status = write_bytes(cp, cnt);
+  status &= write_bytes(zeros, (4 - cnt % 4) % 4); // opaque data is padded to 4 bytes
+  return status;
 }
 
+auto XdrHandle::read(int& value) -> Status { return read_words(&value, 1); }
+
+auto XdrHandle::write(const int& value) -> Status { return write_words(&value, 1); }
+
+auto XdrHandle::read(float& value) -> Status { return read_words(&value, 1); }
+
+auto XdrHandle::write(const float& value) -> Status { return write_words(&value, 1); }
+
+auto XdrHandle::read(double& value) -> Status { return read_words(&value, 1); }
+
+auto XdrHandle::write(const double& value) -> Status { return write_words(&value, 1); }
+
 auto XdrHandle::read(const xmol::future::Span<float>& value) -> Status {
-  auto status = Status::OK;
-  for (auto& el : value) {
-    status &= read(el);
-  }
-  return Status(status);
+  return read_words(value.data(), value.size());
 }
 
 auto XdrHandle::write(const xmol::future::Span<const float>& value) -> Status {
-  auto status = Status::OK;
-  for (auto& el : value) {
-    status &= write(el);
-  }
-  return Status(status);
+  return write_words(value.data(), value.size());
 }
 
-auto XdrHandle::read(const xmol::future::Span<int>& value) -> Status {
-  auto status = Status::OK;
-  for (auto& el : value) {
-    status &= read(el);
-  }
-  return Status(status);
+auto XdrHandle::read(const xmol::future::Span<double>& value) -> Status {
+  return read_words(value.data(), value.size());
+}
+
+auto XdrHandle::write(const xmol::future::Span<const double>& value) -> Status {
+  return write_words(value.data(), value.size());
 }
+
+auto XdrHandle::read(const xmol::future::Span<int>& value) -> Status { return read_words(value.data(), value.size()); }
+
 auto XdrHandle::write(const xmol::future::Span<const int>& value) -> Status {
-  auto status = Status::OK;
-  for (auto& el : value) {
-    status &= write(el);
+  return write_words(value.data(), value.size());
+}
+
+auto XdrHandle::tell() const -> std::int64_t { return m_buffer_offset + m_pos; }
+
+auto XdrHandle::size() const -> std::int64_t {
+  struct stat st {};
+  if (fstat(fileno(m_file), &st) != 0) {
+    return -1;
   }
-  return Status(status);
+  return st.st_size;
 }
+
+auto XdrHandle::seek(std::int64_t offset) -> Status {
+  assert(m_mode == Mode::READ);
+  if (offset >= m_buffer_offset && offset <= m_buffer_offset + std::int64_t(m_end)) {
+    m_pos = offset - m_buffer_offset;
+    return Status::OK;
+  }
+  m_pos = m_end = 0;
+  m_refill_size = SeekRefillSize;
+  if (fseeko(m_file, offset, SEEK_SET) != 0) {
+    m_buffer_offset = ftello(m_file);
+    return Status::ERROR;
+  }
+  m_buffer_offset = offset;
+  return Status::OK;
+}
+
+auto XdrHandle::skip(std::int64_t n_bytes) -> Status { return seek(tell() + n_bytes); }
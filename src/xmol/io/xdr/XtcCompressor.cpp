@@ -0,0 +1,74 @@
+#include "XtcCompressor.h"
+
+using namespace xmol::io::xdr;
+
+void XtcWriter::Record::compress(float precision) {
+  error = header.n_atoms > 9 ? xtc::compress_coords(flat_coords.data(), header.n_atoms, precision, compressed)
+                             : nullptr;
+}
+
+XtcWriter::Compressor::Compressor(float precision, size_t n_threads) : m_precision(precision) {
+  assert(n_threads > 0);
+  m_threads.reserve(n_threads);
+  for (size_t i = 0; i < n_threads; ++i) {
+    m_threads.emplace_back(&Compressor::run, this);
+  }
+}
+
+XtcWriter::Compressor::~Compressor() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_cv.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void XtcWriter::Compressor::run() {
+  while (true) {
+    Record* record;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [this] { return m_stopped || m_n_started < m_queue.size(); });
+      if (m_stopped) {
+        return;
+      }
+      record = m_queue[m_n_started++].get();
+    }
+    try {
+      record->compress(m_precision);
+    } catch (std::bad_alloc&) {
+      record->error = "Can't allocate compression buffers";
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    record->ready = true;
+    m_cv.notify_all();
+  }
+}
+
+void XtcWriter::Compressor::submit(std::unique_ptr<Record> record) {
+  record->ready = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.push_back(std::move(record));
+  }
+  m_cv.notify_all();
+}
+
+std::unique_ptr<XtcWriter::Record> XtcWriter::Compressor::pop(bool wait) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (m_queue.empty()) {
+    return nullptr;
+  }
+  if (wait) {
+    m_cv.wait(lock, [this] { return m_queue.front()->ready; });
+  } else if (!m_queue.front()->ready) {
+    return nullptr;
+  }
+  auto record = std::move(m_queue.front());
+  m_queue.pop_front();
+  --m_n_started;
+  return record;
+}
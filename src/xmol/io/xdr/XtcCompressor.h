@@ -0,0 +1,59 @@
+#pragma once
+#include "xmol/io/xdr/XtcWriter.h"
+#include "xtc_routines.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace xmol::io::xdr {
+
+/// Frame prepared for output, coordinates and box are in nanometers
+struct XtcWriter::Record {
+  XtcHeader header{};
+  std::array<float, 9> box{};
+  std::vector<float> flat_coords;
+  xtc::CompressedCoords compressed;
+  const char* error = nullptr; /// compression error, nullptr on success
+  bool ready = false;
+
+  /// Compress coordinates of frames larger than 9 atoms, smaller ones are stored as is
+  void compress(float precision);
+};
+
+/** Pool of background threads compressing frames
+ *
+ * Records are compressed in arbitrary order and handed back to writer in order of submission.
+ * */
+class XtcWriter::Compressor {
+public:
+  Compressor(float precision, size_t n_threads);
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+  ~Compressor();
+
+  /// Enqueue @p record for compression
+  void submit(std::unique_ptr<Record> record);
+
+  /// Oldest submitted record if it's compressed, nullptr otherwise. Waits for compression if @p wait is set
+  std::unique_ptr<Record> pop(bool wait);
+
+  /// Number of submitted records which are not popped yet
+  [[nodiscard]] size_t size() const { return m_queue.size(); }
+
+  [[nodiscard]] size_t n_threads() const { return m_threads.size(); }
+
+private:
+  void run();
+
+  const float m_precision;
+  std::deque<std::unique_ptr<Record>> m_queue; /// submitted records in order, modified by writer thread only
+  size_t m_n_started = 0;                      /// number of records at front of queue taken by workers
+  bool m_stopped = false;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::vector<std::thread> m_threads;
+};
+
+} // namespace xmol::io::xdr
@@ -9,19 +9,24 @@ using namespace xmol::io::xdr::xtc;
 auto XtcReader::read_header(XtcHeader& header) -> Status {
   constexpr int Magic = 1995;
   auto status = Status::OK;
-  int magic;
+  int magic = 0;
   status &= m_xdr.read(magic);
   status &= m_xdr.read(header.n_atoms);
   status &= m_xdr.read(header.step);
   status &= m_xdr.read(header.time);
+  if (!status) {
+    m_error_str = "Can't read frame header";
+    return Status::ERROR;
+  }
   if (magic != Magic) {
     m_error_str = "Can't read frame header: Bad magic";
     return Status::ERROR;
   }
-  if (!status) {
-    m_error_str = "Can't read frame header";
+  if (header.n_atoms < 0) {
+    m_error_str = "Can't read frame header: Bad number of atoms";
+    return Status::ERROR;
   }
-  return Status(status);
+  return Status::OK;
 }
 
 auto XtcReader::read_box(const xmol::future::Span<float>& box) -> Status {
@@ -33,18 +38,8 @@ auto XtcReader::read_box(const xmol::future::Span<float>& box) -> Status {
   return status;
 }
 
-auto XtcReader::read_coords(const xmol::future::Span<float>& flat_coords) -> Status {
-  std::array<unsigned int, 3> sizeint{}, sizesmall{}, bitsizeint{};
-  int flag, k;
-  int small, smaller, i, is_smaller, run;
-  int* thiscoord;
-
-  std::array<int, 3> prevcoord{};
-
+auto XtcReader::read_coords(const xmol::future::Span<float>& flat_coords, size_t max_atoms) -> Status {
   int lsize;
-  unsigned int bitsize;
-  float inv_precision;
-
   if (m_xdr.read(lsize) != Status::OK) {
     m_error_str = "Can't read size";
     return Status::ERROR;
@@ -55,7 +50,7 @@ auto XtcReader::read_coords(const xmol::future::Span<float>& flat_coords) -> Sta
     return Status::ERROR;
   }
 
-  if (flat_coords.size() <= 9) {
+  if (flat_coords.size() <= 9 * 3) {
     return m_xdr.read(flat_coords);
   }
   float precision;
@@ -65,9 +60,6 @@ auto XtcReader::read_coords(const xmol::future::Span<float>& flat_coords) -> Sta
     return Status::ERROR;
   }
 
-  m_ip.resize(flat_coords.size());
-  m_buf.resize(flat_coords.size() * 1.2);
-
   std::array<int, 3> minint{};
   std::array<int, 3> maxint{};
 
@@ -78,6 +70,9 @@ auto XtcReader::read_coords(const xmol::future::Span<float>& flat_coords) -> Sta
     return Status::ERROR;
   }
 
+  std::array<unsigned int, 3> sizeint{};
+  std::array<int, 3> bitsizeint{};
+  int bitsize;
   sizeint[0] = maxint[0] - minint[0] + 1;
   sizeint[1] = maxint[1] - minint[1] + 1;
   sizeint[2] = maxint[2] - minint[2] + 1;
@@ -97,114 +92,102 @@ auto XtcReader::read_coords(const xmol::future::Span<float>& flat_coords) -> Sta
     m_error_str = "Can't read smallidx";
     return Status::ERROR;
   }
-  smaller = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
-  small = magicints[smallidx] / 2;
-  sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+  if (smallidx < FIRSTIDX || smallidx >= static_cast<int>(magicints.size())) {
+    m_error_str = "Bad smallidx";
+    return Status::ERROR;
+  }
 
   int n_bytes;
-  if (m_xdr.read(n_bytes) == Status::ERROR) {
-    m_error_str = "Error at: m_xdr.read(n_bytes)";
+  if (m_xdr.read(n_bytes) == Status::ERROR || n_bytes < 0) {
+    m_error_str = "Can't read size in bytes of compressed coords";
     return Status::ERROR;
   }
-  assert(m_buf.size() * sizeof(m_buf[0]) >= n_bytes);
-
-  if (m_xdr.read_opaque((char*)&m_buf[3], (unsigned int)n_bytes) == Status::ERROR) {
-    m_error_str = "Error at: m_xdr.read_opaque((caddr_t) & (m_buf[3]), (u_int)m_buf[0])";
+  m_buf.resize(n_bytes);
+  if (m_xdr.read_opaque(m_buf.data(), (unsigned int)n_bytes) == Status::ERROR) {
+    m_error_str = "Can't read compressed coords";
     return Status::ERROR;
   }
-  m_buf[0] = m_buf[1] = m_buf[2] = 0;
-
-  float* lfp = flat_coords.data();
-  int* lip = m_ip.data();
-  inv_precision = 1.0f / precision;
-  run = 0;
-  i = 0;
-  while (i < lsize) {
-    thiscoord = (int*)(lip) + i * 3;
 
+  BitReader bits(reinterpret_cast<const unsigned char*>(m_buf.data()), m_buf.size());
+  const float inv_precision = 1.0f / precision;
+  auto store = [inv_precision](float*& out, const std::array<int, 3>& coord) {
+    out[0] = static_cast<float>(coord[0]) * inv_precision;
+    out[1] = static_cast<float>(coord[1]) * inv_precision;
+    out[2] = static_cast<float>(coord[2]) * inv_precision;
+    out += 3;
+  };
+
+  float* out = flat_coords.data();
+  std::array<int, 3> coord{};
+  std::array<int, 3> prevcoord{};
+  const int n_decoded = static_cast<int>(std::min<size_t>(lsize, max_atoms));
+  int run = 0; // length of run of small atoms in coordinates (multiple of 3), kept until changed by flag
+  int i = 0;
+  while (i < n_decoded) {
+    // atom encoded relative to the bounding box
     if (bitsize == 0) {
-      thiscoord[0] = receivebits(m_buf.data(), bitsizeint[0]);
-      thiscoord[1] = receivebits(m_buf.data(), bitsizeint[1]);
-      thiscoord[2] = receivebits(m_buf.data(), bitsizeint[2]);
+      prevcoord[0] = bits.read_bits(bitsizeint[0]);
+      prevcoord[1] = bits.read_bits(bitsizeint[1]);
+      prevcoord[2] = bits.read_bits(bitsizeint[2]);
     } else {
-      receiveints(m_buf.data(), 3, (int)bitsize, sizeint.data(), thiscoord);
+      bits.read_ints(bitsize, sizeint.data(), prevcoord.data());
     }
-
+    prevcoord[0] += minint[0];
+    prevcoord[1] += minint[1];
+    prevcoord[2] += minint[2];
     i++;
-    thiscoord[0] += minint[0];
-    thiscoord[1] += minint[1];
-    thiscoord[2] += minint[2];
-
-    prevcoord[0] = thiscoord[0];
-    prevcoord[1] = thiscoord[1];
-    prevcoord[2] = thiscoord[2];
 
-    flag = receivebits(m_buf.data(), 1);
-    is_smaller = 0;
-    if (flag == 1) {
-      run = receivebits(m_buf.data(), 5);
-      is_smaller = run % 3;
-      run -= is_smaller;
-      is_smaller--;
+    // run of atoms encoded relative to the previous one
+    int is_smaller = 0;
+    if (bits.read_bits(1)) {
+      run = bits.read_bits(5);
+      is_smaller = run % 3 - 1;
+      run -= run % 3;
+    }
+    if (run / 3 > lsize - i) {
+      m_error_str = "Run of compressed atoms exceeds number of atoms";
+      return Status::ERROR;
     }
-    if (run > 0) {
-      thiscoord += 3;
-      for (k = 0; k < run; k += 3) {
-        receiveints(m_buf.data(), 3, smallidx, sizesmall.data(), thiscoord);
-        i++;
-        thiscoord[0] += prevcoord[0] - small;
-        thiscoord[1] += prevcoord[1] - small;
-        thiscoord[2] += prevcoord[2] - small;
-        if (k == 0) {
-          /* interchange first with second atom for better
-           * compression of water molecules
-           */
-          std::swap(thiscoord[0], prevcoord[0]);
-          std::swap(thiscoord[1], prevcoord[1]);
-          std::swap(thiscoord[2], prevcoord[2]);
 
-          *lfp++ = prevcoord[0] * inv_precision;
-          *lfp++ = prevcoord[1] * inv_precision;
-          *lfp++ = prevcoord[2] * inv_precision;
-        } else {
-          prevcoord[0] = thiscoord[0];
-          prevcoord[1] = thiscoord[1];
-          prevcoord[2] = thiscoord[2];
-        }
-        *lfp++ = static_cast<float>(thiscoord[0]) * inv_precision;
-        *lfp++ = static_cast<float>(thiscoord[1]) * inv_precision;
-        *lfp++ = static_cast<float>(thiscoord[2]) * inv_precision;
-      }
+    if (run == 0) {
+      store(out, prevcoord);
     } else {
-      *lfp++ = static_cast<float>(thiscoord[0]) * inv_precision;
-      *lfp++ = static_cast<float>(thiscoord[1]) * inv_precision;
-      *lfp++ = static_cast<float>(thiscoord[2]) * inv_precision;
+      const int small = magicints[smallidx] / 2;
+      // first atom of run is interchanged with preceding one for better compression of water molecules
+      bits.read_small_ints(smallidx, coord.data());
+      coord[0] += prevcoord[0] - small;
+      coord[1] += prevcoord[1] - small;
+      coord[2] += prevcoord[2] - small;
+      store(out, coord);
+      store(out, prevcoord);
+      prevcoord = coord;
+      for (int k = 3; k < run; k += 3) {
+        bits.read_small_ints(smallidx, coord.data());
+        coord[0] += prevcoord[0] - small;
+        coord[1] += prevcoord[1] - small;
+        coord[2] += prevcoord[2] - small;
+        store(out, coord);
+        prevcoord = coord;
+      }
+      i += run / 3;
     }
+
     smallidx += is_smaller;
-    if (is_smaller < 0) {
-      small = smaller;
-      if (smallidx > FIRSTIDX) {
-        smaller = magicints[smallidx - 1] / 2;
-      } else {
-        smaller = 0;
-      }
-    } else if (is_smaller > 0) {
-      smaller = small;
-      small = magicints[smallidx] / 2;
+    if (smallidx < FIRSTIDX || smallidx >= static_cast<int>(magicints.size())) {
+      m_error_str = "Bad smallidx";
+      return Status::ERROR;
     }
-    sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
   }
   m_error_str = "";
   return Status::OK;
 }
 
-// Frames have variable length in bytes, therefore we still need to make dummy reads
+// Frames have variable length in bytes, therefore we still need to read sizes of compressed payload
 auto XtcReader::advance(size_t n_frames) -> Status {
 
   XtcHeader header{};
   std::array<float, 9> box{};
 
-  std::array<int, 3> int3{};
   for (int i = 0; i < n_frames; i++) {
     if (!read_header(header)) {
       return Status::ERROR;
@@ -212,48 +195,78 @@ auto XtcReader::advance(size_t n_frames) -> Status {
     if (!read_box(box)) {
       return Status::ERROR;
     }
-    int lsize;
-    if (m_xdr.read(lsize) != Status::OK) { // size
+    if (!skip_coords(header.n_atoms)) {
       return Status::ERROR;
     }
+  }
+  return Status::OK;
+}
 
-    if (lsize <= 9) {
-      if (!m_xdr.read(box)) { // uncompressed coords
-        return Status::ERROR;
+auto XtcReader::scan(FrameOffsetIndex& index) -> Status {
+  XtcHeader header{};
+  std::array<float, 9> box{};
+  const auto file_size = m_xdr.size();
+  while (tell() < file_size) {
+    auto offset = tell();
+    if (!read_header(header) || !read_box(box) || !skip_coords(header.n_atoms)) {
+      if (!m_xdr.past_end() || index.n_frames() == 0) {
+        return Status::ERROR; // corrupted frame
       }
-      continue;
+      break; // last frame is incomplete (e.g. file is being written), keep preceding frames
     }
-
-    float precision;
-    if (!m_xdr.read(precision)) {
-      return Status::ERROR;
+    if (tell() > file_size) {
+      break; // last frame is incomplete
     }
+    index.push_back(offset, header.time);
+  }
+  m_error_str = "";
+  return Status::OK;
+}
 
-    m_ip.resize(lsize);
-    m_buf.resize(lsize * 1.2);
+auto XtcReader::seek(std::int64_t offset) -> Status {
+  if (!m_xdr.seek(offset)) {
+    m_error_str = "Can't seek to frame offset";
+    return Status::ERROR;
+  }
+  return Status::OK;
+}
 
-    if (!m_xdr.read(int3)) { // minints
-      return Status::ERROR;
-    }
-    if (!m_xdr.read(int3)) { // maxints
-      return Status::ERROR;
-    }
+auto XtcReader::skip_coords(int n_atoms) -> Status {
+  int lsize;
+  if (m_xdr.read(lsize) != Status::OK) { // size
+    m_error_str = "Can't read size";
+    return Status::ERROR;
+  }
+  if (lsize != n_atoms) {
+    m_error_str = "Wrong number of coordinates";
+    return Status::ERROR;
+  }
 
-    int smallidx;
-    if (!m_xdr.read(smallidx)) { // smallidx
+  if (lsize <= 9) {
+    if (!m_xdr.skip(lsize * 3 * sizeof(float))) { // uncompressed coords
+      m_error_str = "Can't skip uncompressed coords";
       return Status::ERROR;
     }
+    return Status::OK;
+  }
 
-    int n_bytes;
-    if (!m_xdr.read(n_bytes)) { // nbytes
-      return Status::ERROR;
-    }
+  // precision, minint[3], maxint[3], smallidx
+  constexpr int n_skipped_words = 1 + 3 + 3 + 1;
+  if (!m_xdr.skip(n_skipped_words * 4)) {
+    m_error_str = "Can't skip compression parameters";
+    return Status::ERROR;
+  }
 
-    assert(m_buf.size() * sizeof(m_buf[0]) >= n_bytes);
+  int n_bytes;
+  if (!m_xdr.read(n_bytes) || n_bytes < 0) { // nbytes
+    m_error_str = "Can't read size in bytes of compressed coords";
+    return Status::ERROR;
+  }
 
-    if (m_xdr.read_opaque((char*)&m_buf[3], (unsigned int)n_bytes) == Status::ERROR) { // compressed coords
-      return Status::ERROR;
-    }
+  const int n_padded_bytes = (n_bytes + 3) / 4 * 4; // xdr opaque data is padded to 4 bytes boundary
+  if (!m_xdr.skip(n_padded_bytes)) { // compressed coords
+    m_error_str = "Can't skip compressed coords";
+    return Status::ERROR;
   }
   return Status::OK;
 }
@@ -1,32 +1,50 @@
 #include "xtc_routines.h"
-#include <cstdio>
+#include "../byte_order.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
 #include <cstdlib>
 
 namespace xmol::io::xdr::xtc {
 
-void sendints(int buf[], const int num_of_ints, const int num_of_bits, unsigned int sizes[],
-                     unsigned int nums[]) {
+namespace {
 
-  int i;
-  unsigned int bytes[32], num_of_bytes, bytecnt, tmp;
+/// `ceil(2^64 / magicints[i])`, turns division of 32-bit values into multiplication (Lemire et al., 2019)
+const std::array<uint64_t, magicints.size()> magicints_reciprocals = [] {
+  std::array<uint64_t, magicints.size()> result{};
+  for (size_t i = FIRSTIDX; i < magicints.size(); ++i) {
+    result[i] = UINT64_MAX / magicints[i] + 1;
+  }
+  return result;
+}();
 
-  tmp = nums[0];
-  num_of_bytes = 0;
-  do {
-    bytes[num_of_bytes++] = tmp & 0xff;
-    tmp >>= 8;
-  } while (tmp != 0);
+/// Quotient of 32-bit @p n by divisor with @p reciprocal from magicints_reciprocals
+inline uint32_t divide(uint32_t n, uint64_t reciprocal) {
+  return static_cast<uint32_t>((static_cast<unsigned __int128>(reciprocal) * n) >> 64);
+}
 
-  for (i = 1; i < num_of_ints; i++) {
-    if (nums[i] >= sizes[i]) {
-      fprintf(stderr,
-              "major breakdown in sendints num %d doesn't "
-              "match size %d\n",
-              nums[i], sizes[i]);
-      exit(1);
-    }
-    /* use one step multiply */
-    tmp = nums[i];
+} // namespace
+
+int sizeofint(const int size) {
+  unsigned int num = 1;
+  int num_of_bits = 0;
+
+  while (size >= num && num_of_bits < 32) {
+    num_of_bits++;
+    num <<= 1;
+  }
+  return num_of_bits;
+}
+
+int sizeofints(const int num_of_ints, unsigned int sizes[]) {
+  int i, num;
+  unsigned int num_of_bytes, num_of_bits, bytes[32], bytecnt, tmp;
+  num_of_bytes = 1;
+  bytes[0] = 1;
+  num_of_bits = 0;
+  for (i = 0; i < num_of_ints; i++) {
+    tmp = 0;
     for (bytecnt = 0; bytecnt < num_of_bytes; bytecnt++) {
       tmp = bytes[bytecnt] * sizes[i] + tmp;
       bytes[bytecnt] = tmp & 0xff;
@@ -38,101 +56,77 @@ void sendints(int buf[], const int num_of_ints, const int num_of_bits, unsigned
     }
     num_of_bytes = bytecnt;
   }
-  if (num_of_bits >= num_of_bytes * 8) {
-    for (i = 0; i < num_of_bytes; i++) {
-      sendbits(buf, 8, bytes[i]);
-    }
-    sendbits(buf, num_of_bits - num_of_bytes * 8, 0);
-  } else {
-    for (i = 0; i < num_of_bytes - 1; i++) {
-      sendbits(buf, 8, bytes[i]);
-    }
-    sendbits(buf, num_of_bits - (num_of_bytes - 1) * 8, bytes[i]);
+  num = 1;
+  num_of_bytes--;
+  while (bytes[num_of_bytes] >= num) {
+    num_of_bits++;
+    num *= 2;
   }
+  return num_of_bits + num_of_bytes * 8;
 }
 
-void sendbits(int buf[], int num_of_bits, int num) {
-
-  unsigned int cnt, lastbyte;
-  int lastbits;
-  unsigned char* cbuf;
-
-  cbuf = ((unsigned char*)buf) + 3 * sizeof(*buf);
-  cnt = (unsigned int)buf[0];
-  lastbits = buf[1];
-  lastbyte = (unsigned int)buf[2];
-  while (num_of_bits >= 8) {
-    lastbyte = (lastbyte << 8) | ((num >> (num_of_bits - 8)) /* & 0xff*/);
-    cbuf[cnt++] = lastbyte >> lastbits;
-    num_of_bits -= 8;
-  }
-  if (num_of_bits > 0) {
-    lastbyte = (lastbyte << num_of_bits) | num;
-    lastbits += num_of_bits;
-    if (lastbits >= 8) {
-      lastbits -= 8;
-      cbuf[cnt++] = lastbyte >> lastbits;
-    }
-  }
-  buf[0] = cnt;
-  buf[1] = lastbits;
-  buf[2] = lastbyte;
-  if (lastbits > 0) {
-    cbuf[cnt] = lastbyte << (8 - lastbits);
+uint64_t BitReader::read_packed(int num_of_bits) {
+  // sendints() stores bytes of a number starting from the least significant one,
+  // the last (most significant) byte may be shorter than 8 bits
+  const int n_full_bytes = (num_of_bits - 1) / 8;
+  uint64_t bytes = 0;
+  if (n_full_bytes > 4) {
+    bytes = uint64_t(read_bits(32)) << (8 * (n_full_bytes - 4));
+    bytes |= read_bits(8 * (n_full_bytes - 4));
+  } else if (n_full_bytes > 0) {
+    bytes = read_bits(8 * n_full_bytes);
   }
+  uint64_t result = n_full_bytes > 0 ? byte_order::byteswap(bytes) >> (64 - 8 * n_full_bytes) : 0;
+  result |= uint64_t(read_bits(num_of_bits - 8 * n_full_bytes)) << (8 * n_full_bytes);
+  return result;
 }
 
-int receivebits(int buf[], int num_of_bits) {
-
-  int cnt, num;
-  unsigned int lastbits, lastbyte;
-  unsigned char* cbuf;
-  int mask = (1 << num_of_bits) - 1;
-
-  cbuf = ((unsigned char*)buf) + 3 * sizeof(*buf);
-  cnt = buf[0];
-  lastbits = (unsigned int)buf[1];
-  lastbyte = (unsigned int)buf[2];
+void BitReader::read_ints(int num_of_bits, const unsigned int sizes[3], int nums[3]) {
+  if (num_of_bits > 64) {
+    read_ints_generic(num_of_bits, sizes, nums);
+    return;
+  }
+  uint64_t value = read_packed(num_of_bits);
+  nums[2] = static_cast<int>(value % sizes[2]);
+  value /= sizes[2];
+  nums[1] = static_cast<int>(value % sizes[1]);
+  value /= sizes[1];
+  nums[0] = static_cast<int>(static_cast<uint32_t>(value));
+}
 
-  num = 0;
-  while (num_of_bits >= 8) {
-    lastbyte = (lastbyte << 8) | cbuf[cnt++];
-    num |= (lastbyte >> lastbits) << (num_of_bits - 8);
-    num_of_bits -= 8;
+void BitReader::read_small_ints(int smallidx, int nums[3]) {
+  const unsigned int size = magicints[smallidx];
+  if (smallidx > 32) {
+    const unsigned int sizes[3] = {size, size, size};
+    read_ints(smallidx, sizes, nums);
+    return;
   }
-  if (num_of_bits > 0) {
-    if (lastbits < num_of_bits) {
-      lastbits += 8;
-      lastbyte = (lastbyte << 8) | cbuf[cnt++];
-    }
-    lastbits -= num_of_bits;
-    num |= (lastbyte >> lastbits) & ((1 << num_of_bits) - 1);
-  }
-  num &= mask;
-  buf[0] = cnt;
-  buf[1] = lastbits;
-  buf[2] = lastbyte;
-  return num;
+  const uint64_t reciprocal = magicints_reciprocals[smallidx];
+  const auto value = static_cast<uint32_t>(read_packed(smallidx));
+  const uint32_t q1 = divide(value, reciprocal);
+  const uint32_t q2 = divide(q1, reciprocal);
+  nums[2] = static_cast<int>(value - q1 * size);
+  nums[1] = static_cast<int>(q1 - q2 * size);
+  nums[0] = static_cast<int>(q2);
 }
 
-void receiveints(int buf[], const int num_of_ints, int num_of_bits, unsigned int sizes[], int nums[]) {
+void BitReader::read_ints_generic(int num_of_bits, const unsigned int sizes[3], int nums[3]) {
+  // byte-wise long division, used for sizes which don't fit 64 bits
   int bytes[32];
-  int i, j, num_of_bytes, p, num;
-
+  int num_of_bytes = 0;
   bytes[1] = bytes[2] = bytes[3] = 0;
-  num_of_bytes = 0;
   while (num_of_bits > 8) {
-    bytes[num_of_bytes++] = receivebits(buf, 8);
+    bytes[num_of_bytes++] = read_bits(8);
     num_of_bits -= 8;
   }
   if (num_of_bits > 0) {
-    bytes[num_of_bytes++] = receivebits(buf, num_of_bits);
+    bytes[num_of_bytes++] = read_bits(num_of_bits);
   }
-  for (i = num_of_ints - 1; i > 0; i--) {
-    num = 0;
-    for (j = num_of_bytes - 1; j >= 0; j--) {
+  for (int i = 2; i > 0; i--) {
+    int num = 0;
+    for (int j = num_of_bytes - 1; j >= 0; j--) {
       num = (num << 8) | bytes[j];
-      p = num / sizes[i];
+      int p = num / sizes[i];
       bytes[j] = p;
       num = num - p * sizes[i];
     }
@@ -141,27 +135,43 @@ void receiveints(int buf[], const int num_of_ints, int num_of_bits, unsigned int
   nums[0] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
 }
 
-int sizeofint(const int size) {
-  unsigned int num = 1;
-  int num_of_bits = 0;
-
-  while (size >= num && num_of_bits < 32) {
-    num_of_bits++;
-    num <<= 1;
+void BitWriter::write_ints(int num_of_bits, const unsigned int sizes[3], const unsigned int nums[3]) {
+  assert(nums[1] < sizes[1] && nums[2] < sizes[2]);
+  if (num_of_bits > 64) {
+    write_ints_generic(num_of_bits, sizes, nums);
+    return;
   }
-  return num_of_bits;
+  const uint64_t value = (uint64_t(nums[0]) * sizes[1] + nums[1]) * sizes[2] + nums[2];
+  // inverse of BitReader::read_packed(): bytes starting from the least significant one,
+  // the last (most significant) byte may be shorter than 8 bits
+  const int n_full_bytes = (num_of_bits - 1) / 8;
+  if (n_full_bytes > 0) {
+    const uint64_t bytes = byte_order::byteswap(value) >> (64 - 8 * n_full_bytes);
+    if (n_full_bytes > 4) {
+      const int n_low_bits = 8 * (n_full_bytes - 4);
+      write_bits(32, static_cast<uint32_t>(bytes >> n_low_bits));
+      write_bits(n_low_bits, static_cast<uint32_t>(bytes) & ((1u << n_low_bits) - 1));
+    } else {
+      write_bits(8 * n_full_bytes, static_cast<uint32_t>(bytes));
+    }
+  }
+  write_bits(num_of_bits - 8 * n_full_bytes, static_cast<uint32_t>(value >> (8 * n_full_bytes)));
 }
 
-int sizeofints(const int num_of_ints, unsigned int sizes[]) {
-  int i, num;
-  unsigned int num_of_bytes, num_of_bits, bytes[32], bytecnt, tmp;
-  num_of_bytes = 1;
-  bytes[0] = 1;
-  num_of_bits = 0;
-  for (i = 0; i < num_of_ints; i++) {
-    tmp = 0;
+void BitWriter::write_ints_generic(int num_of_bits, const unsigned int sizes[3], const unsigned int nums[3]) {
+  // byte-wise long multiplication, used for sizes which don't fit 64 bits
+  unsigned int bytes[32];
+  int num_of_bytes = 0;
+  uint64_t tmp = nums[0];
+  do {
+    bytes[num_of_bytes++] = tmp & 0xff;
+    tmp >>= 8;
+  } while (tmp != 0);
+  for (int i = 1; i < 3; i++) {
+    tmp = nums[i];
+    int bytecnt;
     for (bytecnt = 0; bytecnt < num_of_bytes; bytecnt++) {
-      tmp = bytes[bytecnt] * sizes[i] + tmp;
+      tmp = bytes[bytecnt] * uint64_t(sizes[i]) + tmp;
       bytes[bytecnt] = tmp & 0xff;
       tmp >>= 8;
     }
@@ -171,13 +181,194 @@ int sizeofints(const int num_of_ints, unsigned int sizes[]) {
     }
     num_of_bytes = bytecnt;
   }
-  num = 1;
-  num_of_bytes--;
-  while (bytes[num_of_bytes] >= num) {
-    num_of_bits++;
-    num *= 2;
+  if (num_of_bits >= num_of_bytes * 8) {
+    for (int i = 0; i < num_of_bytes; i++) {
+      write_bits(8, bytes[i]);
+    }
+    for (int n_zeros = num_of_bits - num_of_bytes * 8; n_zeros > 0; n_zeros -= 32) {
+      write_bits(std::min(n_zeros, 32), 0);
+    }
+  } else {
+    for (int i = 0; i < num_of_bytes - 1; i++) {
+      write_bits(8, bytes[i]);
+    }
+    write_bits(num_of_bits - (num_of_bytes - 1) * 8, bytes[num_of_bytes - 1]);
   }
-  return num_of_bits + num_of_bytes * 8;
+}
+
+size_t BitWriter::finish() {
+  while (m_n_bits >= 8) {
+    m_n_bits -= 8;
+    *m_pos++ = static_cast<unsigned char>(m_bits >> m_n_bits);
+  }
+  if (m_n_bits > 0) {
+    *m_pos++ = static_cast<unsigned char>(m_bits << (8 - m_n_bits));
+    m_n_bits = 0;
+  }
+  return m_pos - m_begin;
+}
+
+const char* compress_coords(const float* flat_coords, size_t n_atoms, float precision, CompressedCoords& out) {
+  constexpr int MAXABS = INT_MAX - 2;
+
+  const int size = static_cast<int>(n_atoms);
+  std::array<unsigned, 3> sizeint{}, sizesmall{}, bitsizeint{};
+  std::array<int, 3> prevcoord{};
+  std::array<unsigned, 30> tmpcoord{};
+  unsigned int bitsize;
+
+  out.ints.resize(n_atoms * 3);
+  auto& minint = out.minint;
+  auto& maxint = out.maxint;
+  minint = {INT_MAX, INT_MAX, INT_MAX};
+  maxint = {INT_MIN, INT_MIN, INT_MIN};
+  int mindiff = INT_MAX;
+  for (size_t i = 0; i < n_atoms; ++i) {
+    for (int k = 0; k < 3; ++k) {
+      /* find nearest integer */
+      const float value = flat_coords[i * 3 + k];
+      const float lf = value >= 0.0 ? value * precision + 0.5f : value * precision - 0.5f;
+      if (std::fabs((double)lf) > (double)MAXABS) {
+        /* scaling would cause overflow */
+        return "scaling would cause overflow";
+      }
+      const int lint = static_cast<int>(lf);
+      minint[k] = std::min(minint[k], lint);
+      maxint[k] = std::max(maxint[k], lint);
+      out.ints[i * 3 + k] = lint;
+    }
+    if (i > 0) {
+      const int* lip = &out.ints[i * 3];
+      const int diff = abs(lip[-3] - lip[0]) + abs(lip[-2] - lip[1]) + abs(lip[-1] - lip[2]);
+      mindiff = std::min(mindiff, diff);
+    }
+  }
+
+  if ((double)maxint[0] - minint[0] >= (double)MAXABS || (double)maxint[1] - minint[1] >= (double)MAXABS ||
+      (double)maxint[2] - minint[2] >= (double)MAXABS) {
+    return "turning value in unsigned by subtracting minint would cause overflow";
+  }
+  sizeint[0] = maxint[0] - minint[0] + 1;
+  sizeint[1] = maxint[1] - minint[1] + 1;
+  sizeint[2] = maxint[2] - minint[2] + 1;
+
+  /* check if one of the sizes is to big to be multiplied */
+  if ((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff) {
+    bitsizeint[0] = sizeofint(sizeint[0]);
+    bitsizeint[1] = sizeofint(sizeint[1]);
+    bitsizeint[2] = sizeofint(sizeint[2]);
+    bitsize = 0; /* flag the use of large sizes */
+  } else {
+    bitsize = sizeofints(3, sizeint.data());
+  }
+  int smallidx = FIRSTIDX;
+  while (smallidx < magicints.size() && magicints[smallidx] < mindiff) {
+    smallidx++;
+  }
+  out.smallidx = smallidx;
+
+  // every atom takes at most 3*32 bits as large one or `smallidx` <= 72 bits as small one plus 6 bits of run flag
+  out.bytes.resize(n_atoms * 16 + 8);
+  BitWriter writer(out.bytes.data());
+
+  const int maxidx = std::min((int)magicints.size(), smallidx + 8);
+  const int minidx = maxidx - 8; /* often this equal smallidx */
+  int smaller = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
+  int small = magicints[smallidx] / 2;
+  sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+  const int larger = magicints[maxidx] / 2;
+  int prevrun = -1;
+  int i = 0;
+  while (i < size) {
+    int is_small = 0;
+    int is_smaller;
+    int* thiscoord = out.ints.data() + i * 3;
+    if (smallidx < maxidx && i >= 1 && abs(thiscoord[0] - prevcoord[0]) < larger &&
+        abs(thiscoord[1] - prevcoord[1]) < larger && abs(thiscoord[2] - prevcoord[2]) < larger) {
+      is_smaller = 1;
+    } else if (smallidx > minidx) {
+      is_smaller = -1;
+    } else {
+      is_smaller = 0;
+    }
+    if (i + 1 < size) {
+      if (abs(thiscoord[0] - thiscoord[3]) < small && abs(thiscoord[1] - thiscoord[4]) < small &&
+          abs(thiscoord[2] - thiscoord[5]) < small) {
+        /* interchange first with second atom for better
+         * compression of water molecules
+         */
+        std::swap(thiscoord[0], thiscoord[3]);
+        std::swap(thiscoord[1], thiscoord[4]);
+        std::swap(thiscoord[2], thiscoord[5]);
+        is_small = 1;
+      }
+    }
+    tmpcoord[0] = thiscoord[0] - minint[0];
+    tmpcoord[1] = thiscoord[1] - minint[1];
+    tmpcoord[2] = thiscoord[2] - minint[2];
+    if (bitsize == 0) {
+      writer.write_bits(bitsizeint[0], tmpcoord[0]);
+      writer.write_bits(bitsizeint[1], tmpcoord[1]);
+      writer.write_bits(bitsizeint[2], tmpcoord[2]);
+    } else {
+      writer.write_ints(bitsize, sizeint.data(), tmpcoord.data());
+    }
+    prevcoord[0] = thiscoord[0];
+    prevcoord[1] = thiscoord[1];
+    prevcoord[2] = thiscoord[2];
+    thiscoord = thiscoord + 3;
+    i++;
+
+    int run = 0;
+    if (is_small == 0 && is_smaller == -1)
+      is_smaller = 0;
+    while (is_small && run < 8 * 3) {
+      if (is_smaller == -1 &&
+          (SQR(thiscoord[0] - prevcoord[0]) + SQR(thiscoord[1] - prevcoord[1]) + SQR(thiscoord[2] - prevcoord[2]) >=
+           smaller * smaller)) {
+        is_smaller = 0;
+      }
+
+      tmpcoord[run++] = thiscoord[0] - prevcoord[0] + small;
+      tmpcoord[run++] = thiscoord[1] - prevcoord[1] + small;
+      tmpcoord[run++] = thiscoord[2] - prevcoord[2] + small;
+
+      prevcoord[0] = thiscoord[0];
+      prevcoord[1] = thiscoord[1];
+      prevcoord[2] = thiscoord[2];
+
+      i++;
+      thiscoord = thiscoord + 3;
+      is_small = 0;
+      if (i < size && abs(thiscoord[0] - prevcoord[0]) < small && abs(thiscoord[1] - prevcoord[1]) < small &&
+          abs(thiscoord[2] - prevcoord[2]) < small) {
+        is_small = 1;
+      }
+    }
+    if (run != prevrun || is_smaller != 0) {
+      prevrun = run;
+      /* flag the change in run-length (1 bit) followed by new run-length (5 bits) */
+      writer.write_bits(6, 0x20 | (run + is_smaller + 1));
+    } else {
+      writer.write_bits(1, 0); /* flag the fact that runlength did not change */
+    }
+    for (int k = 0; k < run; k += 3) {
+      writer.write_ints(smallidx, sizesmall.data(), &tmpcoord[k]);
+    }
+    if (is_smaller != 0) {
+      smallidx += is_smaller;
+      if (is_smaller < 0) {
+        small = smaller;
+        smaller = magicints[smallidx - 1] / 2;
+      } else {
+        smaller = small;
+        small = magicints[smallidx] / 2;
+      }
+      sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+    }
+  }
+  out.bytes.resize(writer.finish());
+  return nullptr;
 }
 
 } // namespace xmo::io::xdr::xtc
@@ -8,62 +8,12 @@
 
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace xmol::io::xdr::xtc {
 
-/*____________________________________________________________________________
- |
- | sendints - send a small set of small integers in compressed format
- |
- | this routine is used internally by xdr3dfcoord, to send a set of
- | small integers to the buffer.
- | Multiplication with fixed (specified maximum ) sizes is used to get
- | to one big, multibyte integer. Allthough the routine could be
- | modified to handle sizes bigger than 16777216, or more than just
- | a few integers, this is not done, because the gain in compression
- | isn't worth the effort. Note that overflowing the multiplication
- | or the byte buffer (32 bytes) is unchecked and causes bad results.
- |
- */
-
-void sendints(int buf[], const int num_of_ints, const int num_of_bits,
-                     unsigned int sizes[], unsigned int nums[]);
-
-/*____________________________________________________________________________
- |
- | sendbits - encode num into buf using the specified number of bits
- |
- | This routines appends the value of num to the bits already present in
- | the array buf. You need to give it the number of bits to use and you
- | better make sure that this number of bits is enough to hold the value
- | Also num must be positive.
- |
-*/
-
-void sendbits(int buf[], int num_of_bits, int num);
-
-/**__________________________________________________________________________
- |
- | receivebits - decode number from buf using specified number of bits
- |
- | extract the number of bits from the array buf and construct an integer
- | from it. Return that value.
- |
-*/
-int receivebits(int buf[], int num_of_bits);
-
-/**___________________________________________________________________________
- |
- | receiveints - decode 'small' integers from the buf array
- |
- | this routine is the inverse from sendints() and decodes the small integers
- | written to buf by calculating the remainder and doing divisions with
- | the given sizes[]. You need to specify the total number of bits to be
- | used from buf in num_of_bits.
- |
-*/
-void receiveints(int buf[], const int num_of_ints, int num_of_bits, unsigned int sizes[], int nums[]);
-
 /**________________________________________________________________________
  |
  | sizeofint - calculate bitsize of an integer
@@ -79,7 +29,7 @@ int sizeofint(const int size);
  |
  | given the number of small unsigned integers and the maximum value
  | return the number of bits needed to read or write them with the
- | routines receiveints and sendints. You need this parameter when
+ | routines BitReader::read_ints() and BitWriter::write_ints(). You need this parameter when
  | calling these routines. Note that for many calls I can use
  | the variable 'smallidx' which is exactly the number of bits, and
  | So I don't need to call 'sizeofints for those calls.
@@ -99,4 +49,102 @@ int sizeofints(const int num_of_ints, unsigned int sizes[]);
 
 constexpr int SQR(int x) { return x * x; };
 
+/** Reads compressed coordinates bit stream (inverse of BitWriter)
+ *
+ * Bits are served from a 64-bit reservoir refilled by whole bytes, small integer triplets are
+ * restored with one 64-bit division per integer instead of byte-by-byte long division.
+ * Reads past the end of data yield zero bits.
+ * */
+class BitReader {
+public:
+  BitReader(const unsigned char* data, size_t n_bytes) : m_pos(data), m_end(data + n_bytes) {}
+
+  /// Next @p num_of_bits bits (at most 32) as unsigned integer
+  unsigned int read_bits(int num_of_bits) {
+    if (m_n_bits < num_of_bits) {
+      refill();
+    }
+    m_n_bits -= num_of_bits;
+    return static_cast<unsigned int>((m_bits >> m_n_bits) & ((uint64_t(1) << num_of_bits) - 1));
+  }
+
+  /// Decode three integers packed by BitWriter::write_ints() into @p num_of_bits bits
+  void read_ints(int num_of_bits, const unsigned int sizes[3], int nums[3]);
+
+  /// Same as read_ints() for triplet of equal sizes `magicints[smallidx]` packed into `smallidx` bits
+  void read_small_ints(int smallidx, int nums[3]);
+
+private:
+  void refill() {
+    while (m_n_bits <= 56) {
+      m_bits = (m_bits << 8) | (m_pos < m_end ? *m_pos++ : 0u);
+      m_n_bits += 8;
+    }
+  }
+  /// Little-endian byte sequence written by BitWriter::write_ints(), total size must not exceed 64 bits
+  uint64_t read_packed(int num_of_bits);
+  void read_ints_generic(int num_of_bits, const unsigned int sizes[3], int nums[3]);
+
+  const unsigned char* m_pos;
+  const unsigned char* m_end;
+  uint64_t m_bits = 0;
+  int m_n_bits = 0;
+};
+
+/** Writes compressed coordinates bit stream, bits are stored starting from the most significant one
+ *
+ * Bits are collected in a 64-bit accumulator and stored by 32-bit words,
+ * integer triplets are packed with one 64-bit multiplication per integer when they fit 64 bits.
+ * */
+class BitWriter {
+public:
+  /// Output @p data must be large enough to hold all written bits
+  explicit BitWriter(unsigned char* data) : m_begin(data), m_pos(data) {}
+
+  /// Append lower @p num_of_bits bits (at most 32) of @p num
+  void write_bits(int num_of_bits, unsigned int num) {
+    m_bits = (m_bits << num_of_bits) | num;
+    m_n_bits += num_of_bits;
+    if (m_n_bits >= 32) {
+      m_n_bits -= 32;
+      const auto word = static_cast<uint32_t>(m_bits >> m_n_bits);
+      m_pos[0] = word >> 24;
+      m_pos[1] = word >> 16;
+      m_pos[2] = word >> 8;
+      m_pos[3] = word;
+      m_pos += 4;
+    }
+  }
+
+  /// Pack three integers `nums[i] < sizes[i]` into @p num_of_bits bits
+  void write_ints(int num_of_bits, const unsigned int sizes[3], const unsigned int nums[3]);
+
+  /// Store pending bits (last byte is padded with zeros), returns total number of written bytes
+  size_t finish();
+
+private:
+  void write_ints_generic(int num_of_bits, const unsigned int sizes[3], const unsigned int nums[3]);
+
+  unsigned char* m_begin;
+  unsigned char* m_pos;
+  uint64_t m_bits = 0;
+  int m_n_bits = 0;
+};
+
+/// Compressed coordinates of a frame
+struct CompressedCoords {
+  std::array<int, 3> minint{};
+  std::array<int, 3> maxint{};
+  int smallidx = 0;
+  std::vector<unsigned char> bytes; /// compressed bit stream
+  std::vector<int> ints;            /// scratch: coordinates scaled to integers
+};
+
+/** Compress @p n_atoms coordinates (nanometers) with given @p precision
+ *
+ * Safe to call concurrently for distinct @p out
+ * @return error description or nullptr on success
+ * */
+const char* compress_coords(const float* flat_coords, size_t n_atoms, float precision, CompressedCoords& out);
+
 } // namespace xmol::io::xdr::xtc
\ No newline at end of file
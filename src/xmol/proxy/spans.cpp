@@ -69,6 +69,31 @@ CoordSpan AtomSpan::coords() {
   return {begin()->frame(), begin()->m_coord, size()};
 }
 
+VelocitySpan AtomSpan::velocities() {
+  Frame* frame = frame_ptr();
+  if (!frame || !frame->has_velocities()) {
+    return {};
+  }
+  return {*frame, frame->m_velocities, static_cast<size_t>(frame->index_of(*m_begin)), size()};
+}
+
+ForceSpan AtomSpan::forces() {
+  Frame* frame = frame_ptr();
+  if (!frame || !frame->has_forces()) {
+    return {};
+  }
+  return {*frame, frame->m_forces, static_cast<size_t>(frame->index_of(*m_begin)), size()};
+}
+
+xmol::XYZ* AtomVectorSpan::data() {
+  if (m_begin + m_size > m_storage->size()) {
+    throw std::out_of_range("AtomVectorSpan: atoms [" + std::to_string(m_begin) + ", " +
+                            std::to_string(m_begin + m_size) + ") are out of frame vectors range [0, " +
+                            std::to_string(m_storage->size()) + ")");
+  }
+  return m_storage->data() + m_begin;
+}
+
 ResidueSpan AtomSpan::residues() {
   if (empty()) {
     return {};
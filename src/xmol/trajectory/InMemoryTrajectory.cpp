@@ -0,0 +1,208 @@
+#include "xmol/trajectory/InMemoryTrajectory.h"
+#include "../io/xdr/xtc_routines.h"
+#include "xmol/Frame.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+using namespace xmol::trajectory;
+using xmol::io::xdr::xtc::BitReader;
+using xmol::io::xdr::xtc::BitWriter;
+
+namespace {
+
+/// Header of bit-packed frame: `value = offset[k] + (width[k]-bit unsigned)` for every atom and axis `k`
+struct PackedFrame {
+  size_t begin;                  /// offset of packed bits in block
+  std::array<int32_t, 3> offset; /// minimal difference to previous frame
+  std::array<int, 3> width;      /// number of bits per value
+};
+
+struct Block {
+  std::vector<unsigned char> bytes;
+  std::vector<PackedFrame> frames;
+};
+
+int bit_width(uint32_t range) { return range == 0 ? 0 : 32 - __builtin_clz(range); }
+
+/// Difference of 32-bit integers, wraps around instead of overflow
+uint32_t subtract(int32_t lhs, int32_t rhs) { return static_cast<uint32_t>(lhs) - static_cast<uint32_t>(rhs); }
+
+} // namespace
+
+struct InMemoryTrajectory::Storage {
+  std::vector<float> floats; /// float32 coordinates [n_frames, n_atoms, 3]
+  std::vector<Block> blocks; /// quantized coordinates
+  std::vector<int32_t> last; /// quantized coordinates of the last appended frame
+  std::vector<geom::UnitCell> cells;
+  std::vector<double> times;
+};
+
+InMemoryTrajectory::InMemoryTrajectory(size_t n_atoms, double precision, size_t block_size)
+    : m_n_atoms(n_atoms), m_precision(precision), m_block_size(block_size), m_storage(std::make_shared<Storage>()) {
+  if (!(precision >= 0) || block_size == 0) {
+    throw std::invalid_argument("InMemoryTrajectory: bad precision " + std::to_string(precision) +
+                                " or block size " + std::to_string(block_size));
+  }
+}
+
+size_t InMemoryTrajectory::n_frames() const { return m_storage->times.size(); }
+
+size_t InMemoryTrajectory::size_in_bytes() const {
+  size_t result = m_storage->floats.size() * sizeof(float);
+  for (auto& block : m_storage->blocks) {
+    result += block.bytes.size() + block.frames.size() * sizeof(PackedFrame);
+  }
+  return result;
+}
+
+void InMemoryTrajectory::append(Frame& frame) {
+  if (frame.n_atoms() != m_n_atoms) {
+    throw std::runtime_error("InMemoryTrajectory::append(): n_atoms() mismatch: " + std::to_string(m_n_atoms) +
+                             " vs " + std::to_string(frame.n_atoms()));
+  }
+  if (m_storage.use_count() > 1) { // copy on write, clones keep reading old snapshot
+    m_storage = std::make_shared<Storage>(*m_storage);
+  }
+  auto& storage = *m_storage;
+  auto coords = frame.coords()._eigen();
+
+  if (m_precision == 0) {
+    const size_t size = storage.floats.size();
+    storage.floats.resize(size + m_n_atoms * 3);
+    CoordEigenMatrixMapf(storage.floats.data() + size, m_n_atoms, 3) = coords.cast<float>();
+  } else {
+    const bool new_block = n_frames() % m_block_size == 0;
+    if (new_block) {
+      storage.blocks.emplace_back();
+      storage.last.assign(m_n_atoms * 3, 0);
+    }
+    // quantize and compute differences to the last frame of block
+    std::vector<int32_t> diffs(m_n_atoms * 3);
+    std::array<int32_t, 3> min_diff{INT32_MAX, INT32_MAX, INT32_MAX};
+    std::array<int32_t, 3> max_diff{INT32_MIN, INT32_MIN, INT32_MIN};
+    constexpr double MaxAbs = 1 << 30;
+    for (size_t i = 0; i < m_n_atoms; ++i) {
+      for (int k = 0; k < 3; ++k) {
+        const double scaled = std::round(coords(i, k) / m_precision);
+        if (!(std::fabs(scaled) < MaxAbs)) {
+          throw std::runtime_error("InMemoryTrajectory::append(): coordinate " + std::to_string(coords(i, k)) +
+                                   " is out of range for precision " + std::to_string(m_precision));
+        }
+        const auto value = static_cast<int32_t>(scaled);
+        const auto diff = static_cast<int32_t>(subtract(value, storage.last[i * 3 + k]));
+        storage.last[i * 3 + k] = value;
+        diffs[i * 3 + k] = diff;
+        min_diff[k] = std::min(min_diff[k], diff);
+        max_diff[k] = std::max(max_diff[k], diff);
+      }
+    }
+    auto& block = storage.blocks.back();
+    PackedFrame packed{block.bytes.size(), {}, {}};
+    for (int k = 0; k < 3; ++k) {
+      packed.offset[k] = m_n_atoms > 0 ? min_diff[k] : 0;
+      packed.width[k] = m_n_atoms > 0 ? bit_width(subtract(max_diff[k], min_diff[k])) : 0;
+    }
+    block.bytes.resize(packed.begin + m_n_atoms * 3 * sizeof(int32_t) + 8);
+    BitWriter writer(block.bytes.data() + packed.begin);
+    for (size_t i = 0; i < m_n_atoms * 3; ++i) {
+      const int k = i % 3;
+      writer.write_bits(packed.width[k], subtract(diffs[i], packed.offset[k]));
+    }
+    block.bytes.resize(packed.begin + writer.finish());
+    block.frames.push_back(packed);
+  }
+  storage.cells.push_back(frame.cell);
+  storage.times.push_back(frame.time);
+}
+
+void InMemoryTrajectory::decode(size_t index) {
+  if (m_decoded == index) {
+    return;
+  }
+  const size_t first = index - index % m_block_size;
+  size_t next = first;
+  if (m_decoded != SIZE_MAX && m_decoded >= first && m_decoded < index) {
+    next = m_decoded + 1; // continue from previously decoded frame of the same block
+  } else {
+    m_ints.assign(m_n_atoms * 3, 0);
+  }
+  const auto& block = m_storage->blocks[index / m_block_size];
+  for (; next <= index; ++next) {
+    const auto& packed = block.frames[next - first];
+    BitReader reader(block.bytes.data() + packed.begin, block.bytes.size() - packed.begin);
+    for (size_t i = 0; i < m_n_atoms * 3; ++i) {
+      const int k = i % 3;
+      const uint32_t diff = static_cast<uint32_t>(packed.offset[k]) + reader.read_bits(packed.width[k]);
+      m_ints[i] = static_cast<int32_t>(static_cast<uint32_t>(m_ints[i]) + diff);
+    }
+  }
+  m_decoded = index;
+}
+
+template <typename T> void InMemoryTrajectory::load_coords(size_t index, const std::vector<AtomIndex>* atoms, T* dst) {
+  const size_t n = atoms ? atoms->size() : m_n_atoms;
+  auto atom = [atoms](size_t i) -> size_t { return atoms ? (*atoms)[i] : i; };
+  if (m_precision == 0) {
+    const float* src = m_storage->floats.data() + index * m_n_atoms * 3;
+    for (size_t i = 0; i < n; ++i) {
+      std::copy_n(src + atom(i) * 3, 3, dst + i * 3);
+    }
+    return;
+  }
+  decode(index);
+  for (size_t i = 0; i < n; ++i) {
+    for (int k = 0; k < 3; ++k) {
+      dst[i * 3 + k] = static_cast<T>(m_ints[atom(i) * 3 + k] * m_precision);
+    }
+  }
+}
+
+void InMemoryTrajectory::read_frame(size_t index, Frame& frame) {
+  assert(m_current_frame == index);
+  assert(frame.n_atoms() == n_atoms());
+  load_coords(index, nullptr, frame.coords()._eigen().data());
+  frame.cell = m_storage->cells[index];
+  frame.time = m_storage->times[index];
+}
+
+void InMemoryTrajectory::read_coords(size_t index, const future::Span<float>& coords) {
+  assert(m_current_frame == index);
+  assert(coords.size() == n_atoms() * 3);
+  load_coords(index, nullptr, coords.data());
+}
+
+void InMemoryTrajectory::read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) {
+  assert(m_current_frame == index);
+  assert(frame.n_atoms() == atoms.size());
+  load_coords(index, &atoms, frame.coords()._eigen().data());
+  frame.cell = m_storage->cells[index];
+  frame.time = m_storage->times[index];
+}
+
+std::optional<double> InMemoryTrajectory::frame_time(size_t index) const { return m_storage->times[index]; }
+
+std::unique_ptr<TrajectoryInputFile> InMemoryTrajectory::clone() const {
+  auto result = std::make_unique<InMemoryTrajectory>(m_n_atoms, m_precision, m_block_size);
+  result->m_storage = m_storage;
+  return result;
+}
+
+void InMemoryTrajectory::seek(size_t current, size_t index) {
+  assert(current == m_current_frame);
+  static_cast<void>(current);
+  m_current_frame = index; // decoded frame is reused if `index` follows it within the block
+}
+
+void InMemoryTrajectory::advance(size_t shift) {
+  m_current_frame += shift;
+  if (m_current_frame >= n_frames()) {
+    m_current_frame = 0;
+    m_decoded = SIZE_MAX;
+    m_ints = {};
+  }
+}
@@ -0,0 +1,124 @@
+#include "Prefetcher.h"
+
+using namespace xmol::trajectory;
+
+Trajectory::Iterator::Prefetcher::Prefetcher(Files& files, Position begin, size_t end, size_t step,
+                                             const std::vector<AtomIndex>* atoms, const Frame& frame, size_t depth)
+    : m_files(files), m_pos(begin), m_end(end), m_step(step), m_atoms(atoms), m_buffers(depth, frame),
+      m_positions(depth), m_thread(&Prefetcher::run, this) {
+  assert(depth > 0);
+}
+
+Trajectory::Iterator::Prefetcher::~Prefetcher() { stop(); }
+
+void Trajectory::Iterator::Prefetcher::run() {
+  while (true) {
+    size_t slot;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [this] { return m_stopped || m_size < m_buffers.size(); });
+      if (m_stopped) {
+        return;
+      }
+      slot = (m_head + m_size) % m_buffers.size();
+    }
+    m_positions[slot] = m_pos;
+    try {
+      Trajectory::read_frame(m_files, m_pos, m_buffers[slot], m_atoms);
+      Trajectory::advance(m_files, m_pos, m_end, m_step);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_error = std::current_exception();
+      m_done = true;
+      m_cv.notify_all();
+      return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_size;
+    m_done = m_pos.global_pos >= m_end;
+    m_cv.notify_all();
+    if (m_done) {
+      return;
+    }
+  }
+}
+
+void Trajectory::Iterator::Prefetcher::pop(Frame& frame) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cv.wait(lock, [this] { return m_size > 0 || m_done; });
+  if (m_size == 0) {
+    assert(m_error);
+    std::rethrow_exception(m_error);
+  }
+  Frame& buffer = m_buffers[m_head];
+  if ((frame.has_velocities() && !buffer.has_velocities()) || (frame.has_forces() && !buffer.has_forces())) {
+    // frame got velocities/forces after ready buffers were read, read them again
+    const Position pos = m_positions[m_head];
+    lock.unlock();
+    restart(pos, frame);
+    pop(frame);
+    return;
+  }
+  lock.unlock(); // producer doesn't touch ready buffers
+  frame.coords()._eigen() = buffer.coords()._eigen();
+  if (frame.has_velocities() && buffer.has_velocities()) {
+    frame.velocities()._eigen() = buffer.velocities()._eigen();
+  }
+  if (frame.has_forces() && buffer.has_forces()) {
+    frame.forces()._eigen() = buffer.forces()._eigen();
+  }
+  frame.cell = buffer.cell;
+  frame.time = buffer.time;
+  // next reads into buffer fill velocities/forces if frame stores them
+  sync_vectors(frame, buffer);
+  lock.lock();
+  m_head = (m_head + 1) % m_buffers.size();
+  --m_size;
+  m_cv.notify_all();
+}
+
+void Trajectory::Iterator::Prefetcher::sync_vectors(const Frame& frame, Frame& buffer) {
+  if (frame.has_velocities() != buffer.has_velocities()) {
+    frame.has_velocities() ? buffer.add_velocities() : buffer.remove_velocities();
+  }
+  if (frame.has_forces() != buffer.has_forces()) {
+    frame.has_forces() ? buffer.add_forces() : buffer.remove_forces();
+  }
+}
+
+void Trajectory::Iterator::Prefetcher::restart(const Position& pos, const Frame& frame) {
+  stop();
+  // producer leaves files at m_pos: file of m_pos is open unless end is reached, preceding files are closed
+  const bool is_open = m_pos.global_pos < m_end;
+  if (is_open && m_pos.file == pos.file) {
+    m_files[pos.file]->seek(m_pos.pos_in_file, pos.pos_in_file);
+  } else {
+    if (is_open) {
+      auto& file = *m_files[m_pos.file];
+      file.advance(file.n_frames() - m_pos.pos_in_file);
+    }
+    m_files[pos.file]->seek(0, pos.pos_in_file);
+  }
+  m_pos = pos;
+  for (auto& buffer : m_buffers) {
+    sync_vectors(frame, buffer);
+  }
+  m_head = 0;
+  m_size = 0;
+  m_stopped = false;
+  m_done = false;
+  m_error = nullptr;
+  m_thread = std::thread(&Prefetcher::run, this);
+}
+
+Trajectory::Position Trajectory::Iterator::Prefetcher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_cv.notify_all();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  return m_pos;
+}
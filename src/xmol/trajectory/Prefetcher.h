@@ -0,0 +1,61 @@
+#pragma once
+#include "xmol/trajectory/Trajectory.h"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace xmol::trajectory {
+
+/** Background reader of trajectory frames
+ *
+ * Producer thread exclusively owns iterator input files until stop() is called.
+ * Frames are read into a bounded ring of buffer frames and handed over to consumer in order.
+ * Exception raised by producer is rethrown by pop() after all frames read before it are consumed.
+ *
+ * Buffers follow velocities/forces layout of consumer frame. If consumer frame gets velocities/forces
+ * which ready buffers lack (e.g. Frame::add_velocities() in the middle of iteration), ready buffers are
+ * discarded and producer restarts from the popped frame.
+ * */
+class Trajectory::Iterator::Prefetcher {
+public:
+  Prefetcher(Files& files, Position begin, size_t end, size_t step, const std::vector<AtomIndex>* atoms,
+             const Frame& frame, size_t depth);
+  Prefetcher(const Prefetcher&) = delete;
+  Prefetcher& operator=(const Prefetcher&) = delete;
+  ~Prefetcher();
+
+  /// Wait for next frame and copy its coordinates, velocities, forces, cell and time to @p frame
+  void pop(Frame& frame);
+
+  /// Stop background thread and return position of input files
+  Position stop();
+
+private:
+  void run();
+
+  /// Stop producer, move input files back to @p pos and start producer again with buffers matching @p frame
+  void restart(const Position& pos, const Frame& frame);
+
+  /// Make @p buffer store velocities/forces if and only if @p frame does
+  static void sync_vectors(const Frame& frame, Frame& buffer);
+
+  Files& m_files;
+  Position m_pos; /// position of input files, accessed by producer only until stop()
+  const size_t m_end;
+  const size_t m_step;
+  const std::vector<AtomIndex>* m_atoms; /// selected atoms, owned by iterator
+  std::vector<Frame> m_buffers;
+  std::vector<Position> m_positions; /// positions of frames read into buffers
+  size_t m_head = 0; /// first ready buffer
+  size_t m_size = 0; /// number of ready buffers
+  bool m_stopped = false;
+  bool m_done = false;
+  std::exception_ptr m_error;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::thread m_thread;
+};
+
+} // namespace xmol::trajectory
@@ -1,28 +1,108 @@
 #include "xmol/trajectory/Trajectory.h"
+#include "Prefetcher.h"
 
-void xmol::trajectory::Trajectory::advance(xmol::trajectory::Trajectory::Position& position, size_t end, size_t step) {
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+/// Copy of @p atoms of @p frame along with their residues and molecules
+xmol::Frame make_subset_frame(xmol::Frame& frame, const std::vector<xmol::AtomIndex>& atoms) {
+  xmol::Frame result;
+  result.cell = frame.cell;
+  result.time = frame.time;
+  result.index = frame.index;
+  result.reserve_atoms(atoms.size());
+  result.reserve_residues(atoms.size());
+  result.reserve_molecules(atoms.size());
+
+  auto all_atoms = frame.atoms();
+  std::optional<xmol::proxy::MoleculeRef> molecule, source_molecule;
+  std::optional<xmol::proxy::ResidueRef> residue, source_residue;
+  for (auto index : atoms) {
+    auto atom = all_atoms[index];
+    if (!source_molecule || atom.molecule() != *source_molecule) {
+      source_molecule = atom.molecule();
+      molecule = result.add_molecule().name(source_molecule->name());
+      source_residue = {};
+    }
+    if (!source_residue || atom.residue() != *source_residue) {
+      source_residue = atom.residue();
+      residue = molecule->add_residue().name(source_residue->name()).id(source_residue->id());
+    }
+    residue->add_atom()
+        .name(atom.name())
+        .id(atom.id())
+        .mass(atom.mass())
+        .vdw_radius(atom.vdw_radius())
+        .r(atom.r());
+  }
+  if (frame.has_velocities()) {
+    result.add_velocities();
+    auto velocities = frame.velocities();
+    for (size_t i = 0; i < atoms.size(); ++i) {
+      result.velocities()[i] = velocities[atoms[i]];
+    }
+  }
+  if (frame.has_forces()) {
+    result.add_forces();
+    auto forces = frame.forces();
+    for (size_t i = 0; i < atoms.size(); ++i) {
+      result.forces()[i] = forces[atoms[i]];
+    }
+  }
+  return result;
+}
+
+/// Time of @p index frame of @p file, throws if file doesn't know it
+double frame_time(const xmol::trajectory::TrajectoryInputFile& file, size_t index) {
+  auto time = file.frame_time(index);
+  if (!time) {
+    throw std::runtime_error("Trajectory: input file doesn't provide frame times");
+  }
+  return *time;
+}
+
+/// First frame in `[begin, end)` of @p file with time not less than @p t
+size_t lower_bound_time(const xmol::trajectory::TrajectoryInputFile& file, size_t begin, size_t end, double t) {
+  while (begin < end) {
+    const size_t mid = begin + (end - begin) / 2;
+    if (frame_time(file, mid) < t) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin;
+}
+
+} // namespace
+
+void xmol::trajectory::Trajectory::advance(Files& files, Position& position, size_t end, size_t step) {
   position.global_pos += step;
   if (step == 0) {
-    assert(position.pos_in_file < m_files[position.file]->n_frames());
-    m_files[position.file]->advance(position.pos_in_file);
+    assert(position.pos_in_file < files[position.file]->n_frames());
+    files[position.file]->advance(position.pos_in_file);
     return;
   }
   if (position.global_pos >= end) {
-    m_files[position.file]->advance(m_files[position.file]->n_frames());
+    files[position.file]->advance(files[position.file]->n_frames());
     return;
   }
   position.pos_in_file += step;
-  m_files[position.file]->advance(step);
-  if (position.file < m_files.size() && position.pos_in_file >= m_files[position.file]->n_frames()) {
-    position.pos_in_file -= m_files[position.file]->n_frames();
+  files[position.file]->advance(step);
+  if (position.file < files.size() && position.pos_in_file >= files[position.file]->n_frames()) {
+    position.pos_in_file -= files[position.file]->n_frames();
     position.file++;
-    while (position.file < m_files.size() && position.pos_in_file >= m_files[position.file]->n_frames()) {
-      position.pos_in_file -= m_files[position.file]->n_frames();
+    while (position.file < files.size() && position.pos_in_file >= files[position.file]->n_frames()) {
+      position.pos_in_file -= files[position.file]->n_frames();
       position.file++;
     }
-    m_files[position.file]->advance(0);
+    files[position.file]->advance(position.pos_in_file);
   }
-  assert(position.file < m_files.size() && position.pos_in_file < m_files[position.file]->n_frames());
+  assert(position.file < files.size() && position.pos_in_file < files[position.file]->n_frames());
 }
 
 xmol::trajectory::Trajectory::Slice xmol::trajectory::Trajectory::slice(std::optional<size_t> begin,
@@ -36,24 +116,349 @@ xmol::trajectory::Trajectory::Slice xmol::trajectory::Trajectory::slice(std::opt
   assert(*end <= n_frames());
   assert(step > 0);
   Position pos{*begin, 0, *begin};
-  while (pos.pos_in_file >= m_files[pos.file]->n_frames()) {
+  while (pos.file < m_files.size() && pos.pos_in_file >= m_files[pos.file]->n_frames()) {
     pos.pos_in_file -= m_files[pos.file]->n_frames();
     ++pos.file;
   }
   return Slice(*this, pos, *end, step);
 }
+
+template <typename T, typename Store>
+void xmol::trajectory::Trajectory::Slice::read_coords(const future::Span<T>& coords, Store&& store) {
+  const size_t frame_size = n_atoms() * 3;
+  if (coords.size() != size() * frame_size) {
+    throw std::runtime_error("Trajectory::Slice::read_coords(): size mismatch: " + std::to_string(coords.size()) +
+                             " != " + std::to_string(size() * frame_size));
+  }
+  std::vector<float> buffer;
+  T* out = coords.data();
+  for (Iterator it(m_traj, m_begin, m_end, m_step, 0, m_atoms, false); it != Sentinel{}; ++it) {
+    store(it, buffer, out);
+    out += frame_size;
+  }
+}
+
+void xmol::trajectory::Trajectory::Slice::read_coords(const future::Span<float>& coords) {
+  const size_t frame_size = n_atoms() * 3;
+  read_coords(coords, [frame_size](Iterator& it, std::vector<float>& buffer, float* out) {
+    it.read_coords(future::Span<float>(out, frame_size), buffer);
+  });
+}
+
+void xmol::trajectory::Trajectory::Slice::read_coords(const future::Span<double>& coords) {
+  const size_t frame_size = n_atoms() * 3;
+  std::vector<float> frame_coords(frame_size); // only one frame is kept in single precision
+  read_coords(coords, [&frame_coords](Iterator& it, std::vector<float>& buffer, double* out) {
+    it.read_coords(future::Span<float>(frame_coords.data(), frame_coords.size()), buffer);
+    std::copy(frame_coords.begin(), frame_coords.end(), out);
+  });
+}
+
+xmol::trajectory::Trajectory::Slice
+xmol::trajectory::Trajectory::Slice::select_atoms(std::vector<AtomIndex> atoms) const {
+  std::sort(atoms.begin(), atoms.end());
+  atoms.erase(std::unique(atoms.begin(), atoms.end()), atoms.end());
+  if (!atoms.empty() && (atoms.front() < 0 || atoms.back() >= static_cast<AtomIndex>(m_traj.n_atoms()))) {
+    throw std::out_of_range("Trajectory::Slice::select_atoms(): atom index is out of range [0," +
+                            std::to_string(m_traj.n_atoms()) + ")");
+  }
+  Slice result(*this);
+  result.m_atoms = std::make_shared<const std::vector<AtomIndex>>(std::move(atoms));
+  return result;
+}
+xmol::trajectory::Trajectory::Iterator::Iterator(Trajectory& t, Position begin, size_t end, size_t step,
+                                                  size_t prefetch_depth,
+                                                  std::shared_ptr<const std::vector<AtomIndex>> atoms,
+                                                  bool read_frames)
+    : m_traj(&t), m_files(&t.m_files), m_pos(begin), m_end(end), m_step(step), m_atoms(std::move(atoms)),
+      m_read_frames(read_frames),
+      m_frame(!read_frames ? Frame() : m_atoms ? make_subset_frame(t.m_frame, *m_atoms) : t.m_frame) {
+  assert(step > 0);
+  if (m_traj->m_iterator_counter++ > 0) {
+    try {
+      m_own_files = std::make_unique<Files>(m_traj->clone_files());
+    } catch (...) {
+      m_traj->m_iterator_counter--;
+      throw;
+    }
+    m_files = m_own_files.get();
+  }
+  if (m_pos.global_pos < m_end) {
+    try {
+      Trajectory::advance(*m_files, m_pos, m_end, 0);
+      if (prefetch_depth > 0 && m_read_frames) {
+        m_prefetcher =
+            std::make_unique<Prefetcher>(*m_files, m_pos, m_end, m_step, m_atoms.get(), m_frame, prefetch_depth);
+      }
+      update();
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+}
+
+xmol::trajectory::Trajectory::Iterator::~Iterator() { release(); }
+
+void xmol::trajectory::Trajectory::Iterator::release() {
+  if (!m_traj) {
+    return;
+  }
+  if (m_prefetcher) {
+    m_pos = m_prefetcher->stop(); // files are positioned where prefetcher stopped
+    m_prefetcher.reset();
+  }
+  if (m_own_files) {
+    m_own_files.reset(); // own copies are closed on destruction
+  } else if (m_pos.global_pos < m_end) { /// handle break
+    Trajectory::advance(*m_files, m_pos, m_end, m_end - m_pos.global_pos);
+  }
+  m_traj->m_iterator_counter--; // shared files are not touched after this point
+  m_traj = nullptr;
+}
+
+void xmol::trajectory::Trajectory::Iterator::update() {
+  if (!m_read_frames) {
+    return;
+  }
+  if (m_prefetcher) {
+    m_prefetcher->pop(m_frame);
+  } else {
+    Trajectory::read_frame(*m_files, m_pos, m_frame, m_atoms.get());
+  }
+  m_frame.index = m_pos.global_pos;
+}
+
+void xmol::trajectory::Trajectory::Iterator::read_coords(const future::Span<float>& coords,
+                                                         std::vector<float>& buffer) {
+  auto& file = *(*m_files)[m_pos.file];
+  if (!m_atoms) {
+    file.read_coords(m_pos.pos_in_file, coords);
+    return;
+  }
+  buffer.resize(file.n_atoms() * 3);
+  file.read_coords(m_pos.pos_in_file, future::Span<float>(buffer.data(), buffer.size()));
+  float* out = coords.data();
+  for (auto index : *m_atoms) {
+    std::copy_n(buffer.data() + index * 3, 3, out);
+    out += 3;
+  }
+}
+
 xmol::trajectory::Trajectory::Iterator::Iterator(xmol::trajectory::Trajectory::Iterator&& other) noexcept
-    : m_traj(other.m_traj), m_pos(other.m_pos), m_end(other.m_end), m_step(other.m_step),
-      m_frame(std::move(other.m_frame)) {
+    : m_traj(other.m_traj), m_own_files(std::move(other.m_own_files)), m_files(other.m_files), m_pos(other.m_pos),
+      m_end(other.m_end), m_step(other.m_step), m_atoms(std::move(other.m_atoms)), m_read_frames(other.m_read_frames),
+      m_frame(std::move(other.m_frame)),
+      m_prefetcher(std::move(other.m_prefetcher)) {
   other.m_traj = nullptr;
 }
 xmol::trajectory::Trajectory::Iterator&
 xmol::trajectory::Trajectory::Iterator::operator=(xmol::trajectory::Trajectory::Iterator&& other) noexcept {
+  release();
   m_traj = other.m_traj;
+  m_own_files = std::move(other.m_own_files);
+  m_files = other.m_files;
   m_pos = other.m_pos;
   m_end = other.m_end;
   m_step = other.m_step;
+  m_atoms = std::move(other.m_atoms);
+  m_read_frames = other.m_read_frames;
   m_frame = std::move(other.m_frame);
+  m_prefetcher = std::move(other.m_prefetcher);
   other.m_traj = nullptr;
   return *this;
 }
+
+xmol::trajectory::Trajectory::Trajectory(Trajectory&& other)
+    : m_frame(std::move(other.m_frame)), m_n_frames(other.m_n_frames), m_files(std::move(other.m_files)),
+      m_iterator_counter(other.m_iterator_counter.load()), m_file_times(std::move(other.m_file_times)),
+      m_random_access_files(std::move(other.m_random_access_files)),
+      m_random_access_positions(std::move(other.m_random_access_positions)),
+      m_random_access_open_file(other.m_random_access_open_file) {}
+
+xmol::trajectory::Trajectory& xmol::trajectory::Trajectory::operator=(Trajectory&& other) {
+  m_frame = std::move(other.m_frame);
+  m_n_frames = other.m_n_frames;
+  m_files = std::move(other.m_files);
+  m_iterator_counter = other.m_iterator_counter.load();
+  m_file_times = std::move(other.m_file_times);
+  m_random_access_files = std::move(other.m_random_access_files);
+  m_random_access_positions = std::move(other.m_random_access_positions);
+  m_random_access_open_file = other.m_random_access_open_file;
+  return *this;
+}
+
+xmol::trajectory::Trajectory::Files xmol::trajectory::Trajectory::clone_files() const {
+  Files result;
+  result.reserve(m_files.size());
+  for (auto& file : m_files) {
+    auto copy = file->clone();
+    if (!copy) {
+      throw TrajectoryDoubleTraverseError("Trajectory is already traversed and its input files can't be "
+                                          "opened independently");
+    }
+    result.push_back(std::move(copy));
+  }
+  return result;
+}
+
+std::vector<xmol::trajectory::Trajectory::TimeSegment> xmol::trajectory::Trajectory::time_segments() {
+  for (size_t i = m_file_times.size(); i < m_files.size(); ++i) {
+    const auto& file = *m_files[i];
+    const size_t n = file.n_frames();
+    m_file_times.push_back(n > 0 ? FileTimes{frame_time(file, 0), frame_time(file, n - 1)} : FileTimes{0, 0});
+  }
+  std::vector<size_t> begins(m_files.size());
+  for (size_t i = 1; i < m_files.size(); ++i) {
+    begins[i] = begins[i - 1] + m_files[i - 1]->n_frames();
+  }
+  std::vector<TimeSegment> result;
+  double end_time = std::numeric_limits<double>::infinity();
+  for (size_t i = m_files.size(); i-- > 0;) {
+    const size_t n = m_files[i]->n_frames();
+    if (n == 0) {
+      continue;
+    }
+    const size_t size = m_file_times[i].last < end_time ? n : lower_bound_time(*m_files[i], 0, n, end_time);
+    if (size > 0) {
+      result.push_back({i, begins[i], size});
+    }
+    end_time = std::min(end_time, m_file_times[i].first);
+  }
+  std::reverse(result.begin(), result.end());
+  return result;
+}
+
+size_t xmol::trajectory::Trajectory::index_at_time(double t) {
+  const auto segments = time_segments();
+  auto time = [this](const TimeSegment& s, size_t i) { return frame_time(*m_files[s.file], i); };
+  const double eps = 1e-6 * std::max(1.0, std::fabs(t));
+  if (segments.empty() || !(t >= time(segments.front(), 0) - eps) ||
+      !(t <= time(segments.back(), segments.back().size - 1) + eps)) {
+    throw std::out_of_range("Trajectory::index_at_time(): time " + std::to_string(t) +
+                            " is out of trajectory time range");
+  }
+  size_t prev_index = segments.front().begin; // last frame of previous segment
+  double prev_time = time(segments.front(), 0);
+  for (auto& s : segments) {
+    const double last_time = time(s, s.size - 1);
+    if (t <= last_time) {
+      const size_t i = lower_bound_time(*m_files[s.file], 0, s.size, t);
+      if (i > 0) {
+        prev_index = s.begin + i - 1;
+        prev_time = time(s, i - 1);
+      }
+      return t - prev_time <= time(s, i) - t ? prev_index : s.begin + i;
+    }
+    prev_index = s.begin + s.size - 1;
+    prev_time = last_time;
+  }
+  return prev_index;
+}
+
+xmol::trajectory::Trajectory::Slice xmol::trajectory::Trajectory::slice_by_time(double t0, double t1,
+                                                                               std::optional<double> dt) {
+  if (!(t0 <= t1) || (dt && !(*dt > 0))) {
+    throw std::invalid_argument("Trajectory::slice_by_time(): bad time window [" + std::to_string(t0) + ", " +
+                                std::to_string(t1) + ") or time step");
+  }
+  const auto segments = time_segments();
+  auto time = [this](const TimeSegment& s, size_t i) { return frame_time(*m_files[s.file], i); };
+
+  // first frame with time >= t0 and frame past the last one with time < t1
+  size_t begin = n_frames();
+  double begin_time = 0;
+  for (auto& s : segments) {
+    if (t0 <= time(s, s.size - 1)) {
+      const size_t i = lower_bound_time(*m_files[s.file], 0, s.size, t0);
+      begin = s.begin + i;
+      begin_time = time(s, i);
+      break;
+    }
+  }
+  size_t end = 0;
+  double last_time = 0;
+  for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+    if (time(*it, 0) < t1) {
+      const size_t i = lower_bound_time(*m_files[it->file], 0, it->size, t1);
+      end = it->begin + i;
+      last_time = time(*it, i - 1);
+      break;
+    }
+  }
+  if (end <= begin) {
+    return slice(begin, begin, 1);
+  }
+
+  size_t n_covered = 0; // number of not superseded frames in [begin, end)
+  for (auto& s : segments) {
+    const size_t lo = std::max(begin, s.begin);
+    const size_t hi = std::min(end, s.begin + s.size);
+    n_covered += hi > lo ? hi - lo : 0;
+  }
+  if (n_covered != end - begin) {
+    throw std::runtime_error("Trajectory::slice_by_time(): frames with time in [" + std::to_string(t0) + ", " +
+                             std::to_string(t1) +
+                             ") are interleaved with frames superseded by later input files, "
+                             "split the window at restart times");
+  }
+
+  size_t step = 1;
+  if (dt && end - begin > 1) {
+    const double mean_dt = (last_time - begin_time) / static_cast<double>(end - begin - 1);
+    if (mean_dt > 0) {
+      step = std::max<size_t>(1, static_cast<size_t>(std::llround(*dt / mean_dt)));
+    }
+  }
+  return slice(begin, end, step);
+}
+
+void xmol::trajectory::Trajectory::read_into(size_t i, Frame& frame) {
+  if (i >= n_frames()) {
+    throw std::out_of_range("Trajectory::read_into(): index " + std::to_string(i) + " is out of range [0," +
+                            std::to_string(n_frames()) + ")");
+  }
+  if (frame.n_atoms() != n_atoms()) {
+    throw std::runtime_error("Trajectory::read_into(): n_atoms() mismatch: " + std::to_string(n_atoms()) +
+                             " != " + std::to_string(frame.n_atoms()));
+  }
+  Position pos{i, 0, i};
+  while (pos.pos_in_file >= m_files[pos.file]->n_frames()) {
+    pos.pos_in_file -= m_files[pos.file]->n_frames();
+    pos.file++;
+  }
+  while (m_random_access_files.size() < m_files.size()) { // files added by extend()
+    m_random_access_files.push_back(m_files[m_random_access_files.size()]->clone());
+    m_random_access_positions.push_back(0);
+  }
+
+  if (m_random_access_open_file != pos.file && m_random_access_open_file < m_random_access_files.size()) {
+    // keep only one copy open, otherwise random access over many files runs out of file descriptors
+    auto& prev = *m_random_access_files[m_random_access_open_file];
+    prev.advance(prev.n_frames() - m_random_access_positions[m_random_access_open_file]);
+    m_random_access_positions[m_random_access_open_file] = 0;
+    m_random_access_open_file = no_open_file;
+  }
+
+  if (auto& file = m_random_access_files[pos.file]) {
+    // closed file is at position 0, first seek() opens it
+    m_random_access_open_file = pos.file;
+    file->seek(m_random_access_positions[pos.file], pos.pos_in_file);
+    m_random_access_positions[pos.file] = pos.pos_in_file;
+    file->read_frame(pos.pos_in_file, frame);
+  } else {
+    if (m_iterator_counter > 0) {
+      throw TrajectoryDoubleTraverseError("Trajectory is traversed and its input file can't be opened independently");
+    }
+    auto& shared_file = *m_files[pos.file];
+    shared_file.advance(pos.pos_in_file);
+    try {
+      shared_file.read_frame(pos.pos_in_file, frame);
+    } catch (...) {
+      shared_file.advance(shared_file.n_frames() - pos.pos_in_file);
+      throw;
+    }
+    shared_file.advance(shared_file.n_frames() - pos.pos_in_file); // iterators expect closed files
+  }
+  frame.index = i;
+}
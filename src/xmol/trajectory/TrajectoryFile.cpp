@@ -0,0 +1,81 @@
+#include "xmol/trajectory/TrajectoryFile.h"
+#include "xmol/Frame.h"
+
+using namespace xmol::trajectory;
+
+namespace {
+xmol::Frame make_frame(size_t n_atoms) {
+  xmol::Frame frame;
+  frame.reserve_atoms(n_atoms);
+  auto residue = frame.add_molecule().add_residue();
+  for (size_t i = 0; i < n_atoms; ++i) {
+    residue.add_atom();
+  }
+  return frame;
+}
+} // namespace
+
+TrajectoryInputFile::TrajectoryInputFile(const TrajectoryInputFile&) {}
+TrajectoryInputFile::TrajectoryInputFile(TrajectoryInputFile&& other) noexcept = default;
+TrajectoryInputFile& TrajectoryInputFile::operator=(const TrajectoryInputFile&) { return *this; }
+TrajectoryInputFile& TrajectoryInputFile::operator=(TrajectoryInputFile&& other) noexcept = default;
+TrajectoryInputFile::~TrajectoryInputFile() = default;
+
+xmol::Frame& TrajectoryInputFile::scratch_frame(bool with_velocities, bool with_forces) {
+  if (!m_scratch_frame) {
+    m_scratch_frame = std::make_unique<Frame>(make_frame(n_atoms()));
+  }
+  auto& frame = *m_scratch_frame;
+  if (with_velocities) {
+    frame.add_velocities();
+  } else {
+    frame.remove_velocities();
+  }
+  if (with_forces) {
+    frame.add_forces();
+  } else {
+    frame.remove_forces();
+  }
+  return frame;
+}
+
+void TrajectoryInputFile::read_coords(size_t index, const future::Span<float>& coords) {
+  assert(coords.size() == n_atoms() * 3);
+  Frame& frame = scratch_frame(false, false);
+  read_frame(index, frame);
+  CoordEigenMatrixMapf(coords.data(), n_atoms(), 3) = frame.coords()._eigen().cast<float>();
+}
+
+void TrajectoryInputFile::read_frame_atoms(size_t index, const std::vector<AtomIndex>& atoms, Frame& frame) {
+  auto coordinates = frame.coords();
+  assert(coordinates.size() == atoms.size());
+  Frame& full_frame = scratch_frame(frame.has_velocities(), frame.has_forces());
+  read_frame(index, full_frame);
+  auto copy_rows = [&atoms](auto&& selected, const auto& full) {
+    for (size_t i = 0; i < atoms.size(); ++i) {
+      selected.row(i) = full.row(atoms[i]);
+    }
+  };
+  copy_rows(coordinates._eigen(), full_frame.coords()._eigen());
+  if (frame.has_velocities()) {
+    copy_rows(frame.velocities()._eigen(), full_frame.velocities()._eigen());
+  }
+  if (frame.has_forces()) {
+    copy_rows(frame.forces()._eigen(), full_frame.forces()._eigen());
+  }
+  frame.cell = full_frame.cell;
+  frame.time = full_frame.time;
+}
+
+std::optional<double> TrajectoryInputFile::frame_time(size_t) const { return std::nullopt; }
+
+std::unique_ptr<TrajectoryInputFile> TrajectoryInputFile::clone() const { return nullptr; }
+
+void TrajectoryInputFile::seek(size_t current, size_t index) {
+  if (index >= current) {
+    advance(index - current);
+    return;
+  }
+  advance(n_frames() - current);
+  advance(index);
+}
@@ -0,0 +1,39 @@
+#include "xmol/utils/MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace xmol::utils;
+
+MappedFile::MappedFile(const std::string& filename) {
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("MappedFile(): can't open `" + filename + "`: " + std::strerror(errno));
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("MappedFile(): can't stat `" + filename + "`: " + std::strerror(errno));
+  }
+  m_size = st.st_size;
+  if (m_size > 0) {
+    void* ptr = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("MappedFile(): can't map `" + filename + "`: " + std::strerror(errno));
+    }
+    m_data = static_cast<const char*>(ptr);
+  }
+  ::close(fd); // mapping stays valid after descriptor is closed
+}
+
+MappedFile::~MappedFile() {
+  if (m_data) {
+    ::munmap(const_cast<char*>(m_data), m_size);
+  }
+}
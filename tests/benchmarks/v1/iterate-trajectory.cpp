@@ -18,3 +18,20 @@ BENCHMARK_REGISTER_F(BM_TrajectoryTrjtool, Stride)
     ->Args({0, 2000, 100})
     ->Args({0, 2000, 1000});
 
+
+BENCHMARK_DEFINE_F(BM_TrajectoryTrjtool, RandomAccess)(benchmark::State& state) {
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<size_t> index(0, trj_ptr->n_frames() - 1);
+  Frame frame = trj_ptr->at(0);
+  for (auto _ : state) {
+    if (state.range(0)) {
+      trj_ptr->read_into(index(generator), frame);
+    } else {
+      frame = trj_ptr->at(index(generator));
+    }
+    benchmark::DoNotOptimize(frame);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_TrajectoryTrjtool, RandomAccess)->ArgName("read_into")->Arg(0)->Arg(1);
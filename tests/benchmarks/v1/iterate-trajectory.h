@@ -7,6 +7,7 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <random>
 
 using namespace trajectory;
 
@@ -0,0 +1,77 @@
+#include "common.h"
+#include "xmol/io/pdb/PdbBufferReader.h"
+#include "xmol/io/pdb/PdbReader.h"
+#include "xmol/io/pdb/PdbRecord.h"
+#include "xmol/io/pdb/PdbWriter.h"
+
+#include <iomanip>
+#include <sstream>
+
+using namespace xmol::io::pdb;
+
+/// PDB text of state.range(0) atoms in residues of 10 atoms
+class BM_PdbRead : public benchmark::Fixture {
+public:
+  std::string text;
+
+  void SetUp(const ::benchmark::State& state) {
+    Frame frame;
+    populate_frame(frame, 1, state.range(0) / 10, 10);
+    frame.coords()._eigen().setRandom();
+    std::ostringstream out;
+    PdbWriter(out).write(frame);
+    text = out.str();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_PdbRead, PdbReader)(benchmark::State& state) {
+  for (auto _ : state) {
+    std::istringstream in(text);
+    auto frames = PdbReader(in).read_frames();
+    benchmark::DoNotOptimize(frames.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0)); // atoms/s
+}
+
+BENCHMARK_DEFINE_F(BM_PdbRead, PdbBufferReader)(benchmark::State& state) {
+  PdbBufferReader reader(StandardPdbRecords::instance());
+  for (auto _ : state) {
+    auto frames = reader.read_frames(text.data(), text.data() + text.size());
+    benchmark::DoNotOptimize(frames.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0)); // atoms/s
+}
+
+BENCHMARK_REGISTER_F(BM_PdbRead, PdbReader)->Arg(1000)->Arg(50000);
+BENCHMARK_REGISTER_F(BM_PdbRead, PdbBufferReader)->Arg(1000)->Arg(50000);
+
+/// 100 models of state.range(0) atoms read with state.range(1) threads
+class BM_PdbReadModels : public benchmark::Fixture {
+public:
+  static constexpr int n_models = 100;
+  std::string text;
+
+  void SetUp(const ::benchmark::State& state) {
+    Frame frame;
+    populate_frame(frame, 1, state.range(0) / 10, 10);
+    std::ostringstream out;
+    for (int m = 0; m < n_models; ++m) {
+      frame.coords()._eigen().setRandom();
+      out << "MODEL     " << std::setw(4) << m + 1 << "\n";
+      PdbWriter(out).write(frame);
+      out << "ENDMDL\n";
+    }
+    text = out.str();
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_PdbReadModels, PdbBufferReader)(benchmark::State& state) {
+  PdbBufferReader reader(StandardPdbRecords::instance());
+  for (auto _ : state) {
+    auto frames = reader.read_frames(text.data(), text.data() + text.size(), state.range(1));
+    benchmark::DoNotOptimize(frames.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n_models * state.range(0)); // atoms/s
+}
+
+BENCHMARK_REGISTER_F(BM_PdbReadModels, PdbBufferReader)->Args({10000, 1})->Args({10000, 4})->UseRealTime();
@@ -0,0 +1,65 @@
+#include "common.h"
+#include "xmol/io/pdb/PdbBufferWriter.h"
+#include "xmol/io/pdb/PdbWriter.h"
+#include "xmol/trajectory/InMemoryTrajectory.h"
+
+#include <sstream>
+
+using namespace xmol::io::pdb;
+
+/// Frame of state.range(0) atoms in residues of 10 atoms
+class BM_PdbWrite : public benchmark::Fixture {
+public:
+  Frame frame;
+
+  void SetUp(const ::benchmark::State& state) {
+    frame = Frame();
+    populate_frame(frame, 1, state.range(0) / 10, 10);
+    frame.coords()._eigen().setRandom();
+    frame.coords()._eigen() *= 100;
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_PdbWrite, PdbWriter)(benchmark::State& state) {
+  for (auto _ : state) {
+    std::ostringstream out;
+    PdbWriter(out).write(frame);
+    benchmark::DoNotOptimize(out.str().size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0)); // atoms/s
+}
+
+BENCHMARK_DEFINE_F(BM_PdbWrite, PdbBufferWriter)(benchmark::State& state) {
+  for (auto _ : state) {
+    std::ostringstream out;
+    PdbBufferWriter(out).write(frame);
+    benchmark::DoNotOptimize(out.str().size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0)); // atoms/s
+}
+
+BENCHMARK_REGISTER_F(BM_PdbWrite, PdbWriter)->Arg(1000)->Arg(50000);
+BENCHMARK_REGISTER_F(BM_PdbWrite, PdbBufferWriter)->Arg(1000)->Arg(50000);
+
+/// 100 frames of state.range(0) atoms written as multi-model PDB
+static void BM_PdbWriteModels(benchmark::State& state) {
+  const int n_models = 100;
+  Frame frame;
+  populate_frame(frame, 1, state.range(0) / 10, 10);
+  trajectory::InMemoryTrajectory store(frame.n_atoms());
+  for (int m = 0; m < n_models; ++m) {
+    frame.coords()._eigen().setRandom();
+    frame.coords()._eigen() *= 100;
+    store.append(frame);
+  }
+  trajectory::Trajectory traj(frame);
+  traj.extend(std::move(store));
+  for (auto _ : state) {
+    std::ostringstream out;
+    PdbBufferWriter(out).write(traj.slice());
+    benchmark::DoNotOptimize(out.str().size());
+  }
+  state.SetItemsProcessed(state.iterations() * n_models * state.range(0)); // atoms/s
+}
+
+BENCHMARK(BM_PdbWriteModels)->Arg(10000);
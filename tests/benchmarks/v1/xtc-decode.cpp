@@ -0,0 +1,54 @@
+#include "common.h"
+#include "xmol/io/xdr/XtcReader.h"
+#include "xmol/io/xdr/XtcWriter.h"
+
+#include <cstdio>
+#include <random>
+
+using namespace xmol::io::xdr;
+
+/// Synthetic trajectory of state.range(0) atoms: water-like triplets scattered in a box
+class BM_XtcDecode : public benchmark::Fixture {
+public:
+  static constexpr int n_frames = 10;
+  const char* const filename = "benchmark-decode.xtc";
+
+  void SetUp(const ::benchmark::State& state) {
+    Frame frame;
+    populate_frame(frame, 1, state.range(0) / 3, 3);
+    auto coords = frame.coords()._eigen();
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> position(0.0, 100.0);
+    std::normal_distribution<double> bond(0.0, 1.0);
+    XtcWriter writer(filename, 1000);
+    for (int f = 0; f < n_frames; ++f) {
+      for (int i = 0; i < coords.rows(); ++i) {
+        for (int k = 0; k < 3; ++k) {
+          coords(i, k) = i % 3 == 0 ? position(generator) : coords(i - 1, k) + bond(generator);
+        }
+      }
+      writer.write(frame);
+    }
+  }
+
+  void TearDown(const ::benchmark::State&) { std::remove(filename); }
+};
+
+BENCHMARK_DEFINE_F(BM_XtcDecode, ReadCoords)(benchmark::State& state) {
+  XtcHeader header{};
+  std::array<float, 9> box{};
+  std::vector<float> coords;
+  for (auto _ : state) {
+    XtcReader reader(filename);
+    for (int f = 0; f < n_frames; ++f) {
+      reader.read_header(header);
+      reader.read_box(box);
+      coords.resize(header.n_atoms * 3);
+      reader.read_coords(coords);
+      benchmark::DoNotOptimize(coords.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n_frames * state.range(0)); // atoms/s
+}
+
+BENCHMARK_REGISTER_F(BM_XtcDecode, ReadCoords)->Arg(3000)->Arg(30000)->Arg(300000);
@@ -62,6 +62,19 @@ def test_calc_alignment():
     assert calc_rmsd(a, c) == pytest.approx(0)
 
 
+def test_calc_alignment_float32():
+    from pyxmolpp2 import calc_alignment, XYZ, calc_rmsd, Rotation, Translation, Degrees
+
+    a = np.array([(1, 2, 3), (1, 2, 5), (4, 2, 7), (8, 1, 4)], dtype=np.float32)
+    G = Rotation(XYZ(7, 6, 5), Degrees(12)) * Translation(XYZ(8, -9, 1))
+    b = np.array([G.transform(XYZ(*x)).values for x in a], dtype=np.float32)
+
+    G2 = calc_alignment(a, b)
+    assert calc_rmsd(a, b) > 1
+    c = np.array([G2.transform(XYZ(*x)).values for x in b], dtype=np.float32)
+    assert calc_rmsd(a, c) == pytest.approx(0, abs=1e-5)
+
+
 def test_calc_inertia_tensor():
     from pyxmolpp2 import calc_inertia_tensor, XYZ, Rotation, Translation
     import numpy as np
@@ -14,3 +14,28 @@ def test_read_netcdf():
     assert datfile.n_atoms() == frame.atoms.size
 
     datfile.read_frame(0, frame)
+
+
+def test_writer():
+    from pyxmolpp2 import PdbFile, AmberNetCDF, AmberNetCDFWriter, Trajectory
+    import numpy as np
+
+    frame = PdbFile(os.environ["TEST_DATA_PATH"] + "/amber/GB1_F30C_MTSL/box.pdb").frames()[0]
+    traj = Trajectory(frame)
+    traj.extend(AmberNetCDF(os.environ["TEST_DATA_PATH"] + "/amber/GB1_F30C_MTSL/GB1_F30C_MTSL_10_frames.nc"))
+
+    writer = AmberNetCDFWriter("test.nc", buffer_frames=4)
+    expected = []
+    for frame in traj:
+        writer.write(frame, velocities=np.ones((frame.atoms.size, 3)))
+        expected.append(frame.coords.values.copy())
+    assert writer.n_frames() == traj.n_frames
+    writer.close()
+
+    copy = Trajectory(frame)
+    copy.extend(AmberNetCDF("test.nc"))
+    assert copy.n_frames == traj.n_frames
+    for frame, coords in zip(copy, expected):
+        assert np.allclose(frame.coords.values, coords)
+    del copy
+    os.remove("test.nc")
@@ -0,0 +1,64 @@
+import pytest
+import os
+
+
+def test_write_and_read(tmpdir):
+    from pyxmolpp2 import PdbFile, Frame, GromacsTrrFile, TrrWriter, Trajectory, Translation, XYZ
+    import numpy as np
+
+    frame = PdbFile(os.environ["TEST_DATA_PATH"] + "/gromacs/xtc/1am7_protein.pdb").frames()[0]
+    trr_filename = str(tmpdir.join("test.trr"))
+    velocities = np.random.random((frame.atoms.size, 3))
+    forces = np.random.random((frame.atoms.size, 3))
+
+    writer = TrrWriter(trr_filename, double_precision=True)
+    expected = []
+    for i in range(5):
+        frame.coords.apply(Translation(XYZ(1, 0, 0)))
+        expected.append(frame.coords.values.copy())
+        writer.write(frame, velocities=velocities * i, forces=forces if i % 2 else None)
+    del writer
+
+    trr = GromacsTrrFile(trr_filename)
+    assert trr.n_frames() == 5
+    assert trr.n_atoms() == frame.atoms.size
+    assert trr.is_double_precision()
+    assert trr.has_velocities()
+    assert not trr.has_forces()
+
+    frame_vf = Frame(frame)
+    frame_vf.add_velocities()
+    frame_vf.add_forces()
+    trr.advance(3)
+    trr.read_frame(3, frame_vf)
+    assert np.allclose(frame_vf.velocities, velocities * 3)
+    assert np.allclose(frame_vf.forces, forces)
+
+    trr.advance(1)
+    trr.read_frame(4, frame)
+    assert frame.velocities is None
+
+    traj = Trajectory(frame)
+    traj.extend(GromacsTrrFile(trr_filename))
+    for f in traj:
+        assert np.allclose(f.coords.values, expected[f.index])
+
+
+def test_frame_vectors_round_trip(tmpdir):
+    from pyxmolpp2 import PdbFile, GromacsTrrFile, TrrWriter
+    import numpy as np
+
+    frame = PdbFile(os.environ["TEST_DATA_PATH"] + "/gromacs/xtc/1am7_protein.pdb").frames()[0]
+    trr_filename = str(tmpdir.join("test_vectors.trr"))
+    frame.add_velocities()
+    assert frame.has_velocities
+    assert not frame.has_forces
+    frame.velocities[:] = np.random.random((frame.atoms.size, 3))
+    TrrWriter(trr_filename).write(frame)
+
+    read = PdbFile(os.environ["TEST_DATA_PATH"] + "/gromacs/xtc/1am7_protein.pdb").frames()[0]
+    read.add_velocities()
+    trr = GromacsTrrFile(trr_filename)
+    trr.advance(0)
+    trr.read_frame(0, read)
+    assert np.allclose(read.velocities, frame.velocities, atol=1e-5)
@@ -17,6 +17,35 @@ def test_read_one_file():
     inp.read_frame(0, frame)
 
 
+def test_read_without_n_frames(tmpdir):
+    from pyxmolpp2 import GromacsXtcFile
+
+    xtc_filename = os.environ["TEST_DATA_PATH"] + "/gromacs/xtc/1am7_corrected.xtc"
+    assert GromacsXtcFile(xtc_filename).n_frames() == 51
+
+    index_filename = str(tmpdir.join("1am7_corrected.xtc.idx"))
+    assert GromacsXtcFile(xtc_filename, index_filename=index_filename).n_frames() == 51
+    assert os.path.exists(index_filename)
+    assert GromacsXtcFile(xtc_filename, index_filename=index_filename).n_frames() == 51
+
+
+def test_read_frames():
+    from pyxmolpp2 import GromacsXtcFile, PdbFile, Trajectory
+    import numpy as np
+
+    xtc_filename = os.environ["TEST_DATA_PATH"] + "/gromacs/xtc/1am7_corrected.xtc"
+    frame = PdbFile(os.environ["TEST_DATA_PATH"] + "/gromacs/xtc/1am7_protein.pdb").frames()[0]
+    xtc = GromacsXtcFile(xtc_filename)
+    coords = xtc.read_frames(1, 51, stride=7, n_threads=3)
+    assert coords.shape == (8, frame.atoms.size, 3)
+    assert coords.dtype == np.float32
+
+    traj = Trajectory(frame)
+    traj.extend(GromacsXtcFile(xtc_filename))
+    for k, f in enumerate(traj[1::7]):
+        assert np.allclose(coords[k], f.coords.values, atol=1e-4)
+
+
 def test_writer():
     from pyxmolpp2 import PdbFile, XtcWriter, Translation, XYZ
 
@@ -28,3 +57,30 @@ def test_writer():
         xtc_writer.write(frame)
     del xtc_writer
     os.remove("test.xtc")
+
+
+def test_parallel_writer(tmpdir):
+    from pyxmolpp2 import PdbFile, XtcWriter, GromacsXtcFile, Trajectory, Translation, XYZ
+    import numpy as np
+
+    frame = PdbFile(os.environ["TEST_DATA_PATH"] + "/gromacs/xtc/1am7_protein.pdb").frames()[0]
+    serial_filename = str(tmpdir.join("serial.xtc"))
+    parallel_filename = str(tmpdir.join("parallel.xtc"))
+    serial = XtcWriter(serial_filename, 1000)
+    parallel = XtcWriter(parallel_filename, 1000, n_threads=4)
+    expected = []
+    for i in range(10):
+        frame.coords.apply(Translation(XYZ(1, 0, 0)))
+        expected.append(frame.coords.values.copy())
+        serial.write(frame)
+        parallel.write(frame)
+    serial.flush()
+    parallel.flush()
+
+    with open(serial_filename, "rb") as s, open(parallel_filename, "rb") as p:
+        assert s.read() == p.read()
+
+    traj = Trajectory(frame)
+    traj.extend(GromacsXtcFile(parallel_filename))
+    for f in traj:
+        assert np.allclose(f.coords.values, expected[f.index], atol=1e-2)
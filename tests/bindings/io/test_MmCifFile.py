@@ -0,0 +1,47 @@
+import pytest
+
+
+def test_mmcif_file(tmpdir):
+    from pyxmolpp2 import MmCifFile, Trajectory
+
+    text = "data_TEST\n" \
+           "loop_\n" \
+           "_atom_site.id\n" \
+           "_atom_site.label_atom_id\n" \
+           "_atom_site.label_comp_id\n" \
+           "_atom_site.label_asym_id\n" \
+           "_atom_site.label_seq_id\n" \
+           "_atom_site.Cartn_x\n" \
+           "_atom_site.Cartn_y\n" \
+           "_atom_site.Cartn_z\n" \
+           "_atom_site.auth_asym_id\n" \
+           "_atom_site.pdbx_PDB_model_num\n"
+    for m in range(1, 4):
+        text += f"1 N  GLY A 1 {m}.0 2.0 3.0 AB {m}\n" \
+                f"2 CA GLY A 1 4.0 {m}.0 6.0 AB {m}\n"
+    filename = str(tmpdir.join("models.cif"))
+    with open(filename, "w") as f:
+        f.write(text)
+
+    file = MmCifFile(filename)
+    assert file.n_frames() == 3
+    assert file.n_atoms() == 2
+    frame = file.frame(0)
+    assert frame.molecules[0].name == "AB"
+    assert frame.atoms[1].name == "CA"
+
+    traj = Trajectory(frame)
+    traj.extend(MmCifFile(filename))
+    for f, expected in zip(traj, file.frames()):
+        assert f.coords.values.tolist() == expected.coords.values.tolist()
+        assert f.coords.values[0, 0] == pytest.approx(f.index + 1)
+
+
+def test_mmcif_read_error(tmpdir):
+    from pyxmolpp2 import MmCifFile, CifReadError
+
+    filename = str(tmpdir.join("bad.cif"))
+    with open(filename, "w") as f:
+        f.write("data_1\nloop_\n_atom_site.id\n_atom_site.Cartn_x\n1 1.0\n")
+    with pytest.raises(CifReadError):
+        MmCifFile(filename)
@@ -42,3 +42,36 @@ def test_read_empty_file():
     import os
 
     assert len(PdbFile(os.devnull).frames()) == 0
+
+
+def test_read_frames_in_parallel():
+    from pyxmolpp2 import PdbFile
+    import glob
+
+    for filename in glob.glob(os.environ["TEST_DATA_PATH"] + "/pdb/rcsb/*.pdb"):
+        frames = PdbFile(filename).frames()
+        parallel_frames = PdbFile(filename, n_threads=4).frames()
+
+        assert len(parallel_frames) == len(frames)
+        for frame, parallel_frame in zip(frames, parallel_frames):
+            assert parallel_frame.atoms.size == frame.atoms.size
+            assert parallel_frame.residues.size == frame.residues.size
+            assert parallel_frame.molecules.size == frame.molecules.size
+            assert parallel_frame.coords.values.tolist() == frame.coords.values.tolist()
+
+
+def test_pdb_trajectory_file():
+    from pyxmolpp2 import PdbFile, PdbTrajectoryFile, Trajectory
+    import glob
+
+    for filename in glob.glob(os.environ["TEST_DATA_PATH"] + "/pdb/rcsb/*.pdb"):
+        frames = PdbFile(filename).frames()
+        file = PdbTrajectoryFile(filename)
+        if any(frame.atoms.size != frames[0].atoms.size for frame in frames):
+            continue
+
+        assert file.n_frames() == len(frames)
+        traj = Trajectory(file.frame(0))
+        traj.extend(PdbTrajectoryFile(filename))
+        for frame, expected in zip(traj, frames):
+            assert frame.coords.values.tolist() == expected.coords.values.tolist()
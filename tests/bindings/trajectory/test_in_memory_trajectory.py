@@ -0,0 +1,67 @@
+from make_polygly import make_polyglycine
+from pyxmolpp2 import InMemoryTrajectory, Trajectory
+import numpy as np
+import pytest
+
+
+@pytest.mark.parametrize("precision", [0.0, 1e-3])
+def test_in_memory_trajectory(precision):
+    ref = make_polyglycine([("A", 10)])
+    store = InMemoryTrajectory(ref.atoms.size, precision=precision, block_size=4)
+    assert store.precision == precision
+
+    expected = []
+    for i in range(10):
+        ref.coords.values[:] = np.random.random((ref.atoms.size, 3)) * 10
+        ref.time = i
+        expected.append(ref.coords.values.copy())
+        store.append(ref)
+    assert store.n_frames() == 10
+    assert store.size_in_bytes > 0
+
+    traj = Trajectory(ref)
+    traj.extend(store)
+    for _ in range(2):  # frames are decoded on each pass
+        for f in traj:
+            assert f.time == f.index
+            assert np.allclose(f.coords.values, expected[f.index], atol=max(precision, 1e-5))
+    for f in traj[5::3]:
+        assert np.allclose(f.coords.values, expected[f.index], atol=max(precision, 1e-5))
+
+
+def test_time_lookup():
+    ref = make_polyglycine([("A", 2)])
+    traj = Trajectory(ref)
+    for t0, n in [(0, 10), (7, 8), (15, 5)]:  # restarts with overlapping times
+        store = InMemoryTrajectory(ref.atoms.size)
+        for i in range(n):
+            ref.time = t0 + i
+            store.append(ref)
+        assert store.frame_time(n - 1) == t0 + n - 1
+        traj.extend(store)
+
+    assert traj.index_at_time(9) == 12
+    assert traj.frame_at_time(8.2).time == 8
+    assert [f.time for f in traj.slice_by_time(8, 20, dt=3)] == [8, 11, 14, 17]
+    with pytest.raises(RuntimeError):
+        traj.slice_by_time(5, 9)
+    with pytest.raises(IndexError):
+        traj.index_at_time(100)
+
+
+def test_read_into():
+    ref = make_polyglycine([("A", 2)])
+    store = InMemoryTrajectory(ref.atoms.size)
+    for i in range(10):
+        ref.coords.values[:] = i
+        ref.time = i
+        store.append(ref)
+    traj = Trajectory(ref)
+    traj.extend(store)
+
+    frame = traj[0]
+    for i in [7, 3, 3, 9, 0]:
+        traj.read_into(i, frame)
+        assert frame.index == i
+        assert frame.time == i
+        assert np.allclose(frame.coords.values, i)
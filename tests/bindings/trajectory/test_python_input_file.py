@@ -33,3 +33,18 @@ def test_pseudo_trajectory():
         assert np.allclose(frame.coords.values, frame.index)
         assert np.isclose(frame.cell.volume, frame.index + 1)
         assert np.isclose(frame.time, frame.index * 15)
+
+
+def test_pseudo_trajectory_prefetch():
+    ref = make_polyglycine([('A', 10)])
+
+    traj = Trajectory(ref)
+    traj.extend(IotaTrajectory(natoms=ref.atoms.size, nframes=10))
+    traj.extend(IotaTrajectory(natoms=ref.atoms.size, nframes=15))
+
+    # python methods are called by background reader thread
+    indices = []
+    for frame in traj[2::3].prefetch(4):
+        assert np.allclose(frame.coords.values, frame.index if frame.index < 10 else frame.index - 10)
+        indices.append(frame.index)
+    assert indices == list(range(2, 25, 3))
@@ -103,4 +103,141 @@ def test_trajectory_bad_n_atoms():
 
     trj = Trajectory(frame)
     with pytest.raises(RuntimeError):
-        trj.extend(DatFile(os.environ["TEST_DATA_PATH"] + "/trjtool/GB1/run00001.dat"))
\ No newline at end of file
+        trj.extend(DatFile(os.environ["TEST_DATA_PATH"] + "/trjtool/GB1/run00001.dat"))
+
+def test_trajectory_prefetch():
+    from pyxmolpp2 import PdbFile, TrjtoolDatFile as DatFile, Trajectory
+
+    frame = PdbFile(os.environ["TEST_DATA_PATH"] + "/trjtool/GB1/run00001.pdb").frames()[0]
+
+    trj = Trajectory(frame)
+    trj.extend(DatFile(os.environ["TEST_DATA_PATH"] + "/trjtool/GB1/run00001.dat"))
+
+    expected = [f.atoms[0].r for f in trj[3::7]]
+    actual = [f.atoms[0].r for f in trj[3::7].prefetch(4)]
+    assert len(expected) == len(actual)
+    assert all(a.distance(b) < 1e-6 for a, b in zip(expected, actual))
+
+    for i, f in enumerate(trj.prefetch(2)):
+        if i == 10:
+            break
+
+    assert sum(1 for _ in trj.prefetch(3)) == trj.n_frames
+
+
+def test_trajectory_select_atoms():
+    from pyxmolpp2 import PdbFile, TrjtoolDatFile as DatFile, Trajectory, aName
+
+    frame = PdbFile(os.environ["TEST_DATA_PATH"] + "/trjtool/GB1/run00001.pdb").frames()[0]
+
+    trj = Trajectory(frame)
+    trj.extend(DatFile(os.environ["TEST_DATA_PATH"] + "/trjtool/GB1/run00001.dat"))
+
+    ca = frame.atoms.filter(aName == "CA")
+    expected = [f.atoms.filter(aName == "CA").coords.values for f in trj[::100]]
+    actual = [f.coords.values for f in trj[::100].select_atoms(ca)]
+    assert len(expected) == len(actual)
+    assert all((a == b).all() for a, b in zip(expected, actual))
+
+    subset = trj.select_atoms([10, 2, 2, 5])
+    assert subset.n_atoms == 3
+    assert [a.id for a in subset[0].atoms] == [frame.atoms[i].id for i in (2, 5, 10)]
+
+    with pytest.raises(IndexError):
+        trj.select_atoms([trj.n_atoms])
+
+
+def test_trajectory_slice_coords():
+    from pyxmolpp2 import PdbFile, TrjtoolDatFile, Trajectory, aName
+    import numpy as np
+
+    frame = PdbFile(os.environ["TEST_DATA_PATH"] + "/trjtool/GB1/run00001.pdb").frames()[0]
+    trj = Trajectory(frame)
+    trj.extend(TrjtoolDatFile(os.environ["TEST_DATA_PATH"] + "/trjtool/GB1/run00001.dat"))
+    trj.extend(TrjtoolDatFile(os.environ["TEST_DATA_PATH"] + "/trjtool/GB1/run00002.dat"))
+
+    ca = frame.atoms.filter(aName == "CA")
+    expected = np.array([f.coords.values[ca.index] for f in trj[10:1500:7]])
+
+    coords = trj[10:1500:7].coords()
+    assert coords.dtype == np.float32
+    assert coords.shape == (len(trj[10:1500:7]), frame.atoms.size, 3)
+
+    ca_coords = trj[10:1500:7].coords(ca)
+    assert ca_coords.shape == expected.shape
+    assert np.allclose(ca_coords, expected, atol=1e-4)
+    assert np.allclose(coords[:, ca.index], expected, atol=1e-4)
+
+    ca_coords64 = trj[10:1500:7].coords([a.index for a in ca], dtype=np.float64)
+    assert ca_coords64.dtype == np.float64
+    assert np.allclose(ca_coords64, expected, atol=1e-4)
+
+    with pytest.raises(TypeError):
+        trj[:].coords(dtype=np.int32)
+
+
+def test_trajectory_slice_coords_of_python_input_file():
+    from pyxmolpp2 import TrajectoryInputFile, Trajectory, Frame
+    from make_polygly import make_polyglycine
+    import numpy as np
+
+    class IotaTrajectory(TrajectoryInputFile):
+        def __init__(self, natoms, nframes):
+            super().__init__()
+            self._natoms = natoms
+            self._nframes = nframes
+
+        def n_frames(self):
+            return self._nframes
+
+        def n_atoms(self):
+            return self._natoms
+
+        def read_frame(self, index: int, frame: Frame):
+            frame.coords.values[:] = np.ones_like(frame.coords.values) * index
+
+        def advance(self, shift: int):
+            pass
+
+    ref = make_polyglycine([('A', 10)])
+    trj = Trajectory(ref)
+    trj.extend(IotaTrajectory(natoms=ref.atoms.size, nframes=10))
+    trj.extend(IotaTrajectory(natoms=ref.atoms.size, nframes=15))
+
+    # coordinates are read with GIL released, python methods must reacquire it
+    expected = np.array([i if i < 10 else i - 10 for i in range(3, 25, 4)])
+    coords = trj[3::4].coords()
+    assert coords.dtype == np.float32
+    assert coords.shape == (len(expected), ref.atoms.size, 3)
+    assert (coords == expected[:, None, None]).all()
+
+    coords64 = trj[3::4].coords([0, 5], dtype=np.float64)
+    assert coords64.shape == (len(expected), 2, 3)
+    assert (coords64 == expected[:, None, None]).all()
+
+
+def test_trajectory_slice_to_pdb(tmpdir):
+    from pyxmolpp2 import PdbFile, InMemoryTrajectory, Trajectory
+    from make_polygly import make_polyglycine
+    from io import StringIO
+    import numpy as np
+
+    np.random.seed(17)
+    ref = make_polyglycine([("A", 3)])
+    store = InMemoryTrajectory(ref.atoms.size, precision=1e-3)
+    for i in range(5):
+        ref.coords.values[:] = np.random.random((ref.atoms.size, 3)) * 10
+        store.append(ref)
+    traj = Trajectory(ref)
+    traj.extend(store)
+
+    filename = str(tmpdir.join("models.pdb"))
+    traj[1::2].to_pdb(filename)
+    frames = PdbFile(filename).frames()
+    assert len(frames) == 2
+    for frame, expected in zip(frames, traj[1::2]):
+        assert np.allclose(frame.coords.values, expected.coords.values, atol=1e-3)
+
+    output = StringIO()
+    traj[:].to_pdb(output)
+    assert output.getvalue().count("ENDMDL") == 5
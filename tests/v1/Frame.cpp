@@ -277,3 +277,44 @@ TEST_F(FrameTests, frame_forward_construction) {
   ASSERT_EQ(frame.n_residues(), n_molecules * n_residues_per_molecule);
   ASSERT_EQ(frame.n_atoms(), n_molecules * n_residues_per_molecule * n_atoms_per_residue);
 }
+
+TEST_F(FrameTests, velocities_and_forces) {
+  Frame frame;
+  auto residue = frame.add_molecule().add_residue();
+  residue.add_atom();
+  residue.add_atom();
+
+  EXPECT_FALSE(frame.has_velocities());
+  EXPECT_TRUE(frame.velocities().empty());
+  EXPECT_TRUE(frame.atoms().forces().empty());
+
+  frame.add_velocities();
+  ASSERT_TRUE(frame.has_velocities());
+  EXPECT_FALSE(frame.has_forces());
+  auto velocities = frame.velocities();
+  ASSERT_EQ(velocities.size(), 2);
+  EXPECT_DOUBLE_EQ(velocities._eigen().norm(), 0);
+  velocities[1] = XYZ(1, 2, 3);
+
+  for (int i = 0; i < 100; ++i) { // force reallocation of atom storage
+    frame.molecules()[0].residues()[0].add_atom();
+  }
+  ASSERT_EQ(frame.velocities().size(), frame.n_atoms());
+  EXPECT_DOUBLE_EQ(velocities[1].y(), 2);
+  EXPECT_DOUBLE_EQ(frame.atoms()[1].r().y(), 0);
+  EXPECT_DOUBLE_EQ(frame.velocities()._eigen().norm(), XYZ(1, 2, 3).len());
+  EXPECT_DOUBLE_EQ(frame.atoms().slice(1, 3).velocities()[0].z(), 3);
+
+  Frame copy = frame;
+  ASSERT_TRUE(copy.has_velocities());
+  copy.velocities()[1] = XYZ(0, 0, 0);
+  EXPECT_DOUBLE_EQ(frame.velocities()[1].x(), 1);
+
+  Frame moved = std::move(copy);
+  EXPECT_TRUE(moved.has_velocities());
+  EXPECT_EQ(moved.velocities().size(), moved.n_atoms());
+
+  frame.remove_velocities();
+  EXPECT_FALSE(frame.has_velocities());
+  EXPECT_THROW(static_cast<void>(velocities[0]), std::out_of_range);
+}
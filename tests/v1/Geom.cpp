@@ -42,6 +42,29 @@ TEST_F(GeomTests, alignment) {
   EXPECT_LT((X - Y).array().abs().maxCoeff(), 1e-12);
 }
 
+TEST_F(GeomTests, alignment_float) {
+  std::vector<float> X = {1, 2, 3, 2, 4, 5, 8, 1, 3, 1, 1, 1, 5, 1, 2};
+  std::vector<float> Y = X;
+
+  Transformation3d G = Translation3d(XYZ(-1, 1, 2)) * Rotation3d(XYZ(1, 2, 3), Degrees(10));
+  CoordEigenMatrixMapf Y_map(Y.data(), 5, 3);
+  Y_map = ((G.get_underlying_matrix() * Y_map.cast<double>().transpose()).transpose().rowwise() +
+           G.get_translation()._eigen())
+              .cast<float>();
+
+  auto G2 = calc_alignment(future::Span(X), future::Span(Y));
+  EXPECT_LT((G2.get_underlying_matrix() - G.inverted().get_underlying_matrix()).array().abs().maxCoeff(), 1e-5);
+  EXPECT_GT(calc_rmsd(future::Span(X), future::Span(Y)), 1);
+
+  Y_map = ((G2.get_underlying_matrix() * Y_map.cast<double>().transpose()).transpose().rowwise() +
+           G2.get_translation()._eigen())
+              .cast<float>();
+  EXPECT_LT(calc_rmsd(future::Span(X), future::Span(Y)), 1e-5);
+
+  std::vector<float> Z(6);
+  EXPECT_THROW(static_cast<void>(calc_rmsd(future::Span(X), future::Span(Z))), GeomError);
+}
+
 TEST_F(GeomTests, calc_intertia_tensor) {
   {
     double data[] = {0, 1, 0, 1, 0, 0, -1, 0, 0, 0, -1, 0};
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
-#include <memory>
+#include <cstring>
+#include <fstream>
 
 #include "xmol/trajectory/Trajectory.h"
 #include "xmol/io/TrjtoolDatFile.h"
@@ -46,6 +47,54 @@ TEST_F(TrjtoolDatFileTests, read) {
   EXPECT_LE((expected - actual).len(), 1e-3);
 }
 
+TEST_F(TrjtoolDatFileTests, big_endian) {
+  std::string filename("trjtool/GB1/run00001.dat");
+  std::string swapped_filename("run00001.swapped.dat");
+  {
+    std::ifstream in(filename, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ASSERT_GE(bytes.size(), 12);
+    auto swap_word = [&bytes](size_t pos) { std::reverse(bytes.begin() + pos, bytes.begin() + pos + 4); };
+    int32_t nitems;
+    std::memcpy(&nitems, bytes.data(), sizeof(nitems));
+    size_t pos = 0;
+    for (; pos < 12; pos += 4) {
+      swap_word(pos);
+    }
+    for (int i = 0; i < nitems; ++i) {
+      int32_t info_len;
+      std::memcpy(&info_len, bytes.data() + pos, sizeof(info_len));
+      swap_word(pos);
+      pos += 4 + info_len;
+    }
+    for (; pos < bytes.size(); pos += 4) {
+      swap_word(pos);
+    }
+    std::ofstream(swapped_filename, std::ios::binary).write(bytes.data(), bytes.size());
+  }
+
+  io::TrjtoolDatFile native(filename);
+  io::TrjtoolDatFile swapped(swapped_filename);
+  EXPECT_FALSE(native.is_byte_swapped());
+  EXPECT_TRUE(swapped.is_byte_swapped());
+  EXPECT_EQ(swapped.n_frames(), native.n_frames());
+  EXPECT_EQ(swapped.n_atoms(), native.n_atoms());
+
+  Frame frame = io::PdbInputFile("trjtool/GB1/run00001.pdb", io::PdbInputFile::Dialect::AMBER_99).frames()[0];
+  Frame swapped_frame = frame;
+  native.advance(7);
+  swapped.advance(7);
+  native.read_frame(7, frame);
+  swapped.read_frame(7, swapped_frame);
+  EXPECT_EQ((frame.coords()._eigen() - swapped_frame.coords()._eigen()).cwiseAbs().maxCoeff(), 0);
+
+  float x;
+  std::memcpy(&x, native.raw_frame(7), sizeof(x));
+  EXPECT_EQ(x, frame.coords()[0].x());
+  EXPECT_THROW(static_cast<void>(native.raw_frame(native.n_frames())), std::out_of_range);
+  std::remove(swapped_filename.c_str());
+}
+
 TEST_F(TrjtoolDatFileTests, trajectory_traverse) {
   Trajectory traj = construct_trajectory();
   {
@@ -88,6 +137,14 @@ TEST_F(TrjtoolDatFileTests, trajectory_traverse) {
     }
     EXPECT_EQ(count, 950) << "traj[100::2]";
   }
+  {
+    int count = 0;
+    for (auto& frame : traj.slice(1, {}, 3)) {
+      EXPECT_EQ(frame.index, 1 + 3 * count);
+      count += 1;
+    }
+    EXPECT_EQ(count, 667) << "traj[1::3]";
+  }
   for (int i = 0; i < 3; i++) {
     int count = 0;
     for (auto& _ : traj.slice(100, 200, 2)) {
@@ -115,16 +172,3 @@ TEST_F(TrjtoolDatFileTests, trajectory_traverse) {
     EXPECT_EQ(count, 25) << "traj[100:200:2] with throw";
   }
 }
-
-TEST_F(TrjtoolDatFileTests, double_penetration) {
-  Trajectory traj = construct_trajectory();
-  auto dp = [&traj] {
-    for (auto& x : traj) {
-      static_cast<void>(x);
-      for (auto& y : traj) {
-        static_cast<void>(y);
-      }
-    }
-  };
-  EXPECT_THROW(dp(), TrajectoryDoubleTraverseError);
-}
\ No newline at end of file
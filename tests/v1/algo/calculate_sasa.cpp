@@ -23,6 +23,26 @@ TEST_F(calculate_sasa_Tests, test1) {
   EXPECT_DOUBLE_EQ(result[0], result[1]);
 }
 
+TEST_F(calculate_sasa_Tests, single_precision) {
+  std::vector<double> radii = {1.0, 1.5, 1.2};
+  std::vector<XYZ> coords = {XYZ(0, 0, 0), XYZ(0.5, 0, 1.25), XYZ(-1, 0.75, 0.5)};
+  std::vector<float> flat = {0, 0, 0, 0.5, 0, 1.25, -1, 0.75, 0.5};
+  std::vector<double> expected(3);
+  std::vector<double> result(3);
+  calc_sasa(coords, Span(radii), 0.5, Span(expected));
+  calc_sasa(Span(flat), Span(radii), 0.5, Span(result));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_DOUBLE_EQ(result[i], expected[i]) << i;
+  }
+  std::vector<int> indices = {2};
+  std::vector<double> one(1);
+  calc_sasa(Span(flat), Span(radii), 0.5, Span(one), 20, Span(indices));
+  EXPECT_DOUBLE_EQ(one[0], expected[2]);
+
+  std::vector<float> bad(4);
+  EXPECT_THROW(calc_sasa(Span(bad), Span(radii), 0.5, Span(result)), GeomError);
+}
+
 TEST_F(calculate_sasa_Tests, calc_sasa_on_pdb) {
   auto files = {
       "pdb/rcsb/1PGB.pdb",
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include "xmol/io/DcdFile.h"
+#include "xmol/trajectory/Trajectory.h"
+#include "test_common.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using ::testing::Test;
+using namespace xmol::io;
+using namespace xmol;
+
+namespace {
+
+/// Minimal CHARMM-style DCD writer for tests
+class DcdTestWriter {
+public:
+  DcdTestWriter(bool big_endian, size_t marker_size, bool with_cell, std::vector<int32_t> free_atoms)
+      : m_big_endian(big_endian), m_marker_size(marker_size), m_with_cell(with_cell),
+        m_free_atoms(std::move(free_atoms)) {}
+
+  std::string write(const std::string& filename, const std::vector<std::vector<float>>& frames, size_t n_atoms) {
+    std::string out;
+    std::string header("CORD");
+    int32_t control[20] = {};
+    control[0] = frames.size();
+    control[1] = 100; // first step
+    control[2] = 10;  // steps per frame
+    control[8] = m_free_atoms.empty() ? 0 : n_atoms - m_free_atoms.size(); // fixed atoms
+    float delta = 2.0;
+    std::memcpy(&control[9], &delta, sizeof(delta));
+    control[10] = m_with_cell;
+    control[19] = 24; // CHARMM version
+    for (auto value : control) {
+      append(header, value);
+    }
+    record(out, header);
+
+    std::string title;
+    append(title, int32_t{1});
+    title += std::string(80, ' ');
+    record(out, title);
+
+    std::string atoms;
+    append(atoms, static_cast<int32_t>(n_atoms));
+    record(out, atoms);
+
+    if (!m_free_atoms.empty()) {
+      std::string free;
+      for (auto index : m_free_atoms) {
+        append(free, index + 1);
+      }
+      record(out, free);
+    }
+
+    for (size_t f = 0; f < frames.size(); ++f) {
+      if (m_with_cell) {
+        std::string cell;
+        for (double value : {30.0 + f, 0.0, 40.0, 0.0, 0.0, 50.0}) { // cosines of 90 degrees
+          append(cell, value);
+        }
+        record(out, cell);
+      }
+      for (size_t dim = 0; dim < 3; ++dim) {
+        std::string component;
+        for (size_t i = 0; i < n_atoms; ++i) {
+          if (f == 0 || m_free_atoms.empty() ||
+              std::find(m_free_atoms.begin(), m_free_atoms.end(), i) != m_free_atoms.end()) {
+            append(component, frames[f][i * 3 + dim]);
+          }
+        }
+        record(out, component);
+      }
+    }
+    std::ofstream(filename, std::ios::binary) << out;
+    return filename;
+  }
+
+private:
+  bool m_big_endian;
+  size_t m_marker_size;
+  bool m_with_cell;
+  std::vector<int32_t> m_free_atoms;
+
+  template <typename T> void append(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    if (m_big_endian) {
+      std::reverse(bytes, bytes + sizeof(T));
+    }
+    out.append(bytes, sizeof(T));
+  }
+
+  void record(std::string& out, const std::string& payload) {
+    auto marker = [&] {
+      if (m_marker_size == 4) {
+        append(out, static_cast<uint32_t>(payload.size()));
+      } else {
+        append(out, static_cast<uint64_t>(payload.size()));
+      }
+    };
+    marker();
+    out += payload;
+    marker();
+  }
+};
+
+} // namespace
+
+class DcdFileTests : public Test {
+public:
+  DcdFileTests() {
+    test::add_polyglycines({{"A", 5}}, frame);
+    for (size_t f = 0; f < 7; ++f) {
+      frames.emplace_back(frame.n_atoms() * 3);
+      for (size_t i = 0; i < frames.back().size(); ++i) {
+        frames.back()[i] = 0.5f * i + f;
+      }
+    }
+  }
+
+  Frame frame;
+  std::vector<std::vector<float>> frames;
+};
+
+TEST_F(DcdFileTests, read) {
+  for (bool big_endian : {false, true}) {
+    for (size_t marker_size : {4, 8}) {
+      for (bool with_cell : {false, true}) {
+        auto filename = DcdTestWriter(big_endian, marker_size, with_cell, {})
+                            .write("test.dcd", frames, frame.n_atoms());
+        DcdFile dcd(filename);
+        EXPECT_EQ(dcd.n_atoms(), frame.n_atoms());
+        EXPECT_EQ(dcd.n_frames(), frames.size());
+        EXPECT_EQ(dcd.has_cell(), with_cell);
+        EXPECT_EQ(dcd.n_fixed_atoms(), 0);
+
+        trajectory::Trajectory traj(frame);
+        traj.extend(std::move(dcd));
+        size_t count = 0;
+        for (auto& f : traj.slice(1, {}, 2)) {
+          auto& expected = frames[f.index];
+          auto coords = f.coords()._eigen();
+          for (size_t i = 0; i < f.n_atoms(); ++i) {
+            for (int k = 0; k < 3; ++k) {
+              EXPECT_EQ(coords(i, k), expected[i * 3 + k]);
+            }
+          }
+          EXPECT_DOUBLE_EQ(f.time, (100 + 10 * f.index) * 2.0 * 0.04888821);
+          if (with_cell) {
+            EXPECT_NEAR(f.cell.a(), 30.0 + f.index, 1e-9);
+            EXPECT_NEAR(f.cell.c(), 50.0, 1e-9);
+            EXPECT_NEAR(f.cell.alpha().degrees(), 90.0, 1e-9);
+          }
+          ++count;
+        }
+        EXPECT_EQ(count, 3);
+      }
+    }
+  }
+  std::remove("test.dcd");
+}
+
+TEST_F(DcdFileTests, fixed_atoms) {
+  std::vector<int32_t> free_atoms{1, 2, 7, 10};
+  auto filename = DcdTestWriter(false, 4, true, free_atoms).write("test_fixed.dcd", frames, frame.n_atoms());
+  DcdFile dcd(filename);
+  EXPECT_EQ(dcd.n_fixed_atoms(), frame.n_atoms() - free_atoms.size());
+  EXPECT_EQ(dcd.n_frames(), frames.size());
+
+  trajectory::Trajectory traj(frame);
+  traj.extend(std::move(dcd));
+  std::vector<AtomIndex> selection{0, 2, 10, 11};
+  for (auto& f : traj.select_atoms(selection)) {
+    auto coords = f.coords()._eigen();
+    for (size_t i = 0; i < selection.size(); ++i) {
+      bool is_free = std::find(free_atoms.begin(), free_atoms.end(), selection[i]) != free_atoms.end();
+      auto& expected = frames[is_free ? f.index : 0];
+      for (int k = 0; k < 3; ++k) {
+        EXPECT_EQ(coords(i, k), expected[selection[i] * 3 + k]);
+      }
+    }
+  }
+  for (auto& f : traj) {
+    auto coords = f.coords()._eigen();
+    for (size_t i = 0; i < f.n_atoms(); ++i) {
+      bool is_free = std::find(free_atoms.begin(), free_atoms.end(), i) != free_atoms.end();
+      auto& expected = frames[is_free ? f.index : 0];
+      for (int k = 0; k < 3; ++k) {
+        EXPECT_EQ(coords(i, k), expected[i * 3 + k]);
+      }
+    }
+  }
+  std::remove("test_fixed.dcd");
+}
+
+TEST_F(DcdFileTests, bad_file) {
+  std::ofstream("test_bad.dcd", std::ios::binary) << std::string(100, 'x');
+  EXPECT_THROW(DcdFile("test_bad.dcd"), std::runtime_error);
+  std::remove("test_bad.dcd");
+}
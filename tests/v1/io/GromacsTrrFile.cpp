@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include "xmol/io/GromacsTrrFile.h"
+#include "xmol/io/xdr/TrrWriter.h"
+#include "xmol/trajectory/Trajectory.h"
+#include "test_common.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using ::testing::Test;
+using namespace xmol::io;
+using namespace xmol;
+
+class GromacsTrrFileTests : public Test {
+public:
+  GromacsTrrFileTests() { test::add_polyglycines({{"A", 5}}, frame); }
+
+  /// Writes 7 frames, velocities are present in even frames, forces in every frame
+  void write_trajectory(const std::string& filename, bool double_precision) {
+    xdr::TrrWriter writer(filename, double_precision);
+    for (size_t f = 0; f < 7; ++f) {
+      frame.index = f;
+      frame.time = 0.5 * f;
+      frame.cell = geom::UnitCell(30.0 + f, 40, 50, geom::Degrees(90), geom::Degrees(90), geom::Degrees(90));
+      auto coords = frame.coords()._eigen();
+      for (size_t i = 0; i < frame.n_atoms(); ++i) {
+        for (int k = 0; k < 3; ++k) {
+          coords(i, k) = value(f, i, k);
+        }
+      }
+      auto velocities = vectors(f, 1);
+      auto forces = vectors(f, 2);
+      writer.write(frame, f % 2 == 0 ? future::Span<const double>(velocities.data(), velocities.size())
+                                     : future::Span<const double>{},
+                   future::Span<const double>(forces.data(), forces.size()));
+    }
+  }
+
+  static double value(size_t f, size_t i, int k) { return 0.123456789 * i + 1.1 * k + f; }
+
+  std::vector<double> vectors(size_t f, double factor) const {
+    std::vector<double> result(frame.n_atoms() * 3);
+    for (size_t i = 0; i < result.size(); ++i) {
+      result[i] = factor * (0.25 * i - f);
+    }
+    return result;
+  }
+
+  Frame frame;
+};
+
+TEST_F(GromacsTrrFileTests, read_write) {
+  for (bool double_precision : {false, true}) {
+    const double tolerance = double_precision ? 1e-12 : 1e-5;
+    write_trajectory("test.trr", double_precision);
+
+    GromacsTrrFile trr("test.trr");
+    EXPECT_EQ(trr.n_frames(), 7);
+    EXPECT_EQ(trr.n_atoms(), frame.n_atoms());
+    EXPECT_EQ(trr.is_double_precision(), double_precision);
+    EXPECT_TRUE(trr.has_velocities());
+    EXPECT_TRUE(trr.has_forces());
+
+    Frame frame_vf = frame;
+    frame_vf.add_velocities();
+    frame_vf.add_forces();
+
+    trr.advance(3); // seek
+    trr.read_frame(3, frame_vf);
+    EXPECT_DOUBLE_EQ(frame_vf.time, 1.5);
+    EXPECT_NEAR(frame_vf.cell.a(), 33.0, tolerance);
+    EXPECT_NEAR(frame_vf.coords()._eigen()(4, 2), value(3, 4, 2), tolerance * 10);
+    EXPECT_DOUBLE_EQ(frame_vf.velocities()._eigen().norm(), 0);
+    EXPECT_NEAR(frame_vf.forces()[1].y(), vectors(3, 2)[4], tolerance * 10);
+
+    trr.advance(1); // sequential read
+    trr.read_frame(4, frame_vf);
+    EXPECT_NEAR(frame_vf.velocities()[2].y(), vectors(4, 1)[7], tolerance * 10);
+
+    trr.advance(1);
+    trr.read_frame(5, frame); // vectors are skipped
+    EXPECT_FALSE(frame.has_velocities());
+    EXPECT_NEAR(frame.coords()._eigen()(2, 0), value(5, 2, 0), tolerance * 10);
+    trr.advance(trr.n_frames()); // rewind
+
+    trajectory::Trajectory traj(frame);
+    traj.extend(std::move(trr));
+    size_t count = 0;
+    for (auto& f : traj.slice(1, {}, 2)) {
+      auto coords = f.coords()._eigen();
+      for (size_t i = 0; i < f.n_atoms(); ++i) {
+        for (int k = 0; k < 3; ++k) {
+          EXPECT_NEAR(coords(i, k), value(f.index, i, k), tolerance * 10);
+        }
+      }
+      EXPECT_DOUBLE_EQ(f.time, 0.5 * f.index);
+      ++count;
+    }
+    EXPECT_EQ(count, 3);
+
+    std::vector<AtomIndex> selection{0, 2, 10, 11};
+    for (auto& f : traj.select_atoms(selection)) {
+      auto coords = f.coords()._eigen();
+      for (size_t i = 0; i < selection.size(); ++i) {
+        EXPECT_NEAR(coords(i, 1), value(f.index, selection[i], 1), tolerance * 10);
+      }
+    }
+
+    std::vector<float> coords(traj.n_frames() * traj.n_atoms() * 3);
+    traj.slice().read_coords(future::Span<float>(coords.data(), coords.size()));
+    EXPECT_NEAR(coords[(6 * traj.n_atoms() + 3) * 3 + 1], value(6, 3, 1), 1e-4);
+  }
+  std::remove("test.trr");
+}
+
+TEST_F(GromacsTrrFileTests, selected_atoms_velocities) {
+  write_trajectory("test_select.trr", false);
+  GromacsTrrFile trr("test_select.trr");
+  Frame selected;
+  test::add_polyglycines({{"A", 1}}, selected);
+  selected.add_velocities();
+  selected.add_forces();
+  std::vector<AtomIndex> selection{1, 4, 9, 10, 17, 20, 33};
+  ASSERT_EQ(selected.n_atoms(), selection.size());
+
+  trr.advance(0);
+  trr.read_frame_atoms(0, selection, selected);
+  for (size_t i = 0; i < selection.size(); ++i) {
+    EXPECT_NEAR(selected.coords()._eigen()(i, 0), value(0, selection[i], 0), 1e-4);
+    EXPECT_NEAR(selected.velocities()[i].z(), vectors(0, 1)[selection[i] * 3 + 2], 1e-5);
+    EXPECT_NEAR(selected.forces()[i].x(), vectors(0, 2)[selection[i] * 3], 1e-5);
+  }
+  std::remove("test_select.trr");
+}
+
+TEST_F(GromacsTrrFileTests, prefetch_velocities) {
+  write_trajectory("test_prefetch.trr", false);
+  frame.add_velocities();
+  frame.add_forces();
+  trajectory::Trajectory traj(frame);
+  traj.extend(GromacsTrrFile("test_prefetch.trr"));
+  for (size_t depth : {0, 2}) {
+    size_t count = 0;
+    for (auto& f : traj.prefetch(depth)) {
+      ASSERT_TRUE(f.has_velocities());
+      ASSERT_TRUE(f.has_forces());
+      const double v = f.index % 2 == 0 ? vectors(f.index, 1)[7] : 0.0;
+      EXPECT_NEAR(f.velocities()[2].y(), v, 1e-5) << depth << " " << f.index;
+      EXPECT_NEAR(f.forces()[1].y(), vectors(f.index, 2)[4], 1e-5) << depth << " " << f.index;
+      ++count;
+    }
+    EXPECT_EQ(count, 7);
+  }
+  std::remove("test_prefetch.trr");
+}
+
+TEST_F(GromacsTrrFileTests, prefetch_add_velocities_mid_iteration) {
+  write_trajectory("test_prefetch_add.trr", false);
+  for (size_t step : {1, 2}) {
+    for (size_t depth : {1, 4}) {
+      trajectory::Trajectory traj(frame);
+      traj.extend(GromacsTrrFile("test_prefetch_add.trr"));
+      traj.extend(GromacsTrrFile("test_prefetch_add.trr"));
+      size_t expected_index = 0;
+      for (auto& f : traj.slice(0, {}, step).prefetch(depth)) {
+        // frames ahead of 5th are already read without velocities, some of them from the second file
+        ASSERT_EQ(f.index, expected_index) << step << " " << depth;
+        const size_t f_in_file = f.index % 7;
+        EXPECT_NEAR(f.coords()._eigen()(3, 1), value(f_in_file, 3, 1), 1e-4) << step << " " << depth;
+        if (f.index > 5) {
+          ASSERT_TRUE(f.has_velocities());
+          const double v = f_in_file % 2 == 0 ? vectors(f_in_file, 1)[7] : 0.0;
+          EXPECT_NEAR(f.velocities()[2].y(), v, 1e-5) << step << " " << depth << " " << f.index;
+        }
+        if (f.index == 5 || f.index == 4) {
+          f.add_velocities();
+        }
+        expected_index += step;
+      }
+      EXPECT_EQ(expected_index, (14 + step - 1) / step * step);
+    }
+  }
+  std::remove("test_prefetch_add.trr");
+}
+
+TEST_F(GromacsTrrFileTests, frames_without_coordinates) {
+  write_trajectory("test_no_x.trr", false);
+  xdr::FrameOffsetIndex offsets;
+  ASSERT_TRUE(!!xdr::TrrReader("test_no_x.trr").scan(offsets));
+  ASSERT_EQ(offsets.n_frames(), 7);
+  {
+    frame.time = 99;
+    auto velocities = vectors(0, 1);
+    xdr::TrrWriter("test_v.trr", false).write(frame, future::Span<const double>(velocities.data(), velocities.size()),
+                                              {});
+  }
+  auto read_bytes = [](const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    return std::string{std::istreambuf_iterator<char>(in), {}};
+  };
+  // drop x block of single precision frame: 84 bytes of header (`x_size` at 52) followed by 36 bytes of box
+  auto velocity_only = read_bytes("test_v.trr");
+  velocity_only.replace(52, 4, std::string(4, '\0'));
+  velocity_only.erase(84 + 36, frame.n_atoms() * 3 * sizeof(float));
+  auto bytes = read_bytes("test_no_x.trr");
+  bytes.insert(offsets[3], velocity_only);
+  bytes.insert(offsets[0], velocity_only);
+  std::ofstream("test_no_x.trr", std::ios::binary) << bytes;
+
+  GromacsTrrFile trr("test_no_x.trr");
+  EXPECT_EQ(trr.n_frames(), 7);
+  EXPECT_EQ(trr.n_atoms(), frame.n_atoms());
+  trajectory::Trajectory traj(frame);
+  traj.extend(std::move(trr));
+  for (auto& f : traj) {
+    EXPECT_DOUBLE_EQ(f.time, 0.5 * f.index);
+    EXPECT_NEAR(f.coords()._eigen()(3, 1), value(f.index, 3, 1), 1e-4);
+  }
+  std::remove("test_no_x.trr");
+  std::remove("test_v.trr");
+}
+
+TEST_F(GromacsTrrFileTests, bad_file) {
+  std::ofstream("test_bad.trr", std::ios::binary) << std::string(100, 'x');
+  EXPECT_THROW(GromacsTrrFile("test_bad.trr"), TrrReadError);
+  std::remove("test_bad.trr");
+}
+
+TEST_F(GromacsTrrFileTests, truncated_file) {
+  write_trajectory("test_truncated.trr", false);
+  xdr::FrameOffsetIndex offsets;
+  ASSERT_TRUE(!!xdr::TrrReader("test_truncated.trr").scan(offsets));
+  ASSERT_EQ(offsets.n_frames(), 7);
+  std::ifstream in("test_truncated.trr", std::ios::binary);
+  const std::string bytes{std::istreambuf_iterator<char>(in), {}};
+
+  // last frame is cut in magic, header and data (e.g. by crashed mdrun)
+  for (size_t shift : {2, 20, 100}) {
+    std::ofstream("test_truncated_prefix.trr", std::ios::binary) << bytes.substr(0, offsets[6] + shift);
+    GromacsTrrFile trr("test_truncated_prefix.trr");
+    EXPECT_EQ(trr.n_frames(), 6) << shift;
+  }
+  std::ofstream("test_truncated_prefix.trr", std::ios::binary) << bytes.substr(0, 20);
+  EXPECT_THROW(GromacsTrrFile("test_truncated_prefix.trr"), TrrReadError); // first frame is cut
+  std::remove("test_truncated.trr");
+  std::remove("test_truncated_prefix.trr");
+}
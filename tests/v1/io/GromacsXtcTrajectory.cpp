@@ -2,7 +2,14 @@
 
 #include "xmol/io/GromacsXtcFile.h"
 #include "xmol/io/PdbInputFile.h"
+#include "xmol/io/xdr/XtcWriter.h"
 #include "xmol/trajectory/Trajectory.h"
+#include "test_common.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 
 using ::testing::Test;
 using namespace xmol::io;
@@ -25,6 +32,148 @@ TEST_F(GromacsXtcTrajectoryFileTests, constructor) {
   EXPECT_EQ(xtcFile.n_frames(), 51);
 }
 
+TEST_F(GromacsXtcTrajectoryFileTests, constructor_without_n_frames) {
+  GromacsXtcFile xtcFile(xtc_corrected);
+  EXPECT_EQ(xtcFile.n_atoms(), 2504);
+  EXPECT_EQ(xtcFile.n_frames(), 51);
+
+  EXPECT_EQ(GromacsXtcFile(xtc_corrected, 10).n_frames(), 10);
+  EXPECT_THROW(GromacsXtcFile(xtc_corrected, 52), XtcReadError);
+}
+
+TEST_F(GromacsXtcTrajectoryFileTests, index_file) {
+  const std::string index_filename = "1am7_corrected.xtc.idx";
+  std::remove(index_filename.c_str());
+  {
+    GromacsXtcFile xtcFile(xtc_corrected, index_filename);
+    EXPECT_EQ(xtcFile.n_frames(), 51);
+  }
+  auto offsets = xdr::FrameOffsetIndex::load(index_filename, xtc_corrected);
+  ASSERT_TRUE(offsets);
+  EXPECT_EQ(offsets->n_frames(), 51);
+  EXPECT_EQ((*offsets)[0], 0);
+  EXPECT_FALSE(xdr::FrameOffsetIndex::load(index_filename, pdb_filename)); // stamp mismatch
+  {
+    GromacsXtcFile xtcFile(xtc_corrected, index_filename);
+    EXPECT_EQ(xtcFile.n_frames(), 51);
+  }
+  std::remove(index_filename.c_str());
+}
+
+TEST_F(GromacsXtcTrajectoryFileTests, frame_times) {
+  Frame frame;
+  test::add_polyglycines({{"A", 3}}, frame);
+  {
+    xdr::XtcWriter writer("test_times.xtc", 1000);
+    for (int i = 0; i < 5; i++) {
+      frame.time = 100 + 2.5 * i;
+      writer.write(frame);
+    }
+  }
+  for (int pass = 0; pass < 2; ++pass) { // times are scanned, then loaded from index file
+    GromacsXtcFile xtc("test_times.xtc", "test_times.xtc.idx");
+    ASSERT_EQ(xtc.n_frames(), 5);
+    for (size_t i = 0; i < 5; i++) {
+      ASSERT_TRUE(xtc.frame_time(i));
+      EXPECT_FLOAT_EQ(*xtc.frame_time(i), 100 + 2.5 * i);
+    }
+  }
+  std::remove("test_times.xtc");
+  std::remove("test_times.xtc.idx");
+}
+
+TEST_F(GromacsXtcTrajectoryFileTests, damaged_index_file) {
+  Frame frame;
+  test::add_polyglycines({{"A", 3}}, frame);
+  {
+    xdr::XtcWriter writer("test_damaged.xtc", 1000);
+    for (int i = 0; i < 3; i++) {
+      writer.write(frame);
+    }
+  }
+  static_cast<void>(GromacsXtcFile("test_damaged.xtc", "test_damaged.xtc.idx"));
+  auto read_bytes = [] {
+    std::ifstream in("test_damaged.xtc.idx", std::ios::binary);
+    return std::string{std::istreambuf_iterator<char>(in), {}};
+  };
+  const auto bytes = read_bytes();
+  ASSERT_TRUE(xdr::FrameOffsetIndex::load("test_damaged.xtc.idx", "test_damaged.xtc"));
+
+  // magic, file size and mtime are followed by number of frames and offsets
+  constexpr size_t n_frames_pos = 8 + 8 + 8;
+  constexpr size_t offsets_pos = n_frames_pos + 8;
+  auto expect_rejected = [](const std::string& damaged, const char* what) {
+    // writing index changes its own mtime only, stamp of trajectory is still valid
+    std::ofstream("test_damaged.xtc.idx", std::ios::binary | std::ios::trunc) << damaged;
+    EXPECT_FALSE(xdr::FrameOffsetIndex::load("test_damaged.xtc.idx", "test_damaged.xtc")) << what;
+  };
+  auto with = [&bytes](size_t pos, std::uint64_t value) {
+    auto result = bytes;
+    std::memcpy(&result[pos], &value, sizeof(value));
+    return result;
+  };
+  expect_rejected(with(n_frames_pos, std::uint64_t(1) << 61), "overflowing number of frames");
+  expect_rejected(with(offsets_pos + 8, 0), "non-increasing offsets");
+  expect_rejected(with(offsets_pos + 16, std::uint64_t(1) << 40), "offset beyond end of file");
+  expect_rejected(with(offsets_pos, std::uint64_t(-1)), "negative offset");
+
+  GromacsXtcFile xtc("test_damaged.xtc", "test_damaged.xtc.idx"); // damaged index is rebuilt
+  EXPECT_EQ(xtc.n_frames(), 3);
+  EXPECT_EQ(read_bytes(), bytes);
+  std::remove("test_damaged.xtc");
+  std::remove("test_damaged.xtc.idx");
+}
+
+TEST_F(GromacsXtcTrajectoryFileTests, strided_slice) {
+  trajectory::Trajectory traj(frame);
+  traj.extend(GromacsXtcFile(xtc_corrected));
+  std::vector<XYZ> expected;
+  for (auto& f : traj) {
+    if (f.index % 7 == 3) {
+      expected.push_back(f.coords()[0]);
+    }
+  }
+  int n = 0;
+  for (auto& f : traj.slice(3, {}, 7)) {
+    ASSERT_LT(n, expected.size());
+    EXPECT_LE((f.coords()[0] - expected[n]).len(), 1e-6);
+    ++n;
+  }
+  EXPECT_EQ(n, expected.size());
+}
+
+TEST_F(GromacsXtcTrajectoryFileTests, read_frames) {
+  GromacsXtcFile xtc(xtc_corrected);
+  const size_t n_atoms = xtc.n_atoms();
+  const size_t begin = 2, end = 51, stride = 3, n_selected = (end - begin + stride - 1) / stride;
+  std::vector<float> batch(n_selected * n_atoms * 3);
+  xtc.read_frames(begin, end, stride, batch.data(), 4);
+
+  trajectory::Trajectory traj(frame);
+  traj.extend(GromacsXtcFile(xtc_corrected));
+  size_t k = 0;
+  for (auto& f : traj.slice(begin, end, stride)) {
+    ASSERT_LT(k, n_selected);
+    CoordEigenMatrixMapf batch_map(batch.data() + k * n_atoms * 3, n_atoms, 3);
+    EXPECT_LE((batch_map.cast<double>() - f.coords()._eigen()).cwiseAbs().maxCoeff(), 1e-4);
+    ++k;
+  }
+  EXPECT_EQ(k, n_selected);
+  EXPECT_THROW(xtc.read_frames(0, 52, 1, batch.data()), std::out_of_range);
+}
+
+TEST_F(GromacsXtcTrajectoryFileTests, read_coords) {
+  GromacsXtcFile xtc(xtc_corrected);
+  GromacsXtcFile xtc_f(xtc_corrected);
+  std::vector<float> coords(xtc.n_atoms() * 3);
+  xtc.advance(5);
+  xtc_f.advance(5);
+  xtc.read_frame(5, frame);
+  xtc_f.read_coords(5, coords);
+  CoordEigenMatrixMapf coords_map(coords.data(), xtc.n_atoms(), 3);
+  EXPECT_LE((coords_map.cast<double>() - frame.coords()._eigen()).cwiseAbs().maxCoeff(), 1e-4);
+}
+
 TEST_F(GromacsXtcTrajectoryFileTests, trajectory) {
   trajectory::Trajectory traj(frame);
   traj.extend(GromacsXtcFile(xtc_corrected, 51));
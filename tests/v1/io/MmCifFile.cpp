@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include "xmol/io/MmCifFile.h"
+#include "xmol/io/cif/exceptions.h"
+#include "xmol/trajectory/Trajectory.h"
+
+#include <cstdio>
+#include <fstream>
+
+using ::testing::Test;
+using namespace xmol::io;
+using namespace xmol;
+
+class MmCifFileTests : public Test {
+public:
+  static void write(const std::string& filename, const std::string& text) { std::ofstream(filename) << text; }
+
+  /// @p n_models models of 3 atoms, the second atom is HETATM
+  static std::string models(int n_models) {
+    std::string text = "data_TEST\n"
+                       "_cell.length_a 30.0\n"
+                       "_cell.length_b 40.0\n"
+                       "_cell.length_c 50.0\n"
+                       "#\n"
+                       "loop_\n"
+                       "_atom_site.group_PDB\n"
+                       "_atom_site.id\n"
+                       "_atom_site.label_atom_id\n"
+                       "_atom_site.label_comp_id\n"
+                       "_atom_site.label_asym_id\n"
+                       "_atom_site.label_seq_id\n"
+                       "_atom_site.Cartn_x\n"
+                       "_atom_site.Cartn_y\n"
+                       "_atom_site.Cartn_z\n"
+                       "_atom_site.pdbx_PDB_model_num\n";
+    for (int m = 0; m < n_models; ++m) {
+      char lines[400];
+      std::snprintf(lines, sizeof(lines),
+                    "ATOM   1 N  GLY A 1 %.3f %.3f %.3f %d\n"
+                    "HETATM 2 O  HOH B . %.3f %.3f %.3f %d\n"
+                    "ATOM   3 CA GLY C 3 %.3f %.3f %.3f %d\n",
+                    1.0 * m, 2.0, 3.0, m + 1, 4.0, -1.0 * m, 6.0, m + 1, 7.0, 8.0, 0.5 * m, m + 1);
+      text += lines;
+    }
+    return text + "#\n";
+  }
+};
+
+TEST_F(MmCifFileTests, read) {
+  write("test_models.cif", models(20));
+  MmCifFile file("test_models.cif");
+  auto frames = file.frames();
+  ASSERT_EQ(file.n_frames(), 20);
+  ASSERT_EQ(frames.size(), 20);
+  ASSERT_EQ(file.n_atoms(), 3);
+
+  trajectory::Trajectory traj(file.frame(0));
+  traj.extend(MmCifFile("test_models.cif"));
+  ASSERT_EQ(traj.n_frames(), frames.size());
+  for (auto& f : traj) {
+    auto& expected = frames[f.index];
+    EXPECT_TRUE(f.coords()._eigen().isApprox(expected.coords()._eigen())) << f.index;
+    EXPECT_EQ(f.coords()[0].x(), 1.0 * f.index);
+    EXPECT_EQ(f.coords()[2].z(), 0.5 * f.index);
+    EXPECT_DOUBLE_EQ(f.cell.volume(), 30.0 * 40.0 * 50.0);
+  }
+
+  Frame out = file.frame(0);
+  for (size_t i : {17, 3, 9, 0}) { // random access
+    traj.read_into(i, out);
+    EXPECT_TRUE(out.coords()._eigen().isApprox(frames[i].coords()._eigen())) << i;
+  }
+
+  auto frame = file.frame(13);
+  EXPECT_EQ(frame.n_molecules(), 3);
+  EXPECT_EQ(frame.residues()[1].name(), ResidueName("HOH"));
+  EXPECT_TRUE(frame.coords()._eigen().isApprox(frames[13].coords()._eigen()));
+  EXPECT_THROW(static_cast<void>(file.frame(20)), std::out_of_range);
+  std::remove("test_models.cif");
+}
+
+TEST_F(MmCifFileTests, wrong_number_of_atoms) {
+  auto text = models(3);
+  text.insert(text.rfind("#\n"), "ATOM   4 C  GLY C 3 1.0 1.0 1.0 3\n");
+  write("test_models_mismatch.cif", text);
+  trajectory::Trajectory traj(MmCifFile("test_models_mismatch.cif").frame(0));
+  traj.extend(MmCifFile("test_models_mismatch.cif"));
+  auto it = traj.begin();
+  ++it;
+  EXPECT_THROW(++it, cif::CifException);
+  std::remove("test_models_mismatch.cif");
+}
+
+TEST_F(MmCifFileTests, non_existent_file) {
+  EXPECT_THROW(MmCifFile("does_not_exist.cif"), cif::CifException);
+}
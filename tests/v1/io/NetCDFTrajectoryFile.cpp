@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 
 #include "xmol/io/AmberNetCDF.h"
+#include "xmol/io/AmberNetCDFWriter.h"
 #include "xmol/io/PdbInputFile.h"
 #include "xmol/trajectory/Trajectory.h"
+#include "test_common.h"
+
+#include <cstdio>
+#include <random>
 
 using ::testing::Test;
 using namespace xmol::io;
@@ -61,6 +66,156 @@ TEST_F(AmberNetCDFTrajectoryFileTests, read_coordinates_and_cell) {
   }
 }
 
+TEST_F(AmberNetCDFTrajectoryFileTests, block_reads) {
+  trajectory::Trajectory single_frame_reads(frame);
+  single_frame_reads.extend(AmberNetCDF(nc_filename, 1));
+  single_frame_reads.extend(AmberNetCDF(nc_filename, 1));
+
+  trajectory::Trajectory block_reads(frame);
+  block_reads.extend(AmberNetCDF(nc_filename, 4));
+  block_reads.extend(AmberNetCDF(nc_filename, 4));
+
+  for (size_t step : {1, 2, 3, 7}) {
+    std::vector<Frame> expected;
+    for (auto& f : single_frame_reads.slice(1, {}, step)) {
+      expected.push_back(f);
+    }
+    size_t i = 0;
+    for (auto& f : block_reads.slice(1, {}, step)) {
+      ASSERT_LT(i, expected.size());
+      EXPECT_EQ((f.coords()._eigen() - expected[i].coords()._eigen()).cwiseAbs().maxCoeff(), 0);
+      EXPECT_EQ(f.cell.a(), expected[i].cell.a());
+      EXPECT_EQ(f.time, expected[i].time);
+      ++i;
+    }
+    EXPECT_EQ(i, expected.size());
+  }
+}
+
+TEST_F(AmberNetCDFTrajectoryFileTests, write) {
+  const char* const output_filename = "GB1_F30C_MTSL_copy.nc";
+  std::vector<Frame> frames;
+  {
+    AmberNetCDF nc(nc_filename);
+    AmberNetCDFWriter writer(output_filename, 3);
+    for (size_t i = 0; i < nc.n_frames(); ++i) {
+      nc.read_frame(i, frame);
+      frame.time = 2.0 * i;
+      writer.write(frame);
+      frames.push_back(frame);
+      nc.advance(1);
+    }
+    EXPECT_EQ(writer.n_frames(), nc.n_frames());
+  }
+  AmberNetCDF copy(output_filename);
+  ASSERT_EQ(copy.n_frames(), frames.size());
+  ASSERT_EQ(copy.n_atoms(), frame.n_atoms());
+  EXPECT_TRUE(copy.has_cell());
+  for (size_t i = 0; i < copy.n_frames(); ++i) {
+    copy.read_frame(i, frame);
+    EXPECT_EQ((frame.coords()._eigen() - frames[i].coords()._eigen()).cwiseAbs().maxCoeff(), 0);
+    EXPECT_LE(fabs(frame.cell.a() - frames[i].cell.a()), 1e-9);
+    EXPECT_LE(fabs(frame.cell.alpha().degrees() - frames[i].cell.alpha().degrees()), 1e-9);
+    copy.advance(1);
+  }
+  std::remove(output_filename);
+}
+
+TEST_F(AmberNetCDFTrajectoryFileTests, write_velocities) {
+  const char* const output_filename = "GB1_F30C_MTSL_velocities.nc";
+  frame.add_velocities();
+  {
+    AmberNetCDF nc(nc_filename);
+    AmberNetCDFWriter writer(output_filename, 3);
+    for (size_t i = 0; i < 5; ++i) {
+      nc.read_frame(i, frame);
+      frame.velocities()._eigen() = frame.coords()._eigen() * 0.5;
+      writer.write(frame);
+      nc.advance(1);
+    }
+  }
+  AmberNetCDF copy(output_filename);
+  ASSERT_TRUE(copy.has_velocities());
+  Frame selected = frame;
+  for (size_t i = 0; i < copy.n_frames(); ++i) {
+    copy.read_frame(i, frame);
+    EXPECT_EQ((frame.velocities()._eigen() - frame.coords()._eigen() * 0.5).cwiseAbs().maxCoeff(), 0);
+    copy.advance(1);
+  }
+
+  frame.remove_velocities();
+  copy.advance(copy.n_frames());
+  copy.read_frame(0, frame); // velocities are not requested
+  EXPECT_FALSE(frame.has_velocities());
+
+  trajectory::Trajectory traj(selected);
+  traj.extend(AmberNetCDF(output_filename));
+  std::vector<AtomIndex> atoms{0, 1, 2, 10, 11, 25};
+  for (auto& f : traj.select_atoms(atoms)) {
+    ASSERT_TRUE(f.has_velocities());
+    EXPECT_EQ((f.velocities()._eigen() - f.coords()._eigen() * 0.5).cwiseAbs().maxCoeff(), 0);
+  }
+  std::remove(output_filename);
+}
+
+class AmberNetCDFBlockReadTests : public Test {};
+
+TEST_F(AmberNetCDFBlockReadTests, random_access_reads_single_frames) {
+  const char* const output_filename = "block_reads.nc";
+  Frame frame;
+  test::add_polyglycines({{"A", 5}}, frame);
+  {
+    AmberNetCDFWriter writer(output_filename);
+    for (int i = 0; i < 100; ++i) {
+      frame.coords()._eigen().setConstant(i);
+      frame.time = i;
+      writer.write(frame);
+    }
+  }
+  auto expect_frame = [&frame](AmberNetCDF& nc, size_t index) {
+    nc.read_frame(index, frame);
+    EXPECT_EQ(frame.coords()._eigen().maxCoeff(), index);
+    EXPECT_EQ(frame.time, index);
+  };
+
+  std::mt19937 generator(5);
+  std::uniform_int_distribution<size_t> distribution(0, 99);
+  std::vector<size_t> indices;
+  for (int i = 0; i < 20; ++i) {
+    indices.push_back(distribution(generator));
+  }
+
+  { // Trajectory::read_into() pattern, each miss reads exactly one frame
+    AmberNetCDF nc(output_filename, 16);
+    size_t current = 0;
+    for (size_t index : indices) {
+      nc.seek(current, index);
+      expect_frame(nc, index);
+      current = index;
+    }
+    EXPECT_EQ(nc.n_block_reads(), indices.size());
+  }
+  { // same with default seek() which closes the file and advances it from the beginning
+    AmberNetCDF nc(output_filename, 16);
+    size_t current = 0;
+    for (size_t index : indices) {
+      nc.TrajectoryInputFile::seek(current, index);
+      expect_frame(nc, index);
+      current = index;
+    }
+    EXPECT_EQ(nc.n_block_reads(), indices.size());
+  }
+  { // regular stride: two single frames, then blocks of 16 frames
+    AmberNetCDF nc(output_filename, 16);
+    for (size_t index = 0; index < 100; index += 3) {
+      expect_frame(nc, index);
+      nc.advance(3);
+    }
+    EXPECT_EQ(nc.n_block_reads(), 4);
+  }
+  std::remove(output_filename);
+}
+
 // TEST_F(AmberNetCDFTrajectoryFileTests, prints) {
 //  NetCDFTrajectoryFile nc(nc_filename);
 //  nc.print_info();
@@ -83,4 +238,33 @@ TEST_F(AmberNetCDFTrajectoryFileTests, trajectory) {
               << frame.cell.gamma().degrees() << std::endl;
     //    frame.to_pdb("frames/"+std::to_string(frame.index)+".pdb");
   }
-}
\ No newline at end of file
+}
+class AmberNetCDFWriterTests : public Test {};
+
+TEST_F(AmberNetCDFWriterTests, write_without_cell) {
+  const char* const output_filename = "no_cell.nc";
+  Frame frame;
+  test::add_polyglycines({{"A", 5}}, frame);
+  {
+    AmberNetCDFWriter writer(output_filename);
+    for (int i = 0; i < 3; ++i) {
+      frame.coords()._eigen().setConstant(i);
+      writer.write(frame);
+    }
+    frame.cell = geom::UnitCell(30, 40, 50, geom::Degrees(90), geom::Degrees(90), geom::Degrees(90));
+    EXPECT_THROW(writer.write(frame), std::runtime_error);
+  }
+  {
+    AmberNetCDF nc(output_filename);
+    EXPECT_EQ(nc.n_frames(), 3);
+    EXPECT_FALSE(nc.has_cell()); // unit cubic cell is not written as periodic box
+  }
+  {
+    AmberNetCDFWriter writer(output_filename);
+    writer.write(frame);
+    frame.cell = geom::UnitCell::unit_cubic_cell();
+    EXPECT_THROW(writer.write(frame), std::runtime_error);
+  }
+  EXPECT_TRUE(AmberNetCDF(output_filename).has_cell());
+  std::remove(output_filename);
+}
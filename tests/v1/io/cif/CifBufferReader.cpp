@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+
+#include "xmol/io/cif/CifBufferReader.h"
+#include "xmol/io/cif/exceptions.h"
+#include "xmol/io/pdb/PdbBufferReader.h"
+#include "xmol/io/pdb/PdbRecord.h"
+
+using ::testing::Test;
+using namespace xmol::io::cif;
+using namespace xmol;
+
+class CifBufferReaderTests : public Test {
+public:
+  static std::vector<Frame> read(const std::string& text) {
+    return CifBufferReader(text.data(), text.data() + text.size()).read_frames(text.data(), text.data() + text.size());
+  }
+
+  static std::string error_of(const std::string& text) {
+    try {
+      static_cast<void>(read(text));
+    } catch (CifException& e) {
+      return e.what();
+    }
+    return {};
+  }
+
+  static const std::string header;
+};
+
+const std::string CifBufferReaderTests::header = "data_TEST\n"
+                                                 "#\n"
+                                                 "_cell.entry_id           TEST\n"
+                                                 "_cell.length_a           30.000\n"
+                                                 "_cell.length_b           40.000\n"
+                                                 "_cell.length_c           50.000\n"
+                                                 "_cell.angle_alpha        90.00\n"
+                                                 "_cell.angle_beta         90.00\n"
+                                                 "_cell.angle_gamma        120.00\n"
+                                                 "#\n"
+                                                 "loop_\n"
+                                                 "_struct_asym.id\n"
+                                                 "_struct_asym.details\n"
+                                                 "A\n"
+                                                 ";multi-line\n"
+                                                 "_atom_site.id in text field\n"
+                                                 ";\n"
+                                                 "B 'quoted _value'\n"
+                                                 "#\n"
+                                                 "loop_\n"
+                                                 "_atom_site.group_PDB\n"
+                                                 "_atom_site.id\n"
+                                                 "_atom_site.type_symbol\n"
+                                                 "_atom_site.label_atom_id\n"
+                                                 "_atom_site.label_alt_id\n"
+                                                 "_atom_site.label_comp_id\n"
+                                                 "_atom_site.label_asym_id\n"
+                                                 "_atom_site.label_seq_id\n"
+                                                 "_atom_site.pdbx_PDB_ins_code\n"
+                                                 "_atom_site.Cartn_x\n"
+                                                 "_atom_site.Cartn_y\n"
+                                                 "_atom_site.Cartn_z\n"
+                                                 "_atom_site.occupancy\n"
+                                                 "_atom_site.auth_seq_id\n"
+                                                 "_atom_site.auth_comp_id\n"
+                                                 "_atom_site.auth_asym_id\n"
+                                                 "_atom_site.auth_atom_id\n"
+                                                 "_atom_site.pdbx_PDB_model_num\n";
+
+TEST_F(CifBufferReaderTests, read) {
+  const std::string text = header +
+                           "ATOM   1      N N     . GLY A 1 ? -1.000 2.500 -30.125 1.00 1     GLY AA N     1\n"
+                           "ATOM   2      C CA    . GLY A 1 ? 0.001  0.010 0.100   1.00 1     GLY AA CA    1\n"
+                           "ATOM   3      N N     . ARG A 2 A 1.0    2     3       1.00 2     ARG AA N     1\n"
+                           "ATOM   4      C \"C5'\" . ARG A 2 B 1e1    -2E-1 3(2)    1.00 2     ARG AA \"C5'\" 1\n"
+                           "HETATM 123456 O O     . HOH C . ? 1.000  2.000 3.000   1.00 12345 HOH AA O     1 # water\n"
+                           "HETATM 123457 O O     . HOH D . ? 4.000  5.000 6.000   1.00 1     HOH B  O     1\n"
+                           "ATOM   1      N N     . GLY A 1 ? 7.000  8.000 9.000   1.00 1     GLY AA N     2\n"
+                           "ATOM   2      C CA    . GLY A 1 ? 10.000 11.00 12.000  1.00 1     GLY AA CA    2\n"
+                           "#\n"
+                           "loop_\n"
+                           "_atom_site_anisotrop.id\n"
+                           "1\n";
+  CifBufferReader reader(text.data(), text.data() + text.size());
+  ASSERT_EQ(reader.n_frames(), 2);
+  EXPECT_EQ(reader.n_atoms(0), 6);
+  EXPECT_EQ(reader.n_atoms(1), 2);
+
+  auto frames = read(text);
+  ASSERT_EQ(frames.size(), 2);
+  auto& frame = frames[0];
+  ASSERT_EQ(frame.n_molecules(), 3); // water of AA chain has its own label_asym_id
+  ASSERT_EQ(frame.n_residues(), 5);
+  ASSERT_EQ(frame.n_atoms(), 6);
+  EXPECT_EQ(frame.molecules()[0].name(), MoleculeName("AA"));
+  EXPECT_EQ(frame.molecules()[1].name(), MoleculeName("AA"));
+  EXPECT_EQ(frame.molecules()[2].name(), MoleculeName("B"));
+  EXPECT_EQ(frame.residues()[1].id(), ResidueId(2, ResidueInsertionCode("A")));
+  EXPECT_EQ(frame.residues()[2].id(), ResidueId(2, ResidueInsertionCode("B")));
+  EXPECT_EQ(frame.residues()[3].id(), ResidueId(12345));
+  EXPECT_EQ(frame.residues()[3].name(), ResidueName("HOH"));
+  EXPECT_EQ(frame.atoms()[3].name(), AtomName("C5'"));
+  EXPECT_EQ(frame.atoms()[4].id(), 123456);
+  EXPECT_EQ(frame.atoms()[0].r().x(), -1.0);
+  EXPECT_EQ(frame.atoms()[0].r().z(), -30.125);
+  EXPECT_EQ(frame.atoms()[1].r().x(), 0.001);
+  EXPECT_EQ(frame.atoms()[3].r().x(), 10.0);
+  EXPECT_EQ(frame.atoms()[3].r().y(), -0.2);
+  EXPECT_EQ(frame.atoms()[3].r().z(), 3.0);
+  EXPECT_NEAR(frame.cell.a(), 30, 1e-9);
+  EXPECT_NEAR(frame.cell.gamma().degrees(), 120, 1e-9);
+
+  EXPECT_EQ(frames[1].n_atoms(), 2);
+  EXPECT_EQ(frames[1].atoms()[1].r().y(), 11.0);
+
+  std::vector<XYZ> coords;
+  reader.read_coords(text.data(), text.data() + text.size(), 1, coords);
+  ASSERT_EQ(coords.size(), 2);
+  EXPECT_EQ(coords[0].x(), 7.0);
+  EXPECT_EQ(coords[1].z(), 12.0);
+}
+
+TEST_F(CifBufferReaderTests, long_comp_id) {
+  // PDBx comp ids (e.g. of ligands from the extended CCD) may have up to 5 characters
+  const std::string text = header +
+                           "HETATM 1 C C1 . A1AAA C . ? 1.000 2.000 3.000 1.00 1 A1AAA A C1 1\n"
+                           "HETATM 2 C C2 . A1AAA C . ? 4.000 5.000 6.000 1.00 1 A1AAA A C2 1\n";
+  auto frames = read(text);
+  ASSERT_EQ(frames.size(), 1);
+  ASSERT_EQ(frames[0].n_residues(), 1);
+  EXPECT_EQ(frames[0].residues()[0].name(), ResidueName("A1AAA"));
+  EXPECT_EQ(frames[0].residues()[0].name().str(), "A1AAA");
+
+  EXPECT_EQ(error_of(header + "HETATM 1 C C1 . A1AAAA C . ? 1.000 2.000 3.000 1.00 1 A1AAAA A C1 1\n"),
+            "Too long `_atom_site.auth_comp_id` value `A1AAAA` at line 39");
+}
+
+TEST_F(CifBufferReaderTests, same_as_pdb) {
+  const std::string pdb = "ATOM      1  N   GLY A   1      -1.000   2.500 -30.125  1.00  0.00           N\n"
+                          "ATOM      2  CA  GLY A   1       0.001   0.010   0.100  1.00  0.00           C\n"
+                          "ATOM      3  N   ARG A   2A      1.000   2.000   3.000  1.00  0.00           N\n"
+                          "ATOM      4  N   ARG A   2B      4.000   5.000   6.000  1.00  0.00           N\n"
+                          "TER       5      ARG A   2B\n"
+                          "HETATM    6  O   HOH A 101     -10.5   -20.25   30.0    1.00  0.00           O\n"
+                          "HETATM    7  O   HOH B 102     11.000  12.000  13.000  1.00  0.00           O\n";
+  const std::string cif = "data_1\n"
+                          "loop_\n"
+                          "_atom_site.id\n"
+                          "_atom_site.label_atom_id\n"
+                          "_atom_site.label_comp_id\n"
+                          "_atom_site.label_asym_id\n"
+                          "_atom_site.label_seq_id\n"
+                          "_atom_site.pdbx_PDB_ins_code\n"
+                          "_atom_site.Cartn_x\n"
+                          "_atom_site.Cartn_y\n"
+                          "_atom_site.Cartn_z\n"
+                          "1 N  GLY A 1   ? -1.000 2.500 -30.125\n"
+                          "2 CA GLY A 1   ? 0.001  0.010 0.100\n"
+                          "3 N  ARG A 2   A 1.000  2.000 3.000\n"
+                          "4 N  ARG A 2   B 4.000  5.000 6.000\n"
+                          "6 O  HOH C 101 ? -10.5  -20.25 30.0\n"
+                          "7 O  HOH B 102 ? 11.000 12.000 13.000\n";
+  auto expected = io::pdb::PdbBufferReader(io::pdb::StandardPdbRecords::instance())
+                      .read_frames(pdb.data(), pdb.data() + pdb.size())[0];
+  auto frame = read(cif)[0];
+  ASSERT_EQ(frame.n_molecules(), expected.n_molecules());
+  ASSERT_EQ(frame.n_residues(), expected.n_residues());
+  ASSERT_EQ(frame.n_atoms(), expected.n_atoms());
+  for (size_t i = 0; i < frame.n_residues(); ++i) {
+    EXPECT_EQ(frame.residues()[i].name(), expected.residues()[i].name());
+    EXPECT_EQ(frame.residues()[i].id(), expected.residues()[i].id());
+    EXPECT_EQ(frame.residues()[i].size(), expected.residues()[i].size());
+  }
+  for (size_t i = 0; i < frame.n_atoms(); ++i) {
+    EXPECT_EQ(frame.atoms()[i].name(), expected.atoms()[i].name());
+    EXPECT_EQ(frame.atoms()[i].id(), expected.atoms()[i].id());
+    EXPECT_EQ(frame.atoms()[i].r().x(), expected.atoms()[i].r().x());
+    EXPECT_EQ(frame.atoms()[i].r().y(), expected.atoms()[i].r().y());
+    EXPECT_EQ(frame.atoms()[i].r().z(), expected.atoms()[i].r().z());
+  }
+  EXPECT_DOUBLE_EQ(frame.cell.volume(), 1.0);
+}
+
+TEST_F(CifBufferReaderTests, inexact_negative_values) {
+  // values with too many digits or too large exponents are parsed by strtod
+  const std::string text = "data_1\n"
+                           "loop_\n"
+                           "_atom_site.id\n"
+                           "_atom_site.label_atom_id\n"
+                           "_atom_site.Cartn_x\n"
+                           "_atom_site.Cartn_y\n"
+                           "_atom_site.Cartn_z\n"
+                           "1 N 12.3456789012345678901 -12.3456789012345678901 -1e-30\n"
+                           "2 N -9007199254740993 1e30 -1.5E+40\n";
+  auto frame = read(text)[0];
+  ASSERT_EQ(frame.n_atoms(), 2);
+  EXPECT_EQ(frame.atoms()[0].r().x(), 12.3456789012345678901);
+  EXPECT_EQ(frame.atoms()[0].r().y(), -12.3456789012345678901);
+  EXPECT_EQ(frame.atoms()[0].r().z(), -1e-30);
+  EXPECT_EQ(frame.atoms()[1].r().x(), -9007199254740993.0);
+  EXPECT_EQ(frame.atoms()[1].r().y(), 1e30);
+  EXPECT_EQ(frame.atoms()[1].r().z(), -1.5e40);
+}
+
+TEST_F(CifBufferReaderTests, no_atoms) {
+  EXPECT_TRUE(read("").empty());
+  EXPECT_TRUE(read("data_1\n_entry.id 1\n").empty());
+}
+
+TEST_F(CifBufferReaderTests, read_error) {
+  const std::string columns = "data_1\n"
+                              "loop_\n"
+                              "_atom_site.id\n"
+                              "_atom_site.label_atom_id\n"
+                              "_atom_site.Cartn_x\n"
+                              "_atom_site.Cartn_y\n"
+                              "_atom_site.Cartn_z\n";
+  EXPECT_EQ(error_of(columns + "1 N 1.0 2.0 3.0\n2 N 1.0 x.0 3.0\n"), "Bad `_atom_site.Cartn_y` value `x.0` at line 9");
+  EXPECT_EQ(error_of(columns + "1 N 1.0 2.0 3.0\n2 N 1.0 ? 3.0\n"), "Bad `_atom_site.Cartn_y` value `?` at line 9");
+  EXPECT_EQ(error_of(columns + "1 NAME_ 1.0 2.0 3.0\n"), "Too long `_atom_site.label_atom_id` value `NAME_` at line 8");
+  EXPECT_EQ(error_of(columns + "1 N 1.0 2.0 3.0\n2 N 1.0\n#\n"),
+            "Number of `_atom_site` values is not multiple of number of columns at line 9");
+  EXPECT_EQ(error_of(columns + "1 'N 1.0 2.0 3.0\n"), "Unterminated quoted string at line 8");
+  EXPECT_EQ(error_of("data_1\nloop_\n_atom_site.id\n_atom_site.Cartn_x\n1 1.0\n"),
+            "No `_atom_site.Cartn_y` column at line 5");
+}
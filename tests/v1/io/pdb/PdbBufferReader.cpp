@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include "xmol/io/pdb/PdbBufferReader.h"
+#include "xmol/io/pdb/PdbReader.h"
+#include "xmol/io/pdb/PdbRecord.h"
+#include "xmol/io/pdb/exceptions.h"
+
+#include <cstdio>
+#include <sstream>
+
+using ::testing::Test;
+using namespace xmol::io::pdb;
+using namespace xmol;
+
+class PdbBufferReaderTests : public Test {
+public:
+  static std::vector<Frame> read(const std::string& text, const basic_PdbRecords& db) {
+    return PdbBufferReader(db).read_frames(text.data(), text.data() + text.size());
+  }
+
+  static void expect_same(std::vector<Frame>& expected, std::vector<Frame>& frames) {
+    ASSERT_EQ(expected.size(), frames.size());
+    for (size_t f = 0; f < frames.size(); ++f) {
+      auto& lhs = expected[f];
+      auto& rhs = frames[f];
+      ASSERT_EQ(lhs.n_molecules(), rhs.n_molecules());
+      ASSERT_EQ(lhs.n_residues(), rhs.n_residues());
+      ASSERT_EQ(lhs.n_atoms(), rhs.n_atoms());
+      for (size_t i = 0; i < lhs.n_molecules(); ++i) {
+        EXPECT_EQ(lhs.molecules()[i].name(), rhs.molecules()[i].name());
+        EXPECT_EQ(lhs.molecules()[i].size(), rhs.molecules()[i].size());
+      }
+      for (size_t i = 0; i < lhs.n_residues(); ++i) {
+        EXPECT_EQ(lhs.residues()[i].name(), rhs.residues()[i].name());
+        EXPECT_EQ(lhs.residues()[i].id(), rhs.residues()[i].id());
+        EXPECT_EQ(lhs.residues()[i].size(), rhs.residues()[i].size());
+      }
+      for (size_t i = 0; i < lhs.n_atoms(); ++i) {
+        EXPECT_EQ(lhs.atoms()[i].name(), rhs.atoms()[i].name());
+        EXPECT_EQ(lhs.atoms()[i].id(), rhs.atoms()[i].id());
+        EXPECT_EQ(lhs.atoms()[i].r().x(), rhs.atoms()[i].r().x());
+        EXPECT_EQ(lhs.atoms()[i].r().y(), rhs.atoms()[i].r().y());
+        EXPECT_EQ(lhs.atoms()[i].r().z(), rhs.atoms()[i].r().z());
+      }
+      EXPECT_DOUBLE_EQ(lhs.cell.volume(), rhs.cell.volume());
+    }
+  }
+};
+
+TEST_F(PdbBufferReaderTests, same_as_pdb_reader) {
+  const std::string text = "CRYST1   30.000   40.000   50.000  90.00  90.00 120.00 P 1           1\n"
+                           "MODEL        1\n"
+                           "ATOM      1  N   GLY A   1      -1.000   2.500 -30.125  1.00  0.00           N\n"
+                           "ANISOU    1  N   GLY A   1     2406   1892   1614    198    519   -328       N\n"
+                           "ATOM      2  CA  GLY A   1       0.001   0.010   0.100  1.00  0.00           C\n"
+                           "ATOM      3  N   ARG A   2A      1.000   2.000   3.000  1.00  0.00           N\n"
+                           "ATOM      4  N   ARG A   2B      4.000   5.000   6.000  1.00  0.00           N\n"
+                           "TER       5      ARG A   2B\n"
+                           "ATOM      6  N   GLY A   3       7.000   8.000   9.000  1.00  0.00           N\n"
+                           "HETATM    7  O   HOH B 101     -10.5   -20.25   30.0    1.00  0.00           O\n"
+                           "HETATM    8  O   HOH B 102     11.000  12.000  13.000  1.00  0.00           O\n"
+                           "ENDMDL\n"
+                           "MODEL        2\n"
+                           "ATOM      1  N   GLY A   1       1.000   2.000   3.000  1.00  0.00           N\n"
+                           "ATOM      2  CA  GLY A   1       4.000   5.000   6.000  1.00  0.00           C\n"
+                           "ENDMDL\n"
+                           "CRYST1   10.000   10.000   10.000  90.00  90.00  90.00 P 1           1\r\n"
+                           "ATOM      1  N   GLY C   1       1.000   2.000   3.000  1.00  0.00           N\r\n"
+                           "END\r\n"
+                           "ATOM      1  N   GLY D   1       1.000   2.000   3.000  1.00  0.00           N";
+  std::stringstream ss(text);
+  auto expected = PdbReader(ss).read_frames();
+  auto frames = read(text, StandardPdbRecords::instance());
+  expect_same(expected, frames);
+
+  ASSERT_EQ(frames.size(), 4);
+  EXPECT_EQ(frames[0].n_molecules(), 3);
+  EXPECT_EQ(frames[0].n_residues(), 6);
+  EXPECT_EQ(frames[0].n_atoms(), 7);
+  EXPECT_EQ(frames[0].residues()[2].id(), ResidueId(2, ResidueInsertionCode("B")));
+}
+
+TEST_F(PdbBufferReaderTests, altered_records) {
+  AlteredPdbRecords records(StandardPdbRecords::instance());
+  records.alter_record(RecordName("ATOM"), FieldName("serial"), {7, 12});
+  const std::string text = "ATOM  123456 N   GLY A   1       1.000   2.000   3.000  1.00  0.00           N\n"
+                           "ATOM  123457 CA  GLY A   1       4.000   5.000   6.000  1.00  0.00           C\n";
+  std::stringstream ss(text);
+  auto expected = PdbReader(ss).read_frames(records);
+  auto frames = read(text, records);
+  expect_same(expected, frames);
+  EXPECT_EQ(frames[0].atoms()[1].id(), 123457);
+}
+
+TEST_F(PdbBufferReaderTests, empty) { EXPECT_TRUE(read("", StandardPdbRecords::instance()).empty()); }
+
+TEST_F(PdbBufferReaderTests, read_error) {
+  const std::string atom = "ATOM      1  N   GLY A   1       1.000   2.000   3.000  1.00  0.00           N\n";
+  const std::string model = "MODEL        1\n" + atom + "ENDMDL\n";
+  const std::vector<std::string> texts = {
+      "REMARK    1\n" + atom + "ATOM      2  CA  GLY A   1       4.000   x.000   6.000  1.00  0.00           C\n",
+      // first bad field is reported
+      atom + "ATOM      2  CA  GLY A   1       x.000   5.000   z.000  1.00  0.00           C\n",
+      "CRYST1   30.000   4x.000   50.000  90.00  90.00  9x.00 P 1           1\n" + atom,
+      // coordinates of model with the same topology as preceding one
+      model + "MODEL        2\nATOM      1  N   GLY A   1       x.000   2.000   z.000  1.00  0.00           N\nENDMDL\n",
+  };
+  for (auto& text : texts) {
+    std::stringstream ss(text);
+    std::string expected;
+    try {
+      static_cast<void>(PdbReader(ss).read_frames());
+    } catch (PdbException& e) {
+      expected = e.what();
+    }
+    ASSERT_FALSE(expected.empty()) << text;
+    try {
+      static_cast<void>(read(text, StandardPdbRecords::instance()));
+      FAIL() << "PdbException expected";
+    } catch (PdbException& e) {
+      EXPECT_EQ(std::string(e.what()), expected);
+    }
+  }
+}
+
+TEST_F(PdbBufferReaderTests, parallel_models) {
+  auto atom = [](int serial, const char* name, const char* residue, int resid, double x) {
+    char line[81];
+    std::snprintf(line, sizeof(line), "ATOM  %5d %-4s %3s A%4d    %8.3f%8.3f%8.3f  1.00  0.00\n", serial, name, residue,
+                  resid, x, x + 1, x + 2);
+    return std::string(line);
+  };
+  std::string text = "REMARK  ensemble\n";
+  for (int m = 0; m < 40; ++m) {
+    if (m % 7 == 0) {
+      text += "CRYST1   " + std::to_string(10 + m) + ".000   10.000   10.000  90.00  90.00  90.00 P 1           1\n";
+    }
+    char model[16];
+    std::snprintf(model, sizeof(model), "MODEL     %4d\n", m + 1);
+    text += model;
+    text += atom(1, "N", "GLY", 1, m);
+    text += atom(2, "CA", "GLY", 1, m + 0.5);
+    text += m % 10 == 3 ? atom(3, "N", "ALA", 2, -m) : atom(3, "N", "GLY", 2, -m); // topology changes
+    text += "TER\n";
+    if (m >= 30) {
+      text += atom(4, "O", "HOH", 3, 2 * m);
+    }
+    text += "ENDMDL\n";
+    if (m == 20) {
+      text += "REMARK  no split before next model\n";
+    }
+  }
+  std::stringstream ss(text);
+  auto expected = PdbReader(ss).read_frames();
+  ASSERT_EQ(expected.size(), 40);
+  for (size_t n_threads : {1, 2, 3, 8, 64}) {
+    SCOPED_TRACE(n_threads);
+    auto frames = PdbBufferReader(StandardPdbRecords::instance()).read_frames(text.data(), text.data() + text.size(), n_threads);
+    expect_same(expected, frames);
+  }
+}
+
+TEST_F(PdbBufferReaderTests, parallel_read_error) {
+  std::string text;
+  for (int m = 0; m < 10; ++m) {
+    text += "MODEL        1\n"
+            "ATOM      1  N   GLY A   1       1.000   2.000   3.000  1.00  0.00           N\n";
+    text += m == 6 || m == 8 ? "ATOM      2  CA  GLY A   1       4.000   x.000   6.000  1.00  0.00           C\n"
+                             : "ATOM      2  CA  GLY A   1       4.000   5.000   6.000  1.00  0.00           C\n";
+    text += "ENDMDL\n";
+  }
+  std::stringstream ss(text);
+  std::string expected;
+  try {
+    static_cast<void>(PdbReader(ss).read_frames());
+  } catch (PdbException& e) {
+    expected = e.what();
+  }
+  ASSERT_FALSE(expected.empty());
+  try {
+    static_cast<void>(PdbBufferReader(StandardPdbRecords::instance()).read_frames(text.data(), text.data() + text.size(), 4));
+    FAIL() << "PdbException expected";
+  } catch (PdbException& e) {
+    EXPECT_EQ(std::string(e.what()), expected);
+  }
+}
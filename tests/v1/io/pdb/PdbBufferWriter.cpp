@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include "xmol/io/pdb/PdbBufferReader.h"
+#include "xmol/io/pdb/PdbBufferWriter.h"
+#include "xmol/io/pdb/PdbRecord.h"
+#include "xmol/io/pdb/PdbWriter.h"
+#include "xmol/io/pdb/exceptions.h"
+#include "xmol/trajectory/InMemoryTrajectory.h"
+#include "test_common.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <sstream>
+
+using ::testing::Test;
+using namespace xmol::io::pdb;
+using namespace xmol;
+
+class PdbBufferWriterTests : public Test {
+public:
+  static std::string pdb_writer_text(Frame& frame) {
+    std::ostringstream out;
+    PdbWriter(out).write(frame);
+    return out.str();
+  }
+
+  static std::string buffer_writer_text(Frame& frame, size_t buffer_size = 1 << 20) {
+    std::ostringstream out;
+    PdbBufferWriter(out, buffer_size).write(frame);
+    return out.str();
+  }
+
+  /// Frame of single residue with atom per value of @p values
+  static Frame frame_of(const std::vector<double>& values) {
+    Frame frame;
+    auto residue = frame.add_molecule().name("A").add_residue().name("ALA").id(1);
+    for (size_t i = 0; i < values.size(); ++i) {
+      residue.add_atom().name("CA").id(static_cast<AtomId>(i + 1));
+    }
+    auto coords = frame.coords()._eigen();
+    for (size_t i = 0; i < values.size(); ++i) {
+      coords(i, 0) = values[i];
+      coords(i, 1) = -values[i];
+      coords(i, 2) = values[values.size() - i - 1];
+    }
+    return frame;
+  }
+};
+
+TEST_F(PdbBufferWriterTests, same_as_pdb_writer) {
+  Frame frame;
+  test::add_polyglycines({{"A", 10}, {"B", 1}, {"", 3}}, frame);
+  frame.add_molecule().name("C");
+  frame.residues()[2].id(ResidueId(-3, ResidueInsertionCode("B")));
+  frame.residues()[3].name("HOH").id(10000);
+  frame.atoms()[3].name("HH31");
+  frame.atoms()[4].id(-1234);
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> distribution(-999.9995, 9999.9995);
+  auto coords = frame.coords()._eigen();
+  for (int k = 0; k < coords.size(); ++k) {
+    coords(k) = distribution(generator);
+  }
+  EXPECT_EQ(buffer_writer_text(frame), pdb_writer_text(frame));
+
+  frame.cell = geom::UnitCell(111.11, 222.22, 333.3335, geom::Degrees(60.005), geom::Degrees(90), geom::Degrees(120));
+  EXPECT_EQ(buffer_writer_text(frame), pdb_writer_text(frame));
+  EXPECT_EQ(buffer_writer_text(frame, 100), pdb_writer_text(frame));
+}
+
+TEST_F(PdbBufferWriterTests, rounding) {
+  std::vector<double> values = {0.0, -0.0, 0.0004, -0.0004, 0.0005, -0.0005, 0.0015, 0.0625, 0.1875, 2.5, 1e-300};
+  for (int k = -20000; k <= 20000; k += 7) {
+    values.push_back(k / 2000.0);       // ties in decimal, not in binary
+    values.push_back(k / 1024.0);       // exact binary ties
+    values.push_back(k * 0.1 + 0.0005); // ties after scaling
+  }
+  std::mt19937 generator(2);
+  std::uniform_real_distribution<double> distribution(-1000, 1000);
+  for (int i = 0; i < 10000; ++i) {
+    values.push_back(distribution(generator));
+  }
+  auto frame = frame_of(values);
+  EXPECT_EQ(buffer_writer_text(frame), pdb_writer_text(frame));
+}
+
+TEST_F(PdbBufferWriterTests, field_overflow) {
+  // Fields which don't fit into columns shift the rest of line as by PdbWriter
+  const double inf = std::numeric_limits<double>::infinity();
+  auto frame = frame_of({99999.9994, 99999.9995, -9999.9995, 123456.789, 1e20, inf, -inf,
+                         std::numeric_limits<double>::quiet_NaN(), 1.5});
+  frame.atoms()[1].id(100000);
+  frame.atoms()[2].id(-99999);
+  frame.residues()[0].id(-99999);
+  EXPECT_EQ(buffer_writer_text(frame), pdb_writer_text(frame));
+}
+
+TEST_F(PdbBufferWriterTests, long_chain_name) {
+  // multi-character chain ids (e.g. read from mmCIF) don't fit single column of chainID field
+  auto frame = frame_of({1.0, 2.0});
+  frame.molecules()[0].name("AB");
+  std::string expected;
+  try {
+    static_cast<void>(pdb_writer_text(frame));
+  } catch (PdbWriteError& e) {
+    expected = e.what();
+  }
+  EXPECT_EQ(expected, "Molecule name `AB` is longer than PDB chainID field (1 columns)");
+  try {
+    static_cast<void>(buffer_writer_text(frame));
+    FAIL() << "PdbWriteError expected";
+  } catch (PdbWriteError& e) {
+    EXPECT_EQ(std::string(e.what()), expected);
+  }
+  trajectory::InMemoryTrajectory store(frame.n_atoms(), 1e-3);
+  store.append(frame);
+  trajectory::Trajectory traj(frame);
+  traj.extend(std::move(store));
+  std::ostringstream out;
+  EXPECT_THROW(PdbBufferWriter(out).write(traj.slice()), PdbWriteError);
+}
+
+TEST_F(PdbBufferWriterTests, long_residue_name) {
+  // residue names of PDBx files (up to 5 characters) don't fit resName field
+  auto frame = frame_of({1.0, 2.0});
+  frame.residues()[0].name(ResidueName("A1AAA"));
+  std::string expected;
+  try {
+    static_cast<void>(pdb_writer_text(frame));
+  } catch (PdbWriteError& e) {
+    expected = e.what();
+  }
+  EXPECT_EQ(expected, "Residue name `A1AAA` is longer than PDB resName field (3 columns)");
+  try {
+    static_cast<void>(buffer_writer_text(frame));
+    FAIL() << "PdbWriteError expected";
+  } catch (PdbWriteError& e) {
+    EXPECT_EQ(std::string(e.what()), expected);
+  }
+}
+
+TEST_F(PdbBufferWriterTests, write_models) {
+  Frame ref;
+  test::add_polyglycines({{"A", 5}, {"B", 2}}, ref);
+  std::vector<Frame> frames;
+  trajectory::InMemoryTrajectory store(ref.n_atoms(), 1e-3);
+  std::mt19937 generator(3);
+  std::uniform_real_distribution<double> distribution(-100, 100);
+  for (int f = 0; f < 12; ++f) {
+    Frame frame(ref);
+    auto coords = frame.coords()._eigen();
+    for (int k = 0; k < coords.size(); ++k) {
+      coords(k) = std::round(distribution(generator) * 1000) / 1000;
+    }
+    if (f % 3 != 0) {
+      frame.cell = geom::UnitCell(30 + f, 40, 50, geom::Degrees(90), geom::Degrees(90), geom::Degrees(90));
+    }
+    store.append(frame);
+    frames.push_back(frame);
+  }
+  trajectory::Trajectory traj(ref);
+  traj.extend(std::move(store));
+
+  std::ostringstream expected;
+  for (int f = 1; f < 12; f += 2) {
+    std::ostringstream model;
+    PdbWriter(model).write(frames[f]);
+    auto text = model.str();
+    auto cryst1 = text.rfind("CRYST1", 0) == 0 ? text.substr(0, text.find('\n') + 1) : std::string();
+    char record[16];
+    std::snprintf(record, sizeof(record), "MODEL     %4d\n", f / 2 + 1);
+    expected << cryst1 << record << text.substr(cryst1.size()) << "ENDMDL\n";
+  }
+
+  for (size_t buffer_size : {1 << 20, 1000, 1}) {
+    SCOPED_TRACE(buffer_size);
+    std::ostringstream out;
+    PdbBufferWriter(out, buffer_size).write(traj.slice(1, {}, 2));
+    ASSERT_EQ(out.str(), expected.str());
+  }
+
+  auto text = expected.str();
+  auto models = PdbBufferReader(StandardPdbRecords::instance()).read_frames(text.data(), text.data() + text.size());
+  ASSERT_EQ(models.size(), 6);
+  for (size_t i = 0; i < models.size(); ++i) {
+    auto& frame = frames[2 * i + 1];
+    EXPECT_TRUE(models[i].coords()._eigen().isApprox(frame.coords()._eigen(), 1e-9));
+    if (frame.cell.volume() != 1.0) {
+      EXPECT_DOUBLE_EQ(models[i].cell.a(), frame.cell.a());
+    }
+  }
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include "xmol/io/PdbTrajectoryFile.h"
+#include "xmol/trajectory/Trajectory.h"
+
+#include <cstdio>
+#include <fstream>
+
+using ::testing::Test;
+using namespace xmol::io;
+using namespace xmol;
+
+class PdbTrajectoryFileTests : public Test {
+public:
+  static void write(const std::string& filename, const std::string& text) { std::ofstream(filename) << text; }
+
+  /// @p n_models models of 3 atoms, the second atom is HETATM
+  static std::string models(int n_models) {
+    std::string text = "REMARK  models\n";
+    for (int m = 0; m < n_models; ++m) {
+      if (m % 3 == 0) {
+        text += "CRYST1   " + std::to_string(10 + m) + ".000   10.000   10.000  90.00  90.00  90.00 P 1           1\n";
+      }
+      char lines[400];
+      std::snprintf(lines, sizeof(lines),
+                    "MODEL     %4d\n"
+                    "ATOM      1  N   GLY A   1    %8.3f%8.3f%8.3f  1.00  0.00           N\n"
+                    "HETATM    2  O   HOH B   2    %8.3f%8.3f%8.3f  1.00  0.00           O\n"
+                    "ANISOU    2  O   HOH B   2     2406   1892   1614    198    519   -328       O\n"
+                    "ATOM      3  CA  GLY C   3    %8.3f%8.3f%8.3f  1.00  0.00           C\n"
+                    "ENDMDL\n",
+                    m + 1, 1.0 * m, 2.0, 3.0, 4.0, -1.0 * m, 6.0, 7.0, 8.0, 0.5 * m);
+      text += lines;
+    }
+    return text + "END\n";
+  }
+};
+
+TEST_F(PdbTrajectoryFileTests, same_as_pdb_file) {
+  write("test_models.pdb", models(20));
+  auto frames = PdbInputFile("test_models.pdb").frames();
+  PdbTrajectoryFile file("test_models.pdb");
+  ASSERT_EQ(file.n_frames(), frames.size());
+  ASSERT_EQ(file.n_atoms(), 3);
+
+  trajectory::Trajectory traj(file.frame(0));
+  traj.extend(PdbTrajectoryFile("test_models.pdb"));
+  ASSERT_EQ(traj.n_frames(), frames.size());
+  for (auto& f : traj) {
+    auto& expected = frames[f.index];
+    EXPECT_TRUE(f.coords()._eigen().isApprox(expected.coords()._eigen())) << f.index;
+    EXPECT_DOUBLE_EQ(f.cell.volume(), expected.cell.volume());
+  }
+
+  Frame out = file.frame(0);
+  for (size_t i : {17, 3, 9, 0}) { // random access
+    traj.read_into(i, out);
+    EXPECT_TRUE(out.coords()._eigen().isApprox(frames[i].coords()._eigen())) << i;
+  }
+
+  auto frame = file.frame(13);
+  EXPECT_EQ(frame.n_molecules(), 3);
+  EXPECT_EQ(frame.residues()[1].name(), ResidueName("HOH"));
+  EXPECT_TRUE(frame.coords()._eigen().isApprox(frames[13].coords()._eigen()));
+  EXPECT_DOUBLE_EQ(frame.cell.volume(), frames[13].cell.volume());
+  EXPECT_THROW(static_cast<void>(file.frame(20)), std::out_of_range);
+  std::remove("test_models.pdb");
+}
+
+TEST_F(PdbTrajectoryFileTests, pdb_input_file_copies) {
+  write("test_models_copies.pdb", models(10));
+  PdbInputFile file("test_models_copies.pdb");
+  auto frames = file.frames();
+  trajectory::Trajectory traj(frames[0]);
+  traj.extend(std::move(file));
+
+  size_t n_pairs = 0;
+  for (auto& f : traj.slice(0, 10, 3)) {
+    for (auto& g : traj.slice(1, 10, 4)) { // concurrent iterator reads own copy of file
+      EXPECT_TRUE(f.coords()._eigen().isApprox(frames[f.index].coords()._eigen())) << f.index;
+      EXPECT_TRUE(g.coords()._eigen().isApprox(frames[g.index].coords()._eigen())) << g.index;
+      ++n_pairs;
+    }
+  }
+  EXPECT_EQ(n_pairs, 4 * 3);
+
+  Frame out = frames[0];
+  for (size_t i : {7, 2, 9, 0, 5}) { // random access
+    traj.read_into(i, out);
+    EXPECT_TRUE(out.coords()._eigen().isApprox(frames[i].coords()._eigen())) << i;
+  }
+  std::remove("test_models_copies.pdb");
+}
+
+TEST_F(PdbTrajectoryFileTests, without_models) {
+  write("test_no_models.pdb", "CRYST1   30.000   40.000   50.000  90.00  90.00 120.00 P 1           1\n"
+                              "ATOM      1  N   GLY A   1       1.000   2.000   3.000  1.00  0.00           N\n"
+                              "TER\n"
+                              "ATOM      2  N   GLY B   1       4.000   5.000   6.000  1.00  0.00           N\n"
+                              "END\n");
+  PdbTrajectoryFile file("test_no_models.pdb");
+  ASSERT_EQ(file.n_frames(), 1);
+  ASSERT_EQ(file.n_atoms(), 2);
+  auto frame = file.frame(0);
+  EXPECT_EQ(frame.n_molecules(), 2);
+  EXPECT_DOUBLE_EQ(frame.cell.volume(), PdbInputFile("test_no_models.pdb").frames()[0].cell.volume());
+  std::remove("test_no_models.pdb");
+}
+
+TEST_F(PdbTrajectoryFileTests, wrong_number_of_atoms) {
+  auto text = models(3);
+  text.insert(text.rfind("ENDMDL"), "ATOM      4  C   GLY C   3       1.000   1.000   1.000  1.00  0.00           C\n");
+  write("test_models_mismatch.pdb", text);
+  trajectory::Trajectory traj(PdbTrajectoryFile("test_models_mismatch.pdb").frame(0));
+  traj.extend(PdbTrajectoryFile("test_models_mismatch.pdb"));
+  auto it = traj.begin();
+  ++it;
+  EXPECT_THROW(++it, PdbReadError);
+  std::remove("test_models_mismatch.pdb");
+}
+
+TEST_F(PdbTrajectoryFileTests, non_existent_file) {
+  EXPECT_THROW(PdbTrajectoryFile("does_not_exist.pdb"), PdbReadError);
+}
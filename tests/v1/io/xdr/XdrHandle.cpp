@@ -0,0 +1,79 @@
+#include "xmol/io/xdr/XdrHandle.h"
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+
+using ::testing::Test;
+using namespace xmol::io::xdr;
+using namespace xmol;
+
+class XdrHandleTests : public Test {};
+
+TEST_F(XdrHandleTests, big_endian_layout) {
+  {
+    XdrHandle xdr("test_layout.xdr", XdrHandle::Mode::WRITE);
+    EXPECT_TRUE(!!xdr.write(0x01020304));
+    EXPECT_TRUE(!!xdr.write(1.0f));
+    EXPECT_TRUE(!!xdr.write_opaque("abcde", 5));
+    EXPECT_TRUE(!!xdr.write(-2.0));
+    EXPECT_EQ(xdr.tell(), 4 + 4 + 8 + 8);
+  }
+  std::ifstream in("test_layout.xdr", std::ios::binary);
+  std::vector<unsigned char> bytes{std::istreambuf_iterator<char>(in), {}};
+  const std::vector<unsigned char> expected{
+      0x01, 0x02, 0x03, 0x04,                         // int
+      0x3f, 0x80, 0x00, 0x00,                         // float
+      'a',  'b',  'c',  'd',  'e', 0, 0, 0,           // padded opaque
+      0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // double
+  };
+  EXPECT_EQ(bytes, expected);
+  std::remove("test_layout.xdr");
+}
+
+TEST_F(XdrHandleTests, read_write_beyond_buffer) {
+  // arrays larger than internal buffer, unaligned to it by scalar values
+  std::vector<float> floats(700000);
+  std::vector<double> doubles(300000);
+  std::iota(floats.begin(), floats.end(), 0.5f);
+  std::iota(doubles.begin(), doubles.end(), -0.25);
+  {
+    XdrHandle xdr("test_arrays.xdr", XdrHandle::Mode::WRITE);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_TRUE(!!xdr.write(i));
+      EXPECT_TRUE(!!xdr.write(future::Span<const float>(floats.data(), floats.size())));
+      EXPECT_TRUE(!!xdr.write(future::Span<const double>(doubles.data(), doubles.size())));
+    }
+  }
+
+  XdrHandle xdr("test_arrays.xdr", XdrHandle::Mode::READ);
+  const std::int64_t block_size = 4 + floats.size() * 4 + doubles.size() * 8;
+  EXPECT_EQ(xdr.size(), 3 * block_size);
+
+  std::vector<float> floats_read(floats.size());
+  std::vector<double> doubles_read(doubles.size());
+  int value = -1;
+  EXPECT_TRUE(!!xdr.read(value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(!!xdr.skip(4 * floats.size()));
+  EXPECT_TRUE(!!xdr.read(doubles_read));
+  EXPECT_EQ(doubles_read, doubles);
+  EXPECT_EQ(xdr.tell(), block_size);
+
+  EXPECT_TRUE(!!xdr.seek(2 * block_size));
+  EXPECT_TRUE(!!xdr.read(value));
+  EXPECT_EQ(value, 2);
+  EXPECT_TRUE(!!xdr.read(floats_read));
+  EXPECT_EQ(floats_read, floats);
+
+  EXPECT_TRUE(!!xdr.seek(block_size));
+  EXPECT_TRUE(!!xdr.read(value));
+  EXPECT_EQ(value, 1);
+
+  EXPECT_TRUE(!!xdr.seek(3 * block_size - 4));
+  EXPECT_TRUE(!!xdr.read(future::Span<int>(&value, 1)));
+  EXPECT_FALSE(!!xdr.read(value)); // end of file
+  std::remove("test_arrays.xdr");
+}
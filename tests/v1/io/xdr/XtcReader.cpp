@@ -1,13 +1,285 @@
 #include "xmol/io/xdr/XtcReader.h"
+#include "xmol/Frame.h"
 #include "xmol/future/span.h"
+#include "xmol/io/xdr/XtcWriter.h"
+#include "test_common.h"
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+
 using ::testing::Test;
 using namespace xmol::io::xdr;
 using namespace xmol;
 
 class XdrReaderTests : public Test {};
 
+namespace {
+
+/// Original byte-wise decoder of compressed `.xtc` coordinates (receivebits/receiveints of libxdrf)
+namespace reference_xtc {
+
+constexpr std::array magicints{
+    0,       0,       0,       0,       0,        0,        0,       0,       0,       8,       10,
+    12,      16,      20,      25,      32,       40,       50,      64,      80,      101,     128,
+    161,     203,     256,     322,     406,      512,      645,     812,     1024,    1290,    1625,
+    2048,    2580,    3250,    4096,    5060,     6501,     8192,    10321,   13003,   16384,   20642,
+    26007,   32768,   41285,   52015,   65536,    82570,    104031,  131072,  165140,  208063,  262144,
+    330280,  416127,  524287,  660561,  832255,   1048576,  1321122, 1664510, 2097152, 2642245, 3329021,
+    4194304, 5284491, 6658042, 8388607, 10568983, 13316085, 16777216};
+
+constexpr int FIRSTIDX = 9;
+
+int receivebits(int buf[], int num_of_bits) {
+
+  int cnt, num;
+  unsigned int lastbits, lastbyte;
+  unsigned char* cbuf;
+  int mask = (1 << num_of_bits) - 1;
+
+  cbuf = ((unsigned char*)buf) + 3 * sizeof(*buf);
+  cnt = buf[0];
+  lastbits = (unsigned int)buf[1];
+  lastbyte = (unsigned int)buf[2];
+
+  num = 0;
+  while (num_of_bits >= 8) {
+    lastbyte = (lastbyte << 8) | cbuf[cnt++];
+    num |= (lastbyte >> lastbits) << (num_of_bits - 8);
+    num_of_bits -= 8;
+  }
+  if (num_of_bits > 0) {
+    if (lastbits < num_of_bits) {
+      lastbits += 8;
+      lastbyte = (lastbyte << 8) | cbuf[cnt++];
+    }
+    lastbits -= num_of_bits;
+    num |= (lastbyte >> lastbits) & ((1 << num_of_bits) - 1);
+  }
+  num &= mask;
+  buf[0] = cnt;
+  buf[1] = lastbits;
+  buf[2] = lastbyte;
+  return num;
+}
+
+void receiveints(int buf[], const int num_of_ints, int num_of_bits, unsigned int sizes[], int nums[]) {
+  int bytes[32];
+  int i, j, num_of_bytes, p, num;
+
+  bytes[1] = bytes[2] = bytes[3] = 0;
+  num_of_bytes = 0;
+  while (num_of_bits > 8) {
+    bytes[num_of_bytes++] = receivebits(buf, 8);
+    num_of_bits -= 8;
+  }
+  if (num_of_bits > 0) {
+    bytes[num_of_bytes++] = receivebits(buf, num_of_bits);
+  }
+  for (i = num_of_ints - 1; i > 0; i--) {
+    num = 0;
+    for (j = num_of_bytes - 1; j >= 0; j--) {
+      num = (num << 8) | bytes[j];
+      p = num / sizes[i];
+      bytes[j] = p;
+      num = num - p * sizes[i];
+    }
+    nums[i] = num;
+  }
+  nums[0] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+}
+
+int sizeofint(const int size) {
+  unsigned int num = 1;
+  int num_of_bits = 0;
+
+  while (size >= num && num_of_bits < 32) {
+    num_of_bits++;
+    num <<= 1;
+  }
+  return num_of_bits;
+}
+
+int sizeofints(const int num_of_ints, unsigned int sizes[]) {
+  int i, num;
+  unsigned int num_of_bytes, num_of_bits, bytes[32], bytecnt, tmp;
+  num_of_bytes = 1;
+  bytes[0] = 1;
+  num_of_bits = 0;
+  for (i = 0; i < num_of_ints; i++) {
+    tmp = 0;
+    for (bytecnt = 0; bytecnt < num_of_bytes; bytecnt++) {
+      tmp = bytes[bytecnt] * sizes[i] + tmp;
+      bytes[bytecnt] = tmp & 0xff;
+      tmp >>= 8;
+    }
+    while (tmp != 0) {
+      bytes[bytecnt++] = tmp & 0xff;
+      tmp >>= 8;
+    }
+    num_of_bytes = bytecnt;
+  }
+  num = 1;
+  num_of_bytes--;
+  while (bytes[num_of_bytes] >= num) {
+    num_of_bits++;
+    num *= 2;
+  }
+  return num_of_bits + num_of_bytes * 8;
+}
+
+/// Decodes coordinates of a frame, @p bytes start with “size” field
+std::vector<float> decode(const std::string& bytes) {
+  size_t pos = 0;
+  auto read_int = [&bytes, &pos]() {
+    uint32_t value = 0;
+    for (int b = 0; b < 4; ++b) {
+      value = (value << 8) | static_cast<unsigned char>(bytes.at(pos++));
+    }
+    return static_cast<int>(value);
+  };
+  auto read_float = [&read_int]() {
+    const int bits = read_int();
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+  };
+
+  const int lsize = read_int();
+  std::vector<float> flat_coords(lsize * 3);
+  if (lsize <= 9) {
+    for (auto& value : flat_coords) {
+      value = read_float();
+    }
+    return flat_coords;
+  }
+  const float precision = read_float();
+  std::array<int, 3> minint{};
+  std::array<int, 3> maxint{};
+  for (auto& value : minint) {
+    value = read_int();
+  }
+  for (auto& value : maxint) {
+    value = read_int();
+  }
+  std::array<unsigned int, 3> sizeint{}, sizesmall{}, bitsizeint{};
+  unsigned int bitsize;
+  sizeint[0] = maxint[0] - minint[0] + 1;
+  sizeint[1] = maxint[1] - minint[1] + 1;
+  sizeint[2] = maxint[2] - minint[2] + 1;
+
+  /* check if one of the sizes is to big to be multiplied */
+  if ((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff) {
+    bitsizeint[0] = sizeofint(sizeint[0]);
+    bitsizeint[1] = sizeofint(sizeint[1]);
+    bitsizeint[2] = sizeofint(sizeint[2]);
+    bitsize = 0; /* flag the use of large sizes */
+  } else {
+    bitsize = sizeofints(3, sizeint.data());
+  }
+
+  int smallidx = read_int();
+  int smaller = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
+  int small = magicints[smallidx] / 2;
+  sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+
+  const int n_bytes = read_int();
+  std::vector<int> buf(3 + n_bytes / sizeof(int) + 1);
+  std::memcpy(&buf[3], bytes.data() + pos, n_bytes);
+  buf[0] = buf[1] = buf[2] = 0;
+
+  std::vector<int> ip(flat_coords.size());
+  std::array<int, 3> prevcoord{};
+  float* lfp = flat_coords.data();
+  const float inv_precision = 1.0f / precision;
+  int run = 0;
+  int i = 0;
+  while (i < lsize) {
+    int* thiscoord = ip.data() + i * 3;
+
+    if (bitsize == 0) {
+      thiscoord[0] = receivebits(buf.data(), bitsizeint[0]);
+      thiscoord[1] = receivebits(buf.data(), bitsizeint[1]);
+      thiscoord[2] = receivebits(buf.data(), bitsizeint[2]);
+    } else {
+      receiveints(buf.data(), 3, (int)bitsize, sizeint.data(), thiscoord);
+    }
+
+    i++;
+    thiscoord[0] += minint[0];
+    thiscoord[1] += minint[1];
+    thiscoord[2] += minint[2];
+
+    prevcoord[0] = thiscoord[0];
+    prevcoord[1] = thiscoord[1];
+    prevcoord[2] = thiscoord[2];
+
+    const int flag = receivebits(buf.data(), 1);
+    int is_smaller = 0;
+    if (flag == 1) {
+      run = receivebits(buf.data(), 5);
+      is_smaller = run % 3;
+      run -= is_smaller;
+      is_smaller--;
+    }
+    if (run > 0) {
+      thiscoord += 3;
+      for (int k = 0; k < run; k += 3) {
+        receiveints(buf.data(), 3, smallidx, sizesmall.data(), thiscoord);
+        i++;
+        thiscoord[0] += prevcoord[0] - small;
+        thiscoord[1] += prevcoord[1] - small;
+        thiscoord[2] += prevcoord[2] - small;
+        if (k == 0) {
+          /* interchange first with second atom for better
+           * compression of water molecules
+           */
+          std::swap(thiscoord[0], prevcoord[0]);
+          std::swap(thiscoord[1], prevcoord[1]);
+          std::swap(thiscoord[2], prevcoord[2]);
+
+          *lfp++ = prevcoord[0] * inv_precision;
+          *lfp++ = prevcoord[1] * inv_precision;
+          *lfp++ = prevcoord[2] * inv_precision;
+        } else {
+          prevcoord[0] = thiscoord[0];
+          prevcoord[1] = thiscoord[1];
+          prevcoord[2] = thiscoord[2];
+        }
+        *lfp++ = static_cast<float>(thiscoord[0]) * inv_precision;
+        *lfp++ = static_cast<float>(thiscoord[1]) * inv_precision;
+        *lfp++ = static_cast<float>(thiscoord[2]) * inv_precision;
+      }
+    } else {
+      *lfp++ = static_cast<float>(thiscoord[0]) * inv_precision;
+      *lfp++ = static_cast<float>(thiscoord[1]) * inv_precision;
+      *lfp++ = static_cast<float>(thiscoord[2]) * inv_precision;
+    }
+    smallidx += is_smaller;
+    if (is_smaller < 0) {
+      small = smaller;
+      if (smallidx > FIRSTIDX) {
+        smaller = magicints[smallidx - 1] / 2;
+      } else {
+        smaller = 0;
+      }
+    } else if (is_smaller > 0) {
+      smaller = small;
+      small = magicints[smallidx] / 2;
+    }
+    sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+  }
+  return flat_coords;
+}
+
+} // namespace reference_xtc
+} // namespace
+
 TEST_F(XdrReaderTests, sound) {
   std::string filename = "gromacs/xtc/1am7_corrected.xtc";
   XtcReader reader(filename);
@@ -30,3 +302,137 @@ TEST_F(XdrReaderTests, sound) {
   }
   EXPECT_EQ(frame_idx, 51);
 }
+
+TEST_F(XdrReaderTests, decode_synthetic) {
+  // water-like clusters exercise runs of small atoms, precision 1e5 forces large (unmultiplied) sizes
+  for (float precision : {10.0f, 1000.0f, 100000.0f}) {
+    Frame frame;
+    test::add_polyglycines({{"A", 100}}, frame);
+    auto coords = frame.coords()._eigen();
+    std::mt19937 generator(42);
+    std::normal_distribution<double> spread(0.0, 30.0);
+    std::normal_distribution<double> jitter(0.0, 1.0);
+    for (size_t i = 0; i < frame.n_atoms(); ++i) {
+      for (int k = 0; k < 3; ++k) {
+        coords(i, k) = i % 3 == 0 ? spread(generator) : coords(i - 1, k) + jitter(generator);
+      }
+    }
+    {
+      XtcWriter writer("test_decode.xtc", precision);
+      writer.write(frame);
+    }
+
+    XtcReader reader("test_decode.xtc");
+    XtcHeader header{};
+    std::array<float, 9> box{};
+    std::vector<float> flat(frame.n_atoms() * 3);
+    ASSERT_TRUE(!!reader.read_header(header));
+    ASSERT_EQ(header.n_atoms, frame.n_atoms());
+    ASSERT_TRUE(!!reader.read_box(box));
+    ASSERT_TRUE(!!reader.read_coords(flat)) << reader.last_error();
+    for (size_t i = 0; i < frame.n_atoms(); ++i) {
+      for (int k = 0; k < 3; ++k) {
+        ASSERT_NEAR(flat[i * 3 + k] * 10, coords(i, k), 10.0 / precision) << "atom " << i;
+      }
+    }
+    EXPECT_FALSE(!!reader.read_header(header)); // end of file
+  }
+  std::remove("test_decode.xtc");
+}
+
+TEST_F(XdrReaderTests, decode_bit_exact) {
+  // decoded values must be bitwise equal to ones of the original byte-wise decoder on the same bytes
+  Frame frame;
+  test::add_polyglycines({{"A", 20}}, frame);
+  for (float precision : {10.0f, 1000.0f, 1e5f, 1e6f, 3e7f}) {
+    std::mt19937 generator(2021); // raw engine output is portable, unlike standard distributions
+    auto uniform = [&generator](double scale) {
+      return (static_cast<int>(generator() % 2001) - 1000) / 1000.0 * scale;
+    };
+    {
+      XtcWriter writer("test_bit_exact.xtc", precision);
+      // spacing of atoms within a group defines run lengths and changes of `smallidx`,
+      // spacing in integer units must stay well below the largest magic int (2^24) for the encoder
+      for (double spacing : {0.02, 0.1, 0.3, 1.0, 3.0, 30.0}) {
+        if (spacing / 10 * precision > 4e6) {
+          continue;
+        }
+        auto coords = frame.coords()._eigen();
+        size_t group_left = 0;
+        for (size_t i = 0; i < frame.n_atoms(); ++i) {
+          const bool new_group = group_left == 0;
+          group_left = new_group ? generator() % 12 : group_left - 1;
+          for (int k = 0; k < 3; ++k) {
+            coords(i, k) = new_group ? uniform(30.0) : coords(i - 1, k) + uniform(spacing);
+          }
+        }
+        writer.write(frame);
+      }
+    }
+    std::ifstream in("test_bit_exact.xtc", std::ios::binary);
+    const std::string bytes{std::istreambuf_iterator<char>(in), {}};
+
+    XtcReader reader("test_bit_exact.xtc");
+    XtcHeader header{};
+    std::array<float, 9> box{};
+    std::vector<float> flat(frame.n_atoms() * 3);
+    for (int f = 0; !!reader.read_header(header); ++f) {
+      ASSERT_TRUE(!!reader.read_box(box));
+      const auto begin = reader.tell();
+      ASSERT_TRUE(!!reader.read_coords(flat)) << reader.last_error() << ", precision " << precision << ", frame " << f;
+      const auto expected = reference_xtc::decode(bytes.substr(begin, reader.tell() - begin));
+      ASSERT_EQ(flat.size(), expected.size());
+      for (size_t i = 0; i < flat.size(); ++i) {
+        uint32_t actual_bits;
+        uint32_t expected_bits;
+        std::memcpy(&actual_bits, &flat[i], sizeof(float));
+        std::memcpy(&expected_bits, &expected[i], sizeof(float));
+        ASSERT_EQ(actual_bits, expected_bits) << "precision " << precision << ", frame " << f << ", value " << i;
+      }
+    }
+  }
+  std::remove("test_bit_exact.xtc");
+}
+
+TEST_F(XdrReaderTests, scan_truncated) {
+  Frame frame;
+  test::add_polyglycines({{"A", 10}}, frame);
+  {
+    XtcWriter writer("test_truncated.xtc", 1000);
+    for (int i = 0; i < 3; i++) {
+      frame.index = i;
+      writer.write(frame);
+    }
+  }
+  std::ifstream in("test_truncated.xtc", std::ios::binary);
+  const std::vector<char> bytes{std::istreambuf_iterator<char>(in), {}};
+
+  FrameOffsetIndex offsets;
+  ASSERT_TRUE(!!XtcReader("test_truncated.xtc").scan(offsets));
+  ASSERT_EQ(offsets.n_frames(), 3);
+
+  auto scan_prefix = [&bytes](size_t size, FrameOffsetIndex& index) {
+    std::ofstream("test_truncated_prefix.xtc", std::ios::binary).write(bytes.data(), size);
+    return XtcReader("test_truncated_prefix.xtc").scan(index);
+  };
+  // last frame is cut in header, box and payload
+  for (size_t shift : {6, 16 + 20, 16 + 36 + 20}) {
+    FrameOffsetIndex index;
+    ASSERT_TRUE(!!scan_prefix(offsets[2] + shift, index)) << shift;
+    EXPECT_EQ(index.n_frames(), 2) << shift;
+  }
+  {
+    FrameOffsetIndex index;
+    EXPECT_FALSE(!!scan_prefix(6, index)); // first frame is bad
+  }
+  // middle frame is corrupted in magic and size, later frames must not be silently dropped
+  for (size_t shift : {0, 16 + 36}) {
+    auto corrupted = bytes;
+    corrupted[offsets[1] + shift] = '\x7f';
+    std::ofstream("test_truncated_prefix.xtc", std::ios::binary).write(corrupted.data(), corrupted.size());
+    FrameOffsetIndex index;
+    EXPECT_FALSE(!!XtcReader("test_truncated_prefix.xtc").scan(index)) << shift;
+  }
+  std::remove("test_truncated.xtc");
+  std::remove("test_truncated_prefix.xtc");
+}
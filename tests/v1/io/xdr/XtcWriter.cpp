@@ -2,8 +2,15 @@
 #include "xmol/Frame.h"
 #include "xmol/geom/affine/Transformation3d.h"
 #include "xmol/io/PdbInputFile.h"
+#include "xmol/io/xdr/XtcReader.h"
+#include "test_common.h"
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+
 using ::testing::Test;
 using namespace xmol::io::xdr;
 using namespace xmol;
@@ -21,3 +28,99 @@ TEST_F(XtcWriterTests, write_trajectory) {
     writer.write(frame);
   }
 }
+
+TEST_F(XtcWriterTests, parallel_compression) {
+  Frame frame;
+  test::add_polyglycines({{"A", 50}}, frame);
+  auto write = [&frame](const std::string& filename, size_t n_threads) {
+    XtcWriter writer(filename, 1000, n_threads);
+    std::mt19937 generator(7);
+    std::normal_distribution<double> spread(0.0, 20.0);
+    for (int i = 0; i < 20; i++) {
+      auto coords = frame.coords()._eigen();
+      for (int k = 0; k < coords.size(); ++k) {
+        coords(k) = spread(generator) / (1 + k % 4);
+      }
+      frame.index = i;
+      writer.write(frame);
+    }
+  };
+  write("test_serial.xtc", 1);
+  write("test_parallel.xtc", 4);
+
+  auto read_bytes = [](const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    return std::vector<char>{std::istreambuf_iterator<char>(in), {}};
+  };
+  const auto serial = read_bytes("test_serial.xtc");
+  EXPECT_FALSE(serial.empty());
+  EXPECT_EQ(serial, read_bytes("test_parallel.xtc"));
+
+  XtcReader reader("test_parallel.xtc");
+  XtcHeader header{};
+  std::array<float, 9> box{};
+  std::vector<float> flat(frame.n_atoms() * 3);
+  for (int i = 0; i < 20; i++) {
+    ASSERT_TRUE(!!reader.read_header(header));
+    EXPECT_EQ(header.step, i);
+    ASSERT_TRUE(!!reader.read_box(box));
+    ASSERT_TRUE(!!reader.read_coords(flat)) << reader.last_error();
+  }
+  EXPECT_FALSE(!!reader.read_header(header));
+  std::remove("test_serial.xtc");
+  std::remove("test_parallel.xtc");
+}
+
+TEST_F(XtcWriterTests, small_frames) {
+  // frames of up to 9 atoms are written as plain floats
+  Frame frame;
+  test::add_polyglycines({{"A", 1}}, frame);
+  ASSERT_GT(frame.n_atoms(), 3);
+  ASSERT_LE(frame.n_atoms(), 9);
+  {
+    XtcWriter writer("test_small.xtc", 1000);
+    for (int i = 0; i < 3; i++) {
+      auto coords = frame.coords()._eigen();
+      for (int k = 0; k < coords.size(); ++k) {
+        coords(k) = 0.37 * k - i;
+      }
+      frame.index = i;
+      writer.write(frame);
+    }
+  }
+  XtcReader reader("test_small.xtc");
+  XtcHeader header{};
+  std::array<float, 9> box{};
+  std::vector<float> flat(frame.n_atoms() * 3);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(!!reader.read_header(header));
+    EXPECT_EQ(header.n_atoms, frame.n_atoms());
+    ASSERT_TRUE(!!reader.read_box(box));
+    ASSERT_TRUE(!!reader.read_coords(flat)) << reader.last_error();
+    for (size_t k = 0; k < flat.size(); ++k) {
+      EXPECT_NEAR(flat[k], (0.37 * k - i) / 10, 1e-6);
+    }
+  }
+  EXPECT_FALSE(!!reader.read_header(header));
+
+  FrameOffsetIndex offsets;
+  ASSERT_TRUE(!!XtcReader("test_small.xtc").scan(offsets));
+  EXPECT_EQ(offsets.n_frames(), 3);
+  std::remove("test_small.xtc");
+}
+
+TEST_F(XtcWriterTests, parallel_compression_error) {
+  Frame frame;
+  test::add_polyglycines({{"A", 2}}, frame);
+  XtcWriter writer("test_overflow.xtc", 1e7, 2);
+  frame.coords()._eigen().setConstant(1e5); // exceeds int range when scaled by precision
+  EXPECT_THROW(
+      {
+        for (int i = 0; i < 10; i++) {
+          writer.write(frame);
+        }
+        writer.flush();
+      },
+      io::XtcWriteError);
+  std::remove("test_overflow.xtc");
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include "xmol/trajectory/InMemoryTrajectory.h"
+#include "xmol/trajectory/Trajectory.h"
+#include "test_common.h"
+
+#include <random>
+
+using ::testing::Test;
+using namespace xmol::trajectory;
+using namespace xmol;
+
+namespace {
+
+/// Random walk of polyglycine atoms, cell and time change from frame to frame
+std::vector<Frame> make_frames(const Frame& ref, size_t n_frames) {
+  std::vector<Frame> frames;
+  Frame frame(ref);
+  std::mt19937 generator(1);
+  std::normal_distribution<double> step(0.0, 0.3);
+  auto coords = frame.coords()._eigen();
+  for (int k = 0; k < coords.size(); ++k) {
+    coords(k) = 100 * step(generator);
+  }
+  for (size_t f = 0; f < n_frames; ++f) {
+    for (int k = 0; k < coords.size(); ++k) {
+      coords(k) += step(generator);
+    }
+    frame.cell = geom::UnitCell(30 + f, 40, 50, geom::Degrees(90), geom::Degrees(90), geom::Degrees(90));
+    frame.time = 0.5 * f;
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+} // namespace
+
+class InMemoryTrajectoryTests : public Test {};
+
+TEST_F(InMemoryTrajectoryTests, float32) {
+  Frame ref;
+  test::add_polyglycines({{"A", 20}}, ref);
+  auto frames = make_frames(ref, 10);
+  InMemoryTrajectory store(ref.n_atoms());
+  for (auto& frame : frames) {
+    store.append(frame);
+  }
+  EXPECT_EQ(store.n_frames(), 10);
+  EXPECT_EQ(store.size_in_bytes(), 10 * ref.n_atoms() * 3 * sizeof(float));
+
+  Trajectory traj(ref);
+  traj.extend(InMemoryTrajectory(store));
+  for (auto& frame : traj) {
+    auto& expected = frames[frame.index];
+    EXPECT_TRUE(frame.coords()._eigen().isApprox(expected.coords()._eigen().cast<float>().cast<double>(), 0));
+    EXPECT_DOUBLE_EQ(frame.cell.a(), expected.cell.a());
+    EXPECT_DOUBLE_EQ(frame.time, expected.time);
+  }
+}
+
+TEST_F(InMemoryTrajectoryTests, quantized) {
+  Frame ref;
+  test::add_polyglycines({{"A", 20}}, ref);
+  auto frames = make_frames(ref, 50);
+  const double precision = 1e-3;
+  InMemoryTrajectory store(ref.n_atoms(), precision, 16);
+  for (auto& frame : frames) {
+    store.append(frame);
+  }
+  EXPECT_EQ(store.n_frames(), 50);
+  EXPECT_LT(store.size_in_bytes(), 50 * ref.n_atoms() * 3 * sizeof(float) / 2);
+
+  auto check = [&](Frame& frame) {
+    auto& expected = frames[frame.index];
+    EXPECT_LE((frame.coords()._eigen() - expected.coords()._eigen()).cwiseAbs().maxCoeff(), precision / 2 + 1e-9);
+    EXPECT_DOUBLE_EQ(frame.cell.a(), expected.cell.a());
+    EXPECT_DOUBLE_EQ(frame.time, expected.time);
+  };
+
+  Trajectory traj(ref);
+  traj.extend(InMemoryTrajectory(store));
+  for (auto& frame : traj) {
+    check(frame);
+  }
+  for (auto& frame : traj.slice(3, 50, 7)) { // random access across blocks
+    check(frame);
+  }
+  for (auto& frame : traj.slice(40, 50).select_atoms({1, 5, 30})) {
+    auto& expected = frames[frame.index];
+    EXPECT_NEAR(frame.coords()._eigen()(2, 0), expected.coords()._eigen()(30, 0), precision / 2 + 1e-9);
+  }
+
+  // values are restored exactly when stored twice
+  InMemoryTrajectory copy(ref.n_atoms(), precision, 7);
+  Frame frame(ref);
+  store.advance(0);
+  for (size_t i = 0; i < store.n_frames(); ++i) {
+    store.read_frame(i, frame);
+    copy.append(frame);
+    store.advance(1);
+  }
+  Trajectory traj_copy(ref);
+  traj_copy.extend(InMemoryTrajectory(copy));
+  for (auto& f : traj_copy) {
+    Frame expected(ref);
+    store.advance(f.index);
+    store.read_frame(f.index, expected);
+    store.advance(store.n_frames());
+    EXPECT_EQ(f.coords()._eigen(), expected.coords()._eigen());
+  }
+}
+
+TEST_F(InMemoryTrajectoryTests, append_after_clone) {
+  Frame ref;
+  test::add_polyglycines({{"A", 2}}, ref);
+  auto frames = make_frames(ref, 3);
+  InMemoryTrajectory store(ref.n_atoms(), 0.01, 2);
+  store.append(frames[0]);
+  auto clone = store.clone();
+  store.append(frames[1]);
+  store.append(frames[2]);
+  EXPECT_EQ(clone->n_frames(), 1);
+  EXPECT_EQ(store.n_frames(), 3);
+  Frame empty;
+  EXPECT_THROW(store.append(empty), std::runtime_error);
+  EXPECT_THROW(InMemoryTrajectory(1, -1), std::invalid_argument);
+}
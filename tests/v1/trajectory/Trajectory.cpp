@@ -0,0 +1,485 @@
+#include <gtest/gtest.h>
+
+#include "xmol/io/GromacsXtcFile.h"
+#include "xmol/io/xdr/XtcWriter.h"
+#include "xmol/trajectory/InMemoryTrajectory.h"
+#include "xmol/trajectory/Trajectory.h"
+#include "test_common.h"
+
+#include <cstdio>
+#include <random>
+#include <set>
+#include <thread>
+
+using ::testing::Test;
+using namespace xmol::trajectory;
+using namespace xmol;
+
+namespace {
+
+/// Frames with times `t0 + i * dt`, first coordinate is equal to time
+InMemoryTrajectory make_file(Frame& frame, size_t n_frames, double t0, double dt) {
+  InMemoryTrajectory file(frame.n_atoms());
+  for (size_t i = 0; i < n_frames; ++i) {
+    frame.time = t0 + i * dt;
+    frame.coords()._eigen()(0, 0) = frame.time;
+    file.append(frame);
+  }
+  return file;
+}
+
+/// Trajectory made of runs restarted from checkpoints: [0, 10), [7, 15), [15, 20) with 1 ps step
+Trajectory make_restarted_trajectory(Frame& frame) {
+  Trajectory traj(frame);
+  traj.extend(make_file(frame, 10, 0, 1));
+  traj.extend(make_file(frame, 8, 7, 1));
+  traj.extend(make_file(frame, 5, 15, 1));
+  return traj;
+}
+
+/// Trajectory of two files of 1000 frames of 880 atoms with random coordinates
+Trajectory make_long_trajectory() {
+  Frame frame;
+  auto residue = frame.add_molecule().add_residue();
+  for (int i = 0; i < 880; ++i) {
+    residue.add_atom();
+  }
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<double> distribution(-50, 50);
+  Trajectory traj(frame);
+  for (int file = 0; file < 2; ++file) {
+    InMemoryTrajectory store(frame.n_atoms());
+    for (int f = 0; f < 1000; ++f) {
+      auto coords = frame.coords()._eigen();
+      for (int k = 0; k < coords.size(); ++k) {
+        coords(k) = distribution(generator);
+      }
+      store.append(frame);
+    }
+    traj.extend(std::move(store));
+  }
+  return traj;
+}
+
+} // namespace
+
+class TrajectoryTests : public Test {};
+
+TEST_F(TrajectoryTests, frame_at_time) {
+  Frame frame;
+  test::add_polyglycines({{"A", 2}}, frame);
+  auto traj = make_restarted_trajectory(frame);
+  ASSERT_EQ(traj.n_frames(), 23);
+
+  EXPECT_EQ(traj.index_at_time(0), 0);
+  EXPECT_EQ(traj.index_at_time(3.4), 3);
+  EXPECT_EQ(traj.index_at_time(3.6), 4);
+  EXPECT_EQ(traj.index_at_time(6.4), 6);   // frames of first run before restart time
+  EXPECT_EQ(traj.index_at_time(6.9), 10);  // first frame of second run
+  EXPECT_EQ(traj.index_at_time(9), 12);    // superseded frames of first run are skipped
+  EXPECT_EQ(traj.index_at_time(14.6), 18); // first frame of third run
+  EXPECT_EQ(traj.index_at_time(19), 22);
+  EXPECT_THROW(static_cast<void>(traj.index_at_time(-0.5)), std::out_of_range);
+  EXPECT_THROW(static_cast<void>(traj.index_at_time(19.5)), std::out_of_range);
+
+  for (double t : {0.0, 6.0, 8.0, 12.0, 17.0}) {
+    auto f = traj.frame_at_time(t);
+    EXPECT_DOUBLE_EQ(f.time, t);
+    EXPECT_DOUBLE_EQ(f.coords()._eigen()(0, 0), t);
+  }
+}
+
+TEST_F(TrajectoryTests, slice_by_time) {
+  Frame frame;
+  test::add_polyglycines({{"A", 2}}, frame);
+  auto traj = make_restarted_trajectory(frame);
+
+  auto times = [](Trajectory::Slice slice) {
+    std::vector<double> result;
+    for (auto& f : slice) {
+      result.push_back(f.time);
+    }
+    return result;
+  };
+  EXPECT_EQ(times(traj.slice_by_time(2, 5.5)), (std::vector<double>{2, 3, 4, 5}));
+  EXPECT_EQ(times(traj.slice_by_time(2, 7)), (std::vector<double>{2, 3, 4, 5, 6}));
+  EXPECT_EQ(times(traj.slice_by_time(7, 17)), (std::vector<double>{7, 8, 9, 10, 11, 12, 13, 14, 15, 16}));
+  EXPECT_EQ(times(traj.slice_by_time(8, 20, 3)), (std::vector<double>{8, 11, 14, 17}));
+  EXPECT_EQ(times(traj.slice_by_time(19.5, 30)), (std::vector<double>{}));
+  EXPECT_EQ(traj.slice_by_time(-10, 7).size(), 7);
+  EXPECT_THROW(traj.slice_by_time(5, 9), std::runtime_error); // includes superseded frames 7..9 of the first run
+  EXPECT_THROW(traj.slice_by_time(5, 4), std::invalid_argument);
+}
+
+TEST_F(TrajectoryTests, slice_by_time_without_times) {
+  Frame frame;
+  test::add_polyglycines({{"A", 2}}, frame);
+  class NoTimes : public TrajectoryInputFile {
+  public:
+    explicit NoTimes(size_t n_atoms) : m_n_atoms(n_atoms) {}
+    [[nodiscard]] size_t n_frames() const final { return 3; }
+    [[nodiscard]] size_t n_atoms() const final { return m_n_atoms; }
+    void read_frame(size_t, Frame&) final {}
+    void advance(size_t) final {}
+
+  private:
+    size_t m_n_atoms;
+  };
+  Trajectory traj(frame);
+  traj.extend(NoTimes(frame.n_atoms()));
+  EXPECT_THROW(static_cast<void>(traj.index_at_time(0)), std::runtime_error);
+  EXPECT_THROW(traj.slice_by_time(0, 1), std::runtime_error);
+}
+
+TEST_F(TrajectoryTests, read_into) {
+  Frame frame;
+  test::add_polyglycines({{"A", 2}}, frame);
+  auto traj = make_restarted_trajectory(frame);
+
+  Frame out(frame);
+  std::mt19937 generator(3);
+  std::uniform_int_distribution<size_t> index(0, traj.n_frames() - 1);
+  for (int k = 0; k < 100; ++k) {
+    const size_t i = index(generator);
+    traj.read_into(i, out);
+    EXPECT_EQ(out.index, i);
+    EXPECT_DOUBLE_EQ(out.coords()._eigen()(0, 0), out.time);
+  }
+  for (auto& f : traj) { // random access while trajectory is traversed
+    traj.read_into(traj.n_frames() - 1 - f.index, out);
+    EXPECT_EQ(out.index, traj.n_frames() - 1 - f.index);
+    EXPECT_DOUBLE_EQ(out.coords()._eigen()(0, 0), out.time);
+  }
+
+  Frame small;
+  test::add_polyglycines({{"A", 1}}, small);
+  EXPECT_THROW(traj.read_into(0, small), std::runtime_error);
+  EXPECT_THROW(traj.read_into(traj.n_frames(), out), std::out_of_range);
+}
+
+TEST_F(TrajectoryTests, read_into_xtc) {
+  Frame frame;
+  test::add_polyglycines({{"A", 3}}, frame);
+  {
+    io::xdr::XtcWriter writer("test_read_into.xtc", 1000);
+    for (int i = 0; i < 10; i++) {
+      frame.time = i;
+      frame.coords()._eigen().setConstant(i);
+      writer.write(frame);
+    }
+  }
+  Trajectory traj(frame);
+  traj.extend(io::GromacsXtcFile("test_read_into.xtc"));
+  Frame out(frame);
+  for (size_t i : {7, 2, 2, 3, 9, 0, 5}) {
+    traj.read_into(i, out);
+    EXPECT_EQ(out.index, i);
+    EXPECT_FLOAT_EQ(out.time, i);
+    EXPECT_FLOAT_EQ(out.coords()._eigen()(4, 1), i);
+  }
+  for (auto& f : traj.slice(0, 10, 3)) { // shared file is not affected by random access
+    EXPECT_FLOAT_EQ(f.time, f.index);
+  }
+  std::remove("test_read_into.xtc");
+}
+
+TEST_F(TrajectoryTests, read_into_closes_other_files) {
+  /// Copyable file which counts its open copies
+  class CountingFile : public TrajectoryInputFile {
+  public:
+    CountingFile(size_t n_atoms, std::shared_ptr<int> n_open) : m_n_atoms(n_atoms), m_n_open(std::move(n_open)) {}
+    [[nodiscard]] size_t n_frames() const final { return 5; }
+    [[nodiscard]] size_t n_atoms() const final { return m_n_atoms; }
+    void read_frame(size_t index, Frame&) final { ASSERT_EQ(index, m_pos); }
+    [[nodiscard]] std::unique_ptr<TrajectoryInputFile> clone() const final {
+      return std::make_unique<CountingFile>(m_n_atoms, m_n_open);
+    }
+    void advance(size_t shift) final {
+      if (!m_open) {
+        m_open = true;
+        ++*m_n_open;
+      }
+      m_pos += shift;
+      if (m_pos >= n_frames()) {
+        m_open = false;
+        m_pos = 0;
+        --*m_n_open;
+      }
+    }
+
+  private:
+    size_t m_n_atoms;
+    std::shared_ptr<int> m_n_open;
+    bool m_open = false;
+    size_t m_pos = 0;
+  };
+
+  Frame frame;
+  test::add_polyglycines({{"A", 2}}, frame);
+  auto n_open = std::make_shared<int>(0);
+  Trajectory traj(frame);
+  for (int i = 0; i < 10; ++i) {
+    traj.extend(CountingFile(frame.n_atoms(), n_open));
+  }
+  Frame out(frame);
+  for (size_t i : {0, 3, 7, 49, 12, 13, 48, 4, 25}) {
+    traj.read_into(i, out);
+    EXPECT_EQ(*n_open, 1) << i;
+  }
+}
+
+TEST_F(TrajectoryTests, prefetch) {
+  Trajectory traj = make_long_trajectory();
+  std::vector<XYZ> expected;
+  for (auto& frame : traj.slice(5, {}, 7)) {
+    expected.push_back(frame.coords()[0]);
+  }
+  for (size_t depth : {1, 2, 8}) {
+    size_t count = 0;
+    for (auto& frame : traj.slice(5, {}, 7).prefetch(depth)) {
+      ASSERT_LT(count, expected.size());
+      EXPECT_EQ(frame.index, 5 + 7 * count);
+      EXPECT_LE((frame.coords()[0] - expected[count]).len(), 1e-6);
+      count += 1;
+    }
+    EXPECT_EQ(count, expected.size()) << "depth=" << depth;
+  }
+  for (int i = 0; i < 3; i++) {
+    int count = 0;
+    for (auto& _ : traj.prefetch(4)) {
+      static_cast<void>(_);
+      if (++count == 25) {
+        break;
+      }
+    }
+    EXPECT_EQ(count, 25) << "traj with prefetch and break";
+  }
+  size_t nested_count = 0;
+  for (auto& x : traj.slice(5, 33, 7).prefetch(2)) {
+    for (auto& y : traj.slice(0, {}, 500).prefetch(2)) {
+      static_cast<void>(y);
+      ++nested_count;
+    }
+    EXPECT_LE(x.coords()[0].distance(expected[(x.index - 5) / 7]), 1e-6);
+  }
+  EXPECT_EQ(nested_count, 4 * 4);
+}
+
+TEST_F(TrajectoryTests, select_atoms) {
+  Trajectory traj = make_long_trajectory();
+  std::vector<AtomIndex> atoms = {879, 3, 100, 101, 102, 3};
+  std::vector<AtomIndex> sorted_atoms = {3, 100, 101, 102, 879};
+  std::vector<Frame> expected;
+  for (auto& frame : traj.slice(10, 1500, 70)) {
+    expected.push_back(frame);
+  }
+  for (size_t depth : {0, 3}) {
+    size_t count = 0;
+    for (auto& frame : traj.slice(10, 1500, 70).select_atoms(atoms).prefetch(depth)) {
+      ASSERT_LT(count, expected.size());
+      ASSERT_EQ(frame.n_atoms(), sorted_atoms.size());
+      EXPECT_EQ(frame.index, expected[count].index);
+      for (size_t i = 0; i < sorted_atoms.size(); ++i) {
+        EXPECT_EQ(frame.coords()[i].distance(expected[count].coords()[sorted_atoms[i]]), 0);
+      }
+      ++count;
+    }
+    EXPECT_EQ(count, expected.size());
+  }
+  EXPECT_THROW(static_cast<void>(traj.select_atoms({880})), std::out_of_range);
+}
+
+TEST_F(TrajectoryTests, default_read_frame_atoms) {
+  /// File without own subset reads, values are `frame + atom / 100` scaled by 1, 10 and 100 for coords,
+  /// velocities and forces
+  class WholeFrameFile : public TrajectoryInputFile {
+  public:
+    [[nodiscard]] size_t n_frames() const final { return 5; }
+    [[nodiscard]] size_t n_atoms() const final { return 20; }
+    void read_frame(size_t index, Frame& frame) final {
+      read_into.insert(&frame);
+      for (size_t i = 0; i < n_atoms(); ++i) {
+        const double value = index + i / 100.0;
+        frame.coords()._eigen().row(i).setConstant(value);
+        if (frame.has_velocities()) {
+          frame.velocities()._eigen().row(i).setConstant(value * 10);
+        }
+        if (frame.has_forces()) {
+          frame.forces()._eigen().row(i).setConstant(value * 100);
+        }
+      }
+    }
+    void advance(size_t) final {}
+    std::set<const Frame*> read_into;
+  };
+
+  WholeFrameFile file;
+  const std::vector<AtomIndex> atoms{2, 7, 19};
+  Frame frame;
+  auto residue = frame.add_molecule().add_residue();
+  for (size_t i = 0; i < atoms.size(); ++i) {
+    residue.add_atom();
+  }
+  for (bool with_velocities : {false, true}) {
+    if (with_velocities) {
+      frame.add_velocities();
+      frame.add_forces();
+    }
+    for (size_t index = 0; index < file.n_frames(); ++index) {
+      file.read_frame_atoms(index, atoms, frame);
+      for (size_t i = 0; i < atoms.size(); ++i) {
+        const double value = index + atoms[i] / 100.0;
+        EXPECT_DOUBLE_EQ(frame.coords()._eigen()(i, 0), value);
+        if (with_velocities) {
+          EXPECT_DOUBLE_EQ(frame.velocities()._eigen()(i, 1), value * 10);
+          EXPECT_DOUBLE_EQ(frame.forces()._eigen()(i, 2), value * 100);
+        }
+      }
+    }
+  }
+  std::vector<float> coords(file.n_atoms() * 3);
+  file.read_coords(3, future::Span<float>(coords.data(), coords.size()));
+  EXPECT_FLOAT_EQ(coords[7 * 3 + 1], 3.07f);
+  EXPECT_EQ(file.read_into.size(), 1); // one scratch frame is reused by all reads
+}
+
+TEST_F(TrajectoryTests, double_penetration) {
+  Trajectory traj = make_long_trajectory();
+  std::vector<XYZ> expected;
+  for (auto& frame : traj.slice(0, {}, 100)) {
+    expected.push_back(frame.coords()[0]);
+  }
+  size_t count = 0;
+  for (auto& x : traj.slice(0, {}, 100)) {
+    for (auto& y : traj.slice(0, {}, 100)) {
+      EXPECT_LE(x.coords()[0].distance(expected[x.index / 100]), 1e-6);
+      EXPECT_LE(y.coords()[0].distance(expected[y.index / 100]), 1e-6);
+      ++count;
+    }
+  }
+  EXPECT_EQ(count, expected.size() * expected.size());
+
+  std::vector<double> sums(4, 0.0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < sums.size(); ++t) {
+    threads.emplace_back([&traj, &sums, t] {
+      for (auto& frame : traj.slice(t, {}, sums.size())) {
+        sums[t] += frame.coords()[0].x();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double total = 0;
+  for (auto& frame : traj) {
+    total += frame.coords()[0].x();
+  }
+  EXPECT_NEAR(sums[0] + sums[1] + sums[2] + sums[3], total, 1e-6);
+}
+
+TEST_F(TrajectoryTests, double_penetration_of_non_copyable_file) {
+  /// Input file which doesn't support independent copies
+  class NonCopyableFile : public trajectory::TrajectoryInputFile {
+  public:
+    explicit NonCopyableFile(InMemoryTrajectory file) : m_file(std::move(file)) {}
+    [[nodiscard]] size_t n_frames() const final { return m_file.n_frames(); }
+    [[nodiscard]] size_t n_atoms() const final { return m_file.n_atoms(); }
+    void read_frame(size_t index, Frame& frame) final { m_file.read_frame(index, frame); }
+    void advance(size_t shift) final { m_file.advance(shift); }
+
+  private:
+    InMemoryTrajectory m_file;
+  };
+
+  Trajectory traj = make_long_trajectory();
+  InMemoryTrajectory store(traj.n_atoms());
+  for (auto& frame : traj.slice(0, 1000)) {
+    store.append(frame);
+  }
+  traj.extend(NonCopyableFile(std::move(store)));
+  auto dp = [&traj] {
+    for (auto& x : traj) {
+      static_cast<void>(x);
+      for (auto& y : traj) {
+        static_cast<void>(y);
+      }
+    }
+  };
+  EXPECT_THROW(dp(), TrajectoryDoubleTraverseError);
+  size_t count = 0;
+  for (auto& x : traj.slice(0, {}, 1000)) {
+    static_cast<void>(x);
+    ++count;
+  }
+  EXPECT_EQ(count, 3) << "trajectory is traversable after TrajectoryDoubleTraverseError";
+}
+
+TEST_F(TrajectoryTests, parallel_map_reduce) {
+  Trajectory traj = make_long_trajectory();
+  auto map = [](Frame& frame) { return std::vector<std::pair<size_t, double>>{{frame.index, frame.coords()[0].x()}}; };
+  auto reduce = [](std::vector<std::pair<size_t, double>> a, std::vector<std::pair<size_t, double>> b) {
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+  };
+  std::vector<std::pair<size_t, double>> expected;
+  for (auto& frame : traj.slice(3, {}, 7)) {
+    expected.emplace_back(frame.index, frame.coords()[0].x());
+  }
+  for (size_t n_threads : {0, 1, 3, 8}) {
+    auto result = traj.parallel_map_reduce(traj.slice(3, {}, 7), n_threads, std::vector<std::pair<size_t, double>>{},
+                                           map, reduce);
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(result[i].first, expected[i].first);
+      EXPECT_DOUBLE_EQ(result[i].second, expected[i].second);
+    }
+  }
+
+  auto n_atoms = traj.parallel_map_reduce(
+      traj.select_atoms({1, 5, 9}), 4, size_t{0}, [](Frame& frame) { return frame.n_atoms(); },
+      [](size_t a, size_t b) { return a + b; });
+  EXPECT_EQ(n_atoms, traj.n_frames() * 3);
+
+  EXPECT_EQ(traj.parallel_map_reduce(
+                traj.slice(0, 0), 4, 42, [](Frame&) { return 1; }, [](int a, int b) { return a + b; }),
+            42);
+  EXPECT_THROW(traj.parallel_map_reduce(
+                   traj.slice(), 4, 0,
+                   [](Frame& frame) -> int {
+                     if (frame.index == 1234) {
+                       throw std::runtime_error("map failure");
+                     }
+                     return 0;
+                   },
+                   [](int a, int b) { return a + b; }),
+               std::runtime_error);
+}
+
+TEST_F(TrajectoryTests, slice_read_coords) {
+  Trajectory traj = make_long_trajectory();
+  auto slice = traj.slice(10, {}, 37).select_atoms({5, 1, 100});
+  std::vector<float> coords(slice.n_frames() * slice.n_atoms() * 3);
+  slice.read_coords(future::Span<float>(coords.data(), coords.size()));
+  size_t i = 0;
+  for (auto& frame : slice) {
+    for (size_t a = 0; a < slice.n_atoms(); ++a) {
+      for (int k = 0; k < 3; ++k) {
+        EXPECT_NEAR(coords[(i * slice.n_atoms() + a) * 3 + k], frame.coords()._eigen()(a, k), 1e-4);
+      }
+    }
+    ++i;
+  }
+  EXPECT_EQ(i, slice.n_frames());
+  std::vector<float> wrong_size(coords.size() + 1);
+  EXPECT_THROW(slice.read_coords(future::Span<float>(wrong_size.data(), wrong_size.size())), std::runtime_error);
+
+  std::vector<double> coords_double(coords.size());
+  slice.read_coords(future::Span<double>(coords_double.data(), coords_double.size()));
+  for (size_t j = 0; j < coords.size(); ++j) {
+    EXPECT_EQ(coords_double[j], static_cast<double>(coords[j]));
+  }
+  std::vector<double> wrong_size_double(coords.size() - 1);
+  EXPECT_THROW(slice.read_coords(future::Span<double>(wrong_size_double.data(), wrong_size_double.size())),
+               std::runtime_error);
+}